@@ -90,6 +90,8 @@ typedef_list = [
     typedef("mongoc_topology_ptr", "mongoc_topology_t *"),
     typedef("mongoc_write_concern_ptr", "mongoc_write_concern_t *"),
     typedef("mongoc_change_stream_ptr", "mongoc_change_stream_t *"),
+    typedef("mongoc_prepared_find_ptr", "mongoc_prepared_find_t *"),
+    typedef("mongoc_prepared_update_ptr", "mongoc_prepared_update_t *"),
     typedef("mongoc_remove_flags_t", None),
 
     # Const libmongoc.
@@ -98,6 +100,7 @@ typedef_list = [
     typedef("const_mongoc_iovec_ptr", "const mongoc_iovec_t *"),
     typedef("const_mongoc_read_prefs_ptr", "const mongoc_read_prefs_t *"),
     typedef("const_mongoc_write_concern_ptr", "const mongoc_write_concern_t *"),
+    typedef("const_uint8_ptr", "const uint8_t *"),
 ]
 
 type_list = [T.name for T in typedef_list]
@@ -498,6 +501,15 @@ future_functions = [
                      param("const_mongoc_write_concern_ptr", "write_concern"),
                      param("bson_error_ptr", "error")]),
 
+    future_function("bool",
+                    "mongoc_collection_insert_raw",
+                    [param("mongoc_collection_ptr", "collection"),
+                     param("const_uint8_ptr", "data"),
+                     param("size_t", "data_len"),
+                     param("const_bson_ptr", "opts"),
+                     param("bson_ptr", "reply"),
+                     param("bson_error_ptr", "error")]),
+
     future_function("bool",
                     "mongoc_collection_update_one",
                     [param("mongoc_collection_ptr", "coll"),
@@ -525,6 +537,19 @@ future_functions = [
                      param("bson_ptr", "reply"),
                      param("bson_error_ptr", "error")]),
 
+    future_function("mongoc_cursor_ptr",
+                    "mongoc_prepared_find_execute",
+                    [param("mongoc_prepared_find_ptr", "prepared"),
+                     param("const_bson_ptr", "filter")]),
+
+    future_function("bool",
+                    "mongoc_prepared_update_execute",
+                    [param("mongoc_prepared_update_ptr", "prepared"),
+                     param("const_bson_ptr", "selector"),
+                     param("const_bson_ptr", "update"),
+                     param("bson_ptr", "reply"),
+                     param("bson_error_ptr", "error")]),
+
     future_function("int64_t",
                     "mongoc_collection_count_documents",
                     [param("mongoc_collection_ptr", "coll"),
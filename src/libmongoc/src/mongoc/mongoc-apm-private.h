@@ -47,6 +47,8 @@ struct _mongoc_apm_callbacks_t {
 struct _mongoc_apm_command_started_t {
    bson_t *command;
    bool command_owned;
+   /* an OP_MSG with a document sequence, not yet appended to "command" */
+   const struct _mongoc_cmd_t *cmd;
    const char *database_name;
    const char *command_name;
    int64_t request_id;
@@ -58,6 +60,7 @@ struct _mongoc_apm_command_started_t {
 
 struct _mongoc_apm_command_succeeded_t {
    int64_t duration;
+   int64_t phase_duration[MONGOC_SPAN_PHASE_COUNT];
    const bson_t *reply;
    const char *command_name;
    int64_t request_id;
@@ -69,6 +72,7 @@ struct _mongoc_apm_command_succeeded_t {
 
 struct _mongoc_apm_command_failed_t {
    int64_t duration;
+   int64_t phase_duration[MONGOC_SPAN_PHASE_COUNT];
    const char *command_name;
    const bson_error_t *error;
    const bson_t *reply;
@@ -115,6 +115,7 @@ mongoc_apm_command_started_init (mongoc_apm_command_started_t *event,
       event->command_owned = false;
    }
 
+   event->cmd = NULL;
    event->database_name = database_name;
    event->command_name = command_name;
    event->request_id = request_id;
@@ -141,8 +142,13 @@ mongoc_apm_command_started_init_with_cmd (mongoc_apm_command_started_t *event,
                                     cmd->server_stream->sd->id,
                                     context);
 
-   /* OP_MSG document sequence for insert, update, or delete? */
-   append_documents_from_cmd (cmd, event);
+   /* OP_MSG document sequence for insert, update, or delete? copying the
+    * command and its documents is expensive, wait until the callback calls
+    * mongoc_apm_command_started_get_command, if it does. @cmd outlives the
+    * callback. */
+   if (cmd->payload && cmd->payload_size) {
+      event->cmd = cmd;
+   }
 }
 
 
@@ -169,6 +175,7 @@ mongoc_apm_command_succeeded_init (mongoc_apm_command_succeeded_t *event,
    BSON_ASSERT (reply);
 
    event->duration = duration;
+   memset (event->phase_duration, 0, sizeof event->phase_duration);
    event->reply = reply;
    event->command_name = command_name;
    event->request_id = request_id;
@@ -201,6 +208,7 @@ mongoc_apm_command_failed_init (mongoc_apm_command_failed_t *event,
    BSON_ASSERT (reply);
 
    event->duration = duration;
+   memset (event->phase_duration, 0, sizeof event->phase_duration);
    event->command_name = command_name;
    event->error = error;
    event->reply = reply;
@@ -229,6 +237,15 @@ const bson_t *
 mongoc_apm_command_started_get_command (
    const mongoc_apm_command_started_t *event)
 {
+   mongoc_apm_command_started_t *mutable_event;
+
+   if (event->cmd) {
+      /* discard "const", the command is only built once */
+      mutable_event = (mongoc_apm_command_started_t *) event;
+      append_documents_from_cmd (event->cmd, mutable_event);
+      mutable_event->cmd = NULL;
+   }
+
    return event->command;
 }
 
@@ -354,6 +371,16 @@ mongoc_apm_command_succeeded_get_context (
 }
 
 
+int64_t
+mongoc_apm_command_succeeded_get_phase_duration (
+   const mongoc_apm_command_succeeded_t *event, mongoc_span_phase_t phase)
+{
+   BSON_ASSERT (phase < MONGOC_SPAN_PHASE_COUNT);
+
+   return event->phase_duration[phase];
+}
+
+
 /* command-failed event fields */
 
 int64_t
@@ -423,6 +450,16 @@ mongoc_apm_command_failed_get_context (const mongoc_apm_command_failed_t *event)
 }
 
 
+int64_t
+mongoc_apm_command_failed_get_phase_duration (
+   const mongoc_apm_command_failed_t *event, mongoc_span_phase_t phase)
+{
+   BSON_ASSERT (phase < MONGOC_SPAN_PHASE_COUNT);
+
+   return event->phase_duration[phase];
+}
+
+
 /* server-changed event fields */
 
 const mongoc_host_list_t *
@@ -24,6 +24,7 @@
 #include "mongoc/mongoc-macros.h"
 #include "mongoc/mongoc-host-list.h"
 #include "mongoc/mongoc-server-description.h"
+#include "mongoc/mongoc-span.h"
 #include "mongoc/mongoc-topology-description.h"
 
 BSON_BEGIN_DECLS
@@ -129,6 +130,9 @@ mongoc_apm_command_succeeded_get_server_id (
 MONGOC_EXPORT (void *)
 mongoc_apm_command_succeeded_get_context (
    const mongoc_apm_command_succeeded_t *event);
+MONGOC_EXPORT (int64_t)
+mongoc_apm_command_succeeded_get_phase_duration (
+   const mongoc_apm_command_succeeded_t *event, mongoc_span_phase_t phase);
 
 /* command-failed event fields */
 
@@ -158,6 +162,9 @@ mongoc_apm_command_failed_get_server_id (
 MONGOC_EXPORT (void *)
 mongoc_apm_command_failed_get_context (
    const mongoc_apm_command_failed_t *event);
+MONGOC_EXPORT (int64_t)
+mongoc_apm_command_failed_get_phase_duration (
+   const mongoc_apm_command_failed_t *event, mongoc_span_phase_t phase);
 
 /* server-changed event fields */
 
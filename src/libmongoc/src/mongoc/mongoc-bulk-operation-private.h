@@ -38,6 +38,9 @@ struct _mongoc_bulk_operation_t {
    mongoc_write_result_t result;
    bool executed;
    int64_t operation_id;
+   bool counts_only;
+   mongoc_bulk_operation_batch_cb_t batch_cb;
+   void *batch_cb_ctx;
 };
 
 
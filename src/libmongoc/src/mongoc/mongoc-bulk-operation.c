@@ -720,6 +720,9 @@ mongoc_bulk_operation_execute (mongoc_bulk_operation_t *bulk, /* IN */
    }
 
    bulk->executed = true;
+   bulk->result.counts_only = bulk->counts_only || bulk->batch_cb;
+   bulk->result.batch_cb = bulk->batch_cb;
+   bulk->result.batch_cb_ctx = bulk->batch_cb_ctx;
 
    if (!bulk->database) {
       bson_set_error (error,
@@ -777,6 +780,9 @@ mongoc_bulk_operation_execute (mongoc_bulk_operation_t *bulk, /* IN */
       command =
          &_mongoc_array_index (&bulk->commands, mongoc_write_command_t, i);
 
+      /* may have been set after the operation was added */
+      command->flags.pipeline_depth = bulk->flags.pipeline_depth;
+
       _mongoc_write_command_execute (command,
                                      bulk->client,
                                      server_stream,
@@ -933,3 +939,47 @@ mongoc_bulk_operation_set_bypass_document_validation (
 
    bulk->flags.bypass_document_validation = bypass;
 }
+
+
+void
+mongoc_bulk_operation_set_pipeline_depth (mongoc_bulk_operation_t *bulk,
+                                          uint32_t depth)
+{
+   BSON_ASSERT (bulk);
+
+   if (depth > MONGOC_WRITE_PIPELINE_DEPTH_MAX) {
+      bson_set_error (&bulk->result.error,
+                      MONGOC_ERROR_COMMAND,
+                      MONGOC_ERROR_COMMAND_INVALID_ARG,
+                      "Pipeline depth %" PRIu32 " is greater than %d",
+                      depth,
+                      MONGOC_WRITE_PIPELINE_DEPTH_MAX);
+      MONGOC_WARNING ("%s", bulk->result.error.message);
+      return;
+   }
+
+   bulk->flags.pipeline_depth = depth;
+}
+
+
+void
+mongoc_bulk_operation_set_counts_only (mongoc_bulk_operation_t *bulk,
+                                       bool counts_only)
+{
+   BSON_ASSERT (bulk);
+
+   bulk->counts_only = counts_only;
+}
+
+
+void
+mongoc_bulk_operation_set_batch_callback (
+   mongoc_bulk_operation_t *bulk,
+   mongoc_bulk_operation_batch_cb_t batch_cb,
+   void *ctx)
+{
+   BSON_ASSERT (bulk);
+
+   bulk->batch_cb = batch_cb;
+   bulk->batch_cb_ctx = ctx;
+}
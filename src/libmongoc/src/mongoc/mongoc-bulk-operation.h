@@ -39,6 +39,9 @@ struct _mongoc_client_session_t;
 
 typedef struct _mongoc_bulk_operation_t mongoc_bulk_operation_t;
 typedef struct _mongoc_bulk_write_flags_t mongoc_bulk_write_flags_t;
+typedef void (*mongoc_bulk_operation_batch_cb_t) (const bson_t *reply,
+                                                  uint32_t offset,
+                                                  void *ctx);
 
 
 MONGOC_EXPORT (void)
@@ -115,6 +118,17 @@ mongoc_bulk_operation_update_one_with_opts (mongoc_bulk_operation_t *bulk,
 MONGOC_EXPORT (void)
 mongoc_bulk_operation_set_bypass_document_validation (
    mongoc_bulk_operation_t *bulk, bool bypass);
+MONGOC_EXPORT (void)
+mongoc_bulk_operation_set_pipeline_depth (mongoc_bulk_operation_t *bulk,
+                                          uint32_t depth);
+MONGOC_EXPORT (void)
+mongoc_bulk_operation_set_counts_only (mongoc_bulk_operation_t *bulk,
+                                       bool counts_only);
+MONGOC_EXPORT (void)
+mongoc_bulk_operation_set_batch_callback (
+   mongoc_bulk_operation_t *bulk,
+   mongoc_bulk_operation_batch_cb_t batch_cb,
+   void *ctx);
 
 
 /*
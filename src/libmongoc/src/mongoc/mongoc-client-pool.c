@@ -48,9 +48,50 @@ struct _mongoc_client_pool_t {
    void *apm_context;
    int32_t error_api_version;
    bool error_api_set;
+   double span_sample_rate;
+   mongoc_span_func_t span_func;
+   void *span_context;
+   /* for mongoc_client_pool_get_stats, guarded by mutex */
+   int64_t pops;
+   int64_t created;
+   int64_t destroyed;
+   int64_t waits;
+   int64_t wait_usec;
+   int64_t wait_max_usec;
+   int64_t wait_buckets[MONGOC_HISTOGRAM_N_BUCKETS];
+   uint32_t waiting;
+   int64_t at_max_since;
+   int64_t at_max_usec;
 };
 
 
+/*
+ * Track how long the pool has all its clients popped, so that pops wait.
+ * Call after anything that changes the size, the number of clients in the
+ * queue, or the max size.
+ *
+ * This function assumes the pool's mutex is locked
+ */
+static void
+_update_at_max (mongoc_client_pool_t *pool)
+{
+   bool at_max;
+   int64_t usec;
+
+   at_max = pool->size >= pool->max_pool_size &&
+            !_mongoc_queue_get_length (&pool->queue);
+
+   if (at_max && !pool->at_max_since) {
+      pool->at_max_since = bson_get_monotonic_time ();
+   } else if (!at_max && pool->at_max_since) {
+      usec = bson_get_monotonic_time () - pool->at_max_since;
+      pool->at_max_usec += usec;
+      pool->at_max_since = 0;
+      mongoc_counter_client_pools_at_max_add (usec);
+   }
+}
+
+
 #ifdef MONGOC_ENABLE_SSL
 void
 mongoc_client_pool_set_ssl_opts (mongoc_client_pool_t *pool,
@@ -173,6 +214,7 @@ mongoc_client_pool_destroy (mongoc_client_pool_t *pool)
    while (
       (client = (mongoc_client_t *) _mongoc_queue_pop_head (&pool->queue))) {
       mongoc_client_destroy (client);
+      mongoc_counter_client_pools_destroyed_inc ();
    }
 
    mongoc_topology_destroy (pool->topology);
@@ -212,11 +254,15 @@ mongoc_client_t *
 mongoc_client_pool_pop (mongoc_client_pool_t *pool)
 {
    mongoc_client_t *client;
+   int64_t started;
+   int64_t wait_started = 0;
+   int64_t wait_usec = 0;
 
    ENTRY;
 
    BSON_ASSERT (pool);
 
+   started = bson_get_monotonic_time ();
    bson_mutex_lock (&pool->mutex);
 
 again:
@@ -233,21 +279,54 @@ again:
          client->error_api_version = pool->error_api_version;
          _mongoc_client_set_apm_callbacks_private (
             client, &pool->apm_callbacks, pool->apm_context);
+         _mongoc_tracer_set (&client->tracer,
+                             pool->span_sample_rate,
+                             pool->span_func,
+                             pool->span_context);
 #ifdef MONGOC_ENABLE_SSL
          if (pool->ssl_opts_set) {
             mongoc_client_set_ssl_opts (client, &pool->ssl_opts);
          }
 #endif
          pool->size++;
+         pool->created++;
+         mongoc_counter_client_pools_created_inc ();
       } else {
+         if (!wait_started) {
+            wait_started = bson_get_monotonic_time ();
+            pool->waiting++;
+            mongoc_counter_client_pools_waiters_active_inc ();
+         }
+
          mongoc_cond_wait (&pool->cond, &pool->mutex);
          GOTO (again);
       }
    }
 
+   pool->pops++;
+
+   if (wait_started) {
+      wait_usec = bson_get_monotonic_time () - wait_started;
+      pool->waiting--;
+      pool->waits++;
+      pool->wait_usec += wait_usec;
+      pool->wait_max_usec = BSON_MAX (pool->wait_max_usec, wait_usec);
+      pool->wait_buckets[_mongoc_histogram_bucket (wait_usec)]++;
+   }
+
+   _update_at_max (pool);
    _start_scanner_if_needed (pool);
    bson_mutex_unlock (&pool->mutex);
 
+   if (wait_started) {
+      mongoc_counter_client_pools_waiters_active_dec ();
+      mongoc_counter_client_pools_waits_inc ();
+      mongoc_histogram_pool_wait_record (wait_usec);
+   }
+
+   mongoc_histogram_pool_checkout_record (bson_get_monotonic_time () -
+                                          started);
+
    RETURN (client);
 }
 
@@ -266,16 +345,24 @@ mongoc_client_pool_try_pop (mongoc_client_pool_t *pool)
    if (!(client = (mongoc_client_t *) _mongoc_queue_pop_head (&pool->queue))) {
       if (pool->size < pool->max_pool_size) {
          client = _mongoc_client_new_from_uri (pool->topology);
+         _mongoc_tracer_set (&client->tracer,
+                             pool->span_sample_rate,
+                             pool->span_func,
+                             pool->span_context);
 #ifdef MONGOC_ENABLE_SSL
          if (pool->ssl_opts_set) {
             mongoc_client_set_ssl_opts (client, &pool->ssl_opts);
          }
 #endif
          pool->size++;
+         pool->created++;
+         mongoc_counter_client_pools_created_inc ();
       }
    }
 
    if (client) {
+      pool->pops++;
+      _update_at_max (pool);
       _start_scanner_if_needed (pool);
    }
    bson_mutex_unlock (&pool->mutex);
@@ -302,9 +389,12 @@ mongoc_client_pool_push (mongoc_client_pool_t *pool, mongoc_client_t *client)
       if (old_client) {
          mongoc_client_destroy (old_client);
          pool->size--;
+         pool->destroyed++;
+         mongoc_counter_client_pools_destroyed_inc ();
       }
    }
 
+   _update_at_max (pool);
    mongoc_cond_signal (&pool->cond);
    bson_mutex_unlock (&pool->mutex);
 
@@ -352,6 +442,78 @@ mongoc_client_pool_num_pushed (mongoc_client_pool_t *pool)
 }
 
 
+/* the upper bound of the bucket containing quantile @q of the waits */
+static int64_t
+_wait_percentile (mongoc_client_pool_t *pool, double q)
+{
+   int64_t rank;
+   int64_t seen = 0;
+   uint32_t i;
+
+   if (!pool->waits) {
+      return 0;
+   }
+
+   rank = BSON_MIN ((int64_t) (q * (double) pool->waits), pool->waits - 1);
+
+   for (i = 0; i < MONGOC_HISTOGRAM_N_BUCKETS - 1; i++) {
+      seen += pool->wait_buckets[i];
+      if (seen > rank) {
+         /* no more than the longest wait */
+         return BSON_MIN (_mongoc_histogram_bucket_min (i + 1) - 1,
+                          pool->wait_max_usec);
+      }
+   }
+
+   return pool->wait_max_usec;
+}
+
+
+void
+mongoc_client_pool_get_stats (mongoc_client_pool_t *pool, bson_t *stats)
+{
+   int64_t at_max_usec;
+   bson_t waits;
+
+   ENTRY;
+
+   BSON_ASSERT (pool);
+   BSON_ASSERT (stats);
+
+   bson_init (stats);
+
+   bson_mutex_lock (&pool->mutex);
+
+   at_max_usec = pool->at_max_usec;
+   if (pool->at_max_since) {
+      at_max_usec += bson_get_monotonic_time () - pool->at_max_since;
+   }
+
+   BSON_APPEND_INT64 (stats, "size", (int64_t) pool->size);
+   BSON_APPEND_INT64 (stats, "maxSize", (int64_t) pool->max_pool_size);
+   BSON_APPEND_INT64 (
+      stats, "available", (int64_t) _mongoc_queue_get_length (&pool->queue));
+   BSON_APPEND_INT64 (stats, "waiting", (int64_t) pool->waiting);
+   BSON_APPEND_INT64 (stats, "pops", pool->pops);
+   BSON_APPEND_INT64 (stats, "created", pool->created);
+   BSON_APPEND_INT64 (stats, "destroyed", pool->destroyed);
+   BSON_APPEND_INT64 (stats, "atMaxMicros", at_max_usec);
+
+   BSON_APPEND_DOCUMENT_BEGIN (stats, "waits", &waits);
+   BSON_APPEND_INT64 (&waits, "count", pool->waits);
+   BSON_APPEND_INT64 (&waits, "totalMicros", pool->wait_usec);
+   BSON_APPEND_INT64 (&waits, "maxMicros", pool->wait_max_usec);
+   BSON_APPEND_INT64 (&waits, "p50Micros", _wait_percentile (pool, 0.5));
+   BSON_APPEND_INT64 (&waits, "p90Micros", _wait_percentile (pool, 0.9));
+   BSON_APPEND_INT64 (&waits, "p99Micros", _wait_percentile (pool, 0.99));
+   bson_append_document_end (stats, &waits);
+
+   bson_mutex_unlock (&pool->mutex);
+
+   EXIT;
+}
+
+
 mongoc_topology_t *
 _mongoc_client_pool_get_topology (mongoc_client_pool_t *pool)
 {
@@ -366,6 +528,7 @@ mongoc_client_pool_max_size (mongoc_client_pool_t *pool, uint32_t max_pool_size)
 
    bson_mutex_lock (&pool->mutex);
    pool->max_pool_size = max_pool_size;
+   _update_at_max (pool);
    bson_mutex_unlock (&pool->mutex);
 
    EXIT;
@@ -440,6 +603,30 @@ mongoc_client_pool_set_error_api (mongoc_client_pool_t *pool, int32_t version)
    return true;
 }
 
+bool
+mongoc_client_pool_set_span_callback (mongoc_client_pool_t *pool,
+                                      double sample_rate,
+                                      mongoc_span_func_t func,
+                                      void *context)
+{
+   bson_mutex_lock (&pool->mutex);
+
+   /* clients already popped keep the callback they were created with */
+   if (pool->size) {
+      bson_mutex_unlock (&pool->mutex);
+      MONGOC_ERROR ("Cannot set span callback after popping a client");
+      return false;
+   }
+
+   pool->span_sample_rate = sample_rate;
+   pool->span_func = func;
+   pool->span_context = context;
+
+   bson_mutex_unlock (&pool->mutex);
+
+   return true;
+}
+
 bool
 mongoc_client_pool_set_appname (mongoc_client_pool_t *pool, const char *appname)
 {
@@ -25,6 +25,7 @@
 #include "mongoc/mongoc-apm.h"
 #include "mongoc/mongoc-client.h"
 #include "mongoc/mongoc-config.h"
+#include "mongoc/mongoc-span.h"
 #ifdef MONGOC_ENABLE_SSL
 #include "mongoc/mongoc-ssl.h"
 #endif
@@ -65,8 +66,15 @@ mongoc_client_pool_set_apm_callbacks (mongoc_client_pool_t *pool,
 MONGOC_EXPORT (bool)
 mongoc_client_pool_set_error_api (mongoc_client_pool_t *pool, int32_t version);
 MONGOC_EXPORT (bool)
+mongoc_client_pool_set_span_callback (mongoc_client_pool_t *pool,
+                                      double sample_rate,
+                                      mongoc_span_func_t func,
+                                      void *context);
+MONGOC_EXPORT (bool)
 mongoc_client_pool_set_appname (mongoc_client_pool_t *pool,
                                 const char *appname);
+MONGOC_EXPORT (void)
+mongoc_client_pool_get_stats (mongoc_client_pool_t *pool, bson_t *stats);
 BSON_END_DECLS
 
 
@@ -30,6 +30,7 @@
 #include "mongoc/mongoc-read-prefs.h"
 #include "mongoc/mongoc-rpc-private.h"
 #include "mongoc/mongoc-opcode.h"
+#include "mongoc/mongoc-span-private.h"
 #ifdef MONGOC_ENABLE_SSL
 #include "mongoc/mongoc-ssl.h"
 #endif
@@ -87,6 +88,8 @@ struct _mongoc_client_t {
    mongoc_apm_callbacks_t apm_callbacks;
    void *apm_context;
 
+   mongoc_tracer_t tracer;
+
    int32_t error_api_version;
    bool error_api_set;
 
@@ -127,6 +130,31 @@ _mongoc_client_set_apm_callbacks_private (mongoc_client_t *client,
                                           mongoc_apm_callbacks_t *callbacks,
                                           void *context);
 
+/* the number of hosts whose addresses are cached for application
+ * connections */
+#define MONGOC_CLIENT_DNS_CACHE_SIZE 64
+
+void
+_mongoc_client_dns_cache_init (void);
+
+void
+_mongoc_client_dns_cache_clear (void);
+
+void
+_mongoc_client_dns_cache_cleanup (void);
+
+struct addrinfo;
+
+void
+_mongoc_client_dns_cache_add (const mongoc_host_list_t *host,
+                              const struct addrinfo *results);
+
+mongoc_stream_t *
+_mongoc_client_connect (const mongoc_uri_t *uri,
+                        const mongoc_host_list_t *host,
+                        mongoc_ssl_opt_t *ssl_opts,
+                        bson_error_t *error);
+
 mongoc_stream_t *
 mongoc_client_default_stream_initiator (const mongoc_uri_t *uri,
                                         const mongoc_host_list_t *host,
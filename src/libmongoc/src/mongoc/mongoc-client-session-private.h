@@ -45,8 +45,9 @@ struct _mongoc_session_opt_t {
 typedef struct _mongoc_server_session_t {
    struct _mongoc_server_session_t *prev, *next;
    int64_t last_used_usec;
-   bson_t lsid;        /* logical session id */
-   int64_t txn_number; /* transaction number */
+   bson_t lsid;          /* logical session id */
+   bson_t lsid_fragment; /* {"lsid": lsid}, appended to each command */
+   int64_t txn_number;   /* transaction number */
 } mongoc_server_session_t;
 
 typedef enum {
@@ -84,6 +85,14 @@ _mongoc_parse_cluster_time (const bson_t *cluster_time,
 bool
 _mongoc_cluster_time_greater (const bson_t *new, const bson_t *old);
 
+void
+_mongoc_cluster_time_fragment_init (bson_t *fragment,
+                                    const bson_t *cluster_time);
+
+void
+_mongoc_cluster_time_from_fragment (const bson_t *fragment,
+                                    bson_t *cluster_time);
+
 void
 _mongoc_client_session_handle_reply (mongoc_client_session_t *session,
                                      bool is_acknowledged,
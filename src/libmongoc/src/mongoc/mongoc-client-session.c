@@ -476,6 +476,39 @@ _mongoc_cluster_time_greater (const bson_t *new, const bson_t *old)
 }
 
 
+/* init @fragment as {"$clusterTime": @cluster_time}, encoded once to be
+ * appended to many commands. empty if @cluster_time is empty. */
+void
+_mongoc_cluster_time_fragment_init (bson_t *fragment,
+                                    const bson_t *cluster_time)
+{
+   bson_init (fragment);
+   if (!bson_empty0 (cluster_time)) {
+      bson_append_document (fragment, "$clusterTime", 12, cluster_time);
+   }
+}
+
+
+/* init @cluster_time as a read-only view of the cluster time in @fragment,
+ * valid while @fragment is, or as an empty document */
+void
+_mongoc_cluster_time_from_fragment (const bson_t *fragment,
+                                    bson_t *cluster_time)
+{
+   bson_iter_t iter;
+   const uint8_t *data;
+   uint32_t len;
+
+   if (bson_iter_init_find (&iter, fragment, "$clusterTime") &&
+       BSON_ITER_HOLDS_DOCUMENT (&iter)) {
+      bson_iter_document (&iter, &len, &data);
+      BSON_ASSERT (bson_init_static (cluster_time, data, (size_t) len));
+   } else {
+      bson_init (cluster_time);
+   }
+}
+
+
 void
 _mongoc_client_session_handle_reply (mongoc_client_session_t *session,
                                      bool is_acknowledged,
@@ -529,6 +562,8 @@ _mongoc_server_session_new (bson_error_t *error)
    bson_init (&s->lsid);
    bson_append_binary (
       &s->lsid, "id", 2, BSON_SUBTYPE_UUID, uuid_data, sizeof uuid_data);
+   bson_init (&s->lsid_fragment);
+   bson_append_document (&s->lsid_fragment, "lsid", 4, &s->lsid);
 
    /* transaction number is a positive integer and will be incremented before
     * each use, so ensure it is initialized to zero. */
@@ -571,6 +606,7 @@ _mongoc_server_session_destroy (mongoc_server_session_t *server_session)
    ENTRY;
 
    bson_destroy (&server_session->lsid);
+   bson_destroy (&server_session->lsid_fragment);
    bson_free (server_session);
 
    EXIT;
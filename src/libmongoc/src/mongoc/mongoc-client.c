@@ -43,7 +43,8 @@
 #include "mongoc/mongoc-error.h"
 #include "mongoc/mongoc-log.h"
 #include "mongoc/mongoc-queue-private.h"
-#include "mongoc/mongoc-socket.h"
+#include "mongoc/mongoc-socket-private.h"
+#include "mongoc/mongoc-errno-private.h"
 #include "mongoc/mongoc-stream-buffered.h"
 #include "mongoc/mongoc-stream-socket.h"
 #include "mongoc/mongoc-thread-private.h"
@@ -59,6 +60,7 @@
 #include "mongoc/mongoc-change-stream-private.h"
 #include "mongoc/mongoc-client-session-private.h"
 #include "mongoc/mongoc-cursor-private.h"
+#include "mongoc/mongoc-topology-scanner-private.h"
 
 #ifdef MONGOC_ENABLE_SSL
 #include "mongoc/mongoc-stream-tls.h"
@@ -507,6 +509,321 @@ _mongoc_client_get_rr (const char *service,
 
 #undef DNS_ERROR
 
+/* one address from getaddrinfo, copied so it outlives freeaddrinfo */
+typedef struct {
+   struct sockaddr_storage addr;
+   mongoc_socklen_t addrlen;
+   int family;
+   int socktype;
+   int protocol;
+} mongoc_client_addr_t;
+
+typedef struct {
+   char *host_and_port;
+   int family;
+   mongoc_client_addr_t *addrs;
+   size_t n_addrs;
+   int64_t expire_at;
+} mongoc_client_dns_cache_entry_t;
+
+/* resolved addresses for application connections, shared by all clients.
+ * the topology scanner keeps its own results per node. */
+static mongoc_client_dns_cache_entry_t gDNSCache[MONGOC_CLIENT_DNS_CACHE_SIZE];
+static size_t gDNSCacheNext;
+static bson_mutex_t gDNSCacheMutex;
+
+
+static void
+_mongoc_client_dns_cache_entry_clear (mongoc_client_dns_cache_entry_t *entry)
+{
+   bson_free (entry->host_and_port);
+   bson_free (entry->addrs);
+   memset (entry, 0, sizeof *entry);
+}
+
+
+void
+_mongoc_client_dns_cache_init (void)
+{
+   memset (gDNSCache, 0, sizeof gDNSCache);
+   gDNSCacheNext = 0;
+   bson_mutex_init (&gDNSCacheMutex);
+}
+
+
+void
+_mongoc_client_dns_cache_clear (void)
+{
+   size_t i;
+
+   bson_mutex_lock (&gDNSCacheMutex);
+   for (i = 0; i < MONGOC_CLIENT_DNS_CACHE_SIZE; i++) {
+      _mongoc_client_dns_cache_entry_clear (&gDNSCache[i]);
+   }
+   gDNSCacheNext = 0;
+   bson_mutex_unlock (&gDNSCacheMutex);
+}
+
+
+void
+_mongoc_client_dns_cache_cleanup (void)
+{
+   _mongoc_client_dns_cache_clear ();
+   bson_mutex_destroy (&gDNSCacheMutex);
+}
+
+
+/* must hold gDNSCacheMutex */
+static mongoc_client_dns_cache_entry_t *
+_mongoc_client_dns_cache_find (const mongoc_host_list_t *host)
+{
+   size_t i;
+
+   for (i = 0; i < MONGOC_CLIENT_DNS_CACHE_SIZE; i++) {
+      if (gDNSCache[i].host_and_port && gDNSCache[i].family == host->family &&
+          !strcasecmp (gDNSCache[i].host_and_port, host->host_and_port)) {
+         return &gDNSCache[i];
+      }
+   }
+
+   return NULL;
+}
+
+
+/* copy @host's cached addresses into a new array, or return NULL if they
+ * aren't cached or have expired */
+static mongoc_client_addr_t *
+_mongoc_client_dns_cache_get (const mongoc_host_list_t *host, size_t *n_addrs)
+{
+   mongoc_client_dns_cache_entry_t *entry;
+   mongoc_client_addr_t *addrs = NULL;
+
+   bson_mutex_lock (&gDNSCacheMutex);
+   entry = _mongoc_client_dns_cache_find (host);
+   if (entry && entry->expire_at <= bson_get_monotonic_time ()) {
+      _mongoc_client_dns_cache_entry_clear (entry);
+   } else if (entry) {
+      addrs = bson_malloc (entry->n_addrs * sizeof *addrs);
+      memcpy (addrs, entry->addrs, entry->n_addrs * sizeof *addrs);
+      *n_addrs = entry->n_addrs;
+   }
+   bson_mutex_unlock (&gDNSCacheMutex);
+
+   return addrs;
+}
+
+
+static void
+_mongoc_client_dns_cache_put (const mongoc_host_list_t *host,
+                              const mongoc_client_addr_t *addrs,
+                              size_t n_addrs)
+{
+   mongoc_client_dns_cache_entry_t *entry;
+
+   bson_mutex_lock (&gDNSCacheMutex);
+   entry = _mongoc_client_dns_cache_find (host);
+   if (!entry) {
+      /* replace the oldest entry */
+      entry = &gDNSCache[gDNSCacheNext];
+      gDNSCacheNext = (gDNSCacheNext + 1) % MONGOC_CLIENT_DNS_CACHE_SIZE;
+   }
+
+   _mongoc_client_dns_cache_entry_clear (entry);
+   entry->host_and_port = bson_strdup (host->host_and_port);
+   entry->family = host->family;
+   entry->addrs = bson_malloc (n_addrs * sizeof *addrs);
+   memcpy (entry->addrs, addrs, n_addrs * sizeof *addrs);
+   entry->n_addrs = n_addrs;
+   entry->expire_at =
+      bson_get_monotonic_time () + MONGOC_DNS_CACHE_TIMEOUT_MS * 1000L;
+   bson_mutex_unlock (&gDNSCacheMutex);
+}
+
+
+static void
+_mongoc_client_dns_cache_remove (const mongoc_host_list_t *host)
+{
+   mongoc_client_dns_cache_entry_t *entry;
+
+   bson_mutex_lock (&gDNSCacheMutex);
+   entry = _mongoc_client_dns_cache_find (host);
+   if (entry) {
+      _mongoc_client_dns_cache_entry_clear (entry);
+   }
+   bson_mutex_unlock (&gDNSCacheMutex);
+}
+
+
+static mongoc_client_addr_t *
+_mongoc_client_addrs_from_addrinfo (const struct addrinfo *results,
+                                    size_t *n_addrs)
+{
+   const struct addrinfo *rp;
+   mongoc_client_addr_t *addrs;
+   size_t n = 0;
+
+   for (rp = results; rp; rp = rp->ai_next) {
+      n++;
+   }
+
+   addrs = bson_malloc0 (BSON_MAX (n, 1) * sizeof *addrs);
+   n = 0;
+   for (rp = results; rp; rp = rp->ai_next) {
+      if (rp->ai_addrlen > sizeof addrs[n].addr) {
+         continue;
+      }
+
+      memcpy (&addrs[n].addr, rp->ai_addr, rp->ai_addrlen);
+      addrs[n].addrlen = (mongoc_socklen_t) rp->ai_addrlen;
+      addrs[n].family = rp->ai_family;
+      addrs[n].socktype = rp->ai_socktype;
+      addrs[n].protocol = rp->ai_protocol;
+      n++;
+   }
+
+   *n_addrs = n;
+   return addrs;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_client_dns_cache_add --
+ *
+ *       Cache @results for @host as though they had been resolved by
+ *       getaddrinfo, replacing any cached addresses for @host. For tests.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_client_dns_cache_add (const mongoc_host_list_t *host,
+                              const struct addrinfo *results)
+{
+   mongoc_client_addr_t *addrs;
+   size_t n_addrs;
+
+   addrs = _mongoc_client_addrs_from_addrinfo (results, &n_addrs);
+   _mongoc_client_dns_cache_put (host, addrs, n_addrs);
+   bson_free (addrs);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_client_connect_happy_eyeballs --
+ *
+ *       Race non-blocking connections to @addrs, starting the next address
+ *       every MONGOC_HAPPY_EYEBALLS_DELAY_MS, or as soon as every attempt
+ *       so far has failed. The first connection established wins, the rest
+ *       are closed. This way an unreachable address costs a short delay
+ *       instead of a full connectTimeoutMS.
+ *
+ * Returns:
+ *       A connected socket, or NULL if no address could be connected to
+ *       before @connecttimeoutms.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static mongoc_socket_t *
+_mongoc_client_connect_happy_eyeballs (const mongoc_client_addr_t *addrs,
+                                       size_t n_addrs,
+                                       int32_t connecttimeoutms)
+{
+   mongoc_socket_poll_t *pending;
+   size_t n_pending = 0;
+   size_t next = 0;
+   size_t i;
+   mongoc_socket_t *sock;
+   mongoc_socket_t *winner = NULL;
+   int64_t now;
+   int64_t expire_at;
+   int64_t next_start_at;
+   int64_t wait_until;
+
+   ENTRY;
+
+   if (n_addrs == 0) {
+      RETURN (NULL);
+   }
+
+   pending = bson_malloc0 (n_addrs * sizeof *pending);
+   now = bson_get_monotonic_time ();
+   expire_at = now + (connecttimeoutms * 1000L);
+   next_start_at = now;
+
+   while (!winner && now < expire_at) {
+      if (next < n_addrs && (now >= next_start_at || n_pending == 0)) {
+         sock = mongoc_socket_new (
+            addrs[next].family, addrs[next].socktype, addrs[next].protocol);
+
+         if (!sock) {
+            /* try the next address */
+         } else if (0 == mongoc_socket_connect (
+                            sock,
+                            (const struct sockaddr *) &addrs[next].addr,
+                            addrs[next].addrlen,
+                            0)) {
+            winner = sock;
+         } else if (MONGOC_ERRNO_IS_AGAIN (mongoc_socket_errno (sock))) {
+            pending[n_pending].socket = sock;
+            pending[n_pending].events = POLLOUT;
+            pending[n_pending].revents = 0;
+            n_pending++;
+         } else {
+            mongoc_socket_destroy (sock);
+         }
+
+         next++;
+         next_start_at = now + MONGOC_HAPPY_EYEBALLS_DELAY_MS * 1000L;
+         now = bson_get_monotonic_time ();
+         continue;
+      }
+
+      if (n_pending == 0) {
+         /* every address failed */
+         break;
+      }
+
+      wait_until =
+         next < n_addrs ? BSON_MIN (next_start_at, expire_at) : expire_at;
+      if (mongoc_socket_poll (
+             pending, n_pending, (int32_t) ((wait_until - now) / 1000L)) < 0) {
+         break;
+      }
+
+      for (i = 0; i < n_pending;) {
+         if (!pending[i].revents) {
+            i++;
+            continue;
+         }
+
+         sock = pending[i].socket;
+         pending[i] = pending[--n_pending];
+
+         if (!winner && 0 == _mongoc_socket_connect_finish (sock)) {
+            winner = sock;
+         } else {
+            mongoc_socket_destroy (sock);
+         }
+      }
+
+      now = bson_get_monotonic_time ();
+   }
+
+   for (i = 0; i < n_pending; i++) {
+      mongoc_socket_destroy (pending[i].socket);
+   }
+
+   bson_free (pending);
+
+   RETURN (winner);
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -515,7 +832,11 @@ _mongoc_client_get_rr (const char *service,
  *       Connect to a host using a TCP socket.
  *
  *       This will be performed synchronously and return a mongoc_stream_t
- *       that can be used to connect with the remote host.
+ *       that can be used to connect with the remote host. The host's
+ *       addresses are raced as described in
+ *       _mongoc_client_connect_happy_eyeballs. They are cached for
+ *       MONGOC_DNS_CACHE_TIMEOUT_MS so reconnecting skips the resolver,
+ *       unless no cached address can be connected to.
  *
  * Returns:
  *       A newly allocated mongoc_stream_t if successful; otherwise
@@ -534,9 +855,10 @@ mongoc_client_connect_tcp (const mongoc_uri_t *uri,
 {
    mongoc_socket_t *sock = NULL;
    struct addrinfo hints;
-   struct addrinfo *result, *rp;
+   struct addrinfo *result;
+   mongoc_client_addr_t *addrs;
+   size_t n_addrs = 0;
    int32_t connecttimeoutms;
-   int64_t expire_at;
    char portstr[8];
    int s;
 
@@ -550,68 +872,57 @@ mongoc_client_connect_tcp (const mongoc_uri_t *uri,
 
    BSON_ASSERT (connecttimeoutms);
 
-   bson_snprintf (portstr, sizeof portstr, "%hu", host->port);
-
-   memset (&hints, 0, sizeof hints);
-   hints.ai_family = host->family;
-   hints.ai_socktype = SOCK_STREAM;
-   hints.ai_flags = 0;
-   hints.ai_protocol = 0;
-
-   s = getaddrinfo (host->host, portstr, &hints, &result);
+   addrs = _mongoc_client_dns_cache_get (host, &n_addrs);
+   if (addrs) {
+      mongoc_counter_dns_cache_hit_inc ();
+   } else {
+      bson_snprintf (portstr, sizeof portstr, "%hu", host->port);
 
-   if (s != 0) {
-      mongoc_counter_dns_failure_inc ();
-      bson_set_error (error,
-                      MONGOC_ERROR_STREAM,
-                      MONGOC_ERROR_STREAM_NAME_RESOLUTION,
-                      "Failed to resolve %s",
-                      host->host);
-      RETURN (NULL);
-   }
+      memset (&hints, 0, sizeof hints);
+      hints.ai_family = host->family;
+      hints.ai_socktype = SOCK_STREAM;
+      hints.ai_flags = 0;
+      hints.ai_protocol = 0;
 
-   mongoc_counter_dns_success_inc ();
+      s = getaddrinfo (host->host, portstr, &hints, &result);
 
-   for (rp = result; rp; rp = rp->ai_next) {
-      /*
-       * Create a new non-blocking socket.
-       */
-      if (!(sock = mongoc_socket_new (
-               rp->ai_family, rp->ai_socktype, rp->ai_protocol))) {
-         continue;
+      if (s != 0) {
+         mongoc_counter_dns_failure_inc ();
+         bson_set_error (error,
+                         MONGOC_ERROR_STREAM,
+                         MONGOC_ERROR_STREAM_NAME_RESOLUTION,
+                         "Failed to resolve %s",
+                         host->host);
+         RETURN (NULL);
       }
 
-      /*
-       * Try to connect to the peer.
-       */
-      expire_at = bson_get_monotonic_time () + (connecttimeoutms * 1000L);
-      if (0 !=
-          mongoc_socket_connect (
-             sock, rp->ai_addr, (mongoc_socklen_t) rp->ai_addrlen, expire_at)) {
-         mongoc_socket_destroy (sock);
-         sock = NULL;
-         continue;
-      }
+      mongoc_counter_dns_success_inc ();
 
-      break;
+      addrs = _mongoc_client_addrs_from_addrinfo (result, &n_addrs);
+      freeaddrinfo (result);
+      _mongoc_client_dns_cache_put (host, addrs, n_addrs);
    }
 
+   sock =
+      _mongoc_client_connect_happy_eyeballs (addrs, n_addrs, connecttimeoutms);
+   bson_free (addrs);
+
    if (!sock) {
+      /* resolve again next time, the host's addresses may have changed */
+      _mongoc_client_dns_cache_remove (host);
       bson_set_error (error,
                       MONGOC_ERROR_STREAM,
                       MONGOC_ERROR_STREAM_CONNECT,
                       "Failed to connect to target host: %s",
                       host->host_and_port);
-      freeaddrinfo (result);
       RETURN (NULL);
    }
 
-   freeaddrinfo (result);
-
-   return mongoc_stream_socket_new (sock);
+   RETURN (mongoc_stream_socket_new (sock));
 }
 
 
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -685,33 +996,27 @@ mongoc_client_connect_unix (const mongoc_uri_t *uri,
 /*
  *--------------------------------------------------------------------------
  *
- * mongoc_client_default_stream_initiator --
+ * _mongoc_client_connect --
  *
- *       A mongoc_stream_initiator_t that will handle the various type
- *       of supported sockets by MongoDB including TCP and UNIX.
- *
- *       Language binding authors may want to implement an alternate
- *       version of this method to use their native stream format.
+ *       Connect to @host with a TCP or UNIX domain socket and, if
+ *       @ssl_opts is not NULL, complete a TLS handshake. Blocks for up to
+ *       the URI's connectTimeoutMS.
  *
  * Returns:
- *       A mongoc_stream_t if successful; otherwise NULL and @error is set.
- *
- * Side effects:
- *       @error is set if return value is NULL.
+ *       An unbuffered mongoc_stream_t if successful; otherwise NULL and
+ *       @error is set.
  *
  *--------------------------------------------------------------------------
  */
 
 mongoc_stream_t *
-mongoc_client_default_stream_initiator (const mongoc_uri_t *uri,
-                                        const mongoc_host_list_t *host,
-                                        void *user_data,
-                                        bson_error_t *error)
+_mongoc_client_connect (const mongoc_uri_t *uri,
+                        const mongoc_host_list_t *host,
+                        mongoc_ssl_opt_t *ssl_opts,
+                        bson_error_t *error)
 {
    mongoc_stream_t *base_stream = NULL;
 #ifdef MONGOC_ENABLE_SSL
-   mongoc_client_t *client = (mongoc_client_t *) user_data;
-   const char *mechanism;
    int32_t connecttimeoutms;
 #endif
 
@@ -719,7 +1024,7 @@ mongoc_client_default_stream_initiator (const mongoc_uri_t *uri,
    BSON_ASSERT (host);
 
 #ifndef MONGOC_ENABLE_SSL
-   if (mongoc_uri_get_ssl (uri)) {
+   if (ssl_opts || mongoc_uri_get_ssl (uri)) {
       bson_set_error (error,
                       MONGOC_ERROR_CLIENT,
                       MONGOC_ERROR_CLIENT_NO_ACCEPTABLE_PEER,
@@ -750,37 +1055,78 @@ mongoc_client_default_stream_initiator (const mongoc_uri_t *uri,
    }
 
 #ifdef MONGOC_ENABLE_SSL
-   if (base_stream) {
-      mechanism = mongoc_uri_get_auth_mechanism (uri);
-
-      if (client->use_ssl ||
-          (mechanism && (0 == strcmp (mechanism, "MONGODB-X509")))) {
-         mongoc_stream_t *original = base_stream;
-
-         base_stream = mongoc_stream_tls_new_with_hostname (
-            base_stream, host->host, &client->ssl_opts, true);
-
-         if (!base_stream) {
-            mongoc_stream_destroy (original);
-            bson_set_error (error,
-                            MONGOC_ERROR_STREAM,
-                            MONGOC_ERROR_STREAM_SOCKET,
-                            "Failed initialize TLS state.");
-            return NULL;
-         }
+   if (base_stream && ssl_opts) {
+      mongoc_stream_t *original = base_stream;
 
-         connecttimeoutms = mongoc_uri_get_option_as_int32 (
-            uri, MONGOC_URI_CONNECTTIMEOUTMS, MONGOC_DEFAULT_CONNECTTIMEOUTMS);
+      base_stream = mongoc_stream_tls_new_with_hostname (
+         base_stream, host->host, ssl_opts, true);
 
-         if (!mongoc_stream_tls_handshake_block (
-                base_stream, host->host, connecttimeoutms, error)) {
-            mongoc_stream_destroy (base_stream);
-            return NULL;
-         }
+      if (!base_stream) {
+         mongoc_stream_destroy (original);
+         bson_set_error (error,
+                         MONGOC_ERROR_STREAM,
+                         MONGOC_ERROR_STREAM_SOCKET,
+                         "Failed initialize TLS state.");
+         return NULL;
+      }
+
+      connecttimeoutms = mongoc_uri_get_option_as_int32 (
+         uri, MONGOC_URI_CONNECTTIMEOUTMS, MONGOC_DEFAULT_CONNECTTIMEOUTMS);
+
+      if (!mongoc_stream_tls_handshake_block (
+             base_stream, host->host, connecttimeoutms, error)) {
+         mongoc_stream_destroy (base_stream);
+         return NULL;
       }
    }
 #endif
 
+   return base_stream;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_client_default_stream_initiator --
+ *
+ *       A mongoc_stream_initiator_t that will handle the various type
+ *       of supported sockets by MongoDB including TCP and UNIX.
+ *
+ *       Language binding authors may want to implement an alternate
+ *       version of this method to use their native stream format.
+ *
+ * Returns:
+ *       A mongoc_stream_t if successful; otherwise NULL and @error is set.
+ *
+ * Side effects:
+ *       @error is set if return value is NULL.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_stream_t *
+mongoc_client_default_stream_initiator (const mongoc_uri_t *uri,
+                                        const mongoc_host_list_t *host,
+                                        void *user_data,
+                                        bson_error_t *error)
+{
+   mongoc_stream_t *base_stream;
+   mongoc_ssl_opt_t *ssl_opts = NULL;
+#ifdef MONGOC_ENABLE_SSL
+   mongoc_client_t *client = (mongoc_client_t *) user_data;
+   const char *mechanism;
+
+   mechanism = mongoc_uri_get_auth_mechanism (uri);
+
+   if (client->use_ssl ||
+       (mechanism && (0 == strcmp (mechanism, "MONGODB-X509")))) {
+      ssl_opts = &client->ssl_opts;
+   }
+#endif
+
+   base_stream = _mongoc_client_connect (uri, host, ssl_opts, error);
+
    return base_stream ? mongoc_stream_buffered_new (base_stream, 1024) : NULL;
 }
 
@@ -1147,10 +1493,14 @@ mongoc_client_start_session (mongoc_client_t *client,
    mongoc_server_session_t *ss;
    mongoc_client_session_t *cs;
    uint32_t csid;
+   int64_t started;
 
    ENTRY;
 
+   started = _mongoc_tracer_phase_begin (&client->tracer);
    ss = _mongoc_client_pop_server_session (client, error);
+   _mongoc_tracer_phase_end (
+      &client->tracer, MONGOC_SPAN_PHASE_SESSION_POP, started);
    if (!ss) {
       RETURN (NULL);
    }
@@ -1719,7 +2069,7 @@ _mongoc_client_command_with_opts (mongoc_client_t *client,
    const mongoc_read_prefs_t *prefs = COALESCE (user_prefs, default_prefs);
    mongoc_server_stream_t *server_stream = NULL;
    mongoc_cluster_t *cluster;
-   mongoc_client_session *session_lookup;
+   mongoc_client_session_t *session_lookup;
    mongoc_client_session_t *cs;
    bson_t reply_local;
    bson_t *reply_ptr;
@@ -1749,7 +2099,7 @@ _mongoc_client_command_with_opts (mongoc_client_t *client,
    cs = read_write_opts.client_session;
 
    /* Don't permit clients to use client sessions that we don't know about */
-   if (!_mongoc_client_lookup_session (client, cs->client_session_id, &session_lookup, error)) {
+   if (cs && !_mongoc_client_lookup_session (client, cs->client_session_id, &session_lookup, error)) {
       GOTO (done);
    }
 
@@ -2556,6 +2906,36 @@ mongoc_client_set_apm_callbacks (mongoc_client_t *client,
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_client_set_span_callback --
+ *
+ *       Record the phases of a fraction @sample_rate of the client's
+ *       operations and pass each operation's span to @func. A NULL @func
+ *       or a @sample_rate of 0 stops recording.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_client_set_span_callback (mongoc_client_t *client,
+                                 double sample_rate,
+                                 mongoc_span_func_t func,
+                                 void *context)
+{
+   if (!client->topology->single_threaded) {
+      MONGOC_ERROR ("Cannot set a span callback on a pooled client, use "
+                    "mongoc_client_pool_set_span_callback");
+      return false;
+   }
+
+   _mongoc_tracer_set (&client->tracer, sample_rate, func, context);
+
+   return true;
+}
+
+
 mongoc_server_description_t *
 mongoc_client_get_server_description (mongoc_client_t *client,
                                       uint32_t server_id)
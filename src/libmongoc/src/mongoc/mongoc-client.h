@@ -38,6 +38,7 @@
 #include "mongoc/mongoc-write-concern.h"
 #include "mongoc/mongoc-read-concern.h"
 #include "mongoc/mongoc-server-description.h"
+#include "mongoc/mongoc-span.h"
 
 BSON_BEGIN_DECLS
 
@@ -236,6 +237,11 @@ MONGOC_EXPORT (bool)
 mongoc_client_set_apm_callbacks (mongoc_client_t *client,
                                  mongoc_apm_callbacks_t *callbacks,
                                  void *context);
+MONGOC_EXPORT (bool)
+mongoc_client_set_span_callback (mongoc_client_t *client,
+                                 double sample_rate,
+                                 mongoc_span_func_t func,
+                                 void *context);
 MONGOC_EXPORT (mongoc_server_description_t *)
 mongoc_client_get_server_description (mongoc_client_t *client,
                                       uint32_t server_id);
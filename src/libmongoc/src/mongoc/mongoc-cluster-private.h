@@ -30,6 +30,7 @@
 #include "mongoc/mongoc-rpc-private.h"
 #include "mongoc/mongoc-server-stream-private.h"
 #include "mongoc/mongoc-set-private.h"
+#include "mongoc/mongoc-span.h"
 #include "mongoc/mongoc-stream.h"
 #include "mongoc/mongoc-topology-private.h"
 #include "mongoc/mongoc-topology-description-private.h"
@@ -53,6 +54,15 @@ typedef struct _mongoc_cluster_node_t {
    int64_t timestamp;
 } mongoc_cluster_node_t;
 
+/* a command written with mongoc_cluster_send_command_monitored whose reply
+ * has not yet been read */
+typedef struct _mongoc_cluster_pending_cmd_t {
+   uint32_t request_id;
+   int64_t started;
+   int64_t sent; /* when writing it finished, the wait for its reply began */
+   int64_t send_duration;
+} mongoc_cluster_pending_cmd_t;
+
 typedef struct _mongoc_cluster_t {
    int64_t operation_id;
    uint32_t request_id;
@@ -67,6 +77,10 @@ typedef struct _mongoc_cluster_t {
    mongoc_array_t iov;
 
    mongoc_scram_cache_t *scram_cache;
+
+   /* the time the command in progress has spent writing, waiting, and
+    * reading, for its APM events. only the wire phases are set */
+   int64_t phase_duration[MONGOC_SPAN_PHASE_COUNT];
 } mongoc_cluster_t;
 
 
@@ -148,6 +162,27 @@ mongoc_cluster_run_command_monitored (mongoc_cluster_t *cluster,
                                       bson_t *reply,
                                       bson_error_t *error);
 
+bool
+mongoc_cluster_send_command_monitored (mongoc_cluster_t *cluster,
+                                       mongoc_cmd_t *cmd,
+                                       mongoc_cluster_pending_cmd_t *pending,
+                                       bson_error_t *error);
+
+bool
+mongoc_cluster_recv_command_monitored (
+   mongoc_cluster_t *cluster,
+   mongoc_cmd_t *cmd,
+   const mongoc_cluster_pending_cmd_t *pending,
+   bson_t *reply,
+   bson_error_t *error);
+
+void
+mongoc_cluster_fail_pending_monitored (
+   mongoc_cluster_t *cluster,
+   mongoc_cmd_t *cmd,
+   const mongoc_cluster_pending_cmd_t *pending,
+   const bson_error_t *error);
+
 bool
 mongoc_cluster_run_command_parts (mongoc_cluster_t *cluster,
                                   mongoc_server_stream_t *server_stream,
@@ -181,6 +216,27 @@ _mongoc_cluster_create_server_stream (mongoc_topology_t *topology,
                                       uint32_t server_id,
                                       mongoc_stream_t *stream,
                                       bson_error_t *error /* OUT */);
+
+#ifdef MONGOC_ENABLE_CRYPTO
+void
+_mongoc_cluster_init_scram (const mongoc_uri_t *uri,
+                            mongoc_scram_t *scram,
+                            mongoc_crypto_hash_algorithm_t algo);
+
+bool
+_mongoc_cluster_get_auth_cmd_scram (mongoc_crypto_hash_algorithm_t algo,
+                                    mongoc_scram_t *scram,
+                                    bson_t *cmd /* OUT */,
+                                    bson_error_t *error /* OUT */);
+
+bool
+_mongoc_cluster_auth_scram_continue (mongoc_cluster_t *cluster,
+                                     mongoc_stream_t *stream,
+                                     mongoc_server_description_t *sd,
+                                     mongoc_scram_t *scram,
+                                     const bson_t *sasl_start_reply,
+                                     bson_error_t *error);
+#endif
 BSON_END_DECLS
 
 
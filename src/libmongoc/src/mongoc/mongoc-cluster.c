@@ -98,6 +98,24 @@ mongoc_cluster_run_opmsg (mongoc_cluster_t *cluster,
                           bson_t *reply,
                           bson_error_t *error);
 
+static bool
+_mongoc_cluster_send_opmsg (mongoc_cluster_t *cluster,
+                            mongoc_cmd_t *cmd,
+                            bson_t *reply,
+                            bson_error_t *error);
+
+static bool
+_mongoc_cluster_recv_opmsg (mongoc_cluster_t *cluster,
+                            mongoc_cmd_t *cmd,
+                            int64_t sent,
+                            bson_t *reply,
+                            bson_error_t *error);
+
+static void
+_mongoc_cluster_phase_end (mongoc_cluster_t *cluster,
+                           mongoc_span_phase_t phase,
+                           int64_t started);
+
 static void
 _bson_error_message_printf (bson_error_t *error, const char *format, ...)
    BSON_GNUC_PRINTF (2, 3);
@@ -156,6 +174,19 @@ _bson_error_message_printf (bson_error_t *error, const char *format, ...)
    }
 }
 
+/* if a read failed because the stream timed out, count it for the server */
+static bool
+_mongoc_cluster_stream_timed_out (mongoc_stream_t *stream,
+                                  const mongoc_server_description_t *sd)
+{
+   if (mongoc_stream_timed_out (stream)) {
+      _mongoc_counters_record_timeout (sd->host.host_and_port);
+      return true;
+   }
+
+   return false;
+}
+
 #define RUN_CMD_ERR_DECORATE                                       \
    do {                                                            \
       _bson_error_message_printf (                                 \
@@ -212,6 +243,8 @@ mongoc_cluster_run_command_opquery (mongoc_cluster_t *cluster,
    bool ret = false;
    char *output = NULL;
    uint32_t server_id;
+   bool ok;
+   int64_t started;
 
    ENTRY;
 
@@ -265,11 +298,14 @@ mongoc_cluster_run_command_opquery (mongoc_cluster_t *cluster,
    /*
     * send and receive
     */
-   if (!_mongoc_stream_writev_full (stream,
+   started = bson_get_monotonic_time ();
+   ok = _mongoc_stream_writev_full (stream,
                                     cluster->iov.data,
                                     cluster->iov.len,
                                     cluster->sockettimeoutms,
-                                    error)) {
+                                    error);
+   _mongoc_cluster_phase_end (cluster, MONGOC_SPAN_PHASE_SEND, started);
+   if (!ok) {
       mongoc_cluster_disconnect_node (cluster, server_id, true, error);
 
       /* add info about the command to writev_full's error message */
@@ -277,17 +313,23 @@ mongoc_cluster_run_command_opquery (mongoc_cluster_t *cluster,
       GOTO (done);
    }
 
-   if (reply_header_size != mongoc_stream_read (stream,
-                                                &reply_header_buf,
-                                                reply_header_size,
-                                                reply_header_size,
-                                                cluster->sockettimeoutms)) {
+   started = bson_get_monotonic_time ();
+   ok = reply_header_size == mongoc_stream_read (stream,
+                                                 &reply_header_buf,
+                                                 reply_header_size,
+                                                 reply_header_size,
+                                                 cluster->sockettimeoutms);
+   _mongoc_cluster_phase_end (cluster, MONGOC_SPAN_PHASE_WAIT, started);
+   if (!ok) {
       RUN_CMD_ERR (MONGOC_ERROR_STREAM,
                    MONGOC_ERROR_STREAM_SOCKET,
                    "socket error or timeout");
 
       mongoc_cluster_disconnect_node (
-         cluster, server_id, !mongoc_stream_timed_out (stream), error);
+         cluster,
+         server_id,
+         !_mongoc_cluster_stream_timed_out (stream, cmd->server_stream->sd),
+         error);
       GOTO (done);
    }
 
@@ -315,11 +357,15 @@ mongoc_cluster_run_command_opquery (mongoc_cluster_t *cluster,
       reply_buf = bson_malloc0 (msg_len);
       memcpy (reply_buf, reply_header_buf, reply_header_size);
 
-      if (doc_len != mongoc_stream_read (stream,
-                                         reply_buf + reply_header_size,
-                                         doc_len,
-                                         doc_len,
-                                         cluster->sockettimeoutms)) {
+      started = bson_get_monotonic_time ();
+      ok = doc_len == mongoc_stream_read (stream,
+                                          reply_buf + reply_header_size,
+                                          doc_len,
+                                          doc_len,
+                                          cluster->sockettimeoutms);
+      _mongoc_cluster_phase_end (
+         cluster, MONGOC_SPAN_PHASE_RECEIVE, started);
+      if (!ok) {
          RUN_CMD_ERR (MONGOC_ERROR_STREAM,
                       MONGOC_ERROR_STREAM_SOCKET,
                       "socket error or timeout");
@@ -331,7 +377,11 @@ mongoc_cluster_run_command_opquery (mongoc_cluster_t *cluster,
       }
 
       buf = bson_malloc0 (len);
-      if (!_mongoc_rpc_decompress (&rpc, buf, len)) {
+      started = bson_get_monotonic_time ();
+      ok = _mongoc_rpc_decompress (&rpc, buf, len);
+      _mongoc_cluster_phase_end (
+         cluster, MONGOC_SPAN_PHASE_DECOMPRESS, started);
+      if (!ok) {
          RUN_CMD_ERR (MONGOC_ERROR_PROTOCOL,
                       MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
                       "Could not decompress server reply");
@@ -358,11 +408,15 @@ mongoc_cluster_run_command_opquery (mongoc_cluster_t *cluster,
       reply_buf = bson_reserve_buffer (reply_ptr, (uint32_t) doc_len);
       BSON_ASSERT (reply_buf);
 
-      if (doc_len != mongoc_stream_read (stream,
-                                         (void *) reply_buf,
-                                         doc_len,
-                                         doc_len,
-                                         cluster->sockettimeoutms)) {
+      started = bson_get_monotonic_time ();
+      ok = doc_len == mongoc_stream_read (stream,
+                                          (void *) reply_buf,
+                                          doc_len,
+                                          doc_len,
+                                          cluster->sockettimeoutms);
+      _mongoc_cluster_phase_end (
+         cluster, MONGOC_SPAN_PHASE_RECEIVE, started);
+      if (!ok) {
          RUN_CMD_ERR (MONGOC_ERROR_STREAM,
                       MONGOC_ERROR_STREAM_SOCKET,
                       "socket error or timeout");
@@ -374,8 +428,11 @@ mongoc_cluster_run_command_opquery (mongoc_cluster_t *cluster,
       GOTO (done);
    }
 
-   if (!_mongoc_cmd_check_ok (
-          reply_ptr, cluster->client->error_api_version, error)) {
+   started = bson_get_monotonic_time ();
+   ok = _mongoc_cmd_check_ok (
+      reply_ptr, cluster->client->error_api_version, error);
+   _mongoc_cluster_phase_end (cluster, MONGOC_SPAN_PHASE_PARSE, started);
+   if (!ok) {
       GOTO (done);
    }
 
@@ -479,8 +536,9 @@ handle_not_master_error (mongoc_cluster_t *cluster,
       } else {
          /* SDAM Spec: "Multi-threaded and asynchronous clients MUST request an
           * immediate check of the server."
-          * Instead of requesting a check of the one server, request a scan
-          * to all servers (to find the new primary). */
+          * Check it and the secondaries at once, to find the new primary
+          * quickly, then scan all servers after minHeartbeatFrequencyMS. */
+         _mongoc_topology_request_probe (topology, server_id);
          _mongoc_topology_request_scan (topology);
       }
    }
@@ -489,52 +547,64 @@ handle_not_master_error (mongoc_cluster_t *cluster,
 /*
  *--------------------------------------------------------------------------
  *
- * mongoc_cluster_run_command_monitored --
+ * _mongoc_cluster_phase_end --
  *
- *       Internal function to run a command on a given stream.
- *       @error and @reply are optional out-pointers.
- *
- * Returns:
- *       true if successful; otherwise false and @error is set.
- *
- * Side effects:
- *       If the client's APM callbacks are set, they are executed.
- *       @reply is set and should ALWAYS be released with bson_destroy().
+ *       Record the time since @started in one of the wire phases of the
+ *       command in progress: writing it, waiting for the reply's first
+ *       bytes, reading the rest, decompressing, or parsing. The time is
+ *       reported in the command's APM events, its span if sampled, and
+ *       the phase's latency histogram.
  *
  *--------------------------------------------------------------------------
  */
 
-bool
-mongoc_cluster_run_command_monitored (mongoc_cluster_t *cluster,
-                                      mongoc_cmd_t *cmd,
-                                      bson_t *reply,
-                                      bson_error_t *error)
+static void
+_mongoc_cluster_phase_end (mongoc_cluster_t *cluster,
+                           mongoc_span_phase_t phase,
+                           int64_t started)
+{
+   int64_t duration = bson_get_monotonic_time () - started;
+
+   cluster->phase_duration[phase] += duration;
+   _mongoc_tracer_phase_add (
+      &cluster->client->tracer, phase, started, duration);
+
+   switch (phase) {
+   case MONGOC_SPAN_PHASE_SEND:
+      mongoc_histogram_command_send_record (duration);
+      break;
+   case MONGOC_SPAN_PHASE_WAIT:
+      mongoc_histogram_command_wait_record (duration);
+      break;
+   case MONGOC_SPAN_PHASE_RECEIVE:
+      mongoc_histogram_command_receive_record (duration);
+      break;
+   case MONGOC_SPAN_PHASE_DECOMPRESS:
+      mongoc_histogram_command_decompress_record (duration);
+      break;
+   case MONGOC_SPAN_PHASE_PARSE:
+      mongoc_histogram_command_parse_record (duration);
+      break;
+   case MONGOC_SPAN_PHASE_SERVER_SELECTION:
+   case MONGOC_SPAN_PHASE_CONNECTION_CHECKOUT:
+   case MONGOC_SPAN_PHASE_SESSION_POP:
+   case MONGOC_SPAN_PHASE_COMMAND_ASSEMBLY:
+   case MONGOC_SPAN_PHASE_COUNT:
+   default:
+      BSON_ASSERT (false);
+   }
+}
+
+
+static void
+_mongoc_cluster_monitor_started (mongoc_cluster_t *cluster,
+                                 mongoc_cmd_t *cmd,
+                                 uint32_t request_id)
 {
-   bool retval;
-   uint32_t request_id = ++cluster->request_id;
-   uint32_t server_id;
    mongoc_apm_callbacks_t *callbacks;
    mongoc_apm_command_started_t started_event;
-   mongoc_apm_command_succeeded_t succeeded_event;
-   mongoc_apm_command_failed_t failed_event;
-   int64_t started = bson_get_monotonic_time ();
-   const mongoc_server_stream_t *server_stream;
-   bson_t reply_local;
-   bson_error_t error_local;
-   int32_t compressor_id;
-
-   server_stream = cmd->server_stream;
-   server_id = server_stream->sd->id;
-   compressor_id = mongoc_server_description_compressor_id (server_stream->sd);
 
    callbacks = &cluster->client->apm_callbacks;
-   if (!reply) {
-      reply = &reply_local;
-   }
-   if (!error) {
-      error = &error_local;
-   }
-
    if (callbacks->started) {
       mongoc_apm_command_started_init_with_cmd (
          &started_event, cmd, request_id, cluster->client->apm_context);
@@ -542,13 +612,26 @@ mongoc_cluster_run_command_monitored (mongoc_cluster_t *cluster,
       callbacks->started (&started_event);
       mongoc_apm_command_started_cleanup (&started_event);
    }
+}
+
+
+static void
+_mongoc_cluster_monitor_finished (mongoc_cluster_t *cluster,
+                                  const mongoc_cmd_t *cmd,
+                                  bool retval,
+                                  uint32_t request_id,
+                                  int64_t started,
+                                  const bson_t *reply,
+                                  const bson_error_t *error)
+{
+   mongoc_apm_callbacks_t *callbacks;
+   mongoc_apm_command_succeeded_t succeeded_event;
+   mongoc_apm_command_failed_t failed_event;
+   const mongoc_server_stream_t *server_stream;
+
+   server_stream = cmd->server_stream;
+   callbacks = &cluster->client->apm_callbacks;
 
-   if (server_stream->sd->max_wire_version >= WIRE_VERSION_OP_MSG) {
-      retval = mongoc_cluster_run_opmsg (cluster, cmd, reply, error);
-   } else {
-      retval = mongoc_cluster_run_command_opquery (
-         cluster, cmd, server_stream->stream, compressor_id, reply, error);
-   }
    if (retval && callbacks->succeeded) {
       bson_t fake_reply = BSON_INITIALIZER;
       /*
@@ -567,8 +650,11 @@ mongoc_cluster_run_command_monitored (mongoc_cluster_t *cluster,
                                          request_id,
                                          cmd->operation_id,
                                          &server_stream->sd->host,
-                                         server_id,
+                                         server_stream->sd->id,
                                          cluster->client->apm_context);
+      memcpy (succeeded_event.phase_duration,
+              cluster->phase_duration,
+              sizeof cluster->phase_duration);
 
       callbacks->succeeded (&succeeded_event);
       mongoc_apm_command_succeeded_cleanup (&succeeded_event);
@@ -583,12 +669,135 @@ mongoc_cluster_run_command_monitored (mongoc_cluster_t *cluster,
                                       request_id,
                                       cmd->operation_id,
                                       &server_stream->sd->host,
-                                      server_id,
+                                      server_stream->sd->id,
                                       cluster->client->apm_context);
+      memcpy (failed_event.phase_duration,
+              cluster->phase_duration,
+              sizeof cluster->phase_duration);
 
       callbacks->failed (&failed_event);
       mongoc_apm_command_failed_cleanup (&failed_event);
    }
+}
+
+
+/* record a command's round trip time in the latency histograms, and count
+ * it for its server and namespace. @reply is NULL if nothing was read */
+static void
+_mongoc_cluster_record_command (const mongoc_cmd_t *cmd,
+                                int64_t duration,
+                                bool succeeded,
+                                const bson_t *reply)
+{
+   const mongoc_server_description_t *sd = cmd->server_stream->sd;
+   const char *collection = NULL;
+   int64_t egress_bytes;
+   bool is_getmore;
+   bson_iter_t iter;
+
+   is_getmore = cmd->command_name && !strcmp (cmd->command_name, "getMore");
+
+   mongoc_histogram_command_record (duration);
+   if (is_getmore) {
+      mongoc_histogram_getmore_record (duration);
+   }
+
+   /* collection commands like {find: "coll"} name it first, getMore has
+    * the cursor id first. only needed if namespaces are counted */
+   if (_mongoc_counters_namespaces_enabled ()) {
+      if (is_getmore) {
+         if (bson_iter_init_find (&iter, cmd->command, "collection") &&
+             BSON_ITER_HOLDS_UTF8 (&iter)) {
+            collection = bson_iter_utf8 (&iter, NULL);
+         }
+      } else if (bson_iter_init (&iter, cmd->command) &&
+                 bson_iter_next (&iter) && BSON_ITER_HOLDS_UTF8 (&iter)) {
+         collection = bson_iter_utf8 (&iter, NULL);
+      }
+   }
+
+   egress_bytes = cmd->command->len;
+   if (cmd->payload) {
+      egress_bytes += cmd->payload_size;
+   }
+
+   _mongoc_counters_record_command (
+      sd->load ? sd->load->counters : NULL,
+      sd->host.host_and_port,
+      cmd->db_name,
+      collection,
+      egress_bytes,
+      reply ? (int64_t) reply->len : 0,
+      !succeeded);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_cluster_run_command_monitored --
+ *
+ *       Internal function to run a command on a given stream.
+ *       @error and @reply are optional out-pointers.
+ *
+ * Returns:
+ *       true if successful; otherwise false and @error is set.
+ *
+ * Side effects:
+ *       If the client's APM callbacks are set, they are executed.
+ *       @reply is set and should ALWAYS be released with bson_destroy().
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_cluster_run_command_monitored (mongoc_cluster_t *cluster,
+                                      mongoc_cmd_t *cmd,
+                                      bson_t *reply,
+                                      bson_error_t *error)
+{
+   bool retval;
+   uint32_t request_id = ++cluster->request_id;
+   uint32_t server_id;
+   int64_t started = bson_get_monotonic_time ();
+   int64_t duration;
+   const mongoc_server_stream_t *server_stream;
+   bson_t reply_local;
+   bson_error_t error_local;
+   int32_t compressor_id;
+
+   server_stream = cmd->server_stream;
+   server_id = server_stream->sd->id;
+   compressor_id = mongoc_server_description_compressor_id (server_stream->sd);
+
+   if (!reply) {
+      reply = &reply_local;
+   }
+   if (!error) {
+      error = &error_local;
+   }
+
+   _mongoc_tracer_begin (&cluster->client->tracer, false);
+   memset (cluster->phase_duration, 0, sizeof cluster->phase_duration);
+   _mongoc_cluster_monitor_started (cluster, cmd, request_id);
+   _mongoc_server_load_begin (server_stream->sd->load);
+
+   if (server_stream->sd->max_wire_version >= WIRE_VERSION_OP_MSG) {
+      retval = mongoc_cluster_run_opmsg (cluster, cmd, reply, error);
+   } else {
+      retval = mongoc_cluster_run_command_opquery (
+         cluster, cmd, server_stream->stream, compressor_id, reply, error);
+   }
+
+   duration = bson_get_monotonic_time () - started;
+   _mongoc_server_load_end (server_stream->sd->load, duration);
+   _mongoc_cluster_record_command (cmd, duration, retval, reply);
+   _mongoc_tracer_end (&cluster->client->tracer,
+                       cmd->command_name,
+                       &server_stream->sd->host,
+                       retval);
+   _mongoc_cluster_monitor_finished (
+      cluster, cmd, retval, request_id, started, reply, error);
 
    handle_not_master_error (cluster, server_id, reply);
 
@@ -602,6 +811,193 @@ mongoc_cluster_run_command_monitored (mongoc_cluster_t *cluster,
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_cluster_send_command_monitored --
+ *
+ *       Internal function to write an acknowledged OP_MSG command to its
+ *       stream without waiting for the reply, so that several commands
+ *       may be in flight on one connection. Each successful call must be
+ *       matched, in order, by a call to
+ *       mongoc_cluster_recv_command_monitored with the same @pending.
+ *
+ * Returns:
+ *       true if the command was sent; otherwise false and @error is set.
+ *
+ * Side effects:
+ *       The APM started event is executed. If sending fails the APM
+ *       failed event is executed too and the node is disconnected.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_cluster_send_command_monitored (mongoc_cluster_t *cluster,
+                                       mongoc_cmd_t *cmd,
+                                       mongoc_cluster_pending_cmd_t *pending,
+                                       bson_error_t *error)
+{
+   uint32_t server_id;
+   bson_t reply;
+   bool retval;
+   int64_t duration;
+
+   BSON_ASSERT (cmd->is_acknowledged);
+   BSON_ASSERT (cmd->command_name);
+   BSON_ASSERT (cmd->server_stream->sd->max_wire_version >=
+                WIRE_VERSION_OP_MSG);
+   BSON_ASSERT (!cluster->client->in_exhaust);
+
+   server_id = cmd->server_stream->sd->id;
+   pending->request_id = ++cluster->request_id;
+   pending->started = bson_get_monotonic_time ();
+
+   _mongoc_tracer_begin_in_flight (&cluster->client->tracer);
+   memset (cluster->phase_duration, 0, sizeof cluster->phase_duration);
+   _mongoc_cluster_monitor_started (cluster, cmd, pending->request_id);
+   _mongoc_server_load_begin (cmd->server_stream->sd->load);
+
+   retval = _mongoc_cluster_send_opmsg (cluster, cmd, &reply, error);
+   pending->sent = bson_get_monotonic_time ();
+   pending->send_duration = cluster->phase_duration[MONGOC_SPAN_PHASE_SEND];
+   if (!retval) {
+      duration = bson_get_monotonic_time () - pending->started;
+      _mongoc_server_load_end (cmd->server_stream->sd->load, duration);
+      _mongoc_cluster_record_command (cmd, duration, false, NULL);
+      _mongoc_tracer_end_in_flight (&cluster->client->tracer,
+                                    cmd->command_name,
+                                    &cmd->server_stream->sd->host,
+                                    false);
+      _mongoc_cluster_monitor_finished (cluster,
+                                        cmd,
+                                        false,
+                                        pending->request_id,
+                                        pending->started,
+                                        &reply,
+                                        error);
+      bson_destroy (&reply);
+      _mongoc_topology_update_last_used (cluster->client->topology,
+                                         server_id);
+   }
+
+   return retval;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_cluster_recv_command_monitored --
+ *
+ *       Internal function to read the reply to a command sent with
+ *       mongoc_cluster_send_command_monitored. @cmd must describe the
+ *       same command and stream it was sent with.
+ *
+ * Returns:
+ *       true if successful; otherwise false and @error is set.
+ *
+ * Side effects:
+ *       The APM succeeded or failed event is executed.
+ *       @reply is set and should ALWAYS be released with bson_destroy().
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_cluster_recv_command_monitored (
+   mongoc_cluster_t *cluster,
+   mongoc_cmd_t *cmd,
+   const mongoc_cluster_pending_cmd_t *pending,
+   bson_t *reply,
+   bson_error_t *error)
+{
+   uint32_t server_id;
+   bool retval;
+   int64_t duration;
+
+   BSON_ASSERT (reply);
+
+   server_id = cmd->server_stream->sd->id;
+
+   /* other commands may have been sent or received since this one was sent */
+   memset (cluster->phase_duration, 0, sizeof cluster->phase_duration);
+   cluster->phase_duration[MONGOC_SPAN_PHASE_SEND] = pending->send_duration;
+   retval =
+      _mongoc_cluster_recv_opmsg (cluster, cmd, pending->sent, reply, error);
+
+   duration = bson_get_monotonic_time () - pending->started;
+   _mongoc_server_load_end (cmd->server_stream->sd->load, duration);
+   _mongoc_cluster_record_command (cmd, duration, retval, reply);
+   _mongoc_tracer_end_in_flight (&cluster->client->tracer,
+                                 cmd->command_name,
+                                 &cmd->server_stream->sd->host,
+                                 retval);
+   _mongoc_cluster_monitor_finished (cluster,
+                                     cmd,
+                                     retval,
+                                     pending->request_id,
+                                     pending->started,
+                                     reply,
+                                     error);
+
+   handle_not_master_error (cluster, server_id, reply);
+   _mongoc_topology_update_last_used (cluster->client->topology, server_id);
+
+   return retval;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_cluster_fail_pending_monitored --
+ *
+ *       Internal function to abandon a command sent with
+ *       mongoc_cluster_send_command_monitored whose reply will never be
+ *       read, because the connection failed while it was in flight. It is
+ *       finished as if reading its reply had failed with @error.
+ *
+ * Side effects:
+ *       The APM failed event is executed.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+mongoc_cluster_fail_pending_monitored (
+   mongoc_cluster_t *cluster,
+   mongoc_cmd_t *cmd,
+   const mongoc_cluster_pending_cmd_t *pending,
+   const bson_error_t *error)
+{
+   bson_t reply = BSON_INITIALIZER;
+   int64_t duration;
+
+   memset (cluster->phase_duration, 0, sizeof cluster->phase_duration);
+   cluster->phase_duration[MONGOC_SPAN_PHASE_SEND] = pending->send_duration;
+
+   duration = bson_get_monotonic_time () - pending->started;
+   _mongoc_server_load_end (cmd->server_stream->sd->load, duration);
+   _mongoc_cluster_record_command (cmd, duration, false, NULL);
+   _mongoc_tracer_end_in_flight (&cluster->client->tracer,
+                                 cmd->command_name,
+                                 &cmd->server_stream->sd->host,
+                                 false);
+   _mongoc_cluster_monitor_finished (cluster,
+                                     cmd,
+                                     false,
+                                     pending->request_id,
+                                     pending->started,
+                                     &reply,
+                                     error);
+
+   bson_destroy (&reply);
+   _mongoc_topology_update_last_used (cluster->client->topology,
+                                      cmd->server_stream->sd->id);
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -630,6 +1026,8 @@ mongoc_cluster_run_command_private (mongoc_cluster_t *cluster,
    const mongoc_server_stream_t *server_stream;
    bson_t reply_local;
    bson_error_t error_local;
+   int64_t started = bson_get_monotonic_time ();
+   int64_t duration;
 
    if (!error) {
       error = &error_local;
@@ -639,12 +1037,17 @@ mongoc_cluster_run_command_private (mongoc_cluster_t *cluster,
       reply = &reply_local;
    }
    server_stream = cmd->server_stream;
+   memset (cluster->phase_duration, 0, sizeof cluster->phase_duration);
+   _mongoc_server_load_begin (server_stream->sd->load);
    if (server_stream->sd->max_wire_version >= WIRE_VERSION_OP_MSG) {
       retval = mongoc_cluster_run_opmsg (cluster, cmd, reply, error);
    } else {
       retval = mongoc_cluster_run_command_opquery (
          cluster, cmd, cmd->server_stream->stream, -1, reply, error);
    }
+   duration = bson_get_monotonic_time () - started;
+   _mongoc_server_load_end (server_stream->sd->load, duration);
+   _mongoc_cluster_record_command (cmd, duration, retval, reply);
    handle_not_master_error (cluster, server_stream->sd->id, reply);
    if (reply == &reply_local) {
       bson_destroy (&reply_local);
@@ -704,7 +1107,9 @@ mongoc_cluster_run_command_parts (mongoc_cluster_t *cluster,
  *
  *       Run an ismaster command on the given stream. If
  *       @negotiate_sasl_supported_mechs is true, then saslSupportedMechs is
- *       added to the ismaster command.
+ *       added to the ismaster command. If @speculative_auth_response is not
+ *       NULL and the cluster requires auth, authentication begins in @scram
+ *       and the server's reply to it is copied to @speculative_auth_response.
  *
  * Returns:
  *       A mongoc_server_description_t you must destroy or NULL. If the call
@@ -718,6 +1123,8 @@ _mongoc_stream_run_ismaster (mongoc_cluster_t *cluster,
                              const char *address,
                              uint32_t server_id,
                              bool negotiate_sasl_supported_mechs,
+                             mongoc_scram_t *scram,
+                             bson_t *speculative_auth_response,
                              bson_error_t *error)
 {
    const bson_t *command;
@@ -745,6 +1152,16 @@ _mongoc_stream_run_ismaster (mongoc_cluster_t *cluster,
       command = copied_command;
    }
 
+   if (cluster->requires_auth && speculative_auth_response) {
+      if (!copied_command) {
+         copied_command = bson_copy (command);
+         command = copied_command;
+      }
+
+      _mongoc_topology_scanner_add_speculative_authentication (
+         copied_command, cluster->uri, scram);
+   }
+
    start = bson_get_monotonic_time ();
    server_stream = _mongoc_cluster_create_server_stream (
       cluster->client->topology, server_id, stream, error);
@@ -777,6 +1194,11 @@ _mongoc_stream_run_ismaster (mongoc_cluster_t *cluster,
 
    rtt_msec = (bson_get_monotonic_time () - start) / 1000;
 
+   if (speculative_auth_response) {
+      _mongoc_topology_scanner_parse_speculative_authentication (
+         &reply, speculative_auth_response);
+   }
+
    sd = (mongoc_server_description_t *) bson_malloc0 (
       sizeof (mongoc_server_description_t));
 
@@ -811,6 +1233,8 @@ _mongoc_stream_run_ismaster (mongoc_cluster_t *cluster,
  * _mongoc_cluster_run_ismaster --
  *
  *       Run an initial ismaster command for the given node and handle result.
+ *       Authentication begins in @scram if the cluster requires it, and the
+ *       server's reply is copied to @speculative_auth_response.
  *
  * Returns:
  *       mongoc_server_description_t on success, NULL otherwise.
@@ -826,6 +1250,8 @@ static mongoc_server_description_t *
 _mongoc_cluster_run_ismaster (mongoc_cluster_t *cluster,
                               mongoc_cluster_node_t *node,
                               uint32_t server_id,
+                              mongoc_scram_t *scram,
+                              bson_t *speculative_auth_response /* OUT */,
                               bson_error_t *error /* OUT */)
 {
    mongoc_server_description_t *sd;
@@ -842,6 +1268,8 @@ _mongoc_cluster_run_ismaster (mongoc_cluster_t *cluster,
       node->connection_address,
       server_id,
       _mongoc_uri_requires_auth_negotiation (cluster->uri),
+      scram,
+      speculative_auth_response,
       error);
 
    if (!sd) {
@@ -1217,111 +1645,170 @@ _mongoc_cluster_auth_node_x509 (mongoc_cluster_t *cluster,
 
 
 #ifdef MONGOC_ENABLE_CRYPTO
+void
+_mongoc_cluster_init_scram (const mongoc_uri_t *uri,
+                            mongoc_scram_t *scram,
+                            mongoc_crypto_hash_algorithm_t algo)
+{
+   _mongoc_scram_init (scram, algo);
+
+   _mongoc_scram_set_pass (scram, mongoc_uri_get_password (uri));
+   _mongoc_scram_set_user (scram, mongoc_uri_get_username (uri));
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_get_auth_cmd_scram --
+ *
+ *       Take the first step of @scram's conversation and build the
+ *       saslStart command that sends it. The command is also embedded in
+ *       the handshake for speculative authentication.
+ *
+ * Returns:
+ *       true on success, false if @error is set. @cmd must be destroyed
+ *       either way.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_cluster_get_auth_cmd_scram (mongoc_crypto_hash_algorithm_t algo,
+                                    mongoc_scram_t *scram,
+                                    bson_t *cmd /* OUT */,
+                                    bson_error_t *error /* OUT */)
+{
+   uint8_t buf[4096] = {0};
+   uint32_t buflen = 0;
+
+   bson_init (cmd);
+
+   if (!_mongoc_scram_step (
+          scram, buf, buflen, buf, sizeof buf, &buflen, error)) {
+      return false;
+   }
+
+   BSON_ASSERT (scram->step == 1);
+
+   BSON_APPEND_INT32 (cmd, "saslStart", 1);
+   if (algo == MONGOC_CRYPTO_ALGORITHM_SHA_1) {
+      BSON_APPEND_UTF8 (cmd, "mechanism", "SCRAM-SHA-1");
+   } else if (algo == MONGOC_CRYPTO_ALGORITHM_SHA_256) {
+      BSON_APPEND_UTF8 (cmd, "mechanism", "SCRAM-SHA-256");
+   } else {
+      BSON_ASSERT (false);
+   }
+   bson_append_binary (cmd, "payload", 7, BSON_SUBTYPE_BINARY, buf, buflen);
+   BSON_APPEND_INT32 (cmd, "autoAuthorize", 1);
+
+   return true;
+}
+
+
 static bool
-_mongoc_cluster_auth_node_scram (mongoc_cluster_t *cluster,
-                                 mongoc_stream_t *stream,
-                                 mongoc_server_description_t *sd,
-                                 mongoc_crypto_hash_algorithm_t algo,
-                                 bson_error_t *error)
+_mongoc_cluster_run_scram_command (mongoc_cluster_t *cluster,
+                                   mongoc_stream_t *stream,
+                                   mongoc_server_description_t *sd,
+                                   const bson_t *cmd,
+                                   bson_t *reply,
+                                   bson_error_t *error)
 {
    mongoc_cmd_parts_t parts;
-   uint32_t buflen = 0;
-   mongoc_scram_t scram;
-   bson_iter_t iter;
-   bool ret = false;
-   const char *tmpstr;
-   const char *auth_source;
-   uint8_t buf[4096] = {0};
-   bson_t cmd;
-   bson_t reply;
-   int conv_id = 0;
-   bson_subtype_t btype;
    mongoc_server_stream_t *server_stream;
-
-   BSON_ASSERT (cluster);
-   BSON_ASSERT (stream);
+   const char *auth_source;
 
    if (!(auth_source = mongoc_uri_get_auth_source (cluster->uri)) ||
        (*auth_source == '\0')) {
       auth_source = "admin";
    }
 
-   _mongoc_scram_init (&scram, algo);
+   mongoc_cmd_parts_init (
+      &parts, cluster->client, auth_source, MONGOC_QUERY_SLAVE_OK, cmd);
+   parts.prohibit_lsid = true;
+   server_stream = _mongoc_cluster_create_server_stream (
+      cluster->client->topology, sd->id, stream, error);
+   if (!server_stream) {
+      bson_init (reply);
+      return false;
+   }
 
-   _mongoc_scram_set_pass (&scram, mongoc_uri_get_password (cluster->uri));
-   _mongoc_scram_set_user (&scram, mongoc_uri_get_username (cluster->uri));
+   if (!mongoc_cluster_run_command_parts (
+          cluster, server_stream, &parts, reply, error)) {
+      mongoc_server_stream_cleanup (server_stream);
 
-   /* Apply previously cached SCRAM secrets if available */
-   if (cluster->scram_cache) {
-      _mongoc_scram_set_cache (&scram, cluster->scram_cache);
+      /* error->message is already set */
+      error->domain = MONGOC_ERROR_CLIENT;
+      error->code = MONGOC_ERROR_CLIENT_AUTHENTICATE;
+      return false;
    }
 
-   for (;;) {
-      if (!_mongoc_scram_step (
-             &scram, buf, buflen, buf, sizeof buf, &buflen, error)) {
-         goto failure;
-      }
+   mongoc_server_stream_cleanup (server_stream);
 
-      bson_init (&cmd);
+   return true;
+}
 
-      if (scram.step == 1) {
-         BSON_APPEND_INT32 (&cmd, "saslStart", 1);
-         if (algo == MONGOC_CRYPTO_ALGORITHM_SHA_1) {
-            BSON_APPEND_UTF8 (&cmd, "mechanism", "SCRAM-SHA-1");
-         } else if (algo == MONGOC_CRYPTO_ALGORITHM_SHA_256) {
-            BSON_APPEND_UTF8 (&cmd, "mechanism", "SCRAM-SHA-256");
-         } else {
-            BSON_ASSERT (false);
-         }
-         bson_append_binary (
-            &cmd, "payload", 7, BSON_SUBTYPE_BINARY, buf, buflen);
-         BSON_APPEND_INT32 (&cmd, "autoAuthorize", 1);
-      } else {
-         BSON_APPEND_INT32 (&cmd, "saslContinue", 1);
-         BSON_APPEND_INT32 (&cmd, "conversationId", conv_id);
-         bson_append_binary (
-            &cmd, "payload", 7, BSON_SUBTYPE_BINARY, buf, buflen);
-      }
 
-      TRACE ("SCRAM: authenticating (step %d)", scram.step);
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_auth_scram_continue --
+ *
+ *       Finish @scram's conversation, given the server's reply to
+ *       saslStart. The reply is from a saslStart command, or the
+ *       speculativeAuthenticate field of the handshake reply.
+ *
+ * Returns:
+ *       true if authenticated. false on failure and @error is set.
+ *
+ *--------------------------------------------------------------------------
+ */
 
-      mongoc_cmd_parts_init (
-         &parts, cluster->client, auth_source, MONGOC_QUERY_SLAVE_OK, &cmd);
-      parts.prohibit_lsid = true;
-      server_stream = _mongoc_cluster_create_server_stream (
-         cluster->client->topology, sd->id, stream, error);
-      if (!mongoc_cluster_run_command_parts (
-             cluster, server_stream, &parts, &reply, error)) {
-         mongoc_server_stream_cleanup (server_stream);
-         bson_destroy (&cmd);
-         bson_destroy (&reply);
+bool
+_mongoc_cluster_auth_scram_continue (mongoc_cluster_t *cluster,
+                                     mongoc_stream_t *stream,
+                                     mongoc_server_description_t *sd,
+                                     mongoc_scram_t *scram,
+                                     const bson_t *sasl_start_reply,
+                                     bson_error_t *error)
+{
+   uint32_t buflen = 0;
+   bson_iter_t iter;
+   bool ret = false;
+   const char *tmpstr;
+   uint8_t buf[4096] = {0};
+   bson_t cmd;
+   bson_t reply_local = BSON_INITIALIZER;
+   const bson_t *reply = sasl_start_reply;
+   int conv_id = 0;
+   bson_subtype_t btype;
 
-         /* error->message is already set */
-         error->domain = MONGOC_ERROR_CLIENT;
-         error->code = MONGOC_ERROR_CLIENT_AUTHENTICATE;
-         goto failure;
-      }
-      mongoc_server_stream_cleanup (server_stream);
+   BSON_ASSERT (cluster);
+   BSON_ASSERT (stream);
+   BSON_ASSERT (scram->step == 1);
 
-      bson_destroy (&cmd);
+   /* Apply previously cached SCRAM secrets if available */
+   if (cluster->scram_cache && !scram->cache) {
+      _mongoc_scram_set_cache (scram, cluster->scram_cache);
+   }
 
-      if (bson_iter_init_find (&iter, &reply, "done") &&
+   for (;;) {
+      if (bson_iter_init_find (&iter, reply, "done") &&
           bson_iter_as_bool (&iter)) {
-         bson_destroy (&reply);
          break;
       }
 
-      if (!bson_iter_init_find (&iter, &reply, "conversationId") ||
+      if (!bson_iter_init_find (&iter, reply, "conversationId") ||
           !BSON_ITER_HOLDS_INT32 (&iter) ||
           !(conv_id = bson_iter_int32 (&iter)) ||
-          !bson_iter_init_find (&iter, &reply, "payload") ||
+          !bson_iter_init_find (&iter, reply, "payload") ||
           !BSON_ITER_HOLDS_BINARY (&iter)) {
          const char *errmsg =
             "Received invalid SCRAM reply from MongoDB server.";
 
          MONGOC_DEBUG ("SCRAM: authentication failed");
 
-         if (bson_iter_init_find (&iter, &reply, "errmsg") &&
+         if (bson_iter_init_find (&iter, reply, "errmsg") &&
              BSON_ITER_HOLDS_UTF8 (&iter)) {
             errmsg = bson_iter_utf8 (&iter, NULL);
          }
@@ -1331,7 +1818,6 @@ _mongoc_cluster_auth_node_scram (mongoc_cluster_t *cluster,
                          MONGOC_ERROR_CLIENT_AUTHENTICATE,
                          "%s",
                          errmsg);
-         bson_destroy (&reply);
          goto failure;
       }
 
@@ -1342,13 +1828,33 @@ _mongoc_cluster_auth_node_scram (mongoc_cluster_t *cluster,
                          MONGOC_ERROR_CLIENT,
                          MONGOC_ERROR_CLIENT_AUTHENTICATE,
                          "SCRAM reply from MongoDB is too large.");
-         bson_destroy (&reply);
          goto failure;
       }
 
       memcpy (buf, tmpstr, buflen);
 
-      bson_destroy (&reply);
+      if (!_mongoc_scram_step (
+             scram, buf, buflen, buf, sizeof buf, &buflen, error)) {
+         goto failure;
+      }
+
+      bson_init (&cmd);
+      BSON_APPEND_INT32 (&cmd, "saslContinue", 1);
+      BSON_APPEND_INT32 (&cmd, "conversationId", conv_id);
+      bson_append_binary (
+         &cmd, "payload", 7, BSON_SUBTYPE_BINARY, buf, buflen);
+
+      TRACE ("SCRAM: authenticating (step %d)", scram->step);
+
+      bson_destroy (&reply_local);
+      reply = &reply_local;
+      if (!_mongoc_cluster_run_scram_command (
+             cluster, stream, sd, &cmd, &reply_local, error)) {
+         bson_destroy (&cmd);
+         goto failure;
+      }
+
+      bson_destroy (&cmd);
    }
 
    TRACE ("%s", "SCRAM: authenticated");
@@ -1360,7 +1866,52 @@ _mongoc_cluster_auth_node_scram (mongoc_cluster_t *cluster,
       _mongoc_scram_cache_destroy (cluster->scram_cache);
    }
 
-   cluster->scram_cache = _mongoc_scram_get_cache (&scram);
+   cluster->scram_cache = _mongoc_scram_get_cache (scram);
+
+failure:
+   bson_destroy (&reply_local);
+
+   return ret;
+}
+
+
+static bool
+_mongoc_cluster_auth_node_scram (mongoc_cluster_t *cluster,
+                                 mongoc_stream_t *stream,
+                                 mongoc_server_description_t *sd,
+                                 mongoc_crypto_hash_algorithm_t algo,
+                                 bson_error_t *error)
+{
+   mongoc_scram_t scram;
+   bool ret = false;
+   bson_t cmd;
+   bson_t reply;
+
+   BSON_ASSERT (cluster);
+   BSON_ASSERT (stream);
+
+   _mongoc_cluster_init_scram (cluster->uri, &scram, algo);
+
+   if (!_mongoc_cluster_get_auth_cmd_scram (algo, &scram, &cmd, error)) {
+      bson_destroy (&cmd);
+      goto failure;
+   }
+
+   TRACE ("SCRAM: authenticating (step %d)", scram.step);
+
+   if (!_mongoc_cluster_run_scram_command (
+          cluster, stream, sd, &cmd, &reply, error)) {
+      bson_destroy (&cmd);
+      bson_destroy (&reply);
+      goto failure;
+   }
+
+   bson_destroy (&cmd);
+
+   ret = _mongoc_cluster_auth_scram_continue (
+      cluster, stream, sd, &scram, &reply, error);
+
+   bson_destroy (&reply);
 
 failure:
    _mongoc_scram_destroy (&scram);
@@ -1389,24 +1940,76 @@ _mongoc_cluster_auth_node_scram_sha_1 (mongoc_cluster_t *cluster,
 }
 
 static bool
-_mongoc_cluster_auth_node_scram_sha_256 (mongoc_cluster_t *cluster,
+_mongoc_cluster_auth_node_scram_sha_256 (mongoc_cluster_t *cluster,
+                                         mongoc_stream_t *stream,
+                                         mongoc_server_description_t *sd,
+                                         bson_error_t *error)
+{
+#ifndef MONGOC_ENABLE_CRYPTO
+   bson_set_error (error,
+                   MONGOC_ERROR_CLIENT,
+                   MONGOC_ERROR_CLIENT_AUTHENTICATE,
+                   "The SCRAM_SHA_256 authentication mechanism requires "
+                   "libmongoc built with ENABLE_SSL");
+   return false;
+#else
+   return _mongoc_cluster_auth_node_scram (
+      cluster, stream, sd, MONGOC_CRYPTO_ALGORITHM_SHA_256, error);
+#endif
+}
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_finish_speculative_auth --
+ *
+ *       Finish authenticating a new connection whose handshake began a
+ *       conversation in @scram, continuing from @auth_response, the
+ *       speculativeAuthenticate field of the handshake reply.
+ *
+ * Returns:
+ *       false if the handshake didn't begin authentication, or the server
+ *       didn't reply to it because it is older than 4.4 or the user has no
+ *       credentials for the mechanism. The caller must then authenticate
+ *       from the start. Otherwise true, and @auth_ok is set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_cluster_finish_speculative_auth (mongoc_cluster_t *cluster,
                                          mongoc_stream_t *stream,
                                          mongoc_server_description_t *sd,
+                                         const bson_t *auth_response,
+                                         mongoc_scram_t *scram,
+                                         bool *auth_ok,
                                          bson_error_t *error)
 {
-#ifndef MONGOC_ENABLE_CRYPTO
-   bson_set_error (error,
-                   MONGOC_ERROR_CLIENT,
-                   MONGOC_ERROR_CLIENT_AUTHENTICATE,
-                   "The SCRAM_SHA_256 authentication mechanism requires "
-                   "libmongoc built with ENABLE_SSL");
-   return false;
+   ENTRY;
+
+   if (bson_empty (auth_response) || scram->step != 1) {
+      RETURN (false);
+   }
+
+#ifdef MONGOC_ENABLE_CRYPTO
+   *auth_ok = _mongoc_cluster_auth_scram_continue (
+      cluster, stream, sd, scram, auth_response, error);
+
+   if (!*auth_ok) {
+      mongoc_counter_auth_failure_inc ();
+      MONGOC_DEBUG ("Authentication failed: %s", error->message);
+   } else {
+      mongoc_counter_auth_success_inc ();
+      TRACE ("%s", "Speculative authentication succeeded");
+   }
+
+   RETURN (true);
 #else
-   return _mongoc_cluster_auth_node_scram (
-      cluster, stream, sd, MONGOC_CRYPTO_ALGORITHM_SHA_256, error);
+   RETURN (false);
 #endif
 }
 
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -1577,6 +2180,9 @@ mongoc_cluster_disconnect_node (mongoc_cluster_t *cluster,
 
    if (invalidate) {
       mongoc_topology_invalidate_server (topology, server_id, why);
+      if (!topology->single_threaded) {
+         _mongoc_topology_request_probe (topology, server_id);
+      }
    }
 
    EXIT;
@@ -1653,12 +2259,18 @@ _mongoc_cluster_add_node (mongoc_cluster_t *cluster,
    mongoc_stream_t *stream;
    mongoc_server_description_t *sd;
    mongoc_handshake_sasl_supported_mechs_t sasl_supported_mechs;
+   mongoc_scram_t scram;
+   bson_t speculative_auth_response = BSON_INITIALIZER;
+   bool auth_ok;
+   int64_t started;
 
    ENTRY;
 
    BSON_ASSERT (cluster);
    BSON_ASSERT (!cluster->client->topology->single_threaded);
 
+   memset (&scram, 0, sizeof scram);
+
    host =
       _mongoc_topology_host_by_id (cluster->client->topology, server_id, error);
 
@@ -1668,7 +2280,9 @@ _mongoc_cluster_add_node (mongoc_cluster_t *cluster,
 
    TRACE ("Adding new server to cluster: %s", host->host_and_port);
 
+   started = bson_get_monotonic_time ();
    stream = _mongoc_client_create_stream (cluster->client, host, error);
+   mongoc_histogram_connect_record (bson_get_monotonic_time () - started);
 
    if (!stream) {
       MONGOC_WARNING (
@@ -1676,10 +2290,19 @@ _mongoc_cluster_add_node (mongoc_cluster_t *cluster,
       GOTO (error);
    }
 
+   _mongoc_counters_record_connection (host->host_and_port);
+
    /* take critical fields from a fresh ismaster */
    cluster_node = _mongoc_cluster_node_new (stream, host->host_and_port);
 
-   sd = _mongoc_cluster_run_ismaster (cluster, cluster_node, server_id, error);
+   started = bson_get_monotonic_time ();
+   sd = _mongoc_cluster_run_ismaster (cluster,
+                                      cluster_node,
+                                      server_id,
+                                      &scram,
+                                      &speculative_auth_response,
+                                      error);
+   mongoc_histogram_handshake_record (bson_get_monotonic_time () - started);
    if (!sd) {
       GOTO (error);
    }
@@ -1688,8 +2311,21 @@ _mongoc_cluster_add_node (mongoc_cluster_t *cluster,
                                                  &sasl_supported_mechs);
 
    if (cluster->requires_auth) {
-      if (!_mongoc_cluster_auth_node (
-             cluster, cluster_node->stream, sd, &sasl_supported_mechs, error)) {
+      started = bson_get_monotonic_time ();
+      if (!_mongoc_cluster_finish_speculative_auth (cluster,
+                                                    cluster_node->stream,
+                                                    sd,
+                                                    &speculative_auth_response,
+                                                    &scram,
+                                                    &auth_ok,
+                                                    error)) {
+         auth_ok = _mongoc_cluster_auth_node (
+            cluster, cluster_node->stream, sd, &sasl_supported_mechs, error);
+      }
+
+      mongoc_histogram_auth_record (bson_get_monotonic_time () - started);
+
+      if (!auth_ok) {
          MONGOC_WARNING ("Failed authentication to %s (%s)",
                          host->host_and_port,
                          error->message);
@@ -1701,11 +2337,19 @@ _mongoc_cluster_add_node (mongoc_cluster_t *cluster,
 
    mongoc_set_add (cluster->nodes, server_id, cluster_node);
    _mongoc_host_list_destroy_all (host);
+   bson_destroy (&speculative_auth_response);
+#ifdef MONGOC_ENABLE_CRYPTO
+   _mongoc_scram_destroy (&scram);
+#endif
 
    RETURN (stream);
 
 error:
    _mongoc_host_list_destroy_all (host); /* null ok */
+   bson_destroy (&speculative_auth_response);
+#ifdef MONGOC_ENABLE_CRYPTO
+   _mongoc_scram_destroy (&scram);
+#endif
 
    if (cluster_node) {
       _mongoc_cluster_node_destroy (cluster_node); /* also destroys stream */
@@ -1817,6 +2461,34 @@ _mongoc_cluster_stream_for_server (mongoc_cluster_t *cluster,
 }
 
 
+/* fetch the stream for @server_id, recorded in the client's span as the
+ * connection checkout. the phases of commands that set up a new connection
+ * are part of the checkout, and not recorded separately. */
+static mongoc_server_stream_t *
+_mongoc_cluster_checkout (mongoc_cluster_t *cluster,
+                          uint32_t server_id,
+                          bool reconnect_ok,
+                          const mongoc_client_session_t *cs,
+                          bson_t *reply,
+                          bson_error_t *error)
+{
+   mongoc_tracer_t *tracer = &cluster->client->tracer;
+   mongoc_server_stream_t *server_stream;
+   int64_t started;
+   bool sampled;
+
+   started = _mongoc_tracer_phase_begin (tracer);
+   sampled = _mongoc_tracer_pause (tracer);
+   server_stream = _mongoc_cluster_stream_for_server (
+      cluster, server_id, reconnect_ok, cs, reply, error);
+   _mongoc_tracer_resume (tracer, sampled);
+   _mongoc_tracer_phase_end (
+      tracer, MONGOC_SPAN_PHASE_CONNECTION_CHECKOUT, started);
+
+   return server_stream;
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -1857,7 +2529,9 @@ mongoc_cluster_stream_for_server (mongoc_cluster_t *cluster,
       error = &err_local;
    }
 
-   server_stream = _mongoc_cluster_stream_for_server (
+   /* an operation on a server chosen earlier, such as a getMore */
+   _mongoc_tracer_begin (&cluster->client->tracer, true);
+   server_stream = _mongoc_cluster_checkout (
       cluster, server_id, reconnect_ok, cs, reply, error);
 
    if (!server_stream) {
@@ -1879,6 +2553,8 @@ mongoc_cluster_fetch_stream_single (mongoc_cluster_t *cluster,
    mongoc_server_description_t *sd;
    mongoc_topology_scanner_node_t *scanner_node;
    char *address;
+   bool auth_ok;
+   int64_t started;
 
    topology = cluster->client->topology;
    scanner_node =
@@ -1930,11 +2606,28 @@ mongoc_cluster_fetch_stream_single (mongoc_cluster_t *cluster,
 
    /* stream open but not auth'ed: first use since connect or reconnect */
    if (cluster->requires_auth && !scanner_node->has_auth) {
-      if (!_mongoc_cluster_auth_node (cluster,
-                                      scanner_node->stream,
-                                      sd,
-                                      &scanner_node->sasl_supported_mechs,
-                                      &sd->error)) {
+      started = bson_get_monotonic_time ();
+      if (!_mongoc_cluster_finish_speculative_auth (
+             cluster,
+             scanner_node->stream,
+             sd,
+             &scanner_node->speculative_auth_response,
+             &scanner_node->scram,
+             &auth_ok,
+             &sd->error)) {
+         auth_ok =
+            _mongoc_cluster_auth_node (cluster,
+                                       scanner_node->stream,
+                                       sd,
+                                       &scanner_node->sasl_supported_mechs,
+                                       &sd->error);
+      }
+
+      mongoc_histogram_auth_record (bson_get_monotonic_time () - started);
+
+      _mongoc_topology_scanner_node_reset_speculative_auth (scanner_node);
+
+      if (!auth_ok) {
          memcpy (error, &sd->error, sizeof *error);
          mongoc_server_description_destroy (sd);
          return NULL;
@@ -2145,23 +2838,44 @@ _mongoc_cluster_stream_for_optype (mongoc_cluster_t *cluster,
    mongoc_server_stream_t *server_stream;
    uint32_t server_id;
    mongoc_topology_t *topology = cluster->client->topology;
+   mongoc_tracer_t *tracer = &cluster->client->tracer;
+   int64_t started;
+   bool sampled;
+   bool connection_ok;
 
    ENTRY;
 
    BSON_ASSERT (cluster);
 
+   /* a new operation, discard the span of one that failed before sending a
+    * command */
+   _mongoc_tracer_begin (tracer, true);
+   started = _mongoc_tracer_phase_begin (tracer);
    server_id =
       mongoc_topology_select_server_id (topology, optype, read_prefs, error);
+   _mongoc_tracer_phase_end (
+      tracer, MONGOC_SPAN_PHASE_SERVER_SELECTION, started);
 
    if (!server_id) {
       _mongoc_bson_init_with_transient_txn_error (cs, reply);
       RETURN (NULL);
    }
 
-   if (!mongoc_cluster_check_interval (cluster, server_id)) {
+   /* checking an idle connection is part of checking it out */
+   started = _mongoc_tracer_phase_begin (tracer);
+   sampled = _mongoc_tracer_pause (tracer);
+   connection_ok = mongoc_cluster_check_interval (cluster, server_id);
+   _mongoc_tracer_resume (tracer, sampled);
+   _mongoc_tracer_phase_end (
+      tracer, MONGOC_SPAN_PHASE_CONNECTION_CHECKOUT, started);
+
+   if (!connection_ok) {
       /* Server Selection Spec: try once more */
+      started = _mongoc_tracer_phase_begin (tracer);
       server_id =
          mongoc_topology_select_server_id (topology, optype, read_prefs, error);
+      _mongoc_tracer_phase_end (
+         tracer, MONGOC_SPAN_PHASE_SERVER_SELECTION, started);
 
       if (!server_id) {
          _mongoc_bson_init_with_transient_txn_error (cs, reply);
@@ -2170,7 +2884,7 @@ _mongoc_cluster_stream_for_optype (mongoc_cluster_t *cluster,
    }
 
    /* connect or reconnect to server if necessary */
-   server_stream = _mongoc_cluster_stream_for_server (
+   server_stream = _mongoc_cluster_checkout (
       cluster, server_id, true /* reconnect_ok */, cs, reply, error);
 
    RETURN (server_stream);
@@ -2477,6 +3191,9 @@ mongoc_cluster_check_interval (mongoc_cluster_t *cluster, uint32_t server_id)
  *
  *       @error may be set.
  *
+ *       The cluster's phase durations are reset and the write is timed
+ *       as the request's send phase.
+ *
  *--------------------------------------------------------------------------
  */
 
@@ -2492,6 +3209,8 @@ mongoc_cluster_legacy_rpc_sendv_to_server (
    bool ret = false;
    int32_t compressor_id = 0;
    char *output = NULL;
+   bool ok;
+   int64_t started;
 
    ENTRY;
 
@@ -2535,11 +3254,16 @@ mongoc_cluster_legacy_rpc_sendv_to_server (
       GOTO (done);
    }
 
-   if (!_mongoc_stream_writev_full (server_stream->stream,
+   /* a new legacy request: its wire phases are timed from scratch */
+   memset (cluster->phase_duration, 0, sizeof cluster->phase_duration);
+   started = bson_get_monotonic_time ();
+   ok = _mongoc_stream_writev_full (server_stream->stream,
                                     cluster->iov.data,
                                     cluster->iov.len,
                                     cluster->sockettimeoutms,
-                                    error)) {
+                                    error);
+   _mongoc_cluster_phase_end (cluster, MONGOC_SPAN_PHASE_SEND, started);
+   if (!ok) {
       GOTO (done);
    }
 
@@ -2576,6 +3300,8 @@ done:
  * Side effects:
  *       @rpc is set on success, @error on failure.
  *       @buffer will be filled with the input data.
+ *       The wait for the reply, reading it, and decompressing it are
+ *       timed as phases of the request in progress.
  *
  *--------------------------------------------------------------------------
  */
@@ -2592,6 +3318,8 @@ mongoc_cluster_try_recv (mongoc_cluster_t *cluster,
    int32_t msg_len;
    int32_t max_msg_size;
    off_t pos;
+   bool ok;
+   int64_t started;
 
    ENTRY;
 
@@ -2612,15 +3340,19 @@ mongoc_cluster_try_recv (mongoc_cluster_t *cluster,
     * Buffer the message length to determine how much more to read.
     */
    pos = buffer->len;
-   if (!_mongoc_buffer_append_from_stream (
-          buffer, server_stream->stream, 4, cluster->sockettimeoutms, error)) {
+   started = bson_get_monotonic_time ();
+   ok = _mongoc_buffer_append_from_stream (
+      buffer, server_stream->stream, 4, cluster->sockettimeoutms, error);
+   _mongoc_cluster_phase_end (cluster, MONGOC_SPAN_PHASE_WAIT, started);
+   if (!ok) {
       MONGOC_DEBUG (
          "Could not read 4 bytes, stream probably closed or timed out");
       mongoc_counter_protocol_ingress_error_inc ();
       mongoc_cluster_disconnect_node (
          cluster,
          server_id,
-         !mongoc_stream_timed_out (server_stream->stream),
+         !_mongoc_cluster_stream_timed_out (server_stream->stream,
+                                            server_stream->sd),
          error);
       RETURN (false);
    }
@@ -2644,15 +3376,19 @@ mongoc_cluster_try_recv (mongoc_cluster_t *cluster,
    /*
     * Read the rest of the message from the stream.
     */
-   if (!_mongoc_buffer_append_from_stream (buffer,
+   started = bson_get_monotonic_time ();
+   ok = _mongoc_buffer_append_from_stream (buffer,
                                            server_stream->stream,
                                            msg_len - 4,
                                            cluster->sockettimeoutms,
-                                           error)) {
+                                           error);
+   _mongoc_cluster_phase_end (cluster, MONGOC_SPAN_PHASE_RECEIVE, started);
+   if (!ok) {
       mongoc_cluster_disconnect_node (
          cluster,
          server_id,
-         !mongoc_stream_timed_out (server_stream->stream),
+         !_mongoc_cluster_stream_timed_out (server_stream->stream,
+                                            server_stream->sd),
          error);
       mongoc_counter_protocol_ingress_error_inc ();
       RETURN (false);
@@ -2677,7 +3413,11 @@ mongoc_cluster_try_recv (mongoc_cluster_t *cluster,
                    sizeof (mongoc_rpc_header_t);
 
       buf = bson_malloc0 (len);
-      if (!_mongoc_rpc_decompress (rpc, buf, len)) {
+      started = bson_get_monotonic_time ();
+      ok = _mongoc_rpc_decompress (rpc, buf, len);
+      _mongoc_cluster_phase_end (
+         cluster, MONGOC_SPAN_PHASE_DECOMPRESS, started);
+      if (!ok) {
          bson_free (buf);
          bson_set_error (error,
                          MONGOC_ERROR_PROTOCOL,
@@ -2720,41 +3460,37 @@ network_error_reply (bson_t *reply, mongoc_cmd_t *cmd)
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_send_opmsg --
+ *
+ *       Gather @cmd into an OP_MSG, compress it if negotiated, and write
+ *       it to the command's stream without waiting for a reply.
+ *
+ * Returns:
+ *       true if the message was written; otherwise false, @error is set,
+ *       @reply is initialized and the node is disconnected.
+ *
+ *--------------------------------------------------------------------------
+ */
+
 static bool
-mongoc_cluster_run_opmsg (mongoc_cluster_t *cluster,
-                          mongoc_cmd_t *cmd,
-                          bson_t *reply,
-                          bson_error_t *error)
+_mongoc_cluster_send_opmsg (mongoc_cluster_t *cluster,
+                            mongoc_cmd_t *cmd,
+                            bson_t *reply,
+                            bson_error_t *error)
 {
    mongoc_rpc_section_t section[2];
-   mongoc_buffer_t buffer;
-   bson_t reply_local; /* only statically initialized */
    char *output = NULL;
    mongoc_rpc_t rpc;
-   int32_t msg_len;
    bool ok;
    const mongoc_server_stream_t *server_stream;
+   int64_t started;
 
    server_stream = cmd->server_stream;
-   if (!cmd->command_name) {
-      bson_set_error (error,
-                      MONGOC_ERROR_COMMAND,
-                      MONGOC_ERROR_COMMAND_INVALID_ARG,
-                      "Empty command document");
-      _mongoc_bson_init_if_set (reply);
-      return false;
-   }
-   if (cluster->client->in_exhaust) {
-      bson_set_error (error,
-                      MONGOC_ERROR_CLIENT,
-                      MONGOC_ERROR_CLIENT_IN_EXHAUST,
-                      "A cursor derived from this client is in exhaust.");
-      _mongoc_bson_init_if_set (reply);
-      return false;
-   }
 
    _mongoc_array_clear (&cluster->iov);
-   _mongoc_buffer_init (&buffer, NULL, 0, NULL, NULL);
 
    rpc.header.msg_len = 0;
    rpc.header.request_id = ++cluster->request_id;
@@ -2797,127 +3533,220 @@ mongoc_cluster_run_opmsg (mongoc_cluster_t *cluster,
          output = _mongoc_rpc_compress (cluster, compressor_id, &rpc, error);
          if (output == NULL) {
             _mongoc_bson_init_if_set (reply);
-            _mongoc_buffer_destroy (&buffer);
             return false;
          }
       }
    }
+
+   /* only the write, not gathering or compressing the message */
+   started = bson_get_monotonic_time ();
    ok = _mongoc_stream_writev_full (server_stream->stream,
                                     (mongoc_iovec_t *) cluster->iov.data,
                                     cluster->iov.len,
                                     cluster->sockettimeoutms,
                                     error);
+   _mongoc_cluster_phase_end (cluster, MONGOC_SPAN_PHASE_SEND, started);
+   bson_free (output);
+
    if (!ok) {
       /* add info about the command to writev_full's error message */
       RUN_CMD_ERR_DECORATE;
       mongoc_cluster_disconnect_node (
          cluster, server_stream->sd->id, true, error);
-      bson_free (output);
+      network_error_reply (reply, cmd);
+      return false;
+   }
+
+   return true;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cluster_recv_opmsg --
+ *
+ *       Read the next OP_MSG reply from the command's stream, decompress
+ *       it if needed, and process it for @cmd. @sent is when @cmd finished
+ *       being written; the wait for its reply is measured from then, even
+ *       if other replies were read in the meantime.
+ *
+ * Returns:
+ *       true if the reply was read and is "ok"; otherwise false and
+ *       @error is set.
+ *
+ * Side effects:
+ *       @reply is set and should ALWAYS be released with bson_destroy().
+ *       On a network error the node is disconnected.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_cluster_recv_opmsg (mongoc_cluster_t *cluster,
+                            mongoc_cmd_t *cmd,
+                            int64_t sent,
+                            bson_t *reply,
+                            bson_error_t *error)
+{
+   mongoc_buffer_t buffer;
+   bson_t reply_local; /* only statically initialized */
+   char *output = NULL;
+   mongoc_rpc_t rpc;
+   int32_t msg_len;
+   bool ok;
+   const mongoc_server_stream_t *server_stream;
+   int64_t started;
+
+   server_stream = cmd->server_stream;
+
+   _mongoc_buffer_init (&buffer, NULL, 0, NULL, NULL);
+
+   /* waiting for the server, until the reply's first bytes arrive */
+   ok = _mongoc_buffer_append_from_stream (
+      &buffer, server_stream->stream, 4, cluster->sockettimeoutms, error);
+   _mongoc_cluster_phase_end (cluster, MONGOC_SPAN_PHASE_WAIT, sent);
+   if (!ok) {
+      RUN_CMD_ERR_DECORATE;
+      _mongoc_cluster_stream_timed_out (server_stream->stream,
+                                        server_stream->sd);
+      mongoc_cluster_disconnect_node (
+         cluster, server_stream->sd->id, true, error);
       network_error_reply (reply, cmd);
       _mongoc_buffer_destroy (&buffer);
       return false;
    }
 
-   /* If acknowledged, wait for a server response. Otherwise, exit early */
-   if (cmd->is_acknowledged) {
-      ok = _mongoc_buffer_append_from_stream (
-         &buffer, server_stream->stream, 4, cluster->sockettimeoutms, error);
-      if (!ok) {
-         RUN_CMD_ERR_DECORATE;
-         mongoc_cluster_disconnect_node (
-            cluster, server_stream->sd->id, true, error);
-         bson_free (output);
-         network_error_reply (reply, cmd);
-         _mongoc_buffer_destroy (&buffer);
-         return false;
-      }
+   BSON_ASSERT (buffer.len == 4);
+   memcpy (&msg_len, buffer.data, 4);
+   msg_len = BSON_UINT32_FROM_LE (msg_len);
+   if ((msg_len < 16) || (msg_len > server_stream->sd->max_msg_size)) {
+      RUN_CMD_ERR (MONGOC_ERROR_PROTOCOL,
+                   MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
+                   "Message size %d is not within expected range 16-%d bytes",
+                   msg_len,
+                   server_stream->sd->max_msg_size);
+      mongoc_cluster_disconnect_node (
+         cluster, server_stream->sd->id, true, error);
+      network_error_reply (reply, cmd);
+      _mongoc_buffer_destroy (&buffer);
+      return false;
+   }
 
-      BSON_ASSERT (buffer.len == 4);
-      memcpy (&msg_len, buffer.data, 4);
-      msg_len = BSON_UINT32_FROM_LE (msg_len);
-      if ((msg_len < 16) || (msg_len > server_stream->sd->max_msg_size)) {
-         RUN_CMD_ERR (
-            MONGOC_ERROR_PROTOCOL,
-            MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
-            "Message size %d is not within expected range 16-%d bytes",
-            msg_len,
-            server_stream->sd->max_msg_size);
-         mongoc_cluster_disconnect_node (
-            cluster, server_stream->sd->id, true, error);
-         bson_free (output);
-         network_error_reply (reply, cmd);
-         _mongoc_buffer_destroy (&buffer);
-         return false;
-      }
+   started = bson_get_monotonic_time ();
+   ok = _mongoc_buffer_append_from_stream (&buffer,
+                                           server_stream->stream,
+                                           (size_t) msg_len - 4,
+                                           cluster->sockettimeoutms,
+                                           error);
+   _mongoc_cluster_phase_end (cluster, MONGOC_SPAN_PHASE_RECEIVE, started);
+   if (!ok) {
+      RUN_CMD_ERR_DECORATE;
+      _mongoc_cluster_stream_timed_out (server_stream->stream,
+                                        server_stream->sd);
+      mongoc_cluster_disconnect_node (
+         cluster, server_stream->sd->id, true, error);
+      network_error_reply (reply, cmd);
+      _mongoc_buffer_destroy (&buffer);
+      return false;
+   }
 
-      ok = _mongoc_buffer_append_from_stream (&buffer,
-                                              server_stream->stream,
-                                              (size_t) msg_len - 4,
-                                              cluster->sockettimeoutms,
-                                              error);
-      if (!ok) {
-         RUN_CMD_ERR_DECORATE;
-         mongoc_cluster_disconnect_node (
-            cluster, server_stream->sd->id, true, error);
-         bson_free (output);
-         network_error_reply (reply, cmd);
-         _mongoc_buffer_destroy (&buffer);
-         return false;
-      }
+   ok = _mongoc_rpc_scatter (&rpc, buffer.data, buffer.len);
+   if (!ok) {
+      RUN_CMD_ERR (MONGOC_ERROR_PROTOCOL,
+                   MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
+                   "Malformed message from server");
+      network_error_reply (reply, cmd);
+      _mongoc_buffer_destroy (&buffer);
+      return false;
+   }
+   if (BSON_UINT32_FROM_LE (rpc.header.opcode) == MONGOC_OPCODE_COMPRESSED) {
+      size_t len = BSON_UINT32_FROM_LE (rpc.compressed.uncompressed_size) +
+                   sizeof (mongoc_rpc_header_t);
 
-      ok = _mongoc_rpc_scatter (&rpc, buffer.data, buffer.len);
+      output = bson_malloc (len);
+      started = bson_get_monotonic_time ();
+      ok = _mongoc_rpc_decompress (&rpc, (uint8_t *) output, len);
+      _mongoc_cluster_phase_end (
+         cluster, MONGOC_SPAN_PHASE_DECOMPRESS, started);
       if (!ok) {
          RUN_CMD_ERR (MONGOC_ERROR_PROTOCOL,
                       MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
-                      "Malformed message from server");
+                      "Could not decompress message from server");
+         mongoc_cluster_disconnect_node (
+            cluster, server_stream->sd->id, true, error);
          bson_free (output);
          network_error_reply (reply, cmd);
          _mongoc_buffer_destroy (&buffer);
          return false;
       }
-      if (BSON_UINT32_FROM_LE (rpc.header.opcode) == MONGOC_OPCODE_COMPRESSED) {
-         size_t len = BSON_UINT32_FROM_LE (rpc.compressed.uncompressed_size) +
-                      sizeof (mongoc_rpc_header_t);
+   }
 
-         output = bson_realloc (output, len);
-         if (!_mongoc_rpc_decompress (&rpc, (uint8_t *) output, len)) {
-            RUN_CMD_ERR (MONGOC_ERROR_PROTOCOL,
-                         MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
-                         "Could not decompress message from server");
-            mongoc_cluster_disconnect_node (
-               cluster, server_stream->sd->id, true, error);
-            bson_free (output);
-            network_error_reply (reply, cmd);
-            _mongoc_buffer_destroy (&buffer);
-            return false;
-         }
-      }
-      _mongoc_rpc_swab_from_le (&rpc);
+   started = bson_get_monotonic_time ();
+   _mongoc_rpc_swab_from_le (&rpc);
 
-      memcpy (&msg_len, rpc.msg.sections[0].payload.bson_document, 4);
-      msg_len = BSON_UINT32_FROM_LE (msg_len);
-      bson_init_static (
-         &reply_local, rpc.msg.sections[0].payload.bson_document, msg_len);
+   memcpy (&msg_len, rpc.msg.sections[0].payload.bson_document, 4);
+   msg_len = BSON_UINT32_FROM_LE (msg_len);
+   bson_init_static (
+      &reply_local, rpc.msg.sections[0].payload.bson_document, msg_len);
 
-      _mongoc_topology_update_cluster_time (cluster->client->topology,
-                                            &reply_local);
-      ok = _mongoc_cmd_check_ok (
-         &reply_local, cluster->client->error_api_version, error);
+   _mongoc_topology_update_cluster_time (cluster->client->topology,
+                                         &reply_local);
+   ok = _mongoc_cmd_check_ok (
+      &reply_local, cluster->client->error_api_version, error);
 
-      if (cmd->session) {
-         _mongoc_client_session_handle_reply (
-            cmd->session, cmd->is_acknowledged, &reply_local);
-      }
+   if (cmd->session) {
+      _mongoc_client_session_handle_reply (
+         cmd->session, cmd->is_acknowledged, &reply_local);
+   }
 
-      if (reply) {
-         bson_copy_to (&reply_local, reply);
-      }
-   } else {
-      _mongoc_bson_init_if_set (reply);
+   if (reply) {
+      bson_copy_to (&reply_local, reply);
    }
 
+   _mongoc_cluster_phase_end (cluster, MONGOC_SPAN_PHASE_PARSE, started);
+
    _mongoc_buffer_destroy (&buffer);
    bson_free (output);
 
    return ok;
 }
+
+
+static bool
+mongoc_cluster_run_opmsg (mongoc_cluster_t *cluster,
+                          mongoc_cmd_t *cmd,
+                          bson_t *reply,
+                          bson_error_t *error)
+{
+   if (!cmd->command_name) {
+      bson_set_error (error,
+                      MONGOC_ERROR_COMMAND,
+                      MONGOC_ERROR_COMMAND_INVALID_ARG,
+                      "Empty command document");
+      _mongoc_bson_init_if_set (reply);
+      return false;
+   }
+   if (cluster->client->in_exhaust) {
+      bson_set_error (error,
+                      MONGOC_ERROR_CLIENT,
+                      MONGOC_ERROR_CLIENT_IN_EXHAUST,
+                      "A cursor derived from this client is in exhaust.");
+      _mongoc_bson_init_if_set (reply);
+      return false;
+   }
+
+   if (!_mongoc_cluster_send_opmsg (cluster, cmd, reply, error)) {
+      return false;
+   }
+
+   /* If acknowledged, wait for a server response. Otherwise, exit early */
+   if (cmd->is_acknowledged) {
+      return _mongoc_cluster_recv_opmsg (
+         cluster, cmd, bson_get_monotonic_time (), reply, error);
+   }
+
+   _mongoc_bson_init_if_set (reply);
+
+   return true;
+}
@@ -762,12 +762,18 @@ mongoc_cmd_parts_assemble (mongoc_cmd_parts_t *parts,
    bool is_get_more;
    const mongoc_read_prefs_t *prefs_ptr;
    bool ret = false;
+   int64_t started;
 
    ENTRY;
 
    BSON_ASSERT (parts);
    BSON_ASSERT (server_stream);
 
+   /* a command on a stream checked out earlier, like a bulk write's second
+    * batch, begins a span here */
+   _mongoc_tracer_begin (&parts->client->tracer, false);
+   started = _mongoc_tracer_phase_begin (&parts->client->tracer);
+
    server_type = server_stream->sd->type;
    cs = parts->prohibit_lsid ? NULL : parts->assembled.session;
 
@@ -857,10 +863,8 @@ mongoc_cmd_parts_assemble (mongoc_cmd_parts_t *parts,
          }
 
          _mongoc_cmd_parts_ensure_copied (parts);
-         bson_append_document (&parts->assembled_body,
-                               "lsid",
-                               4,
-                               mongoc_client_session_get_lsid (cs));
+         bson_concat (&parts->assembled_body,
+                      &cs->server_session->lsid_fragment);
 
          cs->server_session->last_used_usec = bson_get_monotonic_time ();
          cluster_time = mongoc_client_session_get_cluster_time (cs);
@@ -884,15 +888,22 @@ mongoc_cmd_parts_assemble (mongoc_cmd_parts_t *parts,
          parts->is_retryable_write = true;
       }
 
+      /* prefer the topology's cluster time if it's as large as the
+       * session's, it's pre-encoded in server_stream */
       if (!bson_empty (&server_stream->cluster_time)) {
          cluster_time =
-            _largest_cluster_time (&server_stream->cluster_time, cluster_time);
+            _largest_cluster_time (cluster_time, &server_stream->cluster_time);
       }
 
       if (cluster_time && server_type != MONGOC_SERVER_STANDALONE) {
          _mongoc_cmd_parts_ensure_copied (parts);
-         bson_append_document (
-            &parts->assembled_body, "$clusterTime", 12, cluster_time);
+         if (cluster_time == &server_stream->cluster_time) {
+            bson_concat (&parts->assembled_body,
+                         &server_stream->cluster_time_fragment);
+         } else {
+            bson_append_document (
+               &parts->assembled_body, "$clusterTime", 12, cluster_time);
+         }
       }
 
       if (!is_get_more) {
@@ -931,6 +942,8 @@ mongoc_cmd_parts_assemble (mongoc_cmd_parts_t *parts,
 
 done:
    mongoc_read_prefs_destroy (prefs);
+   _mongoc_tracer_phase_end (
+      &parts->client->tracer, MONGOC_SPAN_PHASE_COMMAND_ASSEMBLY, started);
    RETURN (ret);
 }
 
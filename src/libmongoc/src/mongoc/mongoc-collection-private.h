@@ -22,6 +22,7 @@
 #include <bson/bson.h>
 
 #include "mongoc/mongoc-client.h"
+#include "mongoc/mongoc-opts-private.h"
 
 BSON_BEGIN_DECLS
 
@@ -48,6 +49,25 @@ _mongoc_collection_new (mongoc_client_t *client,
                         const mongoc_read_concern_t *read_concern,
                         const mongoc_write_concern_t *write_concern);
 
+void
+_mongoc_collection_append_update_statement_opts (
+   const mongoc_update_opts_t *update_opts,
+   bool multi,
+   const bson_t *array_filters,
+   bson_t *extra);
+
+bool
+_mongoc_collection_update_statement (mongoc_collection_t *collection,
+                                     const bson_t *selector,
+                                     const bson_t *update,
+                                     const mongoc_update_opts_t *update_opts,
+                                     bool multi,
+                                     bool bypass,
+                                     const bson_t *array_filters,
+                                     const bson_t *statement_opts,
+                                     bson_t *reply,
+                                     bson_error_t *error);
+
 BSON_END_DECLS
 
 
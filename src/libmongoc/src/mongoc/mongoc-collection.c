@@ -29,6 +29,7 @@
 #include "mongoc/mongoc-error.h"
 #include "mongoc/mongoc-index.h"
 #include "mongoc/mongoc-log.h"
+#include "mongoc/mongoc-prepared-private.h"
 #include "mongoc/mongoc-trace-private.h"
 #include "mongoc/mongoc-read-concern-private.h"
 #include "mongoc/mongoc-write-concern-private.h"
@@ -648,6 +649,34 @@ mongoc_collection_find_with_opts (mongoc_collection_t *collection,
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_collection_prepare_find --
+ *
+ *       Validate @opts and @read_prefs once for a find that is executed
+ *       many times with different filters. See
+ *       mongoc_prepared_find_execute.
+ *
+ * Returns:
+ *       A mongoc_prepared_find_t that must be freed with
+ *       mongoc_prepared_find_destroy, or NULL and @error is set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_prepared_find_t *
+mongoc_collection_prepare_find (mongoc_collection_t *collection,
+                                const bson_t *opts,
+                                const mongoc_read_prefs_t *read_prefs,
+                                bson_error_t *error)
+{
+   BSON_ASSERT (collection);
+
+   return _mongoc_prepared_find_new (collection, opts, read_prefs, error);
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -1941,6 +1970,92 @@ done:
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_collection_insert_raw --
+ *
+ *       Insert the BSON documents concatenated in @data, such as the
+ *       output of a bson_writer_t, without copying them into bson_t
+ *       structs or into the command's payload.
+ *
+ * Parameters:
+ *       @collection: A mongoc_collection_t.
+ *       @data: Concatenated BSON documents.
+ *       @data_len: Length of @data in bytes.
+ *       @opts: Standard command options, the same as insert_many.
+ *       @reply: Optional. Uninitialized doc to receive the insert result.
+ *       @error: A location for an error or NULL.
+ *
+ * Returns:
+ *       true if successful; otherwise false and @error is set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_collection_insert_raw (mongoc_collection_t *collection,
+                              const uint8_t *data,
+                              size_t data_len,
+                              const bson_t *opts,
+                              bson_t *reply,
+                              bson_error_t *error)
+{
+   mongoc_insert_many_opts_t insert_many_opts;
+   mongoc_write_command_t command;
+   mongoc_write_result_t result;
+   bool ret;
+
+   ENTRY;
+
+   BSON_ASSERT (collection);
+   BSON_ASSERT (data || !data_len);
+
+   _mongoc_bson_init_if_set (reply);
+
+   if (!_mongoc_insert_many_opts_parse (
+          collection->client, opts, &insert_many_opts, error)) {
+      _mongoc_insert_many_opts_cleanup (&insert_many_opts);
+      return false;
+   }
+
+   _mongoc_write_result_init (&result);
+   if (!_mongoc_write_command_init_insert_raw (
+          &command,
+          data,
+          data_len,
+          insert_many_opts.crud.validate,
+          &insert_many_opts.extra,
+          ++collection->client->cluster.operation_id,
+          error)) {
+      ret = false;
+      GOTO (done);
+   }
+
+   command.flags.ordered = insert_many_opts.ordered;
+   command.flags.bypass_document_validation = insert_many_opts.bypass;
+
+   _mongoc_collection_write_command_execute_idl (
+      &command, collection, &insert_many_opts.crud, &result);
+
+   ret = MONGOC_WRITE_RESULT_COMPLETE (&result,
+                                       collection->client->error_api_version,
+                                       insert_many_opts.crud.writeConcern,
+                                       /* no error domain override */
+                                       (mongoc_error_domain_t) 0,
+                                       reply,
+                                       error,
+                                       "insertedCount");
+
+done:
+   _mongoc_write_result_destroy (&result);
+   _mongoc_write_command_destroy (&command);
+   _mongoc_insert_many_opts_cleanup (&insert_many_opts);
+
+   RETURN (ret);
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -2042,30 +2157,25 @@ mongoc_collection_update (mongoc_collection_t *collection,
    RETURN (ret);
 }
 
-static bool
-_mongoc_collection_update_or_replace (mongoc_collection_t *collection,
-                                      const bson_t *selector,
-                                      const bson_t *update,
-                                      mongoc_update_opts_t *update_opts,
-                                      bool multi,
-                                      bool bypass,
-                                      const bson_t *array_filters,
-                                      bson_t *extra,
-                                      bson_t *reply,
-                                      bson_error_t *error)
-{
-   mongoc_write_command_t command;
-   mongoc_write_result_t result;
-   mongoc_server_stream_t *server_stream = NULL;
-   bool reply_initialized = false;
-   bool ret = false;
-
-   ENTRY;
-
-   BSON_ASSERT (collection);
-   BSON_ASSERT (selector);
-   BSON_ASSERT (update);
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_collection_append_update_statement_opts --
+ *
+ *       Append the per-statement fields of an update (upsert, collation,
+ *       arrayFilters, multi) to @extra, which already holds any
+ *       unrecognized options the user passed.
+ *
+ *--------------------------------------------------------------------------
+ */
 
+void
+_mongoc_collection_append_update_statement_opts (
+   const mongoc_update_opts_t *update_opts,
+   bool multi,
+   const bson_t *array_filters,
+   bson_t *extra)
+{
    if (update_opts->upsert) {
       bson_append_bool (extra, "upsert", 6, true);
    }
@@ -2081,13 +2191,56 @@ _mongoc_collection_update_or_replace (mongoc_collection_t *collection,
    if (multi) {
       bson_append_bool (extra, "multi", 5, true);
    }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_collection_update_statement --
+ *
+ *       Run a single update or replace statement. @statement_opts is
+ *       appended to the statement after "q" and "u", it must have been
+ *       built with _mongoc_collection_append_update_statement_opts.
+ *       @update_opts is not modified, so it may be reused for several
+ *       statements.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_collection_update_statement (mongoc_collection_t *collection,
+                                     const bson_t *selector,
+                                     const bson_t *update,
+                                     const mongoc_update_opts_t *update_opts,
+                                     bool multi,
+                                     bool bypass,
+                                     const bson_t *array_filters,
+                                     const bson_t *statement_opts,
+                                     bson_t *reply,
+                                     bson_error_t *error)
+{
+   mongoc_write_command_t command;
+   mongoc_write_result_t result;
+   mongoc_server_stream_t *server_stream = NULL;
+   mongoc_crud_opts_t crud;
+   bool reply_initialized = false;
+   bool ret = false;
+
+   ENTRY;
+
+   BSON_ASSERT (collection);
+   BSON_ASSERT (selector);
+   BSON_ASSERT (update);
+
+   crud = update_opts->crud;
 
    _mongoc_write_result_init (&result);
    _mongoc_write_command_init_update_idl (
       &command,
       selector,
       update,
-      extra,
+      statement_opts,
       ++collection->client->cluster.operation_id);
 
    command.flags.has_multi_write = multi;
@@ -2098,7 +2251,7 @@ _mongoc_collection_update_or_replace (mongoc_collection_t *collection,
 
    server_stream =
       mongoc_cluster_stream_for_writes (&collection->client->cluster,
-                                        update_opts->crud.client_session,
+                                        crud.client_session,
                                         reply,
                                         error);
 
@@ -2118,7 +2271,7 @@ _mongoc_collection_update_or_replace (mongoc_collection_t *collection,
       }
 
       if (!mongoc_write_concern_is_acknowledged (
-             update_opts->crud.writeConcern)) {
+             crud.writeConcern)) {
          bson_set_error (error,
                          MONGOC_ERROR_COMMAND,
                          MONGOC_ERROR_PROTOCOL_BAD_WIRE_VERSION,
@@ -2127,8 +2280,8 @@ _mongoc_collection_update_or_replace (mongoc_collection_t *collection,
       }
    }
 
-   if (_mongoc_client_session_in_txn (update_opts->crud.client_session) &&
-       update_opts->crud.writeConcern) {
+   if (_mongoc_client_session_in_txn (crud.client_session) &&
+       crud.writeConcern) {
       bson_set_error (error,
                       MONGOC_ERROR_COMMAND,
                       MONGOC_ERROR_COMMAND_INVALID_ARG,
@@ -2136,9 +2289,9 @@ _mongoc_collection_update_or_replace (mongoc_collection_t *collection,
       GOTO (done);
    }
 
-   if (!update_opts->crud.writeConcern) {
-      update_opts->crud.writeConcern = collection->write_concern;
-      update_opts->crud.write_concern_owned = false;
+   if (!crud.writeConcern) {
+      crud.writeConcern = collection->write_concern;
+      crud.write_concern_owned = false;
    }
 
    _mongoc_write_command_execute_idl (&command,
@@ -2147,7 +2300,7 @@ _mongoc_collection_update_or_replace (mongoc_collection_t *collection,
                                       collection->db,
                                       collection->collection,
                                       0 /* offset */,
-                                      &update_opts->crud,
+                                      &crud,
                                       &result);
 
    _mongoc_bson_init_if_set (reply);
@@ -2156,7 +2309,7 @@ _mongoc_collection_update_or_replace (mongoc_collection_t *collection,
    /* set fields described in CRUD spec for the UpdateResult */
    ret = MONGOC_WRITE_RESULT_COMPLETE (&result,
                                        collection->client->error_api_version,
-                                       update_opts->crud.writeConcern,
+                                       crud.writeConcern,
                                        /* no error domain override */
                                        (mongoc_error_domain_t) 0,
                                        reply,
@@ -2178,6 +2331,34 @@ done:
    RETURN (ret);
 }
 
+
+static bool
+_mongoc_collection_update_or_replace (mongoc_collection_t *collection,
+                                      const bson_t *selector,
+                                      const bson_t *update,
+                                      mongoc_update_opts_t *update_opts,
+                                      bool multi,
+                                      bool bypass,
+                                      const bson_t *array_filters,
+                                      bson_t *extra,
+                                      bson_t *reply,
+                                      bson_error_t *error)
+{
+   _mongoc_collection_append_update_statement_opts (
+      update_opts, multi, array_filters, extra);
+
+   return _mongoc_collection_update_statement (collection,
+                                               selector,
+                                               update,
+                                               update_opts,
+                                               multi,
+                                               bypass,
+                                               array_filters,
+                                               extra,
+                                               reply,
+                                               error);
+}
+
 bool
 mongoc_collection_update_one (mongoc_collection_t *collection,
                               const bson_t *selector,
@@ -2317,6 +2498,40 @@ mongoc_collection_replace_one (mongoc_collection_t *collection,
 }
 
 
+mongoc_prepared_update_t *
+mongoc_collection_prepare_update_one (mongoc_collection_t *collection,
+                                      const bson_t *opts,
+                                      bson_error_t *error)
+{
+   BSON_ASSERT (collection);
+
+   return _mongoc_prepared_update_new (
+      collection, MONGOC_PREPARED_UPDATE_ONE, opts, error);
+}
+
+mongoc_prepared_update_t *
+mongoc_collection_prepare_update_many (mongoc_collection_t *collection,
+                                       const bson_t *opts,
+                                       bson_error_t *error)
+{
+   BSON_ASSERT (collection);
+
+   return _mongoc_prepared_update_new (
+      collection, MONGOC_PREPARED_UPDATE_MANY, opts, error);
+}
+
+mongoc_prepared_update_t *
+mongoc_collection_prepare_replace_one (mongoc_collection_t *collection,
+                                       const bson_t *opts,
+                                       bson_error_t *error)
+{
+   BSON_ASSERT (collection);
+
+   return _mongoc_prepared_update_new (
+      collection, MONGOC_PREPARED_REPLACE_ONE, opts, error);
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
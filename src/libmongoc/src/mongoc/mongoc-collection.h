@@ -31,6 +31,7 @@
 #include "mongoc/mongoc-read-concern.h"
 #include "mongoc/mongoc-write-concern.h"
 #include "mongoc/mongoc-find-and-modify.h"
+#include "mongoc/mongoc-prepared.h"
 
 BSON_BEGIN_DECLS
 
@@ -170,6 +171,12 @@ mongoc_collection_find_with_opts (mongoc_collection_t *collection,
                                   const bson_t *opts,
                                   const mongoc_read_prefs_t *read_prefs)
    BSON_GNUC_WARN_UNUSED_RESULT;
+MONGOC_EXPORT (mongoc_prepared_find_t *)
+mongoc_collection_prepare_find (mongoc_collection_t *collection,
+                                const bson_t *opts,
+                                const mongoc_read_prefs_t *read_prefs,
+                                bson_error_t *error)
+   BSON_GNUC_WARN_UNUSED_RESULT;
 MONGOC_EXPORT (bool)
 mongoc_collection_insert (mongoc_collection_t *collection,
                           mongoc_insert_flags_t flags,
@@ -190,6 +197,13 @@ mongoc_collection_insert_many (mongoc_collection_t *collection,
                                bson_t *reply,
                                bson_error_t *error);
 MONGOC_EXPORT (bool)
+mongoc_collection_insert_raw (mongoc_collection_t *collection,
+                              const uint8_t *data,
+                              size_t data_len,
+                              const bson_t *opts,
+                              bson_t *reply,
+                              bson_error_t *error);
+MONGOC_EXPORT (bool)
 mongoc_collection_insert_bulk (mongoc_collection_t *collection,
                                mongoc_insert_flags_t flags,
                                const bson_t **documents,
@@ -225,6 +239,21 @@ mongoc_collection_replace_one (mongoc_collection_t *collection,
                                const bson_t *opts,
                                bson_t *reply,
                                bson_error_t *error);
+MONGOC_EXPORT (mongoc_prepared_update_t *)
+mongoc_collection_prepare_update_one (mongoc_collection_t *collection,
+                                      const bson_t *opts,
+                                      bson_error_t *error)
+   BSON_GNUC_WARN_UNUSED_RESULT;
+MONGOC_EXPORT (mongoc_prepared_update_t *)
+mongoc_collection_prepare_update_many (mongoc_collection_t *collection,
+                                       const bson_t *opts,
+                                       bson_error_t *error)
+   BSON_GNUC_WARN_UNUSED_RESULT;
+MONGOC_EXPORT (mongoc_prepared_update_t *)
+mongoc_collection_prepare_replace_one (mongoc_collection_t *collection,
+                                       const bson_t *opts,
+                                       bson_error_t *error)
+   BSON_GNUC_WARN_UNUSED_RESULT;
 MONGOC_EXPORT (bool)
 mongoc_collection_delete (mongoc_collection_t *collection,
                           mongoc_delete_flags_t flags,
@@ -183,6 +183,185 @@ enum {
 #undef COUNTER
 #endif
 
+
+/* latency histograms are log-linear: values below 8 microseconds have a
+ * bucket each, each larger power of two is split into 8 buckets, so a
+ * bucket's width is at most 1/8 of its values. values of 2^28 usec (about
+ * 4.5 minutes) or more are counted in the last bucket. */
+#define MONGOC_HISTOGRAM_SUB_BUCKETS 8
+#define MONGOC_HISTOGRAM_N_BUCKETS 208
+
+
+/* one CPU's share of a histogram, a whole number of cache lines */
+typedef struct {
+   int64_t count;
+   int64_t sum;
+   int64_t buckets[MONGOC_HISTOGRAM_N_BUCKETS];
+   int64_t padding[6];
+} mongoc_histogram_slots_t;
+
+
+BSON_STATIC_ASSERT2 (histogram_slots_t,
+                     sizeof (mongoc_histogram_slots_t) % 64 == 0);
+
+
+typedef struct {
+   mongoc_histogram_slots_t *cpus;
+} mongoc_histogram_t;
+
+
+static BSON_INLINE uint32_t
+_mongoc_histogram_bucket (int64_t usec)
+{
+   uint32_t msb = 0;
+   uint32_t bucket;
+   uint64_t v;
+
+   if (usec < MONGOC_HISTOGRAM_SUB_BUCKETS) {
+      return usec < 0 ? 0 : (uint32_t) usec;
+   }
+
+   v = (uint64_t) usec;
+   while (v >> (msb + 1)) {
+      msb++;
+   }
+
+   /* msb is at least 3, the top 4 bits of usec choose the bucket */
+   bucket = MONGOC_HISTOGRAM_SUB_BUCKETS * (msb - 2) +
+            (uint32_t) ((v >> (msb - 3)) & (MONGOC_HISTOGRAM_SUB_BUCKETS - 1));
+
+   return BSON_MIN (bucket, MONGOC_HISTOGRAM_N_BUCKETS - 1);
+}
+
+
+/* the smallest value counted in @bucket */
+static BSON_INLINE int64_t
+_mongoc_histogram_bucket_min (uint32_t bucket)
+{
+   uint32_t msb;
+
+   if (bucket < MONGOC_HISTOGRAM_SUB_BUCKETS) {
+      return (int64_t) bucket;
+   }
+
+   msb = bucket / MONGOC_HISTOGRAM_SUB_BUCKETS + 2;
+   return (int64_t) (MONGOC_HISTOGRAM_SUB_BUCKETS +
+                     bucket % MONGOC_HISTOGRAM_SUB_BUCKETS)
+          << (msb - 3);
+}
+
+
+#define HISTOGRAM(ident, Category, Name, Description) \
+   extern mongoc_histogram_t __mongoc_histogram_##ident;
+#include "mongoc-histograms.defs"
+#undef HISTOGRAM
+
+
+enum {
+#define HISTOGRAM(ident, Category, Name, Description) HISTOGRAM_##ident,
+#include "mongoc-histograms.defs"
+#undef HISTOGRAM
+   LAST_HISTOGRAM
+};
+
+#ifdef MONGOC_ENABLE_SHM_COUNTERS
+#define HISTOGRAM(ident, Category, Name, Description)                        \
+   static BSON_INLINE void mongoc_histogram_##ident##_record (int64_t usec) \
+   {                                                                        \
+      mongoc_histogram_slots_t *_slots =                                    \
+         &__mongoc_histogram_##ident.cpus[_mongoc_sched_getcpu ()];         \
+      (void) _mongoc_counter_add (                                          \
+         _slots->buckets[_mongoc_histogram_bucket (usec)], 1);              \
+      (void) _mongoc_counter_add (_slots->sum, usec);                       \
+      (void) _mongoc_counter_add (_slots->count, 1);                        \
+   }
+#include "mongoc-histograms.defs"
+#undef HISTOGRAM
+#else
+/* when counters are disabled, these functions are no-ops */
+#define HISTOGRAM(ident, Category, Name, Description)                        \
+   static BSON_INLINE void mongoc_histogram_##ident##_record (int64_t usec) \
+   {                                                                        \
+   }
+#include "mongoc-histograms.defs"
+#undef HISTOGRAM
+#endif
+
+
+/* the shared memory segment also has a fixed-size table of counters per
+ * server, and per namespace on each server if the MONGOC_NAMESPACE_COUNTERS
+ * environment variable is set. entries are claimed the first time a key is
+ * seen and never freed; once the table is full, new keys are counted in its
+ * last entry, which has the host "(other)". */
+#define MONGOC_COUNTERS_TABLE_SIZE 256
+
+#define MONGOC_COUNTERS_ENTRY_FREE 0
+#define MONGOC_COUNTERS_ENTRY_READY 1
+
+
+/* each entry's counters are per-CPU, like the counters above: a
+ * mongoc_counter_slots_t for each CPU, in a region of the segment after the
+ * entries. these are the counters' slots. */
+enum {
+   MONGOC_COUNTERS_SLOT_OPS,
+   MONGOC_COUNTERS_SLOT_ERRORS,
+   MONGOC_COUNTERS_SLOT_TIMEOUTS,
+   MONGOC_COUNTERS_SLOT_CONNECTIONS,
+   MONGOC_COUNTERS_SLOT_EGRESS_BYTES,
+   MONGOC_COUNTERS_SLOT_INGRESS_BYTES,
+   MONGOC_COUNTERS_N_SLOTS
+};
+
+
+BSON_STATIC_ASSERT2 (counters_n_slots,
+                     MONGOC_COUNTERS_N_SLOTS <= SLOTS_PER_CACHELINE);
+
+
+#pragma pack(1)
+typedef struct _mongoc_counters_entry_t {
+   uint32_t state;
+   uint32_t padding;
+   char host[64];
+   /* "db.collection", "db" for database commands, empty for the server's
+    * totals */
+   char ns[128];
+   uint8_t padding2[56];
+} mongoc_counters_entry_t;
+#pragma pack()
+
+
+BSON_STATIC_ASSERT2 (counters_entry_t,
+                     sizeof (mongoc_counters_entry_t) == 256);
+
+
+mongoc_counters_entry_t *
+_mongoc_counters_entry (const char *host, const char *ns);
+
+bool
+_mongoc_counters_namespaces_enabled (void);
+
+void
+_mongoc_counters_set_namespaces_enabled (bool enabled);
+
+void
+_mongoc_counters_record_command (mongoc_counters_entry_t *server_entry,
+                                 const char *host,
+                                 const char *db,
+                                 const char *collection,
+                                 int64_t egress_bytes,
+                                 int64_t ingress_bytes,
+                                 bool failed);
+
+int64_t
+_mongoc_counters_entry_get (const mongoc_counters_entry_t *entry,
+                            uint32_t slot);
+
+void
+_mongoc_counters_record_timeout (const char *host);
+
+void
+_mongoc_counters_record_connection (const char *host);
+
 BSON_END_DECLS
 
 
@@ -18,6 +18,7 @@
 #include <bson/bson.h>
 
 #include <fcntl.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -32,6 +33,7 @@
 
 #include "mongoc/mongoc-counters-private.h"
 #include "mongoc/mongoc-log.h"
+#include "mongoc/mongoc-thread-private.h"
 
 
 #pragma pack(1)
@@ -55,7 +57,13 @@ typedef struct {
    uint32_t n_counters;
    uint32_t infos_offset;
    uint32_t values_offset;
-   uint8_t padding[44];
+   uint32_t n_histograms;
+   uint32_t histogram_infos_offset;
+   uint32_t histogram_values_offset;
+   uint32_t table_size;
+   uint32_t table_offset;
+   uint32_t table_values_offset;
+   uint8_t padding[20];
 } mongoc_counters_t;
 #pragma pack()
 
@@ -75,6 +83,25 @@ static void *gCounterFallback = NULL;
 #include "mongoc-counters.defs"
 #undef COUNTER
 
+#define HISTOGRAM(ident, Category, Name, Description) \
+   mongoc_histogram_t __mongoc_histogram_##ident;
+#include "mongoc-histograms.defs"
+#undef HISTOGRAM
+
+/* the whole segment, for mongoc_counters_openmetrics */
+static const char *gCounterSegment = NULL;
+
+/* entries are claimed with the mutex held, and read without it */
+static mongoc_counters_entry_t *gCounterTable = NULL;
+static bson_mutex_t gCounterTableMutex;
+
+/* each entry's counters, gCounterCpus slots per entry */
+static mongoc_counter_slots_t *gCounterTableValues = NULL;
+static uint32_t gCounterCpus = 0;
+
+/* whether commands are also counted per namespace, which costs a lookup */
+static bool gCounterNamespaces = false;
+
 /**
  * mongoc_counters_use_shm:
  *
@@ -92,8 +119,9 @@ mongoc_counters_use_shm (void)
  * mongoc_counters_calc_size:
  *
  * Returns the number of bytes required for the shared memory segment of
- * the process. This segment contains the various statistical counters for
- * the process.
+ * the process. This segment contains the various statistical counters and
+ * latency histograms for the process, and the table of counters per server
+ * and namespace with each entry's per-CPU values.
  *
  * Returns: The number of bytes required.
  */
@@ -108,7 +136,12 @@ mongoc_counters_calc_size (void)
    n_groups = (LAST_COUNTER / SLOTS_PER_CACHELINE) + 1;
    size = (sizeof (mongoc_counters_t) +
            (LAST_COUNTER * sizeof (mongoc_counter_info_t)) +
-           (n_cpu * n_groups * sizeof (mongoc_counter_slots_t)));
+           (n_cpu * n_groups * sizeof (mongoc_counter_slots_t)) +
+           (LAST_HISTOGRAM * sizeof (mongoc_counter_info_t)) +
+           (n_cpu * LAST_HISTOGRAM * sizeof (mongoc_histogram_slots_t)) +
+           (MONGOC_COUNTERS_TABLE_SIZE * sizeof (mongoc_counters_entry_t)) +
+           (n_cpu * MONGOC_COUNTERS_TABLE_SIZE *
+            sizeof (mongoc_counter_slots_t)));
 
 #ifdef BSON_OS_UNIX
    return BSON_MAX (getpagesize (), size);
@@ -128,6 +161,9 @@ void
 _mongoc_counters_cleanup (void)
 {
 #ifdef MONGOC_ENABLE_SHM_COUNTERS
+   bson_mutex_destroy (&gCounterTableMutex);
+   gCounterSegment = NULL;
+
    if (gCounterFallback) {
       bson_free (gCounterFallback);
       gCounterFallback = NULL;
@@ -273,6 +309,58 @@ mongoc_counters_register (mongoc_counters_t *counters,
 
    return infos->offset;
 }
+
+
+/**
+ * mongoc_counters_register_histogram:
+ * @counters: A mongoc_counter_t.
+ * @num: The histogram number.
+ * @category: The histogram category.
+ * @name: The histogram name.
+ * @description The histogram description.
+ *
+ * Registers a new latency histogram in the memory segment for counters, like
+ * mongoc_counters_register(). Its info's slot is unused, each CPU's values
+ * are a mongoc_histogram_slots_t.
+ *
+ * Returns: The offset to the data for the histogram's values.
+ */
+static size_t
+mongoc_counters_register_histogram (mongoc_counters_t *counters,
+                                    uint32_t num,
+                                    const char *category,
+                                    const char *name,
+                                    const char *description)
+{
+   mongoc_counter_info_t *infos;
+   char *segment;
+   int n_cpu;
+
+   BSON_ASSERT (counters);
+   BSON_ASSERT (category);
+   BSON_ASSERT (name);
+   BSON_ASSERT (description);
+
+   n_cpu = _mongoc_get_cpu_count ();
+   segment = (char *) counters;
+
+   infos =
+      (mongoc_counter_info_t *) (segment + counters->histogram_infos_offset);
+   infos = &infos[counters->n_histograms];
+   infos->slot = 0;
+   infos->offset = (counters->histogram_values_offset +
+                    (num * n_cpu * sizeof (mongoc_histogram_slots_t)));
+
+   bson_strncpy (infos->category, category, sizeof infos->category);
+   bson_strncpy (infos->name, name, sizeof infos->name);
+   bson_strncpy (infos->description, description, sizeof infos->description);
+
+   bson_memory_barrier ();
+
+   counters->n_histograms++;
+
+   return infos->offset;
+}
 #endif
 
 /**
@@ -286,8 +374,10 @@ _mongoc_counters_init (void)
 {
 #ifdef MONGOC_ENABLE_SHM_COUNTERS
    mongoc_counter_info_t *info;
+   mongoc_counters_entry_t *overflow;
    mongoc_counters_t *counters;
    size_t infos_size;
+   size_t values_size;
    size_t off;
    size_t size;
    char *segment;
@@ -304,6 +394,32 @@ _mongoc_counters_init (void)
 
    BSON_ASSERT ((counters->values_offset % 64) == 0);
 
+   values_size = (counters->n_cpu * ((LAST_COUNTER / SLOTS_PER_CACHELINE) + 1) *
+                  sizeof (mongoc_counter_slots_t));
+   counters->n_histograms = 0;
+   counters->histogram_infos_offset =
+      (uint32_t) (counters->values_offset + values_size);
+   counters->histogram_values_offset =
+      (uint32_t) (counters->histogram_infos_offset +
+                  LAST_HISTOGRAM * sizeof *info);
+
+   BSON_ASSERT ((counters->histogram_values_offset % 64) == 0);
+
+   counters->table_size = MONGOC_COUNTERS_TABLE_SIZE;
+   counters->table_offset =
+      (uint32_t) (counters->histogram_values_offset +
+                  (counters->n_cpu * LAST_HISTOGRAM *
+                   sizeof (mongoc_histogram_slots_t)));
+
+   BSON_ASSERT ((counters->table_offset % 64) == 0);
+
+   counters->table_values_offset =
+      (uint32_t) (counters->table_offset +
+                  (MONGOC_COUNTERS_TABLE_SIZE *
+                   sizeof (mongoc_counters_entry_t)));
+
+   BSON_ASSERT ((counters->table_values_offset % 64) == 0);
+
 #define COUNTER(ident, Category, Name, Desc)            \
    off = mongoc_counters_register (                     \
       counters, COUNTER_##ident, Category, Name, Desc); \
@@ -311,6 +427,25 @@ _mongoc_counters_init (void)
 #include "mongoc-counters.defs"
 #undef COUNTER
 
+#define HISTOGRAM(ident, Category, Name, Desc)              \
+   off = mongoc_counters_register_histogram (               \
+      counters, HISTOGRAM_##ident, Category, Name, Desc);   \
+   __mongoc_histogram_##ident.cpus =                        \
+      (mongoc_histogram_slots_t *) (segment + off);
+#include "mongoc-histograms.defs"
+#undef HISTOGRAM
+
+   bson_mutex_init (&gCounterTableMutex);
+   gCounterNamespaces = !!getenv ("MONGOC_NAMESPACE_COUNTERS");
+   gCounterTable =
+      (mongoc_counters_entry_t *) (segment + counters->table_offset);
+   gCounterTableValues =
+      (mongoc_counter_slots_t *) (segment + counters->table_values_offset);
+   gCounterCpus = counters->n_cpu;
+   overflow = &gCounterTable[MONGOC_COUNTERS_TABLE_SIZE - 1];
+   bson_strncpy (overflow->host, "(other)", sizeof overflow->host);
+   overflow->state = MONGOC_COUNTERS_ENTRY_READY;
+
    /*
     * NOTE:
     *
@@ -320,5 +455,829 @@ _mongoc_counters_init (void)
     */
    bson_memory_barrier ();
    counters->size = (uint32_t) size;
+   gCounterSegment = segment;
+#endif
+}
+
+
+#ifdef MONGOC_ENABLE_SHM_COUNTERS
+/* FNV-1a over both keys, so "a" "bc" and "ab" "c" differ */
+static uint32_t
+_mongoc_counters_entry_hash (const char *host, const char *ns)
+{
+   uint32_t hash = 2166136261u;
+   const char *p;
+
+   for (p = host; *p; p++) {
+      hash = (hash ^ (uint8_t) *p) * 16777619u;
+   }
+
+   hash *= 16777619u;
+
+   for (p = ns; *p; p++) {
+      hash = (hash ^ (uint8_t) *p) * 16777619u;
+   }
+
+   return hash;
+}
+
+
+static bool
+_mongoc_counters_entry_matches (const mongoc_counters_entry_t *entry,
+                                const char *host,
+                                const char *ns)
+{
+   return !strcmp (entry->host, host) && !strcmp (entry->ns, ns);
+}
+#endif
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_counters_entry --
+ *
+ *       Find the table entry for @host and @ns, claiming a free entry the
+ *       first time they are seen. Keys longer than an entry's fields are
+ *       truncated. Pass NULL or "" for @ns to get the server's totals.
+ *
+ *       Entries are found by linear probing from the keys' hash. Claimed
+ *       entries never change their keys, so looking up a known key takes
+ *       no lock; claiming an entry takes a process-wide mutex.
+ *
+ * Returns:
+ *       The entry, or the "(other)" entry if the table is full. NULL if
+ *       the driver was built without shared memory counters.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_counters_entry_t *
+_mongoc_counters_entry (const char *host, const char *ns)
+{
+#ifdef MONGOC_ENABLE_SHM_COUNTERS
+   mongoc_counters_entry_t *entry;
+   char host_key[sizeof entry->host];
+   char ns_key[sizeof entry->ns];
+   const uint32_t n_probes = MONGOC_COUNTERS_TABLE_SIZE - 1;
+   uint32_t start;
+   uint32_t i;
+
+   BSON_ASSERT (host);
+
+   bson_strncpy (host_key, host, sizeof host_key);
+   bson_strncpy (ns_key, ns ? ns : "", sizeof ns_key);
+   start = _mongoc_counters_entry_hash (host_key, ns_key) % n_probes;
+
+   for (i = 0; i < n_probes; i++) {
+      entry = &gCounterTable[(start + i) % n_probes];
+      if (entry->state == MONGOC_COUNTERS_ENTRY_FREE) {
+         break;
+      }
+
+      bson_memory_barrier ();
+      if (_mongoc_counters_entry_matches (entry, host_key, ns_key)) {
+         return entry;
+      }
+   }
+
+   if (i == n_probes) {
+      return &gCounterTable[n_probes];
+   }
+
+   /* probe again, another thread may have claimed an entry for the key */
+   bson_mutex_lock (&gCounterTableMutex);
+   for (; i < n_probes; i++) {
+      entry = &gCounterTable[(start + i) % n_probes];
+      if (entry->state == MONGOC_COUNTERS_ENTRY_FREE) {
+         bson_strncpy (entry->host, host_key, sizeof entry->host);
+         bson_strncpy (entry->ns, ns_key, sizeof entry->ns);
+         bson_memory_barrier ();
+         entry->state = MONGOC_COUNTERS_ENTRY_READY;
+         break;
+      }
+
+      if (_mongoc_counters_entry_matches (entry, host_key, ns_key)) {
+         break;
+      }
+   }
+   bson_mutex_unlock (&gCounterTableMutex);
+
+   if (i == n_probes) {
+      return &gCounterTable[n_probes];
+   }
+
+   return entry;
+#else
+   return NULL;
+#endif
+}
+
+
+bool
+_mongoc_counters_namespaces_enabled (void)
+{
+#ifdef MONGOC_ENABLE_SHM_COUNTERS
+   return gCounterNamespaces;
+#else
+   return false;
+#endif
+}
+
+
+/* for tests */
+void
+_mongoc_counters_set_namespaces_enabled (bool enabled)
+{
+#ifdef MONGOC_ENABLE_SHM_COUNTERS
+   gCounterNamespaces = enabled;
+#endif
+}
+
+
+#ifdef MONGOC_ENABLE_SHM_COUNTERS
+/* @entry's values, one mongoc_counter_slots_t per CPU */
+static mongoc_counter_slots_t *
+_mongoc_counters_entry_cpus (const mongoc_counters_entry_t *entry)
+{
+   return &gCounterTableValues[(size_t) (entry - gCounterTable) *
+                               gCounterCpus];
+}
+
+
+static void
+_mongoc_counters_entry_add_command (mongoc_counters_entry_t *entry,
+                                    int64_t egress_bytes,
+                                    int64_t ingress_bytes,
+                                    bool failed)
+{
+   int64_t *slots;
+
+   slots = _mongoc_counters_entry_cpus (entry)[_mongoc_sched_getcpu ()].slots;
+   (void) _mongoc_counter_add (slots[MONGOC_COUNTERS_SLOT_OPS], 1);
+   (void) _mongoc_counter_add (slots[MONGOC_COUNTERS_SLOT_EGRESS_BYTES],
+                               egress_bytes);
+   (void) _mongoc_counter_add (slots[MONGOC_COUNTERS_SLOT_INGRESS_BYTES],
+                               ingress_bytes);
+   if (failed) {
+      (void) _mongoc_counter_add (slots[MONGOC_COUNTERS_SLOT_ERRORS], 1);
+   }
+}
+
+
+static void
+_mongoc_counters_entry_inc (mongoc_counters_entry_t *entry, uint32_t slot)
+{
+   (void) _mongoc_counter_add (
+      _mongoc_counters_entry_cpus (entry)[_mongoc_sched_getcpu ()].slots[slot],
+      1);
+}
+#endif
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_counters_record_command --
+ *
+ *       Count a command sent to @host in the server's entry, and if
+ *       namespaces are counted, in the entry for its namespace on that
+ *       server. @server_entry is the server's entry if the caller has it
+ *       cached, otherwise NULL. @collection is NULL for database
+ *       commands.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_counters_record_command (mongoc_counters_entry_t *server_entry,
+                                 const char *host,
+                                 const char *db,
+                                 const char *collection,
+                                 int64_t egress_bytes,
+                                 int64_t ingress_bytes,
+                                 bool failed)
+{
+#ifdef MONGOC_ENABLE_SHM_COUNTERS
+   mongoc_counters_entry_t *ns_entry;
+   char ns[sizeof ns_entry->ns];
+
+   if (!server_entry) {
+      server_entry = _mongoc_counters_entry (host, NULL);
+   }
+
+   _mongoc_counters_entry_add_command (
+      server_entry, egress_bytes, ingress_bytes, failed);
+
+   if (!gCounterNamespaces) {
+      return;
+   }
+
+   if (collection) {
+      bson_snprintf (ns, sizeof ns, "%s.%s", db, collection);
+   } else {
+      bson_strncpy (ns, db, sizeof ns);
+   }
+
+   /* unless both are the "(other)" entry */
+   ns_entry = _mongoc_counters_entry (host, ns);
+   if (ns_entry != server_entry) {
+      _mongoc_counters_entry_add_command (
+         ns_entry, egress_bytes, ingress_bytes, failed);
+   }
+#endif
+}
+
+
+/* the sum of @entry's counter in @slot over all CPUs */
+int64_t
+_mongoc_counters_entry_get (const mongoc_counters_entry_t *entry,
+                            uint32_t slot)
+{
+#ifdef MONGOC_ENABLE_SHM_COUNTERS
+   const mongoc_counter_slots_t *cpus;
+   int64_t total = 0;
+   uint32_t cpu;
+
+   BSON_ASSERT (slot < MONGOC_COUNTERS_N_SLOTS);
+
+   cpus = _mongoc_counters_entry_cpus (entry);
+   for (cpu = 0; cpu < gCounterCpus; cpu++) {
+      total += cpus[cpu].slots[slot];
+   }
+
+   return total;
+#else
+   return 0;
+#endif
+}
+
+
+void
+_mongoc_counters_record_timeout (const char *host)
+{
+#ifdef MONGOC_ENABLE_SHM_COUNTERS
+   _mongoc_counters_entry_inc (_mongoc_counters_entry (host, NULL),
+                               MONGOC_COUNTERS_SLOT_TIMEOUTS);
+#endif
+}
+
+
+void
+_mongoc_counters_record_connection (const char *host)
+{
+#ifdef MONGOC_ENABLE_SHM_COUNTERS
+   _mongoc_counters_entry_inc (_mongoc_counters_entry (host, NULL),
+                               MONGOC_COUNTERS_SLOT_CONNECTIONS);
+#endif
+}
+
+
+#ifdef MONGOC_ENABLE_SHM_COUNTERS
+/* the counters, histograms, and table of one process's segment */
+typedef struct {
+   const char *segment;
+   size_t size;
+   /* 'pid="123"' when exporting other processes' counters, or "" */
+   char pid_label[32];
+} mongoc_counters_source_t;
+
+
+typedef struct {
+   const char *ident;
+   const char *category;
+   const char *name;
+   const char *description;
+} mongoc_counters_def_t;
+
+
+static const mongoc_counters_def_t gCounterDefs[] = {
+#define COUNTER(ident, Category, Name, Description) \
+   {#ident, Category, Name, Description},
+#include "mongoc-counters.defs"
+#undef COUNTER
+};
+
+
+static const mongoc_counters_def_t gHistogramDefs[] = {
+#define HISTOGRAM(ident, Category, Name, Description) \
+   {#ident, Category, Name, Description},
+#include "mongoc-histograms.defs"
+#undef HISTOGRAM
+};
+
+
+/* the table's fields, exported as one family each */
+typedef struct {
+   const char *family;
+   const char *help;
+   uint32_t slot;
+   bool per_namespace;
+} mongoc_counters_entry_def_t;
+
+
+static const mongoc_counters_entry_def_t gEntryDefs[] = {
+   {"server_commands",
+    "The number of commands sent to each server.",
+    MONGOC_COUNTERS_SLOT_OPS,
+    false},
+   {"server_errors",
+    "The number of commands to each server that failed.",
+    MONGOC_COUNTERS_SLOT_ERRORS,
+    false},
+   {"server_timeouts",
+    "The number of socket timeouts reading from each server.",
+    MONGOC_COUNTERS_SLOT_TIMEOUTS,
+    false},
+   {"server_connections",
+    "The number of connections opened to each server.",
+    MONGOC_COUNTERS_SLOT_CONNECTIONS,
+    false},
+   {"server_egress_bytes",
+    "The bytes of commands sent to each server.",
+    MONGOC_COUNTERS_SLOT_EGRESS_BYTES,
+    false},
+   {"server_ingress_bytes",
+    "The bytes of replies received from each server.",
+    MONGOC_COUNTERS_SLOT_INGRESS_BYTES,
+    false},
+   {"namespace_commands",
+    "The number of commands sent for each namespace on each server.",
+    MONGOC_COUNTERS_SLOT_OPS,
+    true},
+   {"namespace_errors",
+    "The number of commands for each namespace on each server that failed.",
+    MONGOC_COUNTERS_SLOT_ERRORS,
+    true},
+   {"namespace_egress_bytes",
+    "The bytes of commands sent for each namespace on each server.",
+    MONGOC_COUNTERS_SLOT_EGRESS_BYTES,
+    true},
+   {"namespace_ingress_bytes",
+    "The bytes of replies received for each namespace on each server.",
+    MONGOC_COUNTERS_SLOT_INGRESS_BYTES,
+    true},
+};
+
+
+/* find the info for a counter or histogram in @source by its category and
+ * name, since the process may run another version of the driver. NULL if
+ * it has no such counter, or if the segment is too small to hold it. */
+static const mongoc_counter_info_t *
+_mongoc_counters_source_find (const mongoc_counters_source_t *source,
+                              uint32_t n_infos,
+                              uint32_t infos_offset,
+                              size_t values_size,
+                              const mongoc_counters_def_t *def)
+{
+   const mongoc_counter_info_t *infos;
+   uint32_t i;
+
+   if ((size_t) infos_offset + (size_t) n_infos * sizeof *infos >
+       source->size) {
+      return NULL;
+   }
+
+   infos = (const mongoc_counter_info_t *) (source->segment + infos_offset);
+   for (i = 0; i < n_infos; i++) {
+      if (!strncmp (infos[i].category, def->category, sizeof infos->category) &&
+          !strncmp (infos[i].name, def->name, sizeof infos->name)) {
+         if ((size_t) infos[i].offset + values_size > source->size ||
+             infos[i].offset % 8 != 0) {
+            return NULL;
+         }
+
+         return &infos[i];
+      }
+   }
+
+   return NULL;
+}
+
+
+/* append a label in the text format, escaping its value */
+static void
+_mongoc_counters_append_label (bson_string_t *labels,
+                               const char *name,
+                               const char *value)
+{
+   const char *p;
+
+   bson_string_append_printf (
+      labels, "%s%s=\"", labels->len ? "," : "", name);
+
+   for (p = value; *p; p++) {
+      if (*p == '\\') {
+         bson_string_append (labels, "\\\\");
+      } else if (*p == '"') {
+         bson_string_append (labels, "\\\"");
+      } else if (*p == '\n') {
+         bson_string_append (labels, "\\n");
+      } else {
+         bson_string_append_c (labels, *p);
+      }
+   }
+
+   bson_string_append_c (labels, '"');
+}
+
+
+static void
+_mongoc_counters_append_sample (bson_string_t *str,
+                                const char *family,
+                                const char *suffix,
+                                const bson_string_t *labels,
+                                const char *value)
+{
+   bson_string_append_printf (str,
+                              "mongoc_%s%s%s%s%s %s\n",
+                              family,
+                              suffix,
+                              labels->len ? "{" : "",
+                              labels->str,
+                              labels->len ? "}" : "",
+                              value);
+}
+
+
+static void
+_mongoc_counters_append_counters (bson_string_t *str,
+                                  const mongoc_counters_source_t *sources,
+                                  size_t n_sources)
+{
+   const mongoc_counters_def_t *def;
+   const mongoc_counters_t *counters;
+   const mongoc_counter_info_t *info;
+   const mongoc_counter_slots_t *cpus;
+   bson_string_t *labels;
+   char family[64];
+   char value[32];
+   bool is_gauge;
+   size_t len;
+   size_t i;
+   size_t j;
+   uint32_t cpu;
+   int64_t total;
+
+   for (i = 0; i < sizeof gCounterDefs / sizeof gCounterDefs[0]; i++) {
+      def = &gCounterDefs[i];
+      len = strlen (def->ident);
+      is_gauge = len > 7 && !strcmp (def->ident + len - 7, "_active");
+
+      /* a counter's samples are named "<family>_total" */
+      bson_strncpy (family, def->ident, sizeof family);
+      if (len > 6 && !strcmp (family + len - 6, "_total")) {
+         family[len - 6] = '\0';
+      }
+
+      bson_string_append_printf (str,
+                                 "# TYPE mongoc_%s %s\n"
+                                 "# HELP mongoc_%s %s\n",
+                                 family,
+                                 is_gauge ? "gauge" : "counter",
+                                 family,
+                                 def->description);
+
+      for (j = 0; j < n_sources; j++) {
+         counters = (const mongoc_counters_t *) sources[j].segment;
+         info = _mongoc_counters_source_find (
+            &sources[j],
+            counters->n_counters,
+            counters->infos_offset,
+            counters->n_cpu * sizeof (mongoc_counter_slots_t),
+            def);
+         if (!info) {
+            continue;
+         }
+
+         cpus = (const mongoc_counter_slots_t *) (sources[j].segment +
+                                                  info->offset);
+         total = 0;
+         for (cpu = 0; cpu < counters->n_cpu; cpu++) {
+            total += cpus[cpu].slots[info->slot % SLOTS_PER_CACHELINE];
+         }
+
+         labels = bson_string_new (sources[j].pid_label);
+         bson_snprintf (value, sizeof value, "%" PRId64, total);
+         _mongoc_counters_append_sample (
+            str, family, is_gauge ? "" : "_total", labels, value);
+         bson_string_free (labels, true);
+      }
+   }
+}
+
+
+/* histograms are exported in seconds with a bucket for each power of two
+ * microseconds, the boundaries of every MONGOC_HISTOGRAM_SUB_BUCKETS
+ * buckets. values are whole microseconds, so the bucket counting values
+ * below 2^n usec has the bound le="(2^n - 1) / 10^6". */
+static void
+_mongoc_counters_append_histograms (bson_string_t *str,
+                                    const mongoc_counters_source_t *sources,
+                                    size_t n_sources)
+{
+   const mongoc_counters_def_t *def;
+   const mongoc_counters_t *counters;
+   const mongoc_counter_info_t *info;
+   const mongoc_histogram_slots_t *cpus;
+   bson_string_t *labels;
+   const char *unit;
+   char family[64];
+   char value[32];
+   char le[32];
+   size_t help_len;
+   size_t i;
+   size_t j;
+   uint32_t cpu;
+   uint32_t bucket;
+   int64_t count;
+   int64_t sum;
+
+   for (i = 0; i < sizeof gHistogramDefs / sizeof gHistogramDefs[0]; i++) {
+      def = &gHistogramDefs[i];
+      bson_snprintf (family, sizeof family, "%s_duration_seconds", def->ident);
+
+      /* the descriptions give mongoc-stat's unit */
+      unit = strstr (def->description, ", in microseconds");
+      help_len = unit ? (size_t) (unit - def->description)
+                      : strlen (def->description);
+
+      bson_string_append_printf (str,
+                                 "# TYPE mongoc_%s histogram\n"
+                                 "# UNIT mongoc_%s seconds\n"
+                                 "# HELP mongoc_%s %.*s.\n",
+                                 family,
+                                 family,
+                                 family,
+                                 (int) help_len,
+                                 def->description);
+
+      for (j = 0; j < n_sources; j++) {
+         counters = (const mongoc_counters_t *) sources[j].segment;
+         info = _mongoc_counters_source_find (
+            &sources[j],
+            counters->n_histograms,
+            counters->histogram_infos_offset,
+            counters->n_cpu * sizeof (mongoc_histogram_slots_t),
+            def);
+         if (!info) {
+            continue;
+         }
+
+         cpus = (const mongoc_histogram_slots_t *) (sources[j].segment +
+                                                    info->offset);
+         count = 0;
+         sum = 0;
+         for (cpu = 0; cpu < counters->n_cpu; cpu++) {
+            sum += cpus[cpu].sum;
+         }
+
+         for (bucket = 0; bucket < MONGOC_HISTOGRAM_N_BUCKETS; bucket++) {
+            for (cpu = 0; cpu < counters->n_cpu; cpu++) {
+               count += cpus[cpu].buckets[bucket];
+            }
+
+            if (bucket + 1 < MONGOC_HISTOGRAM_N_BUCKETS &&
+                (bucket + 1) % MONGOC_HISTOGRAM_SUB_BUCKETS == 0) {
+               bson_snprintf (
+                  le,
+                  sizeof le,
+                  "%.6f",
+                  (double) (_mongoc_histogram_bucket_min (bucket + 1) - 1) /
+                     (1000 * 1000));
+               labels = bson_string_new (sources[j].pid_label);
+               _mongoc_counters_append_label (labels, "le", le);
+               bson_snprintf (value, sizeof value, "%" PRId64, count);
+               _mongoc_counters_append_sample (
+                  str, family, "_bucket", labels, value);
+               bson_string_free (labels, true);
+            }
+         }
+
+         /* count the buckets rather than the CPUs' counts, so the last
+          * bucket equals _count while the process records values */
+         labels = bson_string_new (sources[j].pid_label);
+         _mongoc_counters_append_label (labels, "le", "+Inf");
+         bson_snprintf (value, sizeof value, "%" PRId64, count);
+         _mongoc_counters_append_sample (str, family, "_bucket", labels, value);
+         bson_string_free (labels, true);
+
+         labels = bson_string_new (sources[j].pid_label);
+         _mongoc_counters_append_sample (str, family, "_count", labels, value);
+         bson_snprintf (value,
+                        sizeof value,
+                        "%" PRId64 ".%06" PRId64,
+                        sum / (1000 * 1000),
+                        sum % (1000 * 1000));
+         _mongoc_counters_append_sample (str, family, "_sum", labels, value);
+         bson_string_free (labels, true);
+      }
+   }
+}
+
+
+static void
+_mongoc_counters_append_table (bson_string_t *str,
+                               const mongoc_counters_source_t *sources,
+                               size_t n_sources)
+{
+   const mongoc_counters_entry_def_t *def;
+   const mongoc_counters_t *counters;
+   const mongoc_counters_entry_t *entries;
+   const mongoc_counters_entry_t *entry;
+   const mongoc_counter_slots_t *values;
+   const mongoc_counter_slots_t *cpus;
+   bson_string_t *labels;
+   char host[sizeof entry->host + 1];
+   char ns[sizeof entry->ns + 1];
+   char value[32];
+   size_t i;
+   size_t j;
+   uint32_t k;
+   uint32_t cpu;
+   int64_t total;
+
+   for (i = 0; i < sizeof gEntryDefs / sizeof gEntryDefs[0]; i++) {
+      def = &gEntryDefs[i];
+      bson_string_append_printf (str,
+                                 "# TYPE mongoc_%s counter\n"
+                                 "# HELP mongoc_%s %s\n",
+                                 def->family,
+                                 def->family,
+                                 def->help);
+
+      for (j = 0; j < n_sources; j++) {
+         counters = (const mongoc_counters_t *) sources[j].segment;
+         if ((size_t) counters->table_offset +
+                   (size_t) counters->table_size * sizeof *entries >
+                sources[j].size ||
+             !counters->table_values_offset ||
+             (size_t) counters->table_values_offset +
+                   (size_t) counters->table_size * counters->n_cpu *
+                      sizeof *cpus >
+                sources[j].size) {
+            continue;
+         }
+
+         entries = (const mongoc_counters_entry_t *) (sources[j].segment +
+                                                      counters->table_offset);
+         values = (const mongoc_counter_slots_t *) (
+            sources[j].segment + counters->table_values_offset);
+         for (k = 0; k < counters->table_size; k++) {
+            entry = &entries[k];
+            if (entry->state != MONGOC_COUNTERS_ENTRY_READY ||
+                !entry->ns[0] != !def->per_namespace) {
+               continue;
+            }
+
+            bson_memory_barrier ();
+
+            /* keys are terminated, unless another process wrote them */
+            bson_strncpy (host, entry->host, sizeof entry->host);
+            bson_strncpy (ns, entry->ns, sizeof entry->ns);
+
+            labels = bson_string_new (sources[j].pid_label);
+            _mongoc_counters_append_label (labels, "host", host);
+            if (def->per_namespace) {
+               _mongoc_counters_append_label (labels, "namespace", ns);
+            }
+
+            cpus = &values[(size_t) k * counters->n_cpu];
+            total = 0;
+            for (cpu = 0; cpu < counters->n_cpu; cpu++) {
+               total += cpus[cpu].slots[def->slot];
+            }
+
+            bson_snprintf (value, sizeof value, "%" PRId64, total);
+            _mongoc_counters_append_sample (
+               str, def->family, "_total", labels, value);
+            bson_string_free (labels, true);
+         }
+      }
+   }
+}
+
+
+static char *
+_mongoc_counters_openmetrics (const mongoc_counters_source_t *sources,
+                              size_t n_sources)
+{
+   bson_string_t *str;
+
+   str = bson_string_new (NULL);
+   _mongoc_counters_append_counters (str, sources, n_sources);
+   _mongoc_counters_append_histograms (str, sources, n_sources);
+   _mongoc_counters_append_table (str, sources, n_sources);
+   bson_string_append (str, "# EOF\n");
+
+   return bson_string_free (str, false);
+}
+#endif
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_counters_openmetrics --
+ *
+ *       Snapshot this process's counters, latency histograms, and counters
+ *       per server and namespace in the OpenMetrics text format.
+ *
+ * Returns:
+ *       A string to be freed with bson_free(). If the driver was built
+ *       without counters, it has no metric families.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+char *
+mongoc_counters_openmetrics (void)
+{
+#ifdef MONGOC_ENABLE_SHM_COUNTERS
+   mongoc_counters_source_t source = {0};
+
+   if (gCounterSegment) {
+      source.segment = gCounterSegment;
+      source.size = ((const mongoc_counters_t *) gCounterSegment)->size;
+      return _mongoc_counters_openmetrics (&source, 1);
+   }
+#endif
+
+   return bson_strdup ("# EOF\n");
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_counters_openmetrics_for_pids --
+ *
+ *       Like mongoc_counters_openmetrics, for the processes @pids. Each
+ *       process's shared memory segment is mapped read-only while its
+ *       metrics are formatted, and each sample has a "pid" label.
+ *       Processes without a segment, or that have exited, are skipped.
+ *
+ * Returns:
+ *       A string to be freed with bson_free().
+ *
+ *--------------------------------------------------------------------------
+ */
+
+char *
+mongoc_counters_openmetrics_for_pids (const int *pids, size_t n_pids)
+{
+#if defined(BSON_OS_UNIX) && defined(MONGOC_ENABLE_SHM_COUNTERS)
+   mongoc_counters_source_t *sources;
+   size_t n_sources = 0;
+   uint32_t len;
+   void *mem;
+   char name[32];
+   char *ret;
+   size_t i;
+   int fd;
+
+   BSON_ASSERT (pids || !n_pids);
+
+   sources = bson_malloc0 ((n_pids ? n_pids : 1) * sizeof *sources);
+
+   for (i = 0; i < n_pids; i++) {
+      bson_snprintf (name, sizeof name, "/mongoc-%u", (unsigned) pids[i]);
+      if (-1 == (fd = shm_open (name, O_RDONLY, 0))) {
+         continue;
+      }
+
+      /* the size is set last, once the process has initialized the rest */
+      if (sizeof len != pread (fd, &len, sizeof len, 0) ||
+          len < sizeof (mongoc_counters_t)) {
+         close (fd);
+         continue;
+      }
+
+      mem = mmap (NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+      close (fd);
+      if (mem == MAP_FAILED) {
+         continue;
+      }
+
+      sources[n_sources].segment = (const char *) mem;
+      sources[n_sources].size = len;
+      bson_snprintf (sources[n_sources].pid_label,
+                     sizeof sources[n_sources].pid_label,
+                     "pid=\"%d\"",
+                     pids[i]);
+      n_sources++;
+   }
+
+   ret = _mongoc_counters_openmetrics (sources, n_sources);
+
+   for (i = 0; i < n_sources; i++) {
+      munmap ((void *) sources[i].segment, sources[i].size);
+   }
+
+   bson_free (sources);
+
+   return ret;
+#else
+   return bson_strdup ("# EOF\n");
 #endif
 }
@@ -0,0 +1,37 @@
+/*
+ * Copyright 2018-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mongoc/mongoc-prelude.h"
+
+#ifndef MONGOC_COUNTERS_H
+#define MONGOC_COUNTERS_H
+
+#include <bson/bson.h>
+
+#include "mongoc/mongoc-macros.h"
+
+BSON_BEGIN_DECLS
+
+MONGOC_EXPORT (char *)
+mongoc_counters_openmetrics (void) BSON_GNUC_WARN_UNUSED_RESULT;
+
+MONGOC_EXPORT (char *)
+mongoc_counters_openmetrics_for_pids (const int *pids, size_t n_pids)
+   BSON_GNUC_WARN_UNUSED_RESULT;
+
+BSON_END_DECLS
+
+#endif /* MONGOC_COUNTERS_H */
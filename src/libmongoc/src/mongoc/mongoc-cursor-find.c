@@ -81,6 +81,19 @@ _destroy (mongoc_cursor_impl_t *impl)
 }
 
 
+/* set the impl that chooses between find command and OP_QUERY on prime */
+static void
+_init_impl (mongoc_cursor_t *cursor, const bson_t *filter)
+{
+   data_find_t *data = bson_malloc0 (sizeof (data_find_t));
+   _mongoc_cursor_check_and_copy_to (cursor, "filter", filter, &data->filter);
+   cursor->impl.prime = _prime;
+   cursor->impl.clone = _clone;
+   cursor->impl.destroy = _destroy;
+   cursor->impl.data = data;
+}
+
+
 mongoc_cursor_t *
 _mongoc_cursor_find_new (mongoc_client_t *client,
                          const char *db_and_coll,
@@ -91,13 +104,22 @@ _mongoc_cursor_find_new (mongoc_client_t *client,
                          const mongoc_read_concern_t *read_concern)
 {
    mongoc_cursor_t *cursor;
-   data_find_t *data = bson_malloc0 (sizeof (data_find_t));
    cursor = _mongoc_cursor_new_with_opts (
       client, db_and_coll, opts, user_prefs, default_prefs, read_concern);
-   _mongoc_cursor_check_and_copy_to (cursor, "filter", filter, &data->filter);
-   cursor->impl.prime = _prime;
-   cursor->impl.clone = _clone;
-   cursor->impl.destroy = _destroy;
-   cursor->impl.data = data;
+   _init_impl (cursor, filter);
    return cursor;
 }
+
+
+/* reuse @cursor, which was returned by _mongoc_cursor_find_new, for a new
+ * @filter. its read preference and read concern were validated when it was
+ * created, @opts and @server_id are those it was created with. */
+void
+_mongoc_cursor_find_reset (mongoc_cursor_t *cursor,
+                           const bson_t *opts,
+                           uint32_t server_id,
+                           const bson_t *filter)
+{
+   _mongoc_cursor_reset (cursor, opts, server_id);
+   _init_impl (cursor, filter);
+}
@@ -122,6 +122,8 @@ _mongoc_cursor_op_getmore (mongoc_cursor_t *cursor,
 
    started = bson_get_monotonic_time ();
    cluster = &cursor->client->cluster;
+   /* in exhaust nothing is sent, so the phases are not reset by sending */
+   memset (cluster->phase_duration, 0, sizeof cluster->phase_duration);
 
    server_stream = _mongoc_cursor_fetch_stream (cursor);
    if (!server_stream) {
@@ -472,6 +474,9 @@ _mongoc_cursor_op_query_find (mongoc_cursor_t *cursor,
    }
 
    started = bson_get_monotonic_time ();
+   memset (cursor->client->cluster.phase_duration,
+           0,
+           sizeof cursor->client->cluster.phase_duration);
 
    /* When the user explicitly provides a readConcern -- but the server
        * doesn't support readConcern, we must error:
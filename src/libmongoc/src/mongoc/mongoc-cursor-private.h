@@ -179,6 +179,10 @@ _mongoc_cursor_run_command (mongoc_cursor_t *cursor,
                             bson_t *reply);
 bool
 _mongoc_cursor_more (mongoc_cursor_t *cursor);
+void
+_mongoc_cursor_reset (mongoc_cursor_t *cursor,
+                      const bson_t *opts,
+                      uint32_t server_id);
 
 bool
 _mongoc_cursor_set_opt_int64 (mongoc_cursor_t *cursor,
@@ -272,6 +276,12 @@ _mongoc_cursor_find_new (mongoc_client_t *client,
                          const mongoc_read_prefs_t *default_prefs,
                          const mongoc_read_concern_t *read_concern);
 
+void
+_mongoc_cursor_find_reset (mongoc_cursor_t *cursor,
+                           const bson_t *opts,
+                           uint32_t server_id,
+                           const bson_t *filter);
+
 mongoc_cursor_t *
 _mongoc_cursor_cmd_new (mongoc_client_t *client,
                         const char *db_and_coll,
@@ -583,15 +583,12 @@ done:
 }
 
 
-void
-mongoc_cursor_destroy (mongoc_cursor_t *cursor)
+/* free the impl, the server-side cursor and the implicit session, leaving
+ * the options, read preference and concerns that @cursor was created with */
+static void
+_mongoc_cursor_release (mongoc_cursor_t *cursor)
 {
    char db[MONGOC_NAMESPACE_MAX];
-   ENTRY;
-
-   if (!cursor) {
-      EXIT;
-   }
 
    if (cursor->impl.destroy) {
       cursor->impl.destroy (&cursor->impl);
@@ -621,8 +618,22 @@ mongoc_cursor_destroy (mongoc_cursor_t *cursor)
 
    if (cursor->client_session && !cursor->explicit_session) {
       mongoc_client_session_destroy (cursor->client_session);
+      cursor->client_session = NULL;
+   }
+}
+
+
+void
+mongoc_cursor_destroy (mongoc_cursor_t *cursor)
+{
+   ENTRY;
+
+   if (!cursor) {
+      EXIT;
    }
 
+   _mongoc_cursor_release (cursor);
+
    mongoc_read_prefs_destroy (cursor->read_prefs);
    mongoc_read_concern_destroy (cursor->read_concern);
    mongoc_write_concern_destroy (cursor->write_concern);
@@ -638,6 +649,53 @@ mongoc_cursor_destroy (mongoc_cursor_t *cursor)
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cursor_reset --
+ *
+ *       Return @cursor to the state it was created in, so it can be
+ *       iterated again without validating its read preference and read
+ *       concern. A server-side cursor is killed, the impl is destroyed and
+ *       must be set again by the caller, and @opts and @server_id replace
+ *       any that were set on the cursor since it was created.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_cursor_reset (mongoc_cursor_t *cursor,
+                      const bson_t *opts,
+                      uint32_t server_id)
+{
+   ENTRY;
+
+   BSON_ASSERT (cursor);
+   BSON_ASSERT (opts);
+
+   _mongoc_cursor_release (cursor);
+
+   cursor->client_generation = cursor->client->generation;
+   cursor->server_id = server_id;
+   cursor->state = UNPRIMED;
+   cursor->in_exhaust = false;
+   cursor->count = 0;
+   cursor->current = NULL;
+   cursor->operation_id = 0;
+   cursor->cursor_id = 0;
+   memset (&cursor->impl, 0, sizeof cursor->impl);
+   memset (&cursor->error, 0, sizeof cursor->error);
+   bson_reinit (&cursor->error_doc);
+
+   /* mongoc_cursor_set_batch_size and friends change the opts */
+   if (!bson_equal (&cursor->opts, opts)) {
+      bson_reinit (&cursor->opts);
+      bson_concat (&cursor->opts, opts);
+   }
+
+   EXIT;
+}
+
 mongoc_server_stream_t *
 _mongoc_cursor_fetch_stream (mongoc_cursor_t *cursor)
 {
@@ -784,6 +842,9 @@ _mongoc_cursor_monitor_succeeded (mongoc_cursor_t *cursor,
                                       &stream->sd->host,
                                       stream->sd->id,
                                       client->apm_context);
+   memcpy (event.phase_duration,
+           client->cluster.phase_duration,
+           sizeof event.phase_duration);
 
    client->apm_callbacks.succeeded (&event);
 
@@ -828,6 +889,9 @@ _mongoc_cursor_monitor_failed (mongoc_cursor_t *cursor,
                                    &stream->sd->host,
                                    stream->sd->id,
                                    client->apm_context);
+   memcpy (event.phase_duration,
+           client->cluster.phase_duration,
+           sizeof event.phase_duration);
 
    client->apm_callbacks.failed (&event);
 
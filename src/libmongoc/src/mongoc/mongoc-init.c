@@ -21,7 +21,10 @@
 #include "mongoc/mongoc-counters-private.h"
 #include "mongoc/mongoc-init.h"
 
+#include "mongoc/mongoc-client-private.h"
 #include "mongoc/mongoc-handshake-private.h"
+#include "mongoc/mongoc-log-private.h"
+#include "mongoc/mongoc-scram-private.h"
 
 #ifdef MONGOC_ENABLE_SSL_OPENSSL
 #include "mongoc/mongoc-openssl-private.h"
@@ -131,6 +134,12 @@ static BSON_ONCE_FUN (_mongoc_do_init)
 
    _mongoc_handshake_init ();
 
+   _mongoc_client_dns_cache_init ();
+
+#ifdef MONGOC_ENABLE_CRYPTO
+   _mongoc_scram_global_cache_init ();
+#endif
+
    BSON_ONCE_RETURN;
 }
 
@@ -143,6 +152,9 @@ mongoc_init (void)
 
 static BSON_ONCE_FUN (_mongoc_do_cleanup)
 {
+   /* handle queued log messages while the rest of the driver is usable */
+   _mongoc_log_async_cleanup ();
+
 #ifdef MONGOC_ENABLE_SSL_OPENSSL
    _mongoc_openssl_cleanup ();
 #endif
@@ -168,6 +180,12 @@ static BSON_ONCE_FUN (_mongoc_do_cleanup)
 
    _mongoc_handshake_cleanup ();
 
+   _mongoc_client_dns_cache_cleanup ();
+
+#ifdef MONGOC_ENABLE_CRYPTO
+   _mongoc_scram_global_cache_cleanup ();
+#endif
+
    BSON_ONCE_RETURN;
 }
 
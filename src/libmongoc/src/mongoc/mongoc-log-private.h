@@ -21,6 +21,22 @@
 
 #include "mongoc/mongoc-iovec.h"
 
+/* the number of messages the async log queue holds */
+#define MONGOC_LOG_ASYNC_QUEUE_SIZE 1024
+
+/* how often the log thread checks an empty queue, in milliseconds */
+#define MONGOC_LOG_ASYNC_POLL_MS 10
+
+/* the number of call sites rate limits are tracked for */
+#define MONGOC_LOG_RATE_LIMIT_SITES 256
+
+void
+_mongoc_log_async_cleanup (void);
+
+/* just for testing */
+void
+_mongoc_log_get_async_stats (int64_t *dropped, int64_t *rate_limited);
+
 /* just for testing */
 void
 _mongoc_log_get_handler (mongoc_log_func_t *log_func, void **user_data);
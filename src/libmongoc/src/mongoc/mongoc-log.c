@@ -25,6 +25,7 @@
 #include <stdarg.h>
 #include <time.h>
 
+#include "mongoc/mongoc-counters-private.h"
 #include "mongoc/mongoc-log.h"
 #include "mongoc/mongoc-log-private.h"
 #include "mongoc/mongoc-thread-private.h"
@@ -38,9 +39,59 @@ static bool gLogTrace = true;
 #endif
 static void *gLogData;
 
+
+/* a message waiting in the async queue. a producer with ticket t fills the
+ * slot t % MONGOC_LOG_ASYNC_QUEUE_SIZE and then sets seq to t + 1 */
+typedef struct {
+   volatile int64_t seq;
+   mongoc_log_level_t log_level;
+   char log_domain[64];
+   char *message;
+} mongoc_log_slot_t;
+
+
+/*
+ * In async mode messages are queued in a ring, and a background thread
+ * calls the handler. Threads that log never block: a producer reserves room
+ * by incrementing gLogQueued, drops its message if the ring is full, and
+ * otherwise takes the next ticket. Since the consumer releases a slot
+ * before decrementing gLogQueued, the ticket's slot is free.
+ */
+static mongoc_log_slot_t *gLogRing;
+static volatile int64_t gLogQueued;
+static volatile int64_t gLogTail;
+static int64_t gLogHead;
+static volatile int32_t gLogAsync;
+static bool gLogAsyncStopping;
+static bson_thread_t gLogThread;
+static mongoc_cond_t gLogCond;
+
+/* guards enabling and disabling async mode */
+static bson_mutex_t gLogAsyncMutex;
+
+static volatile int64_t gLogDropped;
+static volatile int64_t gLogRateLimited;
+
+/* totals the log thread last reported, taken when async mode is enabled */
+static int64_t gLogDroppedReported;
+static int64_t gLogRateLimitedReported;
+
+
+/* messages from each call site, approximately, in the current second */
+typedef struct {
+   volatile int64_t second;
+   volatile int32_t count;
+} mongoc_log_site_t;
+
+static mongoc_log_site_t gLogSites[MONGOC_LOG_RATE_LIMIT_SITES];
+static volatile int32_t gLogRateLimit;
+
+
 static BSON_ONCE_FUN (_mongoc_ensure_mutex_once)
 {
    bson_mutex_init (&gLogMutex);
+   bson_mutex_init (&gLogAsyncMutex);
+   mongoc_cond_init (&gLogCond);
 
    BSON_ONCE_RETURN;
 }
@@ -66,6 +117,84 @@ _mongoc_log_get_handler (mongoc_log_func_t *log_func, void **user_data)
 }
 
 
+/* true if the call site logging with @format has logged more than the rate
+ * limit this second. call sites are told apart by their format strings, a
+ * few may share a limit if their addresses collide in gLogSites. */
+static bool
+_mongoc_log_rate_limited (const char *format)
+{
+   mongoc_log_site_t *site;
+   int32_t limit;
+   int64_t second;
+
+   limit = gLogRateLimit;
+   if (limit <= 0) {
+      return false;
+   }
+
+   site = &gLogSites[((uintptr_t) format >> 3) % MONGOC_LOG_RATE_LIMIT_SITES];
+   second = bson_get_monotonic_time () / (1000 * 1000);
+
+   /* racing threads may each reset the count, allowing a few more */
+   if (site->second != second) {
+      site->second = second;
+      site->count = 0;
+   }
+
+   if (bson_atomic_int_add (&site->count, 1) > limit) {
+      bson_atomic_int64_add (&gLogRateLimited, 1);
+      mongoc_counter_log_rate_limited_inc ();
+      return true;
+   }
+
+   return false;
+}
+
+
+/* queue @message for the background thread, which will free it. returns
+ * false if async mode is off */
+static bool
+_mongoc_log_enqueue (mongoc_log_level_t log_level,
+                     const char *log_domain,
+                     char *message)
+{
+   mongoc_log_slot_t *slot;
+   int64_t ticket;
+
+   /* reserve room before checking the mode, so that disabling it, which
+    * clears the mode and then waits for gLogQueued to be zero, can't miss
+    * this message */
+   if (bson_atomic_int64_add (&gLogQueued, 1) > MONGOC_LOG_ASYNC_QUEUE_SIZE) {
+      bson_atomic_int64_add (&gLogQueued, -1);
+      if (!gLogAsync) {
+         return false;
+      }
+
+      bson_atomic_int64_add (&gLogDropped, 1);
+      mongoc_counter_log_dropped_inc ();
+      bson_free (message);
+      return true;
+   }
+
+   if (!gLogAsync) {
+      bson_atomic_int64_add (&gLogQueued, -1);
+      return false;
+   }
+
+   ticket = bson_atomic_int64_add (&gLogTail, 1) - 1;
+   slot = &gLogRing[ticket % MONGOC_LOG_ASYNC_QUEUE_SIZE];
+   slot->log_level = log_level;
+   bson_strncpy (slot->log_domain,
+                 log_domain ? log_domain : "",
+                 sizeof slot->log_domain);
+   slot->message = message;
+   bson_memory_barrier ();
+   slot->seq = ticket + 1;
+
+   return true;
+}
+
+
 void
 mongoc_log (mongoc_log_level_t log_level,
             const char *log_domain,
@@ -89,10 +218,20 @@ mongoc_log (mongoc_log_level_t log_level,
 
    BSON_ASSERT (format);
 
+   /* tracing is for debugging, it isn't limited */
+   if (log_level != MONGOC_LOG_LEVEL_TRACE &&
+       _mongoc_log_rate_limited (format)) {
+      return;
+   }
+
    va_start (args, format);
    message = bson_strdupv_printf (format, args);
    va_end (args);
 
+   if (gLogAsync && _mongoc_log_enqueue (log_level, log_domain, message)) {
+      return;
+   }
+
    bson_mutex_lock (&gLogMutex);
    gLogFunc (log_level, log_domain, message, gLogData);
    bson_mutex_unlock (&gLogMutex);
@@ -101,6 +240,206 @@ mongoc_log (mongoc_log_level_t log_level,
 }
 
 
+/* call the handler with each queued message, and report messages that were
+ * dropped or rate limited since the last call. returns the number of
+ * messages handled. */
+static int64_t
+_mongoc_log_drain (void)
+{
+   mongoc_log_slot_t *slot;
+   int64_t n = 0;
+   int64_t dropped;
+   int64_t rate_limited;
+   char *summary;
+
+   bson_mutex_lock (&gLogMutex);
+
+   for (;;) {
+      slot = &gLogRing[gLogHead % MONGOC_LOG_ASYNC_QUEUE_SIZE];
+
+      /* the slot is empty, or its producer hasn't finished filling it */
+      if (slot->seq != gLogHead + 1) {
+         break;
+      }
+
+      bson_memory_barrier ();
+      if (gLogFunc) {
+         gLogFunc (slot->log_level, slot->log_domain, slot->message, gLogData);
+      }
+
+      bson_free (slot->message);
+      slot->message = NULL;
+      slot->seq = 0;
+      bson_memory_barrier ();
+      gLogHead++;
+      bson_atomic_int64_add (&gLogQueued, -1);
+      n++;
+   }
+
+   dropped = gLogDropped;
+   rate_limited = gLogRateLimited;
+
+   if (gLogFunc && dropped != gLogDroppedReported) {
+      summary = bson_strdup_printf (
+         "dropped %" PRId64 " log messages, the log queue was full",
+         dropped - gLogDroppedReported);
+      gLogFunc (MONGOC_LOG_LEVEL_WARNING, "mongoc", summary, gLogData);
+      bson_free (summary);
+   }
+
+   if (gLogFunc && rate_limited != gLogRateLimitedReported) {
+      summary = bson_strdup_printf (
+         "suppressed %" PRId64 " log messages over the rate limit",
+         rate_limited - gLogRateLimitedReported);
+      gLogFunc (MONGOC_LOG_LEVEL_WARNING, "mongoc", summary, gLogData);
+      bson_free (summary);
+   }
+
+   gLogDroppedReported = dropped;
+   gLogRateLimitedReported = rate_limited;
+
+   bson_mutex_unlock (&gLogMutex);
+
+   return n;
+}
+
+
+static void *
+_mongoc_log_async_run (void *data)
+{
+   bool stopping;
+
+   for (;;) {
+      if (_mongoc_log_drain ()) {
+         continue;
+      }
+
+      /* producers don't signal, so they never take a lock. poll instead */
+      bson_mutex_lock (&gLogAsyncMutex);
+      stopping = gLogAsyncStopping;
+      if (!stopping) {
+         mongoc_cond_timedwait (
+            &gLogCond, &gLogAsyncMutex, MONGOC_LOG_ASYNC_POLL_MS);
+      }
+      bson_mutex_unlock (&gLogAsyncMutex);
+
+      /* once stopping, gLogAsync is false, wait for reserved messages */
+      if (stopping && !gLogQueued) {
+         break;
+      }
+   }
+
+   return NULL;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_log_async_enable --
+ *
+ *       Queue log messages and call the handler on a background thread,
+ *       so threads that log don't wait for the log mutex or the handler.
+ *       If the queue is full, messages are dropped.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+mongoc_log_async_enable (void)
+{
+   bson_once (&once, &_mongoc_ensure_mutex_once);
+
+   bson_mutex_lock (&gLogAsyncMutex);
+   if (!gLogAsync) {
+      if (!gLogRing) {
+         gLogRing =
+            bson_malloc0 (MONGOC_LOG_ASYNC_QUEUE_SIZE * sizeof *gLogRing);
+      }
+
+      gLogAsyncStopping = false;
+      gLogDroppedReported = gLogDropped;
+      gLogRateLimitedReported = gLogRateLimited;
+      if (bson_thread_create (&gLogThread, _mongoc_log_async_run, NULL)) {
+         MONGOC_ERROR ("could not start the log thread");
+      } else {
+         bson_memory_barrier ();
+         gLogAsync = 1;
+      }
+   }
+   bson_mutex_unlock (&gLogAsyncMutex);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_log_async_disable --
+ *
+ *       Log synchronously again. Messages already queued are handled
+ *       before this returns.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+mongoc_log_async_disable (void)
+{
+   bson_once (&once, &_mongoc_ensure_mutex_once);
+
+   bson_mutex_lock (&gLogAsyncMutex);
+   if (!gLogAsync) {
+      bson_mutex_unlock (&gLogAsyncMutex);
+      return;
+   }
+
+   gLogAsync = 0;
+   bson_memory_barrier ();
+   gLogAsyncStopping = true;
+   mongoc_cond_signal (&gLogCond);
+   bson_mutex_unlock (&gLogAsyncMutex);
+
+   bson_thread_join (gLogThread);
+}
+
+
+void
+_mongoc_log_async_cleanup (void)
+{
+   mongoc_log_async_disable ();
+
+   bson_free (gLogRing);
+   gLogRing = NULL;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_log_set_rate_limit --
+ *
+ *       Limit each call site to @max_per_second messages per second, or
+ *       remove the limit if @max_per_second is 0.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+mongoc_log_set_rate_limit (int32_t max_per_second)
+{
+   gLogRateLimit = max_per_second;
+}
+
+
+/* just for testing */
+void
+_mongoc_log_get_async_stats (int64_t *dropped, int64_t *rate_limited)
+{
+   *dropped = gLogDropped;
+   *rate_limited = gLogRateLimited;
+}
+
+
 const char *
 mongoc_log_level_str (mongoc_log_level_t log_level)
 {
@@ -139,6 +139,37 @@ MONGOC_EXPORT (void)
 mongoc_log_trace_disable (void);
 
 
+/**
+ * mongoc_log_async_enable:
+ *
+ * Queues log messages for a background thread to pass to the log handler,
+ * so logging never blocks. Messages are dropped if the queue is full.
+ */
+MONGOC_EXPORT (void)
+mongoc_log_async_enable (void);
+
+
+/**
+ * mongoc_log_async_disable:
+ *
+ * Handles queued messages, stops the background thread, and logs
+ * synchronously again.
+ */
+MONGOC_EXPORT (void)
+mongoc_log_async_disable (void);
+
+
+/**
+ * mongoc_log_set_rate_limit:
+ * @max_per_second: The most messages to log from one call site per second,
+ * or 0 for no limit.
+ *
+ * Limits how often each call site may log. Trace messages aren't limited.
+ */
+MONGOC_EXPORT (void)
+mongoc_log_set_rate_limit (int32_t max_per_second);
+
+
 BSON_END_DECLS
 
 
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2018-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mongoc/mongoc-prelude.h"
+
+#ifndef MONGOC_PREPARED_PRIVATE_H
+#define MONGOC_PREPARED_PRIVATE_H
+
+#include <bson/bson.h>
+
+#include "mongoc/mongoc-collection.h"
+#include "mongoc/mongoc-opts-private.h"
+#include "mongoc/mongoc-prepared.h"
+
+BSON_BEGIN_DECLS
+
+typedef enum {
+   MONGOC_PREPARED_UPDATE_ONE,
+   MONGOC_PREPARED_UPDATE_MANY,
+   MONGOC_PREPARED_REPLACE_ONE,
+} mongoc_prepared_update_type_t;
+
+struct _mongoc_prepared_find_t {
+   /* read prefs and read concern validated once, reset for each execute */
+   mongoc_cursor_t *cursor;
+   /* the cursor's validated opts and serverId, restored by each reset */
+   bson_t opts;
+   uint32_t server_id;
+};
+
+struct _mongoc_prepared_update_t {
+   mongoc_collection_t *collection;
+   mongoc_prepared_update_type_t type;
+   union {
+      mongoc_update_one_opts_t update_one;
+      mongoc_update_many_opts_t update_many;
+      mongoc_replace_one_opts_t replace_one;
+   } opts;
+   /* the following point into opts */
+   mongoc_update_opts_t *update_opts;
+   const bson_t *array_filters;
+   /* unrecognized opts plus upsert, collation, arrayFilters and multi,
+    * appended to each statement after "q" and "u" */
+   const bson_t *statement_opts;
+};
+
+mongoc_prepared_find_t *
+_mongoc_prepared_find_new (const mongoc_collection_t *collection,
+                           const bson_t *opts,
+                           const mongoc_read_prefs_t *read_prefs,
+                           bson_error_t *error);
+
+mongoc_prepared_update_t *
+_mongoc_prepared_update_new (const mongoc_collection_t *collection,
+                             mongoc_prepared_update_type_t type,
+                             const bson_t *opts,
+                             bson_error_t *error);
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_PREPARED_PRIVATE_H */
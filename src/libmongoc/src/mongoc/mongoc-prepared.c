@@ -0,0 +1,275 @@
+/*
+ * Copyright 2018-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "mongoc/mongoc-collection-private.h"
+#include "mongoc/mongoc-cursor-private.h"
+#include "mongoc/mongoc-prepared-private.h"
+#include "mongoc/mongoc-trace-private.h"
+#include "mongoc/mongoc-util-private.h"
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_prepared_find_new --
+ *
+ *       Validate @opts, @read_prefs and @collection's read concern once,
+ *       for a find that will be executed many times with different
+ *       filters.
+ *
+ * Returns:
+ *       A new prepared find, or NULL and @error is set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_prepared_find_t *
+_mongoc_prepared_find_new (const mongoc_collection_t *collection,
+                           const bson_t *opts,
+                           const mongoc_read_prefs_t *read_prefs,
+                           bson_error_t *error)
+{
+   mongoc_prepared_find_t *prepared;
+   mongoc_cursor_t *cursor;
+
+   ENTRY;
+
+   BSON_ASSERT (collection);
+
+   cursor = _mongoc_cursor_find_new (collection->client,
+                                     collection->ns,
+                                     NULL /* filter */,
+                                     opts,
+                                     read_prefs,
+                                     collection->read_prefs,
+                                     collection->read_concern);
+
+   if (mongoc_cursor_error (cursor, error)) {
+      mongoc_cursor_destroy (cursor);
+      RETURN (NULL);
+   }
+
+   prepared = (mongoc_prepared_find_t *) bson_malloc0 (sizeof *prepared);
+   prepared->cursor = cursor;
+   bson_copy_to (&cursor->opts, &prepared->opts);
+   prepared->server_id = cursor->server_id;
+
+   RETURN (prepared);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_prepared_find_execute --
+ *
+ *       Reset the prepared find's cursor to query with @filter, reusing
+ *       the options validated by mongoc_collection_prepare_find. Any
+ *       results left from the previous execution are discarded. The
+ *       cursor belongs to @prepared and must not be destroyed.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_cursor_t *
+mongoc_prepared_find_execute (mongoc_prepared_find_t *prepared,
+                              const bson_t *filter)
+{
+   BSON_ASSERT (prepared);
+   BSON_ASSERT (filter);
+
+   _mongoc_cursor_find_reset (
+      prepared->cursor, &prepared->opts, prepared->server_id, filter);
+
+   return prepared->cursor;
+}
+
+
+void
+mongoc_prepared_find_destroy (mongoc_prepared_find_t *prepared)
+{
+   if (!prepared) {
+      return;
+   }
+
+   mongoc_cursor_destroy (prepared->cursor);
+   bson_destroy (&prepared->opts);
+   bson_free (prepared);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_prepared_update_new --
+ *
+ *       Parse and validate @opts once, and build the fields appended to
+ *       each update statement, for an update_one, update_many, or
+ *       replace_one that will be executed many times.
+ *
+ * Returns:
+ *       A new prepared update, or NULL and @error is set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_prepared_update_t *
+_mongoc_prepared_update_new (const mongoc_collection_t *collection,
+                             mongoc_prepared_update_type_t type,
+                             const bson_t *opts,
+                             bson_error_t *error)
+{
+   mongoc_prepared_update_t *prepared;
+   mongoc_client_t *client;
+   bson_t *extra;
+   bool multi = false;
+   bool r;
+
+   ENTRY;
+
+   BSON_ASSERT (collection);
+
+   client = collection->client;
+   prepared = (mongoc_prepared_update_t *) bson_malloc0 (sizeof *prepared);
+   prepared->type = type;
+
+   switch (type) {
+   case MONGOC_PREPARED_UPDATE_ONE:
+      r = _mongoc_update_one_opts_parse (
+         client, opts, &prepared->opts.update_one, error);
+      prepared->update_opts = &prepared->opts.update_one.update;
+      prepared->array_filters = &prepared->opts.update_one.arrayFilters;
+      extra = &prepared->opts.update_one.extra;
+      break;
+   case MONGOC_PREPARED_UPDATE_MANY:
+      r = _mongoc_update_many_opts_parse (
+         client, opts, &prepared->opts.update_many, error);
+      prepared->update_opts = &prepared->opts.update_many.update;
+      prepared->array_filters = &prepared->opts.update_many.arrayFilters;
+      extra = &prepared->opts.update_many.extra;
+      multi = true;
+      break;
+   case MONGOC_PREPARED_REPLACE_ONE:
+      r = _mongoc_replace_one_opts_parse (
+         client, opts, &prepared->opts.replace_one, error);
+      prepared->update_opts = &prepared->opts.replace_one.update;
+      prepared->array_filters = NULL;
+      extra = &prepared->opts.replace_one.extra;
+      break;
+   default:
+      BSON_ASSERT (false);
+      RETURN (NULL);
+   }
+
+   if (!r) {
+      mongoc_prepared_update_destroy (prepared);
+      RETURN (NULL);
+   }
+
+   _mongoc_collection_append_update_statement_opts (
+      prepared->update_opts, multi, prepared->array_filters, extra);
+   prepared->statement_opts = extra;
+
+   prepared->collection = _mongoc_collection_new (client,
+                                                  collection->db,
+                                                  collection->collection,
+                                                  collection->read_prefs,
+                                                  collection->read_concern,
+                                                  collection->write_concern);
+
+   RETURN (prepared);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_prepared_update_execute --
+ *
+ *       Update the documents matching @selector, using the options parsed
+ *       by mongoc_collection_prepare_update_one, update_many, or
+ *       replace_one. Only @update is validated on each call.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_prepared_update_execute (mongoc_prepared_update_t *prepared,
+                                const bson_t *selector,
+                                const bson_t *update,
+                                bson_t *reply,
+                                bson_error_t *error)
+{
+   bool r;
+
+   ENTRY;
+
+   BSON_ASSERT (prepared);
+   BSON_ASSERT (selector);
+   BSON_ASSERT (update);
+
+   if (prepared->type == MONGOC_PREPARED_REPLACE_ONE) {
+      r = _mongoc_validate_replace (
+         update, prepared->update_opts->crud.validate, error);
+   } else {
+      r = _mongoc_validate_update (
+         update, prepared->update_opts->crud.validate, error);
+   }
+
+   if (!r) {
+      _mongoc_bson_init_if_set (reply);
+      RETURN (false);
+   }
+
+   RETURN (_mongoc_collection_update_statement (
+      prepared->collection,
+      selector,
+      update,
+      prepared->update_opts,
+      prepared->type == MONGOC_PREPARED_UPDATE_MANY /* multi */,
+      prepared->update_opts->bypass,
+      prepared->array_filters,
+      prepared->statement_opts,
+      reply,
+      error));
+}
+
+
+void
+mongoc_prepared_update_destroy (mongoc_prepared_update_t *prepared)
+{
+   if (!prepared) {
+      return;
+   }
+
+   switch (prepared->type) {
+   case MONGOC_PREPARED_UPDATE_ONE:
+      _mongoc_update_one_opts_cleanup (&prepared->opts.update_one);
+      break;
+   case MONGOC_PREPARED_UPDATE_MANY:
+      _mongoc_update_many_opts_cleanup (&prepared->opts.update_many);
+      break;
+   case MONGOC_PREPARED_REPLACE_ONE:
+      _mongoc_replace_one_opts_cleanup (&prepared->opts.replace_one);
+      break;
+   default:
+      BSON_ASSERT (false);
+   }
+
+   mongoc_collection_destroy (prepared->collection);
+   bson_free (prepared);
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2018-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mongoc/mongoc-prelude.h"
+
+#ifndef MONGOC_PREPARED_H
+#define MONGOC_PREPARED_H
+
+#include <bson/bson.h>
+
+#include "mongoc/mongoc-macros.h"
+#include "mongoc/mongoc-cursor.h"
+
+BSON_BEGIN_DECLS
+
+typedef struct _mongoc_prepared_find_t mongoc_prepared_find_t;
+typedef struct _mongoc_prepared_update_t mongoc_prepared_update_t;
+
+MONGOC_EXPORT (mongoc_cursor_t *)
+mongoc_prepared_find_execute (mongoc_prepared_find_t *prepared,
+                              const bson_t *filter)
+   BSON_GNUC_WARN_UNUSED_RESULT;
+
+MONGOC_EXPORT (void)
+mongoc_prepared_find_destroy (mongoc_prepared_find_t *prepared);
+
+MONGOC_EXPORT (bool)
+mongoc_prepared_update_execute (mongoc_prepared_update_t *prepared,
+                                const bson_t *selector,
+                                const bson_t *update,
+                                bson_t *reply,
+                                bson_error_t *error);
+
+MONGOC_EXPORT (void)
+mongoc_prepared_update_destroy (mongoc_prepared_update_t *prepared);
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_PREPARED_H */
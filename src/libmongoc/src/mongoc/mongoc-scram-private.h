@@ -38,6 +38,9 @@ BSON_BEGIN_DECLS
 #define MONGOC_SCRAM_B64_HASH_MAX_SIZE \
    MONGOC_SCRAM_B64_ENCODED_SIZE (MONGOC_SCRAM_HASH_MAX_SIZE)
 
+/* the number of derived keys shared by all clients in the process */
+#define MONGOC_SCRAM_GLOBAL_CACHE_SIZE 64
+
 typedef struct _mongoc_scram_cache_t {
    /* pre-secrets */
    char *hashed_password;
@@ -113,6 +116,21 @@ _mongoc_scram_step (mongoc_scram_t *scram,
 void
 _mongoc_scram_cache_destroy (mongoc_scram_cache_t *cache);
 
+void
+_mongoc_scram_global_cache_init (void);
+
+void
+_mongoc_scram_global_cache_cleanup (void);
+
+void
+_mongoc_scram_global_cache_clear (void);
+
+bool
+_mongoc_scram_global_cache_get (mongoc_scram_t *scram);
+
+void
+_mongoc_scram_global_cache_put (mongoc_scram_t *scram);
+
 /* returns false if this string does not need SASLPrep. It returns true
  * conservatively, if str might need to be SASLPrep'ed. */
 bool
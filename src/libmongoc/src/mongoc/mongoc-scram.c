@@ -29,10 +29,25 @@
 #include "common-b64-private.h"
 
 #include "mongoc/mongoc-memcmp-private.h"
+#include "mongoc/mongoc-counters-private.h"
+#include "mongoc/mongoc-thread-private.h"
 
 #define MONGOC_SCRAM_SERVER_KEY "Server Key"
 #define MONGOC_SCRAM_CLIENT_KEY "Client Key"
 
+/* An entry in the process-wide cache of derived keys. The pre-secrets in
+ * "secrets" already cover the password, salt, and iteration count. */
+typedef struct {
+   char *user;
+   mongoc_crypto_hash_algorithm_t algorithm;
+   mongoc_scram_cache_t *secrets;
+} mongoc_scram_cache_entry_t;
+
+static mongoc_scram_cache_entry_t gScramCache[MONGOC_SCRAM_GLOBAL_CACHE_SIZE];
+/* the slot the next insert overwrites when the cache is full */
+static int gScramCacheNext;
+static bson_mutex_t gScramCacheMutex;
+
 static int
 _scram_hash_size (mongoc_scram_t *scram)
 {
@@ -220,6 +235,141 @@ _mongoc_scram_update_cache (mongoc_scram_t *scram)
            sizeof (cache->salted_password));
 
    scram->cache = cache;
+
+   _mongoc_scram_global_cache_put (scram);
+}
+
+
+static void
+_mongoc_scram_cache_entry_clear (mongoc_scram_cache_entry_t *entry)
+{
+   bson_free (entry->user);
+   if (entry->secrets) {
+      _mongoc_scram_cache_destroy (entry->secrets);
+   }
+
+   memset (entry, 0, sizeof *entry);
+}
+
+
+void
+_mongoc_scram_global_cache_init (void)
+{
+   bson_mutex_init (&gScramCacheMutex);
+}
+
+
+void
+_mongoc_scram_global_cache_clear (void)
+{
+   int i;
+
+   bson_mutex_lock (&gScramCacheMutex);
+   for (i = 0; i < MONGOC_SCRAM_GLOBAL_CACHE_SIZE; i++) {
+      _mongoc_scram_cache_entry_clear (&gScramCache[i]);
+   }
+
+   gScramCacheNext = 0;
+   bson_mutex_unlock (&gScramCacheMutex);
+}
+
+
+void
+_mongoc_scram_global_cache_cleanup (void)
+{
+   _mongoc_scram_global_cache_clear ();
+   bson_mutex_destroy (&gScramCacheMutex);
+}
+
+
+/* Returns the entry matching scram's user, mechanism, and pre-secrets, or
+ * NULL. Call with gScramCacheMutex locked. */
+static mongoc_scram_cache_entry_t *
+_mongoc_scram_global_cache_find (mongoc_scram_t *scram)
+{
+   mongoc_scram_cache_entry_t *entry;
+   int i;
+
+   for (i = 0; i < MONGOC_SCRAM_GLOBAL_CACHE_SIZE; i++) {
+      entry = &gScramCache[i];
+      if (entry->secrets && entry->algorithm == scram->crypto.algorithm &&
+          !strcmp (entry->user, scram->user ? scram->user : "") &&
+          _mongoc_scram_cache_has_presecrets (entry->secrets, scram)) {
+         return entry;
+      }
+   }
+
+   return NULL;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_scram_global_cache_get --
+ *
+ *       Look up the keys derived from scram's user, mechanism, password,
+ *       salt, and iteration count in the cache shared by all clients and
+ *       pools in this process, and copy them to scram if found.
+ *
+ * Returns:
+ *       True if the keys were found.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_scram_global_cache_get (mongoc_scram_t *scram)
+{
+   mongoc_scram_cache_entry_t *entry;
+
+   BSON_ASSERT (scram);
+
+   bson_mutex_lock (&gScramCacheMutex);
+   entry = _mongoc_scram_global_cache_find (scram);
+   if (entry) {
+      _mongoc_scram_cache_apply_secrets (entry->secrets, scram);
+   }
+
+   bson_mutex_unlock (&gScramCacheMutex);
+
+   return entry != NULL;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_scram_global_cache_put --
+ *
+ *       Store scram's pre-secrets and derived keys in the process-wide
+ *       cache. Call only once the server's signature is verified, so the
+ *       cache never holds keys the server did not accept. When the cache
+ *       is full the oldest entry is replaced.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_scram_global_cache_put (mongoc_scram_t *scram)
+{
+   mongoc_scram_cache_entry_t *entry;
+
+   BSON_ASSERT (scram);
+   BSON_ASSERT (scram->cache);
+
+   bson_mutex_lock (&gScramCacheMutex);
+   entry = _mongoc_scram_global_cache_find (scram);
+   if (!entry) {
+      entry = &gScramCache[gScramCacheNext];
+      gScramCacheNext = (gScramCacheNext + 1) % MONGOC_SCRAM_GLOBAL_CACHE_SIZE;
+      _mongoc_scram_cache_entry_clear (entry);
+      entry->user = bson_strdup (scram->user ? scram->user : "");
+      entry->algorithm = scram->crypto.algorithm;
+      entry->secrets = _mongoc_scram_cache_copy (scram->cache);
+   }
+
+   bson_mutex_unlock (&gScramCacheMutex);
 }
 
 
@@ -760,6 +910,11 @@ _mongoc_scram_step2 (mongoc_scram_t *scram,
    if (scram->cache &&
        _mongoc_scram_cache_has_presecrets (scram->cache, scram)) {
       _mongoc_scram_cache_apply_secrets (scram->cache, scram);
+      mongoc_counter_auth_scram_cache_hit_inc ();
+   } else if (_mongoc_scram_global_cache_get (scram)) {
+      mongoc_counter_auth_scram_cache_hit_inc ();
+   } else {
+      mongoc_counter_auth_scram_cache_miss_inc ();
    }
 
    if (!*scram->salted_password) {
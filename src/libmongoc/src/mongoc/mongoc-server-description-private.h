@@ -20,6 +20,7 @@
 #define MONGOC_SERVER_DESCRIPTION_PRIVATE_H
 
 #include "mongoc/mongoc-server-description.h"
+#include "mongoc/mongoc-thread-private.h"
 
 
 #define MONGOC_DEFAULT_WIRE_VERSION 0
@@ -45,6 +46,19 @@ typedef enum {
    MONGOC_SERVER_DESCRIPTION_TYPES,
 } mongoc_server_description_type_t;
 
+struct _mongoc_counters_entry_t;
+
+/* how busy a server is, measured from the client's own commands. shared by
+ * all copies of the server's description so every client in a pool sees it */
+typedef struct _mongoc_server_load_t {
+   volatile int32_t ref_count;
+   volatile int32_t in_flight;
+   bson_mutex_t mutex;
+   int64_t latency_usec; /* moving average, -1 before the first command */
+   /* the server's entry in the shared memory counters, or NULL */
+   struct _mongoc_counters_entry_t *counters;
+} mongoc_server_load_t;
+
 struct _mongoc_server_description_t {
    uint32_t id;
    mongoc_host_list_t host;
@@ -80,6 +94,9 @@ struct _mongoc_server_description_t {
    int64_t last_write_date_ms;
 
    bson_t compressors;
+
+   /* NULL unless this describes a server in a topology */
+   mongoc_server_load_t *load;
 };
 
 void
@@ -102,6 +119,15 @@ mongoc_server_description_has_election_id (
 void
 mongoc_server_description_cleanup (mongoc_server_description_t *sd);
 
+mongoc_server_load_t *
+_mongoc_server_load_new (const char *host);
+
+void
+_mongoc_server_load_begin (mongoc_server_load_t *load);
+
+void
+_mongoc_server_load_end (mongoc_server_load_t *load, int64_t duration_usec);
+
 void
 mongoc_server_description_reset (mongoc_server_description_t *sd);
 
@@ -15,6 +15,7 @@
  */
 
 #include "mongoc/mongoc-config.h"
+#include "mongoc/mongoc-counters-private.h"
 #include "mongoc/mongoc-host-list.h"
 #include "mongoc/mongoc-host-list-private.h"
 #include "mongoc/mongoc-read-prefs.h"
@@ -47,6 +48,14 @@ mongoc_server_description_cleanup (mongoc_server_description_t *sd)
    bson_destroy (&sd->arbiters);
    bson_destroy (&sd->tags);
    bson_destroy (&sd->compressors);
+
+   if (sd->load &&
+       bson_atomic_int_add (&sd->load->ref_count, -1) == 0) {
+      bson_mutex_destroy (&sd->load->mutex);
+      bson_free (sd->load);
+   }
+
+   sd->load = NULL;
 }
 
 /* Reset fields inside this sd, but keep same id, host information, and RTT,
@@ -315,6 +324,59 @@ mongoc_server_description_round_trip_time (
    return description->round_trip_time_msec;
 }
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_server_description_command_latency_usec --
+ *
+ *      Get the moving average duration of commands this client has run
+ *      on the server, including time the server spent executing them.
+ *
+ * Returns:
+ *      The average in microseconds, or -1 if no command has finished yet.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+int64_t
+mongoc_server_description_command_latency_usec (
+   const mongoc_server_description_t *description)
+{
+   int64_t latency_usec;
+
+   if (!description->load) {
+      return -1;
+   }
+
+   bson_mutex_lock (&description->load->mutex);
+   latency_usec = description->load->latency_usec;
+   bson_mutex_unlock (&description->load->mutex);
+
+   return latency_usec;
+}
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_server_description_in_flight_count --
+ *
+ *      Get the number of commands this client, or the pool it belongs to,
+ *      has sent to the server and not yet received replies to.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+int32_t
+mongoc_server_description_in_flight_count (
+   const mongoc_server_description_t *description)
+{
+   if (!description->load) {
+      return 0;
+   }
+
+   return bson_atomic_int_add (&description->load->in_flight, 0);
+}
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -741,6 +803,13 @@ mongoc_server_description_new_copy (
 
    /* Preserve the error */
    memcpy (&copy->error, &description->error, sizeof copy->error);
+
+   /* copies keep counting the same server's load */
+   copy->load = description->load;
+   if (copy->load) {
+      bson_atomic_int_add (&copy->load->ref_count, 1);
+   }
+
    return copy;
 }
 
@@ -998,3 +1067,71 @@ mongoc_server_description_compressor_id (
 
    return -1;
 }
+
+
+mongoc_server_load_t *
+_mongoc_server_load_new (const char *host)
+{
+   mongoc_server_load_t *load;
+
+   load = (mongoc_server_load_t *) bson_malloc0 (sizeof *load);
+   load->ref_count = 1;
+   load->latency_usec = -1;
+   bson_mutex_init (&load->mutex);
+   /* look it up once, not for each command */
+   load->counters = _mongoc_counters_entry (host, NULL);
+
+   return load;
+}
+
+
+/*
+ *-------------------------------------------------------------------------
+ *
+ * _mongoc_server_load_begin --
+ *
+ *       Count a command sent to the server. Each call must be matched by
+ *       a call to _mongoc_server_load_end. @load may be NULL.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+void
+_mongoc_server_load_begin (mongoc_server_load_t *load)
+{
+   if (load) {
+      bson_atomic_int_add (&load->in_flight, 1);
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------------
+ *
+ * _mongoc_server_load_end --
+ *
+ *       Count a command's reply, or its failure, and fold its duration
+ *       into the moving average like mongoc_server_description_update_rtt.
+ *       @load may be NULL.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+void
+_mongoc_server_load_end (mongoc_server_load_t *load, int64_t duration_usec)
+{
+   if (!load) {
+      return;
+   }
+
+   bson_atomic_int_add (&load->in_flight, -1);
+
+   bson_mutex_lock (&load->mutex);
+   if (load->latency_usec == -1) {
+      load->latency_usec = duration_usec;
+   } else {
+      load->latency_usec = (int64_t) (ALPHA * duration_usec +
+                                      (1 - ALPHA) * load->latency_usec);
+   }
+   bson_mutex_unlock (&load->mutex);
+}
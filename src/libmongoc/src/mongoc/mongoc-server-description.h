@@ -46,6 +46,14 @@ MONGOC_EXPORT (int64_t)
 mongoc_server_description_round_trip_time (
    const mongoc_server_description_t *description);
 
+MONGOC_EXPORT (int64_t)
+mongoc_server_description_command_latency_usec (
+   const mongoc_server_description_t *description);
+
+MONGOC_EXPORT (int32_t)
+mongoc_server_description_in_flight_count (
+   const mongoc_server_description_t *description);
+
 MONGOC_EXPORT (const char *)
 mongoc_server_description_type (const mongoc_server_description_t *description);
 
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2018-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mongoc/mongoc-prelude.h"
+
+#ifndef MONGOC_SERVER_MONITOR_PRIVATE_H
+#define MONGOC_SERVER_MONITOR_PRIVATE_H
+
+#include <bson/bson.h>
+
+#include "mongoc/mongoc-host-list.h"
+#include "mongoc/mongoc-ssl.h"
+#include "mongoc/mongoc-stream.h"
+#include "mongoc/mongoc-thread-private.h"
+#include "mongoc/mongoc-uri.h"
+
+BSON_BEGIN_DECLS
+
+/* how often a monitor waiting for a reply checks for a shutdown request */
+#define MONGOC_SERVER_MONITOR_POLL_MS 100
+
+struct _mongoc_topology_t;
+
+/* in pooled mode, a thread with its own connection to one server that
+ * supports awaitable ismaster. the server replies as soon as its state
+ * changes, or after heartbeatFrequencyMS, and the monitor applies each reply
+ * to the topology. the topology scanner keeps checking the server too, which
+ * measures round trip time and is the fallback if streaming fails. */
+typedef struct _mongoc_server_monitor_t {
+   struct _mongoc_topology_t *topology;
+   uint32_t server_id;
+   mongoc_host_list_t host;
+   const mongoc_uri_t *uri;
+   mongoc_ssl_opt_t *ssl_opts;
+   int64_t heartbeat_msec;
+   int64_t min_heartbeat_msec;
+   int64_t connect_timeout_msec;
+   bson_t handshake_cmd;
+   bson_thread_t thread;
+
+   /* used only by the monitor's thread */
+   mongoc_stream_t *stream;
+   bson_t topology_version;
+   uint32_t request_id;
+
+   /* guards shutdown_requested and stopped, and wakes the thread when
+    * shutdown is requested */
+   bson_mutex_t mutex;
+   mongoc_cond_t cond;
+   bool shutdown_requested;
+   /* the thread has returned, joining it won't block */
+   bool stopped;
+} mongoc_server_monitor_t;
+
+mongoc_server_monitor_t *
+_mongoc_server_monitor_new (struct _mongoc_topology_t *topology,
+                            uint32_t server_id,
+                            const mongoc_host_list_t *host);
+
+void
+_mongoc_server_monitor_request_shutdown (mongoc_server_monitor_t *monitor);
+
+bool
+_mongoc_server_monitor_shutdown_requested (mongoc_server_monitor_t *monitor);
+
+bool
+_mongoc_server_monitor_stopped (mongoc_server_monitor_t *monitor);
+
+void
+_mongoc_server_monitor_destroy (mongoc_server_monitor_t *monitor);
+
+BSON_END_DECLS
+
+#endif /* MONGOC_SERVER_MONITOR_PRIVATE_H */
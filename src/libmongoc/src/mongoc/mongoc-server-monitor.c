@@ -0,0 +1,519 @@
+/*
+ * Copyright 2018-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mongoc/mongoc-server-monitor-private.h"
+
+#include "mongoc/mongoc-array-private.h"
+#include "mongoc/mongoc-buffer-private.h"
+#include "mongoc/mongoc-client-private.h"
+#include "mongoc/mongoc-error.h"
+#include "mongoc/mongoc-rpc-private.h"
+#include "mongoc/mongoc-stream-private.h"
+#include "mongoc/mongoc-topology-private.h"
+#include "mongoc/mongoc-topology-scanner-private.h"
+#include "mongoc/mongoc-trace-private.h"
+
+#undef MONGOC_LOG_DOMAIN
+#define MONGOC_LOG_DOMAIN "server_monitor"
+
+
+bool
+_mongoc_server_monitor_shutdown_requested (mongoc_server_monitor_t *monitor)
+{
+   bool r;
+
+   bson_mutex_lock (&monitor->mutex);
+   r = monitor->shutdown_requested;
+   bson_mutex_unlock (&monitor->mutex);
+
+   return r;
+}
+
+
+bool
+_mongoc_server_monitor_stopped (mongoc_server_monitor_t *monitor)
+{
+   bool r;
+
+   bson_mutex_lock (&monitor->mutex);
+   r = monitor->stopped;
+   bson_mutex_unlock (&monitor->mutex);
+
+   return r;
+}
+
+
+/* sleep for up to @msec, or until shutdown is requested */
+static void
+_server_monitor_wait (mongoc_server_monitor_t *monitor, int64_t msec)
+{
+   int64_t expire_at;
+   int64_t now;
+
+   expire_at = bson_get_monotonic_time () + msec * 1000;
+
+   bson_mutex_lock (&monitor->mutex);
+   while (!monitor->shutdown_requested) {
+      now = bson_get_monotonic_time ();
+      if (now >= expire_at) {
+         break;
+      }
+
+      mongoc_cond_timedwait (
+         &monitor->cond, &monitor->mutex, (expire_at - now) / 1000 + 1);
+   }
+
+   bson_mutex_unlock (&monitor->mutex);
+}
+
+
+static void
+_server_monitor_close (mongoc_server_monitor_t *monitor)
+{
+   if (monitor->stream) {
+      mongoc_stream_failed (monitor->stream);
+      monitor->stream = NULL;
+   }
+
+   bson_reinit (&monitor->topology_version);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _server_monitor_run_ismaster --
+ *
+ *       Send an ismaster command on the monitor's stream and wait up to
+ *       @timeout_msec for the reply. While waiting, check every
+ *       MONGOC_SERVER_MONITOR_POLL_MS whether shutdown was requested.
+ *
+ * Returns:
+ *       True if a reply was received, otherwise false and @error is set.
+ *       @reply is always initialized.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_server_monitor_run_ismaster (mongoc_server_monitor_t *monitor,
+                              const bson_t *cmd,
+                              int64_t timeout_msec,
+                              bson_t *reply,
+                              bson_error_t *error)
+{
+   mongoc_rpc_t rpc;
+   mongoc_array_t array;
+   mongoc_buffer_t buffer;
+   mongoc_stream_poll_t poller;
+   bson_t body;
+   int64_t expire_at;
+   int64_t now;
+   int32_t poll_msec;
+   ssize_t r;
+   uint32_t msg_len;
+   bool ret = false;
+
+   bson_init (reply);
+   _mongoc_array_init (&array, sizeof (mongoc_iovec_t));
+   _mongoc_buffer_init (&buffer, NULL, 0, NULL, NULL);
+
+   /* like the topology scanner's ismaster, never compressed */
+   rpc.header.msg_len = 0;
+   rpc.header.request_id = ++monitor->request_id;
+   rpc.header.response_to = 0;
+   rpc.header.opcode = MONGOC_OPCODE_QUERY;
+   rpc.query.flags = MONGOC_QUERY_SLAVE_OK;
+   rpc.query.collection = "admin.$cmd";
+   rpc.query.skip = 0;
+   rpc.query.n_return = -1;
+   rpc.query.query = bson_get_data (cmd);
+   rpc.query.fields = NULL;
+
+   _mongoc_rpc_gather (&rpc, &array);
+   _mongoc_rpc_swab_to_le (&rpc);
+
+   expire_at = bson_get_monotonic_time () + timeout_msec * 1000;
+
+   if (!_mongoc_stream_writev_full (monitor->stream,
+                                    (mongoc_iovec_t *) array.data,
+                                    array.len,
+                                    (int32_t) monitor->connect_timeout_msec,
+                                    error)) {
+      GOTO (done);
+   }
+
+   for (;;) {
+      if (_mongoc_server_monitor_shutdown_requested (monitor)) {
+         bson_set_error (error,
+                         MONGOC_ERROR_STREAM,
+                         MONGOC_ERROR_STREAM_SOCKET,
+                         "server monitor shut down");
+         GOTO (done);
+      }
+
+      now = bson_get_monotonic_time ();
+      if (now >= expire_at) {
+         bson_set_error (error,
+                         MONGOC_ERROR_STREAM,
+                         MONGOC_ERROR_STREAM_SOCKET,
+                         "socket timeout");
+         GOTO (done);
+      }
+
+      poll_msec = (int32_t) BSON_MIN (MONGOC_SERVER_MONITOR_POLL_MS,
+                                      (expire_at - now) / 1000 + 1);
+      poller.stream = monitor->stream;
+      poller.events = POLLIN;
+      poller.revents = 0;
+
+      r = mongoc_stream_poll (&poller, 1, poll_msec);
+      if (r < 0) {
+         bson_set_error (error,
+                         MONGOC_ERROR_STREAM,
+                         MONGOC_ERROR_STREAM_SOCKET,
+                         "failed to poll server monitor connection");
+         GOTO (done);
+      }
+
+      if (r > 0) {
+         /* readable, or closed: reading tells which */
+         break;
+      }
+   }
+
+   if (!_mongoc_buffer_append_from_stream (
+          &buffer,
+          monitor->stream,
+          4,
+          (int32_t) monitor->connect_timeout_msec,
+          error)) {
+      GOTO (done);
+   }
+
+   memcpy (&msg_len, buffer.data, 4);
+   msg_len = BSON_UINT32_FROM_LE (msg_len);
+   if ((msg_len < 16) || (msg_len > MONGOC_DEFAULT_MAX_MSG_SIZE)) {
+      bson_set_error (error,
+                      MONGOC_ERROR_PROTOCOL,
+                      MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
+                      "Invalid reply from server.");
+      GOTO (done);
+   }
+
+   if (!_mongoc_buffer_append_from_stream (
+          &buffer,
+          monitor->stream,
+          msg_len - 4,
+          (int32_t) monitor->connect_timeout_msec,
+          error)) {
+      GOTO (done);
+   }
+
+   if (!_mongoc_rpc_scatter (&rpc, buffer.data, buffer.len)) {
+      bson_set_error (error,
+                      MONGOC_ERROR_PROTOCOL,
+                      MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
+                      "Invalid reply from server.");
+      GOTO (done);
+   }
+
+   _mongoc_rpc_swab_from_le (&rpc);
+
+   if (rpc.header.opcode != MONGOC_OPCODE_REPLY ||
+       !_mongoc_rpc_get_first_document (&rpc, &body)) {
+      bson_set_error (error,
+                      MONGOC_ERROR_PROTOCOL,
+                      MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
+                      "Invalid reply from server");
+      GOTO (done);
+   }
+
+   bson_destroy (reply);
+   bson_copy_to (&body, reply);
+   ret = true;
+
+done:
+   _mongoc_buffer_destroy (&buffer);
+   _mongoc_array_destroy (&array);
+
+   return ret;
+}
+
+
+/* true if @reply is "ok", otherwise false and @error is set */
+static bool
+_server_monitor_reply_ok (const bson_t *reply, bson_error_t *error)
+{
+   bson_iter_t iter;
+   const char *msg = "unknown error";
+
+   if (bson_iter_init_find (&iter, reply, "ok") && bson_iter_as_bool (&iter)) {
+      return true;
+   }
+
+   if (bson_iter_init_find (&iter, reply, "errmsg") &&
+       BSON_ITER_HOLDS_UTF8 (&iter)) {
+      msg = bson_iter_utf8 (&iter, NULL);
+   }
+
+   bson_set_error (error,
+                   MONGOC_ERROR_SERVER,
+                   MONGOC_ERROR_QUERY_FAILURE,
+                   "ismaster failed: %s",
+                   msg);
+
+   return false;
+}
+
+
+/* true if @reply is an ismaster reply with a topologyVersion. the caller
+ * checks "ok" first */
+static bool
+_server_monitor_can_stream (const bson_t *reply)
+{
+   bson_iter_t iter;
+
+   return bson_iter_init_find (&iter, reply, "topologyVersion") &&
+          BSON_ITER_HOLDS_DOCUMENT (&iter);
+}
+
+
+/* @reply's topologyVersion, which _server_monitor_can_stream checked */
+static void
+_server_monitor_get_topology_version (const bson_t *reply, bson_t *tv)
+{
+   bson_iter_t iter;
+   uint32_t len;
+   const uint8_t *data;
+
+   BSON_ASSERT (bson_iter_init_find (&iter, reply, "topologyVersion"));
+   bson_iter_document (&iter, &len, &data);
+   BSON_ASSERT (bson_init_static (tv, data, len));
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _server_monitor_check --
+ *
+ *       Run one check: on a new connection the handshake, which is a plain
+ *       ismaster, then an awaitable ismaster with the last topologyVersion
+ *       the server sent.
+ *
+ * Returns:
+ *       False if the server replied without a topologyVersion, so it
+ *       doesn't support awaitable ismaster and the monitor should stop and
+ *       leave the server to the topology scanner. The topology starts a
+ *       new monitor if a later scan finds a topologyVersion again.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_server_monitor_check (mongoc_server_monitor_t *monitor)
+{
+   mongoc_topology_t *topology = monitor->topology;
+   bson_t cmd;
+   bson_t reply;
+   bson_t tv;
+   bson_error_t error;
+   int64_t start;
+   int64_t elapsed_msec;
+   int64_t rtt_msec;
+   bool awaited;
+   bool ret = true;
+
+   if (!monitor->stream) {
+      monitor->stream = _mongoc_client_connect (
+         monitor->uri, &monitor->host, monitor->ssl_opts, &error);
+
+      if (!monitor->stream) {
+         /* the topology scanner reports the server's failure */
+         _server_monitor_wait (monitor, monitor->heartbeat_msec);
+         return true;
+      }
+   }
+
+   awaited = !bson_empty (&monitor->topology_version);
+   if (awaited) {
+      bson_init (&cmd);
+      BSON_APPEND_INT32 (&cmd, "isMaster", 1);
+      BSON_APPEND_DOCUMENT (
+         &cmd, "topologyVersion", &monitor->topology_version);
+      BSON_APPEND_INT64 (&cmd, "maxAwaitTimeMS", monitor->heartbeat_msec);
+   } else {
+      bson_copy_to (&monitor->handshake_cmd, &cmd);
+   }
+
+   start = bson_get_monotonic_time ();
+   if (!_server_monitor_run_ismaster (
+          monitor,
+          &cmd,
+          monitor->connect_timeout_msec +
+             (awaited ? monitor->heartbeat_msec : 0),
+          &reply,
+          &error) ||
+       !_server_monitor_reply_ok (&reply, &error)) {
+      /* a command error may be transient, like a network error: reconnect
+       * and retry rather than give up streaming */
+      _server_monitor_close (monitor);
+
+      if (!_mongoc_server_monitor_shutdown_requested (monitor)) {
+         /* the server may be down: have the scanner check it at once */
+         MONGOC_DEBUG ("server monitor for %s failed: %s",
+                       monitor->host.host_and_port,
+                       error.message);
+         _mongoc_topology_request_probe (topology, monitor->server_id);
+         _server_monitor_wait (monitor, monitor->min_heartbeat_msec);
+      }
+
+      GOTO (done);
+   }
+
+   if (!_server_monitor_can_stream (&reply)) {
+      ret = false;
+      GOTO (done);
+   }
+
+   /* an awaited reply's duration isn't a round trip time */
+   elapsed_msec = (bson_get_monotonic_time () - start) / 1000;
+   rtt_msec = awaited ? -1 : elapsed_msec;
+
+   _server_monitor_get_topology_version (&reply, &tv);
+   if (awaited && bson_equal (&monitor->topology_version, &tv) &&
+       elapsed_msec < monitor->min_heartbeat_msec) {
+      /* the server replied at once with nothing new, don't spin */
+      _server_monitor_wait (monitor,
+                            monitor->min_heartbeat_msec - elapsed_msec);
+   }
+
+   bson_destroy (&monitor->topology_version);
+   bson_copy_to (&tv, &monitor->topology_version);
+   _mongoc_topology_update_from_monitor (topology, monitor, &reply, rtt_msec);
+
+done:
+   bson_destroy (&reply);
+   bson_destroy (&cmd);
+
+   return ret;
+}
+
+
+static void *
+_server_monitor_run (void *data)
+{
+   mongoc_server_monitor_t *monitor = (mongoc_server_monitor_t *) data;
+
+   while (!_mongoc_server_monitor_shutdown_requested (monitor)) {
+      if (!_server_monitor_check (monitor)) {
+         MONGOC_DEBUG ("%s doesn't support awaitable ismaster, polling it",
+                       monitor->host.host_and_port);
+         break;
+      }
+   }
+
+   _server_monitor_close (monitor);
+
+   bson_mutex_lock (&monitor->mutex);
+   monitor->stopped = true;
+   bson_mutex_unlock (&monitor->mutex);
+
+   return NULL;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_server_monitor_new --
+ *
+ *       Start monitoring server @server_id at @host in a new thread.
+ *
+ *       NOTE: the caller must hold @topology's mutex.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_server_monitor_t *
+_mongoc_server_monitor_new (mongoc_topology_t *topology,
+                            uint32_t server_id,
+                            const mongoc_host_list_t *host)
+{
+   mongoc_server_monitor_t *monitor;
+   int r;
+
+   monitor = (mongoc_server_monitor_t *) bson_malloc0 (sizeof *monitor);
+   monitor->topology = topology;
+   monitor->server_id = server_id;
+   memcpy (&monitor->host, host, sizeof *host);
+   monitor->uri = topology->uri;
+   monitor->ssl_opts = topology->scanner->ssl_opts;
+   monitor->heartbeat_msec = topology->description.heartbeat_msec;
+   monitor->min_heartbeat_msec = topology->min_heartbeat_frequency_msec;
+   monitor->connect_timeout_msec = topology->connect_timeout_msec;
+   bson_copy_to (_mongoc_topology_scanner_get_ismaster (topology->scanner),
+                 &monitor->handshake_cmd);
+   bson_init (&monitor->topology_version);
+   bson_mutex_init (&monitor->mutex);
+   mongoc_cond_init (&monitor->cond);
+
+   r = bson_thread_create (&monitor->thread, _server_monitor_run, monitor);
+   if (r != 0) {
+      MONGOC_ERROR ("could not start server monitor thread: %s",
+                    strerror (r));
+      abort ();
+   }
+
+   return monitor;
+}
+
+
+/* ask the monitor's thread to stop, without waiting for it */
+void
+_mongoc_server_monitor_request_shutdown (mongoc_server_monitor_t *monitor)
+{
+   bson_mutex_lock (&monitor->mutex);
+   monitor->shutdown_requested = true;
+   mongoc_cond_signal (&monitor->cond);
+   bson_mutex_unlock (&monitor->mutex);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_server_monitor_destroy --
+ *
+ *       Stop the monitor's thread and free it. This waits for the thread,
+ *       which may need @topology's mutex: the caller must not hold it.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_server_monitor_destroy (mongoc_server_monitor_t *monitor)
+{
+   _mongoc_server_monitor_request_shutdown (monitor);
+   bson_thread_join (monitor->thread);
+
+   bson_destroy (&monitor->handshake_cmd);
+   bson_destroy (&monitor->topology_version);
+   mongoc_cond_destroy (&monitor->cond);
+   bson_mutex_destroy (&monitor->mutex);
+   bson_free (monitor);
+}
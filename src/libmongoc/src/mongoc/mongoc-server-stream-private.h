@@ -32,7 +32,8 @@ BSON_BEGIN_DECLS
 typedef struct _mongoc_server_stream_t {
    mongoc_topology_description_type_t topology_type;
    mongoc_server_description_t *sd; /* owned */
-   bson_t cluster_time;             /* owned */
+   bson_t cluster_time_fragment;    /* owned, {"$clusterTime": ...} */
+   bson_t cluster_time;             /* view of cluster_time_fragment */
    mongoc_stream_t *stream;         /* borrowed */
 } mongoc_server_stream_t;
 
@@ -15,6 +15,7 @@
  */
 
 
+#include "mongoc/mongoc-client-session-private.h"
 #include "mongoc/mongoc-cluster-private.h"
 #include "mongoc/mongoc-server-stream-private.h"
 #include "mongoc/mongoc-util-private.h"
@@ -34,7 +35,10 @@ mongoc_server_stream_new (const mongoc_topology_description_t *td,
 
    server_stream = bson_malloc (sizeof (mongoc_server_stream_t));
    server_stream->topology_type = td->type;
-   bson_copy_to (&td->cluster_time, &server_stream->cluster_time);
+   bson_copy_to (&td->cluster_time_fragment,
+                 &server_stream->cluster_time_fragment);
+   _mongoc_cluster_time_from_fragment (&server_stream->cluster_time_fragment,
+                                       &server_stream->cluster_time);
    server_stream->sd = sd;         /* becomes owned */
    server_stream->stream = stream; /* merely borrowed */
 
@@ -47,6 +51,7 @@ mongoc_server_stream_cleanup (mongoc_server_stream_t *server_stream)
    if (server_stream) {
       mongoc_server_description_destroy (server_stream->sd);
       bson_destroy (&server_stream->cluster_time);
+      bson_destroy (&server_stream->cluster_time_fragment);
       bson_free (server_stream);
    }
 }
@@ -39,6 +39,9 @@ mongoc_socket_accept_ex (mongoc_socket_t *sock,
                          int64_t expire_at,
                          uint16_t *port);
 
+int
+_mongoc_socket_connect_finish (mongoc_socket_t *sock);
+
 BSON_END_DECLS
 
 #endif /* MONGOC_SOCKET_PRIVATE_H */
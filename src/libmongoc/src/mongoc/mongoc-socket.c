@@ -572,6 +572,52 @@ _mongoc_socket_setnodelay (int sd) /* IN */
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_socket_connect_finish --
+ *
+ *       Check the result of a non-blocking connect that was started with
+ *       mongoc_socket_connect() and an @expire_at of zero, once @sock is
+ *       reported writable by mongoc_socket_poll().
+ *
+ * Returns:
+ *       0 if the connection is established, otherwise -1 and the socket's
+ *       errno is set.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+int
+_mongoc_socket_connect_finish (mongoc_socket_t *sock) /* IN */
+{
+   int ret;
+   int optval = -1;
+   /* getsockopt parameter types vary, we check in CheckCompiler.m4 */
+   mongoc_socklen_t optlen = (mongoc_socklen_t) sizeof optval;
+
+   ENTRY;
+
+   BSON_ASSERT (sock);
+
+   ret = getsockopt (sock->sd, SOL_SOCKET, SO_ERROR, (char *) &optval, &optlen);
+   if (ret != 0) {
+      _mongoc_socket_capture_errno (sock);
+      RETURN (-1);
+   }
+
+   if (optval != 0) {
+      errno = sock->errno_ = optval;
+      RETURN (-1);
+   }
+
+   RETURN (0);
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
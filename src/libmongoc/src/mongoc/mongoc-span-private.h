@@ -0,0 +1,151 @@
+/*
+ * Copyright 2018-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mongoc/mongoc-prelude.h"
+
+#ifndef MONGOC_SPAN_PRIVATE_H
+#define MONGOC_SPAN_PRIVATE_H
+
+#include <bson/bson.h>
+
+#include "mongoc/mongoc-span.h"
+
+BSON_BEGIN_DECLS
+
+struct _mongoc_span_t {
+   char command_name[64];
+   mongoc_host_list_t host;
+   bool has_host;
+   bool succeeded;
+   int64_t start;
+   int64_t duration;
+   /* the monotonic time each phase first began, or 0 */
+   int64_t phase_start[MONGOC_SPAN_PHASE_COUNT];
+   /* the total time spent in each phase, which may repeat or nest */
+   int64_t phase_duration[MONGOC_SPAN_PHASE_COUNT];
+};
+
+
+/* each client has a tracer. a client is used by one thread at a time and
+ * runs one operation at a time, so the span in progress needs no lock. */
+typedef struct {
+   mongoc_span_func_t func;
+   void *context;
+   double sample_rate;
+   /* accumulates sample_rate per operation, an operation is sampled each
+    * time it reaches 1 */
+   double sample_credit;
+   /* an operation is in progress */
+   bool open;
+   /* and its span is being recorded */
+   bool sampled;
+   /* commands written without waiting for their replies, whose replies have
+    * not been read; the span ends when the last is finished */
+   uint32_t n_in_flight;
+   /* and one of them failed */
+   bool in_flight_failed;
+   mongoc_span_t span;
+} mongoc_tracer_t;
+
+
+void
+_mongoc_tracer_set (mongoc_tracer_t *tracer,
+                    double sample_rate,
+                    mongoc_span_func_t func,
+                    void *context);
+
+void
+_mongoc_tracer_begin (mongoc_tracer_t *tracer, bool restart);
+
+void
+_mongoc_tracer_end (mongoc_tracer_t *tracer,
+                    const char *command_name,
+                    const mongoc_host_list_t *host,
+                    bool succeeded);
+
+void
+_mongoc_tracer_begin_in_flight (mongoc_tracer_t *tracer);
+
+void
+_mongoc_tracer_end_in_flight (mongoc_tracer_t *tracer,
+                              const char *command_name,
+                              const mongoc_host_list_t *host,
+                              bool succeeded);
+
+
+/* returns the time a phase began if the span in progress is sampled, or 0
+ * to skip recording the phase */
+static BSON_INLINE int64_t
+_mongoc_tracer_phase_begin (const mongoc_tracer_t *tracer)
+{
+   return tracer->sampled ? bson_get_monotonic_time () : 0;
+}
+
+
+/* record a phase timed by the caller, if the span in progress is sampled */
+static BSON_INLINE void
+_mongoc_tracer_phase_add (mongoc_tracer_t *tracer,
+                          mongoc_span_phase_t phase,
+                          int64_t started,
+                          int64_t duration)
+{
+   if (!tracer->sampled) {
+      return;
+   }
+
+   if (!tracer->span.phase_start[phase]) {
+      tracer->span.phase_start[phase] = started;
+   }
+
+   tracer->span.phase_duration[phase] += duration;
+}
+
+
+static BSON_INLINE void
+_mongoc_tracer_phase_end (mongoc_tracer_t *tracer,
+                          mongoc_span_phase_t phase,
+                          int64_t started)
+{
+   if (!started || !tracer->sampled) {
+      return;
+   }
+
+   _mongoc_tracer_phase_add (
+      tracer, phase, started, bson_get_monotonic_time () - started);
+}
+
+
+/* stop recording phases while the driver runs its own commands to set up or
+ * check a connection. returns the state to pass to _mongoc_tracer_resume */
+static BSON_INLINE bool
+_mongoc_tracer_pause (mongoc_tracer_t *tracer)
+{
+   bool sampled = tracer->sampled;
+
+   tracer->sampled = false;
+   return sampled;
+}
+
+
+static BSON_INLINE void
+_mongoc_tracer_resume (mongoc_tracer_t *tracer, bool sampled)
+{
+   tracer->sampled = sampled;
+}
+
+BSON_END_DECLS
+
+#endif /* MONGOC_SPAN_PRIVATE_H */
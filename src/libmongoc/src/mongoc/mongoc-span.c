@@ -0,0 +1,261 @@
+/*
+ * Copyright 2018-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mongoc/mongoc-span-private.h"
+
+
+void
+_mongoc_tracer_set (mongoc_tracer_t *tracer,
+                    double sample_rate,
+                    mongoc_span_func_t func,
+                    void *context)
+{
+   memset (tracer, 0, sizeof *tracer);
+
+   if (func && sample_rate > 0) {
+      tracer->func = func;
+      tracer->context = context;
+      tracer->sample_rate = BSON_MIN (sample_rate, 1.0);
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_tracer_begin --
+ *
+ *       Called where an operation may begin. If @restart, a new operation
+ *       begins here and any unfinished span is discarded; otherwise one
+ *       begins only if none is in progress. Decides whether to sample the
+ *       new operation.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_tracer_begin (mongoc_tracer_t *tracer, bool restart)
+{
+   if (restart) {
+      tracer->n_in_flight = 0;
+      tracer->in_flight_failed = false;
+   }
+
+   if (!tracer->func || (tracer->open && !restart)) {
+      return;
+   }
+
+   tracer->open = true;
+   tracer->sample_credit += tracer->sample_rate;
+   tracer->sampled = tracer->sample_credit >= 1.0;
+   if (!tracer->sampled) {
+      return;
+   }
+
+   tracer->sample_credit -= 1.0;
+   memset (&tracer->span, 0, sizeof tracer->span);
+   tracer->span.start = bson_get_monotonic_time ();
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_tracer_end --
+ *
+ *       Called when a command's reply has been handled, or the command
+ *       has failed. If the operation was sampled, passes its span to the
+ *       callback.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_tracer_end (mongoc_tracer_t *tracer,
+                    const char *command_name,
+                    const mongoc_host_list_t *host,
+                    bool succeeded)
+{
+   mongoc_span_t span;
+
+   if (!tracer->sampled) {
+      tracer->open = false;
+      return;
+   }
+
+   /* the callback may run another operation with this client */
+   memcpy (&span, &tracer->span, sizeof span);
+   tracer->open = false;
+   tracer->sampled = false;
+
+   bson_strncpy (span.command_name,
+                 command_name ? command_name : "",
+                 sizeof span.command_name);
+   if (host) {
+      memcpy (&span.host, host, sizeof span.host);
+      span.host.next = NULL;
+      span.has_host = true;
+   }
+
+   span.succeeded = succeeded;
+   span.duration = bson_get_monotonic_time () - span.start;
+
+   tracer->func (&span, tracer->context);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_tracer_begin_in_flight --
+ *
+ *       Called when a command is written without waiting for its reply.
+ *       Begins an operation if none is in progress; commands pipelined
+ *       on one connection share its span.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_tracer_begin_in_flight (mongoc_tracer_t *tracer)
+{
+   _mongoc_tracer_begin (tracer, false);
+   tracer->n_in_flight++;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_tracer_end_in_flight --
+ *
+ *       Called when the reply to a command begun with
+ *       _mongoc_tracer_begin_in_flight has been handled, or the command
+ *       has failed. The span ends with the last command in flight, and
+ *       succeeded only if all of them did.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_tracer_end_in_flight (mongoc_tracer_t *tracer,
+                              const char *command_name,
+                              const mongoc_host_list_t *host,
+                              bool succeeded)
+{
+   BSON_ASSERT (tracer->n_in_flight > 0);
+
+   tracer->n_in_flight--;
+   if (!succeeded) {
+      tracer->in_flight_failed = true;
+   }
+
+   if (tracer->n_in_flight > 0) {
+      return;
+   }
+
+   succeeded = !tracer->in_flight_failed;
+   tracer->in_flight_failed = false;
+   _mongoc_tracer_end (tracer, command_name, host, succeeded);
+}
+
+
+const char *
+mongoc_span_get_command_name (const mongoc_span_t *span)
+{
+   return span->command_name;
+}
+
+
+const mongoc_host_list_t *
+mongoc_span_get_host (const mongoc_span_t *span)
+{
+   return span->has_host ? &span->host : NULL;
+}
+
+
+bool
+mongoc_span_get_succeeded (const mongoc_span_t *span)
+{
+   return span->succeeded;
+}
+
+
+int64_t
+mongoc_span_get_start_time (const mongoc_span_t *span)
+{
+   return span->start;
+}
+
+
+int64_t
+mongoc_span_get_duration (const mongoc_span_t *span)
+{
+   return span->duration;
+}
+
+
+int64_t
+mongoc_span_get_phase_start (const mongoc_span_t *span,
+                             mongoc_span_phase_t phase)
+{
+   BSON_ASSERT (phase < MONGOC_SPAN_PHASE_COUNT);
+
+   if (!span->phase_start[phase]) {
+      return -1;
+   }
+
+   return span->phase_start[phase] - span->start;
+}
+
+
+int64_t
+mongoc_span_get_phase_duration (const mongoc_span_t *span,
+                                mongoc_span_phase_t phase)
+{
+   BSON_ASSERT (phase < MONGOC_SPAN_PHASE_COUNT);
+
+   return span->phase_duration[phase];
+}
+
+
+const char *
+mongoc_span_phase_str (mongoc_span_phase_t phase)
+{
+   switch (phase) {
+   case MONGOC_SPAN_PHASE_SERVER_SELECTION:
+      return "server selection";
+   case MONGOC_SPAN_PHASE_CONNECTION_CHECKOUT:
+      return "connection checkout";
+   case MONGOC_SPAN_PHASE_SESSION_POP:
+      return "session pop";
+   case MONGOC_SPAN_PHASE_COMMAND_ASSEMBLY:
+      return "command assembly";
+   case MONGOC_SPAN_PHASE_SEND:
+      return "send";
+   case MONGOC_SPAN_PHASE_WAIT:
+      return "wait";
+   case MONGOC_SPAN_PHASE_RECEIVE:
+      return "receive";
+   case MONGOC_SPAN_PHASE_DECOMPRESS:
+      return "decompress";
+   case MONGOC_SPAN_PHASE_PARSE:
+      return "parse";
+   case MONGOC_SPAN_PHASE_COUNT:
+   default:
+      return "unknown";
+   }
+}
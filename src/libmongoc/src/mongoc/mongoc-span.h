@@ -0,0 +1,68 @@
+/*
+ * Copyright 2018-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mongoc/mongoc-prelude.h"
+
+#ifndef MONGOC_SPAN_H
+#define MONGOC_SPAN_H
+
+#include <bson/bson.h>
+
+#include "mongoc/mongoc-macros.h"
+#include "mongoc/mongoc-host-list.h"
+
+BSON_BEGIN_DECLS
+
+typedef enum {
+   MONGOC_SPAN_PHASE_SERVER_SELECTION,
+   MONGOC_SPAN_PHASE_CONNECTION_CHECKOUT,
+   MONGOC_SPAN_PHASE_SESSION_POP,
+   MONGOC_SPAN_PHASE_COMMAND_ASSEMBLY,
+   MONGOC_SPAN_PHASE_SEND,
+   MONGOC_SPAN_PHASE_WAIT,
+   MONGOC_SPAN_PHASE_RECEIVE,
+   MONGOC_SPAN_PHASE_DECOMPRESS,
+   MONGOC_SPAN_PHASE_PARSE,
+   MONGOC_SPAN_PHASE_COUNT,
+} mongoc_span_phase_t;
+
+typedef struct _mongoc_span_t mongoc_span_t;
+
+typedef void (*mongoc_span_func_t) (const mongoc_span_t *span,
+                                    void *context);
+
+MONGOC_EXPORT (const char *)
+mongoc_span_get_command_name (const mongoc_span_t *span);
+MONGOC_EXPORT (const mongoc_host_list_t *)
+mongoc_span_get_host (const mongoc_span_t *span);
+MONGOC_EXPORT (bool)
+mongoc_span_get_succeeded (const mongoc_span_t *span);
+MONGOC_EXPORT (int64_t)
+mongoc_span_get_start_time (const mongoc_span_t *span);
+MONGOC_EXPORT (int64_t)
+mongoc_span_get_duration (const mongoc_span_t *span);
+MONGOC_EXPORT (int64_t)
+mongoc_span_get_phase_start (const mongoc_span_t *span,
+                             mongoc_span_phase_t phase);
+MONGOC_EXPORT (int64_t)
+mongoc_span_get_phase_duration (const mongoc_span_t *span,
+                                mongoc_span_phase_t phase);
+MONGOC_EXPORT (const char *)
+mongoc_span_phase_str (mongoc_span_phase_t phase);
+
+BSON_END_DECLS
+
+#endif /* MONGOC_SPAN_H */
@@ -35,6 +35,12 @@ typedef enum {
    MONGOC_TOPOLOGY_DESCRIPTION_TYPES
 } mongoc_topology_description_type_t;
 
+/* how to choose among the servers that are suitable for an operation */
+typedef enum {
+   MONGOC_SERVER_SELECTION_RANDOM,
+   MONGOC_SERVER_SELECTION_POWER_OF_TWO,
+} mongoc_server_selection_mode_t;
+
 struct _mongoc_topology_description_t {
    bson_oid_t topology_id;
    bool opened;
@@ -48,10 +54,13 @@ struct _mongoc_topology_description_t {
    uint32_t max_server_id;
    bool stale;
    unsigned int rand_seed;
+   mongoc_server_selection_mode_t selection_mode;
 
    /* the greatest seen cluster time, for a MongoDB 3.6+ sharded cluster.
     * see Driver Sessions Spec. */
    bson_t cluster_time;
+   /* {"$clusterTime": cluster_time}, or empty */
+   bson_t cluster_time_fragment;
 
    /* smallest seen logicalSessionTimeoutMinutes, or -1 if any server has no
     * logicalSessionTimeoutMinutes. see Server Discovery and Monitoring Spec */
@@ -89,6 +98,20 @@ mongoc_topology_description_select (mongoc_topology_description_t *description,
                                     const mongoc_read_prefs_t *read_pref,
                                     int64_t local_threshold_ms);
 
+mongoc_server_description_t *
+_mongoc_topology_description_select_with_seed (
+   mongoc_topology_description_t *description,
+   mongoc_ss_optype_t optype,
+   const mongoc_read_prefs_t *read_pref,
+   int64_t local_threshold_ms,
+   unsigned int *rand_seed);
+
+mongoc_server_description_t *
+_mongoc_topology_description_pick_server (
+   const mongoc_topology_description_t *description,
+   const mongoc_array_t *suitable_servers,
+   unsigned int *rand_seed);
+
 mongoc_server_description_t *
 mongoc_topology_description_server_by_id (
    mongoc_topology_description_t *description,
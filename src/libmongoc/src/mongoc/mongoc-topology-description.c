@@ -89,6 +89,7 @@ mongoc_topology_description_init (mongoc_topology_description_t *description,
    description->stale = true;
    description->rand_seed = (unsigned int) bson_get_monotonic_time ();
    bson_init (&description->cluster_time);
+   bson_init (&description->cluster_time_fragment);
    description->session_timeout_minutes = MONGOC_NO_SESSIONS;
 
    EXIT;
@@ -147,6 +148,7 @@ _mongoc_topology_description_copy_to (const mongoc_topology_description_t *src,
            sizeof (bson_error_t));
    dst->max_server_id = src->max_server_id;
    dst->stale = src->stale;
+   dst->selection_mode = src->selection_mode;
    memcpy (&dst->apm_callbacks,
            &src->apm_callbacks,
            sizeof (mongoc_apm_callbacks_t));
@@ -154,6 +156,7 @@ _mongoc_topology_description_copy_to (const mongoc_topology_description_t *src,
    dst->apm_context = src->apm_context;
 
    bson_copy_to (&src->cluster_time, &dst->cluster_time);
+   bson_copy_to (&src->cluster_time_fragment, &dst->cluster_time_fragment);
 
    dst->session_timeout_minutes = src->session_timeout_minutes;
 
@@ -191,6 +194,7 @@ mongoc_topology_description_destroy (mongoc_topology_description_t *description)
    }
 
    bson_destroy (&description->cluster_time);
+   bson_destroy (&description->cluster_time_fragment);
 
    EXIT;
 }
@@ -790,10 +794,36 @@ mongoc_topology_description_select (mongoc_topology_description_t *topology,
                                     mongoc_ss_optype_t optype,
                                     const mongoc_read_prefs_t *read_pref,
                                     int64_t local_threshold_ms)
+{
+   return _mongoc_topology_description_select_with_seed (topology,
+                                                         optype,
+                                                         read_pref,
+                                                         local_threshold_ms,
+                                                         &topology->rand_seed);
+}
+
+/*
+ *-------------------------------------------------------------------------
+ *
+ * _mongoc_topology_description_select_with_seed --
+ *
+ *      Like mongoc_topology_description_select, but takes the random seed
+ *      from the caller instead of @topology, so that threads can select
+ *      from a shared, read-only topology description at the same time.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+mongoc_server_description_t *
+_mongoc_topology_description_select_with_seed (
+   mongoc_topology_description_t *topology,
+   mongoc_ss_optype_t optype,
+   const mongoc_read_prefs_t *read_pref,
+   int64_t local_threshold_ms,
+   unsigned int *rand_seed)
 {
    mongoc_array_t suitable_servers;
    mongoc_server_description_t *sd = NULL;
-   int rand_n;
 
    ENTRY;
 
@@ -814,12 +844,8 @@ mongoc_topology_description_select (mongoc_topology_description_t *topology,
 
    mongoc_topology_description_suitable_servers (
       &suitable_servers, optype, topology, read_pref, local_threshold_ms);
-   if (suitable_servers.len != 0) {
-      rand_n = _mongoc_rand_simple (&topology->rand_seed);
-      sd = _mongoc_array_index (&suitable_servers,
-                                mongoc_server_description_t *,
-                                rand_n % suitable_servers.len);
-   }
+   sd = _mongoc_topology_description_pick_server (
+      topology, &suitable_servers, rand_seed);
 
    _mongoc_array_destroy (&suitable_servers);
 
@@ -833,6 +859,80 @@ mongoc_topology_description_select (mongoc_topology_description_t *topology,
    RETURN (sd);
 }
 
+/* true if @a looks less busy than @b */
+static bool
+_less_loaded (const mongoc_server_description_t *a,
+              const mongoc_server_description_t *b)
+{
+   int32_t a_in_flight;
+   int32_t b_in_flight;
+   int64_t a_latency;
+   int64_t b_latency;
+
+   a_in_flight = mongoc_server_description_in_flight_count (a);
+   b_in_flight = mongoc_server_description_in_flight_count (b);
+   if (a_in_flight != b_in_flight) {
+      return a_in_flight < b_in_flight;
+   }
+
+   /* a server we haven't timed yet is worth trying */
+   a_latency = BSON_MAX (mongoc_server_description_command_latency_usec (a), 0);
+   b_latency = BSON_MAX (mongoc_server_description_command_latency_usec (b), 0);
+
+   return a_latency < b_latency;
+}
+
+/*
+ *-------------------------------------------------------------------------
+ *
+ * _mongoc_topology_description_pick_server --
+ *
+ *      Choose one of @suitable_servers, an array of server descriptions
+ *      within the latency window, according to the topology's selection
+ *      mode. Uniformly at random by default; with "powerOfTwoChoices",
+ *      the less loaded of two distinct servers chosen at random.
+ *
+ * Returns:
+ *      A server description from @suitable_servers, or NULL if it is
+ *      empty.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+mongoc_server_description_t *
+_mongoc_topology_description_pick_server (
+   const mongoc_topology_description_t *description,
+   const mongoc_array_t *suitable_servers,
+   unsigned int *rand_seed)
+{
+   mongoc_server_description_t *a;
+   mongoc_server_description_t *b;
+   size_t i;
+   size_t j;
+
+   if (suitable_servers->len == 0) {
+      return NULL;
+   }
+
+   i = (size_t) _mongoc_rand_simple (rand_seed) % suitable_servers->len;
+   a = _mongoc_array_index (suitable_servers, mongoc_server_description_t *, i);
+
+   if (description->selection_mode != MONGOC_SERVER_SELECTION_POWER_OF_TWO ||
+       suitable_servers->len == 1) {
+      return a;
+   }
+
+   /* a second choice distinct from the first */
+   j = (size_t) _mongoc_rand_simple (rand_seed) % (suitable_servers->len - 1);
+   if (j >= i) {
+      j++;
+   }
+
+   b = _mongoc_array_index (suitable_servers, mongoc_server_description_t *, j);
+
+   return _less_loaded (b, a) ? b : a;
+}
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -1167,6 +1267,8 @@ mongoc_topology_description_add_server (mongoc_topology_description_t *topology,
       description =
          (mongoc_server_description_t *) bson_malloc0 (sizeof *description);
       mongoc_server_description_init (description, server, server_id);
+      description->load =
+         _mongoc_server_load_new (description->host.host_and_port);
 
       mongoc_set_add (topology->servers, server_id, description);
 
@@ -1243,6 +1345,9 @@ mongoc_topology_description_update_cluster_time (
        _mongoc_cluster_time_greater (&cluster_time, &td->cluster_time)) {
       bson_destroy (&td->cluster_time);
       bson_copy_to (&cluster_time, &td->cluster_time);
+      bson_destroy (&td->cluster_time_fragment);
+      _mongoc_cluster_time_fragment_init (&td->cluster_time_fragment,
+                                          &td->cluster_time);
    }
 }
 
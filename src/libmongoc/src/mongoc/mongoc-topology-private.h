@@ -21,6 +21,8 @@
 
 #include "mongoc/mongoc-topology-scanner-private.h"
 #include "mongoc/mongoc-server-description-private.h"
+#include "mongoc/mongoc-server-monitor-private.h"
+#include "mongoc/mongoc-set-private.h"
 #include "mongoc/mongoc-topology-description-private.h"
 #include "mongoc/mongoc-thread-private.h"
 #include "mongoc/mongoc-uri.h"
@@ -33,6 +35,7 @@
 #define MONGOC_TOPOLOGY_SERVER_SELECTION_TIMEOUT_MS 30000
 #define MONGOC_TOPOLOGY_HEARTBEAT_FREQUENCY_MS_MULTI_THREADED 10000
 #define MONGOC_TOPOLOGY_HEARTBEAT_FREQUENCY_MS_SINGLE_THREADED 60000
+#define MONGOC_TOPOLOGY_SESSION_REAP_INTERVAL_MS 60000
 
 typedef enum {
    MONGOC_TOPOLOGY_SCANNER_OFF,
@@ -41,6 +44,35 @@ typedef enum {
    MONGOC_TOPOLOGY_SCANNER_SINGLE_THREADED,
 } mongoc_topology_scanner_state_t;
 
+#define MONGOC_TOPOLOGY_SELECTION_CACHE_SIZE 16
+
+/* the servers suitable for an optype and read preference */
+typedef struct _mongoc_topology_cached_selection_t {
+   mongoc_ss_optype_t optype;
+   mongoc_read_mode_t mode;
+   bson_t tags;
+   int64_t max_staleness_seconds;
+   int64_t local_threshold_ms;
+   /* mongoc_server_description_t pointers into the snapshot */
+   mongoc_array_t servers;
+} mongoc_topology_cached_selection_t;
+
+/* an immutable copy of a topology description, shared by reference count */
+typedef struct _mongoc_topology_snapshot_t {
+   mongoc_topology_description_t description;
+   /* whether the scanner has nodes, and its error if not, so selection
+    * needn't lock the topology to check */
+   bool scanner_valid;
+   bson_error_t scanner_error;
+   volatile int32_t ref_count;
+   /* entries below cache_len are complete and never change. cache_mutex
+    * serializes adding entries, readers don't take it */
+   mongoc_topology_cached_selection_t
+      cache[MONGOC_TOPOLOGY_SELECTION_CACHE_SIZE];
+   volatile int32_t cache_len;
+   bson_mutex_t cache_mutex;
+} mongoc_topology_snapshot_t;
+
 typedef struct _mongoc_topology_t {
    mongoc_topology_description_t description;
    mongoc_uri_t *uri;
@@ -61,11 +93,36 @@ typedef struct _mongoc_topology_t {
 
    mongoc_topology_scanner_state_t scanner_state;
    bool scan_requested;
+   /* pooled mode: ids of servers to check at once, outside the heartbeat
+    * schedule, after an error suggests the primary changed */
+   mongoc_array_t probe_ids;
    bool shutdown_requested;
    bool single_threaded;
    bool stale;
 
+   /* pooled mode: a mongoc_server_monitor_t per server that supports
+    * awaitable ismaster, by server id. monitors of removed servers move to
+    * retired_monitors until the background thread joins them. */
+   bool stream_monitoring;
+   mongoc_set_t *server_monitors;
+   mongoc_array_t retired_monitors;
+
+   /* server sessions, most recently used first. session_pool_mutex guards
+    * the list, last_session_reap, and in pooled mode the description's
+    * session timeout and whether it has a data-bearing server, copied each
+    * time a snapshot is published. never nest "mutex" inside it. */
    mongoc_server_session_t *session_pool;
+   bson_mutex_t session_pool_mutex;
+   int64_t last_session_reap;
+   int64_t session_timeout_minutes;
+   bool session_has_data_node;
+
+   /* pooled mode: latest copy of "description", replaced under "mutex"
+    * whenever the description changes. snapshot_mutex only guards taking a
+    * reference to it, so selection never waits for the scanner. */
+   mongoc_topology_snapshot_t *snapshot;
+   bson_mutex_t snapshot_mutex;
+   volatile int32_t snapshot_rand_seed;
 } mongoc_topology_t;
 
 mongoc_topology_t *
@@ -152,6 +209,9 @@ _mongoc_topology_end_sessions_cmd (mongoc_topology_t *topology, bson_t *cmd);
 void
 _mongoc_topology_clear_session_pool (mongoc_topology_t *topology);
 
+void
+_mongoc_topology_reap_server_sessions (mongoc_topology_t *topology);
+
 void
 _mongoc_topology_do_blocking_scan (mongoc_topology_t *topology,
                                    bson_error_t *error);
@@ -159,4 +219,29 @@ const bson_t *
 _mongoc_topology_get_ismaster (mongoc_topology_t *topology);
 void
 _mongoc_topology_request_scan (mongoc_topology_t *topology);
+
+void
+_mongoc_topology_request_probe (mongoc_topology_t *topology, uint32_t id);
+
+void
+_mongoc_topology_update_from_monitor (mongoc_topology_t *topology,
+                                      mongoc_server_monitor_t *monitor,
+                                      const bson_t *ismaster_response,
+                                      int64_t rtt_msec);
+
+void
+_mongoc_topology_publish_snapshot (mongoc_topology_t *topology);
+
+mongoc_topology_snapshot_t *
+_mongoc_topology_snapshot_acquire (mongoc_topology_t *topology);
+
+void
+_mongoc_topology_snapshot_release (mongoc_topology_snapshot_t *snapshot);
+
+mongoc_server_description_t *
+_mongoc_topology_snapshot_select (mongoc_topology_snapshot_t *snapshot,
+                                  mongoc_ss_optype_t optype,
+                                  const mongoc_read_prefs_t *read_prefs,
+                                  int64_t local_threshold_ms,
+                                  unsigned int *rand_seed);
 #endif
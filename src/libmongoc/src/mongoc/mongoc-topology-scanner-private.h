@@ -25,6 +25,7 @@
 #include "mongoc/mongoc-async-private.h"
 #include "mongoc/mongoc-async-cmd-private.h"
 #include "mongoc/mongoc-handshake-private.h"
+#include "mongoc/mongoc-scram-private.h"
 #include "mongoc/mongoc-host-list.h"
 #include "mongoc/mongoc-apm-private.h"
 
@@ -34,6 +35,12 @@
 
 BSON_BEGIN_DECLS
 
+/* how long resolved addresses are reused, and how long to wait for one
+ * connection attempt before racing the next address. application connections
+ * use the same values, see mongoc_client_connect_tcp. */
+#define MONGOC_DNS_CACHE_TIMEOUT_MS (10 * 60 * 1000)
+#define MONGOC_HAPPY_EYEBALLS_DELAY_MS 250
+
 typedef void (*mongoc_topology_scanner_setup_err_cb_t) (
    uint32_t id, void *data, const bson_error_t *error /* IN */);
 
@@ -65,6 +72,10 @@ typedef struct mongoc_topology_scanner_node {
    bool retired;
    bson_error_t last_error;
 
+   /* when an error last made the background thread probe this node. used
+    * to probe each node at most once per minHeartbeatFrequencyMS */
+   int64_t last_probe;
+
    /* the hostname for a node may resolve to multiple DNS results.
     * dns_results has the full list of DNS results, ordered by host preference.
     * successful_dns_result is the most recent successful DNS result.
@@ -77,6 +88,13 @@ typedef struct mongoc_topology_scanner_node {
     * node. */
    mongoc_handshake_sasl_supported_mechs_t sasl_supported_mechs;
    bool negotiated_sasl_supported_mechs;
+
+   /* used by single-threaded clients to begin authenticating in the
+    * handshake of a new connection: the speculativeAuthenticate field sent
+    * in the ismaster, the conversation it began, and the server's reply. */
+   bson_t speculative_auth_cmd;
+   mongoc_scram_t scram;
+   bson_t speculative_auth_response;
 } mongoc_topology_scanner_node_t;
 
 typedef struct mongoc_topology_scanner {
@@ -107,6 +125,8 @@ typedef struct mongoc_topology_scanner {
    int64_t dns_cache_timeout_ms;
    /* only used by single-threaded clients to negotiate auth mechanisms. */
    bool negotiate_sasl_supported_mechs;
+   /* only used by single-threaded clients to authenticate speculatively. */
+   bool speculative_authentication;
 } mongoc_topology_scanner_t;
 
 mongoc_topology_scanner_t *
@@ -179,6 +199,22 @@ mongoc_topology_scanner_get_node (mongoc_topology_scanner_t *ts, uint32_t id);
 const bson_t *
 _mongoc_topology_scanner_get_ismaster (mongoc_topology_scanner_t *ts);
 
+const char *
+_mongoc_topology_scanner_get_speculative_auth_mechanism (
+   const mongoc_uri_t *uri);
+
+bool
+_mongoc_topology_scanner_add_speculative_authentication (
+   bson_t *cmd, const mongoc_uri_t *uri, mongoc_scram_t *scram);
+
+void
+_mongoc_topology_scanner_parse_speculative_authentication (
+   const bson_t *ismaster, bson_t *speculative_authenticate);
+
+void
+_mongoc_topology_scanner_node_reset_speculative_auth (
+   mongoc_topology_scanner_node_t *node);
+
 bool
 mongoc_topology_scanner_has_node_for_host (mongoc_topology_scanner_t *ts,
                                            mongoc_host_list_t *host);
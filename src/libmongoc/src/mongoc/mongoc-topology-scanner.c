@@ -35,13 +35,11 @@
 #include "mongoc/mongoc-topology-private.h"
 #include "mongoc/mongoc-host-list-private.h"
 #include "mongoc/mongoc-uri-private.h"
+#include "mongoc/mongoc-cluster-private.h"
 
 #undef MONGOC_LOG_DOMAIN
 #define MONGOC_LOG_DOMAIN "topology_scanner"
 
-#define DNS_CACHE_TIMEOUT_MS 10 * 60 * 1000
-#define HAPPY_EYEBALLS_DELAY_MS 250
-
 /* forward declarations */
 static void
 _async_connected (mongoc_async_cmd_t *acmd);
@@ -167,6 +165,141 @@ _mongoc_topology_scanner_get_ismaster (mongoc_topology_scanner_t *ts)
    return &ts->ismaster_cmd_with_handshake;
 }
 
+/* Returns the mechanism to begin authenticating with in the handshake of a
+ * new connection, or NULL. If the URI has no mechanism the driver would
+ * negotiate one, and it speculates that the server supports SCRAM-SHA-256.
+ * If not, the server omits speculativeAuthenticate from its reply and the
+ * driver authenticates with the negotiated mechanism as before. */
+const char *
+_mongoc_topology_scanner_get_speculative_auth_mechanism (
+   const mongoc_uri_t *uri)
+{
+   const char *mechanism = mongoc_uri_get_auth_mechanism (uri);
+
+   if (!mechanism) {
+      if (!mongoc_uri_get_username (uri)) {
+         return NULL;
+      }
+
+      mechanism = "SCRAM-SHA-256";
+   }
+
+#ifdef MONGOC_ENABLE_CRYPTO
+   if (!strcasecmp (mechanism, "SCRAM-SHA-1") ||
+       !strcasecmp (mechanism, "SCRAM-SHA-256")) {
+      return mechanism;
+   }
+#endif
+
+   return NULL;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_topology_scanner_add_speculative_authentication --
+ *
+ *       Begin a SCRAM conversation in @scram and add its saslStart command
+ *       to the ismaster @cmd as "speculativeAuthenticate". The server's
+ *       reply to it saves the saslStart round trip when the connection
+ *       is authenticated.
+ *
+ * Returns:
+ *       true if the field was added. Otherwise @scram is zeroed, and the
+ *       connection is authenticated from the start, which reports any
+ *       error.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_topology_scanner_add_speculative_authentication (
+   bson_t *cmd, const mongoc_uri_t *uri, mongoc_scram_t *scram)
+{
+#ifdef MONGOC_ENABLE_CRYPTO
+   const char *mechanism;
+   const char *auth_source;
+   mongoc_crypto_hash_algorithm_t algo;
+   bson_t auth_cmd;
+   bson_error_t error;
+   bool ret;
+
+   mechanism = _mongoc_topology_scanner_get_speculative_auth_mechanism (uri);
+   if (!mechanism) {
+      return false;
+   }
+
+   algo = strcasecmp (mechanism, "SCRAM-SHA-1")
+             ? MONGOC_CRYPTO_ALGORITHM_SHA_256
+             : MONGOC_CRYPTO_ALGORITHM_SHA_1;
+
+   _mongoc_cluster_init_scram (uri, scram, algo);
+   ret = _mongoc_cluster_get_auth_cmd_scram (algo, scram, &auth_cmd, &error);
+   if (ret) {
+      if (!(auth_source = mongoc_uri_get_auth_source (uri)) ||
+          (*auth_source == '\0')) {
+         auth_source = "admin";
+      }
+
+      BSON_APPEND_UTF8 (&auth_cmd, "db", auth_source);
+      BSON_APPEND_DOCUMENT (cmd, "speculativeAuthenticate", &auth_cmd);
+   } else {
+      _mongoc_scram_destroy (scram);
+      memset (scram, 0, sizeof *scram);
+   }
+
+   bson_destroy (&auth_cmd);
+
+   return ret;
+#else
+   return false;
+#endif
+}
+
+
+/* Copy the speculativeAuthenticate field of an ismaster reply, if any, to
+ * @speculative_authenticate, which must be initialized. */
+void
+_mongoc_topology_scanner_parse_speculative_authentication (
+   const bson_t *ismaster, bson_t *speculative_authenticate)
+{
+   bson_iter_t iter;
+   uint32_t data_len;
+   const uint8_t *data;
+   bson_t auth_response;
+
+   BSON_ASSERT (ismaster);
+   BSON_ASSERT (speculative_authenticate);
+
+   if (!bson_iter_init_find (&iter, ismaster, "speculativeAuthenticate") ||
+       !BSON_ITER_HOLDS_DOCUMENT (&iter)) {
+      return;
+   }
+
+   bson_iter_document (&iter, &data_len, &data);
+   BSON_ASSERT (bson_init_static (&auth_response, data, data_len));
+
+   bson_destroy (speculative_authenticate);
+   bson_copy_to (&auth_response, speculative_authenticate);
+}
+
+
+/* Forget the conversation begun in the node's last handshake, once the
+ * connection is authenticated or closed. */
+void
+_mongoc_topology_scanner_node_reset_speculative_auth (
+   mongoc_topology_scanner_node_t *node)
+{
+   bson_reinit (&node->speculative_auth_cmd);
+   bson_reinit (&node->speculative_auth_response);
+#ifdef MONGOC_ENABLE_CRYPTO
+   _mongoc_scram_destroy (&node->scram);
+#endif
+   memset (&node->scram, 0, sizeof node->scram);
+}
+
+
 static void
 _begin_ismaster_cmd (mongoc_topology_scanner_node_t *node,
                      mongoc_stream_t *stream,
@@ -189,6 +322,12 @@ _begin_ismaster_cmd (mongoc_topology_scanner_node_t *node,
       _mongoc_handshake_append_sasl_supported_mechs (ts->uri, &cmd);
    }
 
+   if (!is_setup_done) {
+      /* a new connection. with happy eyeballs the node may begin several,
+       * they share one conversation and the first to reply keeps it. */
+      bson_concat (&cmd, &node->speculative_auth_cmd);
+   }
+
    if (!bson_empty (&ts->cluster_time)) {
       bson_append_document (&cmd, "$clusterTime", 12, &ts->cluster_time);
    }
@@ -240,7 +379,7 @@ mongoc_topology_scanner_new (
    ts->handshake_ok_to_send = false;
    ts->connect_timeout_msec = connect_timeout_msec;
    /* may be overridden for testing. */
-   ts->dns_cache_timeout_ms = DNS_CACHE_TIMEOUT_MS;
+   ts->dns_cache_timeout_ms = MONGOC_DNS_CACHE_TIMEOUT_MS;
 
    return ts;
 }
@@ -309,6 +448,8 @@ mongoc_topology_scanner_add (mongoc_topology_scanner_t *ts,
    node->ts = ts;
    node->last_failed = -1;
    node->last_used = -1;
+   bson_init (&node->speculative_auth_cmd);
+   bson_init (&node->speculative_auth_response);
 
    DL_APPEND (ts->nodes, node);
 }
@@ -386,6 +527,7 @@ mongoc_topology_scanner_node_disconnect (mongoc_topology_scanner_node_t *node,
       memset (
          &node->sasl_supported_mechs, 0, sizeof (node->sasl_supported_mechs));
       node->negotiated_sasl_supported_mechs = false;
+      _mongoc_topology_scanner_node_reset_speculative_auth (node);
    }
 }
 
@@ -398,6 +540,9 @@ mongoc_topology_scanner_node_destroy (mongoc_topology_scanner_node_t *node,
    if (node->dns_results) {
       freeaddrinfo (node->dns_results);
    }
+   _mongoc_topology_scanner_node_reset_speculative_auth (node);
+   bson_destroy (&node->speculative_auth_cmd);
+   bson_destroy (&node->speculative_auth_response);
    bson_free (node);
 }
 
@@ -462,6 +607,7 @@ _async_connected (mongoc_async_cmd_t *acmd)
    /* this cmd connected successfully, cancel other cmds on this node. */
    _cancel_commands_excluding (node, acmd);
    node->successful_dns_result = acmd->dns_result;
+   _mongoc_counters_record_connection (node->host.host_and_port);
 }
 
 static void
@@ -498,6 +644,11 @@ _async_success (mongoc_async_cmd_t *acmd,
          ismaster_response, &node->sasl_supported_mechs);
    }
 
+   if (ts->speculative_authentication) {
+      _mongoc_topology_scanner_parse_speculative_authentication (
+         ismaster_response, &node->speculative_auth_response);
+   }
+
    /* mongoc_topology_scanner_cb_t takes rtt_msec, not usec */
    ts->cb (node->id,
            ismaster_response,
@@ -721,7 +872,7 @@ mongoc_topology_scanner_node_setup_tcp (mongoc_topology_scanner_node_t *node,
       {
          _begin_ismaster_cmd (node, NULL, false, iter, delay);
          /* each subsequent DNS result will have an additional 250ms delay. */
-         delay += HAPPY_EYEBALLS_DELAY_MS;
+         delay += MONGOC_HAPPY_EYEBALLS_DELAY_MS;
       }
    }
 
@@ -782,6 +933,7 @@ mongoc_topology_scanner_node_connect_unix (mongoc_topology_scanner_node_t *node,
    stream = _mongoc_topology_scanner_node_setup_stream_for_tls (
       node, mongoc_stream_socket_new (sock));
    if (stream) {
+      _mongoc_counters_record_connection (node->host.host_and_port);
       _begin_ismaster_cmd (node,
                            stream,
                            false /* is_setup_done */,
@@ -828,11 +980,19 @@ mongoc_topology_scanner_node_setup (mongoc_topology_scanner_node_t *node,
 
    BSON_ASSERT (!node->retired);
 
+   /* a new connection begins a new conversation */
+   _mongoc_topology_scanner_node_reset_speculative_auth (node);
+   if (node->ts->speculative_authentication) {
+      _mongoc_topology_scanner_add_speculative_authentication (
+         &node->speculative_auth_cmd, node->ts->uri, &node->scram);
+   }
+
    if (node->ts->initiator) {
       stream = node->ts->initiator (
          node->ts->uri, &node->host, node->ts->initiator_context, error);
       if (stream) {
          success = true;
+         _mongoc_counters_record_connection (node->host.host_and_port);
          _begin_ismaster_cmd (node, stream, false, NULL, 0);
       }
    } else {
@@ -1188,8 +1348,8 @@ _jumpstart_other_acmds (mongoc_topology_scanner_node_t *node,
    {
       if ((mongoc_topology_scanner_node_t *) iter->data == node &&
           iter != acmd && acmd->initiate_delay_ms < iter->initiate_delay_ms) {
-         iter->initiate_delay_ms =
-            BSON_MAX (iter->initiate_delay_ms - HAPPY_EYEBALLS_DELAY_MS, 0);
+         iter->initiate_delay_ms = BSON_MAX (
+            iter->initiate_delay_ms - MONGOC_HAPPY_EYEBALLS_DELAY_MS, 0);
       }
    }
 }
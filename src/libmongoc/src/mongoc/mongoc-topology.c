@@ -24,6 +24,7 @@
 #include "mongoc/mongoc-topology-private.h"
 #include "mongoc/mongoc-topology-description-apm-private.h"
 #include "mongoc/mongoc-client-private.h"
+#include "mongoc/mongoc-counters-private.h"
 #include "mongoc/mongoc-uri-private.h"
 #include "mongoc/mongoc-util-private.h"
 #include "mongoc/mongoc-trace-private.h"
@@ -56,6 +57,8 @@ mongoc_topology_reconcile (mongoc_topology_t *topology)
    mongoc_topology_description_t *description;
    mongoc_set_t *servers;
    mongoc_server_description_t *sd;
+   mongoc_server_monitor_t *monitor;
+   uint32_t id;
    int i;
    mongoc_topology_scanner_node_t *ele, *tmp;
 
@@ -76,6 +79,18 @@ mongoc_topology_reconcile (mongoc_topology_t *topology)
          mongoc_topology_scanner_node_retire (ele);
       }
    }
+
+   /* Stop monitors of removed nodes, the background thread joins them */
+   for (i = (int) topology->server_monitors->items_len - 1; i >= 0; i--) {
+      monitor = (mongoc_server_monitor_t *) mongoc_set_get_item_and_id (
+         topology->server_monitors, i, &id);
+
+      if (!mongoc_topology_description_server_by_id (description, id, NULL)) {
+         _mongoc_server_monitor_request_shutdown (monitor);
+         _mongoc_array_append_val (&topology->retired_monitors, monitor);
+         mongoc_set_rm (topology->server_monitors, id);
+      }
+   }
 }
 
 
@@ -96,6 +111,69 @@ _mongoc_topology_update_no_lock (uint32_t id,
 }
 
 
+/*
+ *-------------------------------------------------------------------------
+ *
+ * _mongoc_topology_start_monitor --
+ *
+ *       In pooled mode, if server @id replied to ismaster with a
+ *       topologyVersion, it supports awaitable ismaster: start a monitor
+ *       that streams its state changes, unless it has one already. A
+ *       monitor that stopped because the server didn't support streaming
+ *       is replaced.
+ *
+ *       NOTE: the caller must hold @topology's mutex.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+static void
+_mongoc_topology_start_monitor (mongoc_topology_t *topology,
+                                uint32_t id,
+                                const bson_t *ismaster_response)
+{
+   mongoc_server_description_t *sd;
+   mongoc_server_monitor_t *monitor;
+   bson_iter_t iter;
+
+   if (!topology->stream_monitoring || !ismaster_response ||
+       topology->scanner_state != MONGOC_TOPOLOGY_SCANNER_BG_RUNNING ||
+       topology->shutdown_requested) {
+      return;
+   }
+
+   if (!bson_iter_init_find (&iter, ismaster_response, "topologyVersion") ||
+       !BSON_ITER_HOLDS_DOCUMENT (&iter)) {
+      return;
+   }
+
+   sd = mongoc_topology_description_server_by_id (
+      &topology->description, id, NULL);
+
+   if (!sd) {
+      return;
+   }
+
+   monitor = (mongoc_server_monitor_t *) mongoc_set_get (
+      topology->server_monitors, id);
+
+   if (monitor) {
+      if (!_mongoc_server_monitor_stopped (monitor)) {
+         return;
+      }
+
+      /* it stopped when the server replied without a topologyVersion, now
+       * the server has one again. the background thread joins the old one */
+      _mongoc_array_append_val (&topology->retired_monitors, monitor);
+      mongoc_set_rm (topology->server_monitors, id);
+   }
+
+   mongoc_set_add (topology->server_monitors,
+                   id,
+                   _mongoc_server_monitor_new (topology, id, &sd->host));
+}
+
+
 /*
  *-------------------------------------------------------------------------
  *
@@ -104,6 +182,8 @@ _mongoc_topology_update_no_lock (uint32_t id,
  *       Callback method to handle errors during topology scanner node
  *       setup, typically DNS or SSL errors.
  *
+ *       NOTE: this method expects @topology's mutex to be locked on entry.
+ *
  *-------------------------------------------------------------------------
  */
 
@@ -123,6 +203,9 @@ _mongoc_topology_scanner_setup_err_cb (uint32_t id,
                                                 NULL /* ismaster reply */,
                                                 -1 /* rtt_msec */,
                                                 error);
+
+   /* don't let selection keep choosing the server from an old snapshot */
+   _mongoc_topology_publish_snapshot (topology);
 }
 
 
@@ -176,8 +259,60 @@ _mongoc_topology_scanner_cb (uint32_t id,
        * agents
        */
       mongoc_topology_reconcile (topology);
+      _mongoc_topology_start_monitor (topology, id, ismaster_response);
+
+      mongoc_cond_broadcast (&topology->cond_client);
+   }
+
+   _mongoc_topology_publish_snapshot (topology);
+   bson_mutex_unlock (&topology->mutex);
+}
+
+
+/*
+ *-------------------------------------------------------------------------
+ *
+ * _mongoc_topology_update_from_monitor --
+ *
+ *       Apply an ismaster reply streamed by @monitor. @rtt_msec is -1 if
+ *       the reply was awaited, then the server's round trip time is kept.
+ *
+ *       NOTE: This method locks the given topology's mutex.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+void
+_mongoc_topology_update_from_monitor (mongoc_topology_t *topology,
+                                      mongoc_server_monitor_t *monitor,
+                                      const bson_t *ismaster_response,
+                                      int64_t rtt_msec)
+{
+   mongoc_server_description_t *sd;
+
+   bson_mutex_lock (&topology->mutex);
+
+   /* the server may have been removed while the monitor waited */
+   if (topology->shutdown_requested ||
+       _mongoc_server_monitor_shutdown_requested (monitor)) {
+      bson_mutex_unlock (&topology->mutex);
+      return;
+   }
+
+   sd = mongoc_topology_description_server_by_id (
+      &topology->description, monitor->server_id, NULL);
+
+   if (sd) {
+      if (rtt_msec < 0) {
+         rtt_msec = sd->round_trip_time_msec;
+      }
+
+      _mongoc_topology_update_no_lock (
+         monitor->server_id, ismaster_response, rtt_msec, topology, NULL);
 
+      mongoc_topology_reconcile (topology);
       mongoc_cond_broadcast (&topology->cond_client);
+      _mongoc_topology_publish_snapshot (topology);
    }
 
    bson_mutex_unlock (&topology->mutex);
@@ -208,6 +343,8 @@ mongoc_topology_new (const mongoc_uri_t *uri, bool single_threaded)
    mongoc_topology_description_type_t init_type;
    const char *service;
    char *prefixed_service;
+   const char *selection_mode;
+   const char *monitoring_mode;
    uint32_t id;
    const mongoc_host_list_t *hl;
 
@@ -258,6 +395,18 @@ mongoc_topology_new (const mongoc_uri_t *uri, bool single_threaded)
    topology->local_threshold_msec =
       mongoc_uri_get_local_threshold_option (topology->uri);
 
+   selection_mode = mongoc_uri_get_option_as_utf8 (
+      topology->uri, MONGOC_URI_SERVERSELECTIONMODE, "random");
+   if (!bson_strcasecmp (selection_mode, "powerOfTwoChoices")) {
+      topology->description.selection_mode =
+         MONGOC_SERVER_SELECTION_POWER_OF_TWO;
+   }
+
+   monitoring_mode = mongoc_uri_get_option_as_utf8 (
+      topology->uri, MONGOC_URI_SERVERMONITORINGMODE, "stream");
+   topology->stream_monitoring =
+      !single_threaded && bson_strcasecmp (monitoring_mode, "poll") != 0;
+
    /* Total time allowed to check a server is connectTimeoutMS.
     * Server Discovery And Monitoring Spec:
     *
@@ -279,8 +428,17 @@ mongoc_topology_new (const mongoc_uri_t *uri, bool single_threaded)
                                    topology->connect_timeout_msec);
 
    bson_mutex_init (&topology->mutex);
+   bson_mutex_init (&topology->snapshot_mutex);
+   bson_mutex_init (&topology->session_pool_mutex);
+   topology->last_session_reap = bson_get_monotonic_time ();
+   topology->session_timeout_minutes = MONGOC_NO_SESSIONS;
+   topology->snapshot_rand_seed = (int32_t) bson_get_monotonic_time ();
    mongoc_cond_init (&topology->cond_client);
    mongoc_cond_init (&topology->cond_server);
+   _mongoc_array_init (&topology->probe_ids, sizeof (uint32_t));
+   topology->server_monitors = mongoc_set_new (8, NULL, NULL);
+   _mongoc_array_init (&topology->retired_monitors,
+                       sizeof (mongoc_server_monitor_t *));
 
    if (single_threaded) {
       /* single threaded clients negotiate sasl supported mechanisms during
@@ -288,6 +446,11 @@ mongoc_topology_new (const mongoc_uri_t *uri, bool single_threaded)
       if (_mongoc_uri_requires_auth_negotiation (uri)) {
          topology->scanner->negotiate_sasl_supported_mechs = true;
       }
+
+      /* and begin authenticating in the handshake of each new connection */
+      if (_mongoc_topology_scanner_get_speculative_auth_mechanism (uri)) {
+         topology->scanner->speculative_authentication = true;
+      }
    }
 
    topology_valid = true;
@@ -408,9 +571,19 @@ mongoc_topology_destroy (mongoc_topology_t *topology)
    /* free sessions if we failed to run _mongoc_topology_end_sessions */
    _mongoc_topology_clear_session_pool (topology);
 
+   if (topology->snapshot) {
+      _mongoc_topology_snapshot_release (topology->snapshot);
+   }
+
+   _mongoc_array_destroy (&topology->probe_ids);
+   /* _mongoc_topology_background_thread_stop destroyed the monitors */
+   mongoc_set_destroy (topology->server_monitors);
+   _mongoc_array_destroy (&topology->retired_monitors);
    mongoc_cond_destroy (&topology->cond_client);
    mongoc_cond_destroy (&topology->cond_server);
    bson_mutex_destroy (&topology->mutex);
+   bson_mutex_destroy (&topology->snapshot_mutex);
+   bson_mutex_destroy (&topology->session_pool_mutex);
 
    bson_free (topology);
 }
@@ -435,10 +608,14 @@ void
 _mongoc_topology_clear_session_pool (mongoc_topology_t *topology) {
    mongoc_server_session_t *ss, *tmp1, *tmp2;
 
+   bson_mutex_lock (&topology->session_pool_mutex);
    CDL_FOREACH_SAFE (topology->session_pool, ss, tmp1, tmp2)
    {
       _mongoc_server_session_destroy (ss);
    }
+
+   topology->session_pool = NULL;
+   bson_mutex_unlock (&topology->session_pool_mutex);
 }
 
 
@@ -623,31 +800,36 @@ mongoc_topology_select (mongoc_topology_t *topology,
    }
 }
 
-/*
- *-------------------------------------------------------------------------
- *
- * mongoc_topology_select_server_id --
- *
- *       Alternative to mongoc_topology_select when you only need the id.
- *
- * Returns:
- *       A server id, or 0 on failure, in which case @error will be set.
- *
- *-------------------------------------------------------------------------
- */
-uint32_t
-mongoc_topology_select_server_id (mongoc_topology_t *topology,
-                                  mongoc_ss_optype_t optype,
-                                  const mongoc_read_prefs_t *read_prefs,
-                                  bson_error_t *error)
+
+/* set @error from the error that left the scanner without nodes */
+static void
+_mongoc_topology_scanner_invalid_error (const bson_error_t *scanner_error,
+                                        bson_error_t *error)
+{
+   if (error) {
+      memcpy (error, scanner_error, sizeof *error);
+      error->domain = MONGOC_ERROR_SERVER_SELECTION;
+      error->code = MONGOC_ERROR_SERVER_SELECTION_FAILURE;
+   }
+}
+
+
+/* mongoc_topology_select_server_id, without recording its latency */
+static uint32_t
+_mongoc_topology_select_server_id (mongoc_topology_t *topology,
+                                   mongoc_ss_optype_t optype,
+                                   const mongoc_read_prefs_t *read_prefs,
+                                   bson_error_t *error)
 {
    static const char *timeout_msg =
       "No suitable servers found: `serverSelectionTimeoutMS` expired";
 
    mongoc_topology_scanner_t *ts;
+   mongoc_topology_snapshot_t *snapshot;
    int r;
    int64_t local_threshold_ms;
    mongoc_server_description_t *selected_server = NULL;
+   unsigned int rand_seed;
    bool try_once;
    int64_t sleep_usec;
    bool tried_once;
@@ -665,19 +847,30 @@ mongoc_topology_select_server_id (mongoc_topology_t *topology,
    BSON_ASSERT (topology);
    ts = topology->scanner;
 
-   bson_mutex_lock (&topology->mutex);
-   /* It isn't strictly necessary to lock here, because if the topology
-    * is invalid, it will never become valid. Lock anyway for consistency. */
-   if (!mongoc_topology_scanner_valid (ts)) {
-      if (error) {
-         mongoc_topology_scanner_get_error (ts, error);
-         error->domain = MONGOC_ERROR_SERVER_SELECTION;
-         error->code = MONGOC_ERROR_SERVER_SELECTION_FAILURE;
+   /* with a background thread, the snapshot says if the scanner is valid */
+   snapshot = topology->single_threaded
+                 ? NULL
+                 : _mongoc_topology_snapshot_acquire (topology);
+
+   if (snapshot && !snapshot->scanner_valid) {
+      _mongoc_topology_scanner_invalid_error (&snapshot->scanner_error, error);
+      _mongoc_topology_snapshot_release (snapshot);
+      return 0;
+   }
+
+   if (!snapshot) {
+      bson_mutex_lock (&topology->mutex);
+      /* It isn't strictly necessary to lock here, because if the topology
+       * is invalid, it will never become valid. Lock anyway for
+       * consistency. */
+      if (!mongoc_topology_scanner_valid (ts)) {
+         mongoc_topology_scanner_get_error (ts, &scanner_error);
+         _mongoc_topology_scanner_invalid_error (&scanner_error, error);
+         bson_mutex_unlock (&topology->mutex);
+         return 0;
       }
       bson_mutex_unlock (&topology->mutex);
-      return 0;
    }
-   bson_mutex_unlock (&topology->mutex);
 
    heartbeat_msec = topology->description.heartbeat_msec;
    local_threshold_ms = topology->local_threshold_msec;
@@ -773,6 +966,28 @@ mongoc_topology_select_server_id (mongoc_topology_t *topology,
    }
 
    /* With background thread */
+   /* first try the latest snapshot, without waiting for the scanner */
+   if (snapshot) {
+      rand_seed = (unsigned int) bson_atomic_int_add (
+         &topology->snapshot_rand_seed, 1);
+
+      if (mongoc_topology_compatible (
+             &snapshot->description, read_prefs, NULL)) {
+         selected_server = _mongoc_topology_snapshot_select (snapshot,
+                                                             optype,
+                                                             read_prefs,
+                                                             local_threshold_ms,
+                                                             &rand_seed);
+      }
+
+      server_id = selected_server ? selected_server->id : 0;
+      _mongoc_topology_snapshot_release (snapshot);
+
+      if (server_id) {
+         return server_id;
+      }
+   }
+
    /* we break out when we've found a server or timed out */
    for (;;) {
       bson_mutex_lock (&topology->mutex);
@@ -830,6 +1045,37 @@ mongoc_topology_select_server_id (mongoc_topology_t *topology,
    }
 }
 
+
+/*
+ *-------------------------------------------------------------------------
+ *
+ * mongoc_topology_select_server_id --
+ *
+ *       Alternative to mongoc_topology_select when you only need the id.
+ *
+ * Returns:
+ *       A server id, or 0 on failure, in which case @error will be set.
+ *
+ *-------------------------------------------------------------------------
+ */
+uint32_t
+mongoc_topology_select_server_id (mongoc_topology_t *topology,
+                                  mongoc_ss_optype_t optype,
+                                  const mongoc_read_prefs_t *read_prefs,
+                                  bson_error_t *error)
+{
+   int64_t started;
+   uint32_t server_id;
+
+   started = bson_get_monotonic_time ();
+   server_id =
+      _mongoc_topology_select_server_id (topology, optype, read_prefs, error);
+   mongoc_histogram_server_selection_record (bson_get_monotonic_time () -
+                                             started);
+
+   return server_id;
+}
+
 /*
  *-------------------------------------------------------------------------
  *
@@ -858,8 +1104,20 @@ mongoc_topology_server_by_id (mongoc_topology_t *topology,
                               uint32_t id,
                               bson_error_t *error)
 {
+   mongoc_topology_snapshot_t *snapshot;
    mongoc_server_description_t *sd;
 
+   snapshot = _mongoc_topology_snapshot_acquire (topology);
+   if (snapshot) {
+      sd = mongoc_server_description_new_copy (
+         mongoc_topology_description_server_by_id (
+            &snapshot->description, id, error));
+
+      _mongoc_topology_snapshot_release (snapshot);
+
+      return sd;
+   }
+
    bson_mutex_lock (&topology->mutex);
 
    sd = mongoc_server_description_new_copy (
@@ -936,6 +1194,186 @@ _mongoc_topology_request_scan (mongoc_topology_t *topology)
    mongoc_cond_signal (&topology->cond_server);
 }
 
+static void
+_mongoc_topology_add_probe (mongoc_topology_t *topology, uint32_t id)
+{
+   size_t i;
+
+   for (i = 0; i < topology->probe_ids.len; i++) {
+      if (_mongoc_array_index (&topology->probe_ids, uint32_t, i) == id) {
+         return;
+      }
+   }
+
+   _mongoc_array_append_val (&topology->probe_ids, id);
+}
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_topology_request_probe --
+ *
+ *       Ask the background thread to check server @id, which just failed
+ *       with a network or "not master" error, without waiting for the
+ *       next scan. Each server is probed at most once per
+ *       minHeartbeatFrequencyMS; see _mongoc_topology_probe_wait_msec.
+ *       In a replica set, also check the
+ *       secondaries, since one of them is likely to be the new primary.
+ *       The checks run in parallel and waiting threads are woken as each
+ *       reply arrives, so selection resumes as soon as a primary appears.
+ *
+ *       Other topologies have no failover to discover: just request a
+ *       scan, limited by minHeartbeatFrequencyMS as usual.
+ *
+ *       NOTE: this method uses @topology's mutex.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_topology_request_probe (mongoc_topology_t *topology, uint32_t id)
+{
+   mongoc_server_description_t *sd;
+   size_t i;
+
+   BSON_ASSERT (!topology->single_threaded);
+
+   bson_mutex_lock (&topology->mutex);
+   if (topology->description.type != MONGOC_TOPOLOGY_RS_NO_PRIMARY &&
+       topology->description.type != MONGOC_TOPOLOGY_RS_WITH_PRIMARY) {
+      _mongoc_topology_request_scan (topology);
+      bson_mutex_unlock (&topology->mutex);
+      return;
+   }
+
+   _mongoc_topology_add_probe (topology, id);
+
+   for (i = 0; i < topology->description.servers->items_len; i++) {
+      sd = (mongoc_server_description_t *) mongoc_set_get_item (
+         topology->description.servers, (int) i);
+
+      if (sd->type == MONGOC_SERVER_RS_SECONDARY) {
+         _mongoc_topology_add_probe (topology, sd->id);
+      }
+   }
+
+   mongoc_cond_signal (&topology->cond_server);
+   bson_mutex_unlock (&topology->mutex);
+}
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_topology_probe_wait_msec --
+ *
+ *       How long until a server requested with
+ *       _mongoc_topology_request_probe may be probed. The first probe
+ *       after an error is immediate, but a server is probed at most once
+ *       per minHeartbeatFrequencyMS, so a server that keeps failing
+ *       operations while claiming to be primary can't cause a probe per
+ *       operation.
+ *
+ * Returns:
+ *       0 if a probe is due, the milliseconds until one is due, or -1 if
+ *       no probe was requested.
+ *
+ *       NOTE: this method expects @topology's mutex to be locked on entry.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static int64_t
+_mongoc_topology_probe_wait_msec (mongoc_topology_t *topology, int64_t now)
+{
+   mongoc_topology_scanner_node_t *node;
+   int64_t wait_msec = -1;
+   int64_t node_wait_msec;
+   size_t i;
+
+   for (i = 0; i < topology->probe_ids.len; i++) {
+      node = mongoc_topology_scanner_get_node (
+         topology->scanner,
+         _mongoc_array_index (&topology->probe_ids, uint32_t, i));
+
+      if (!node || !node->last_probe) {
+         return 0;
+      }
+
+      node_wait_msec = topology->min_heartbeat_frequency_msec -
+                       (now - node->last_probe) / 1000;
+
+      if (node_wait_msec <= 0) {
+         return 0;
+      }
+
+      if (wait_msec == -1 || node_wait_msec < wait_msec) {
+         wait_msec = node_wait_msec;
+      }
+   }
+
+   return wait_msec;
+}
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_topology_probe --
+ *
+ *       Check the servers requested with _mongoc_topology_request_probe
+ *       that haven't been probed within minHeartbeatFrequencyMS; the rest
+ *       stay requested until they may be. Unlike a full scan this doesn't
+ *       count as a heartbeat, so it does not move "last_scan".
+ *
+ *       NOTE: this method unlocks and re-locks @topology's mutex.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void
+_mongoc_topology_probe (mongoc_topology_t *topology)
+{
+   mongoc_topology_scanner_node_t *node;
+   mongoc_array_t ids;
+   uint32_t id;
+   int64_t now;
+   size_t i;
+
+   memcpy (&ids, &topology->probe_ids, sizeof ids);
+   _mongoc_array_init (&topology->probe_ids, sizeof (uint32_t));
+
+   mongoc_topology_reconcile (topology);
+   now = bson_get_monotonic_time ();
+   for (i = 0; i < ids.len; i++) {
+      id = _mongoc_array_index (&ids, uint32_t, i);
+      node = mongoc_topology_scanner_get_node (topology->scanner, id);
+
+      /* skip servers removed from the topology since the request */
+      if (!node || node->retired) {
+         continue;
+      }
+
+      if (node->last_probe &&
+          now - node->last_probe <
+             topology->min_heartbeat_frequency_msec * 1000) {
+         _mongoc_array_append_val (&topology->probe_ids, id);
+         continue;
+      }
+
+      node->last_probe = now;
+      mongoc_topology_scanner_node_setup (node, &node->last_error);
+   }
+
+   _mongoc_array_destroy (&ids);
+
+   /* scanning locks and unlocks the mutex itself until the scan is done */
+   bson_mutex_unlock (&topology->mutex);
+   mongoc_topology_scanner_work (topology->scanner);
+
+   bson_mutex_lock (&topology->mutex);
+
+   _mongoc_topology_scanner_finish (topology->scanner);
+}
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -958,6 +1396,7 @@ mongoc_topology_invalidate_server (mongoc_topology_t *topology,
    bson_mutex_lock (&topology->mutex);
    mongoc_topology_description_invalidate_server (
       &topology->description, id, error);
+   _mongoc_topology_publish_snapshot (topology);
    bson_mutex_unlock (&topology->mutex);
 }
 
@@ -994,6 +1433,7 @@ _mongoc_topology_update_from_handshake (mongoc_topology_t *topology,
 
    /* if pooled, wake threads waiting in mongoc_topology_server_by_id */
    mongoc_cond_broadcast (&topology->cond_client);
+   _mongoc_topology_publish_snapshot (topology);
    bson_mutex_unlock (&topology->mutex);
 
    return has_server;
@@ -1088,6 +1528,56 @@ _mongoc_topology_get_type (mongoc_topology_t *topology)
    return td_type;
 }
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_topology_join_retired_monitors --
+ *
+ *       Destroy the retired server monitors whose threads have returned.
+ *       Monitors still connecting or waiting are left for the next pass,
+ *       so the background thread never blocks on them.
+ *
+ *       NOTE: this method uses @topology's mutex.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void
+_mongoc_topology_join_retired_monitors (mongoc_topology_t *topology)
+{
+   mongoc_server_monitor_t *monitor;
+   mongoc_array_t stopped;
+   size_t i;
+   size_t n;
+
+   _mongoc_array_init (&stopped, sizeof (mongoc_server_monitor_t *));
+
+   bson_mutex_lock (&topology->mutex);
+   for (i = 0, n = 0; i < topology->retired_monitors.len; i++) {
+      monitor = _mongoc_array_index (
+         &topology->retired_monitors, mongoc_server_monitor_t *, i);
+
+      if (_mongoc_server_monitor_stopped (monitor)) {
+         _mongoc_array_append_val (&stopped, monitor);
+      } else {
+         _mongoc_array_index (
+            &topology->retired_monitors, mongoc_server_monitor_t *, n++) =
+            monitor;
+      }
+   }
+
+   topology->retired_monitors.len = n;
+   bson_mutex_unlock (&topology->mutex);
+
+   for (i = 0; i < stopped.len; i++) {
+      _mongoc_server_monitor_destroy (
+         _mongoc_array_index (&stopped, mongoc_server_monitor_t *, i));
+   }
+
+   _mongoc_array_destroy (&stopped);
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -1107,7 +1597,9 @@ _mongoc_topology_run_background (void *data)
    int64_t last_scan;
    int64_t timeout;
    int64_t force_timeout;
+   int64_t probe_timeout;
    int64_t heartbeat_msec;
+   bool reap;
    int r;
 
    BSON_ASSERT (data);
@@ -1118,6 +1610,17 @@ _mongoc_topology_run_background (void *data)
 
    /* we exit this loop when shutdown_requested, or on error */
    for (;;) {
+      _mongoc_topology_join_retired_monitors (topology);
+
+      bson_mutex_lock (&topology->session_pool_mutex);
+      reap = bson_get_monotonic_time () - topology->last_session_reap >
+             MONGOC_TOPOLOGY_SESSION_REAP_INTERVAL_MS * 1000;
+      bson_mutex_unlock (&topology->session_pool_mutex);
+
+      if (reap) {
+         _mongoc_topology_reap_server_sessions (topology);
+      }
+
       /* unlocked after starting a scan or after breaking out of the loop */
       bson_mutex_lock (&topology->mutex);
       if (!mongoc_topology_scanner_valid (topology->scanner)) {
@@ -1134,6 +1637,12 @@ _mongoc_topology_run_background (void *data)
 
          now = bson_get_monotonic_time ();
 
+         /* the first probe of a server after an error is immediate */
+         probe_timeout = _mongoc_topology_probe_wait_msec (topology, now);
+         if (probe_timeout == 0) {
+            break;
+         }
+
          if (last_scan == 0) {
             /* set up the "last scan" as exactly long enough to force an
              * immediate scan on the first pass */
@@ -1151,6 +1660,10 @@ _mongoc_topology_run_background (void *data)
             timeout = BSON_MIN (timeout, force_timeout);
          }
 
+         if (probe_timeout > 0) {
+            timeout = BSON_MIN (timeout, probe_timeout);
+         }
+
          /* if we can start scanning, do so immediately */
          if (timeout <= 0) {
             break;
@@ -1178,6 +1691,12 @@ _mongoc_topology_run_background (void *data)
          }
       }
 
+      if (probe_timeout == 0) {
+         _mongoc_topology_probe (topology);
+         bson_mutex_unlock (&topology->mutex);
+         continue;
+      }
+
       topology->scan_requested = false;
       mongoc_topology_scan_once (topology, false /* obey cooldown */);
       bson_mutex_unlock (&topology->mutex);
@@ -1220,6 +1739,7 @@ _mongoc_topology_start_background_scanner (mongoc_topology_t *topology)
 
       _mongoc_handshake_freeze ();
       _mongoc_topology_description_monitor_opening (&topology->description);
+      _mongoc_topology_publish_snapshot (topology);
 
       r = bson_thread_create (
          &topology->thread, _mongoc_topology_run_background, topology);
@@ -1252,6 +1772,7 @@ static void
 _mongoc_topology_background_thread_stop (mongoc_topology_t *topology)
 {
    bool join_thread = false;
+   size_t i;
 
    if (topology->single_threaded) {
       return;
@@ -1282,6 +1803,27 @@ _mongoc_topology_background_thread_stop (mongoc_topology_t *topology)
        * all listeners */
       bson_thread_join (topology->thread);
       mongoc_cond_broadcast (&topology->cond_client);
+
+      /* only the background thread starts monitors, no more will be added.
+       * monitors take the topology mutex to apply replies, don't hold it */
+      for (i = 0; i < topology->server_monitors->items_len; i++) {
+         _mongoc_server_monitor_request_shutdown (
+            mongoc_set_get_item (topology->server_monitors, (int) i));
+      }
+
+      for (i = 0; i < topology->server_monitors->items_len; i++) {
+         _mongoc_server_monitor_destroy (
+            mongoc_set_get_item (topology->server_monitors, (int) i));
+      }
+
+      for (i = 0; i < topology->retired_monitors.len; i++) {
+         _mongoc_server_monitor_destroy (_mongoc_array_index (
+            &topology->retired_monitors, mongoc_server_monitor_t *, i));
+      }
+
+      mongoc_set_destroy (topology->server_monitors);
+      topology->server_monitors = mongoc_set_new (8, NULL, NULL);
+      topology->retired_monitors.len = 0;
    }
 }
 
@@ -1325,6 +1867,43 @@ _mongoc_topology_update_cluster_time (mongoc_topology_t *topology,
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_topology_session_timeout --
+ *
+ *       The logicalSessionTimeoutMinutes of the topology, and in
+ *       @has_data_node whether it has a data-bearing server, if not NULL.
+ *       In pooled mode they're copied when a snapshot is published, so
+ *       that taking and returning sessions takes no other lock.
+ *
+ *       NOTE: the caller must hold @topology's session_pool_mutex.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static int64_t
+_mongoc_topology_session_timeout (mongoc_topology_t *topology,
+                                  bool *has_data_node)
+{
+   if (topology->single_threaded) {
+      /* only the client's thread uses the description */
+      if (has_data_node) {
+         *has_data_node =
+            mongoc_topology_description_has_data_node (&topology->description);
+      }
+
+      return topology->description.session_timeout_minutes;
+   }
+
+   if (has_data_node) {
+      *has_data_node = topology->session_has_data_node;
+   }
+
+   return topology->session_timeout_minutes;
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -1342,36 +1921,32 @@ _mongoc_topology_pop_server_session (mongoc_topology_t *topology,
 {
    int64_t timeout;
    mongoc_server_session_t *ss = NULL;
-   mongoc_topology_description_t *td;
+   bool has_data_node;
 
    ENTRY;
 
-   bson_mutex_lock (&topology->mutex);
+   bson_mutex_lock (&topology->session_pool_mutex);
+   timeout = _mongoc_topology_session_timeout (topology, &has_data_node);
 
-   td = &topology->description;
-   timeout = td->session_timeout_minutes;
-
-   if (timeout == MONGOC_NO_SESSIONS) {
-      /* if needed, connect and check for session timeout again */
-      if (!mongoc_topology_description_has_data_node (td)) {
-         bson_mutex_unlock (&topology->mutex);
-         if (!mongoc_topology_select_server_id (
-                topology, MONGOC_SS_READ, NULL, error)) {
-            RETURN (NULL);
-         }
-
-         bson_mutex_lock (&topology->mutex);
-         timeout = td->session_timeout_minutes;
-      }
-
-      if (timeout == MONGOC_NO_SESSIONS) {
-         bson_mutex_unlock (&topology->mutex);
-         bson_set_error (error,
-                         MONGOC_ERROR_CLIENT,
-                         MONGOC_ERROR_CLIENT_SESSION_FAILURE,
-                         "Server does not support sessions");
+   if (timeout == MONGOC_NO_SESSIONS && !has_data_node) {
+      /* connect and check for session timeout again */
+      bson_mutex_unlock (&topology->session_pool_mutex);
+      if (!mongoc_topology_select_server_id (
+             topology, MONGOC_SS_READ, NULL, error)) {
          RETURN (NULL);
       }
+
+      bson_mutex_lock (&topology->session_pool_mutex);
+      timeout = _mongoc_topology_session_timeout (topology, NULL);
+   }
+
+   if (timeout == MONGOC_NO_SESSIONS) {
+      bson_mutex_unlock (&topology->session_pool_mutex);
+      bson_set_error (error,
+                      MONGOC_ERROR_CLIENT,
+                      MONGOC_ERROR_CLIENT_SESSION_FAILURE,
+                      "Server does not support sessions");
+      RETURN (NULL);
    }
 
    while (topology->session_pool) {
@@ -1385,7 +1960,7 @@ _mongoc_topology_pop_server_session (mongoc_topology_t *topology,
       }
    }
 
-   bson_mutex_unlock (&topology->mutex);
+   bson_mutex_unlock (&topology->session_pool_mutex);
 
    if (!ss) {
       ss = _mongoc_server_session_new (error);
@@ -1401,6 +1976,10 @@ _mongoc_topology_pop_server_session (mongoc_topology_t *topology,
  *
  *       Internal function. Return a server session to the pool.
  *
+ *       Sessions that time out in the pool are reaped later: in pooled
+ *       mode by the background thread, in single-threaded mode by a push
+ *       at most every MONGOC_TOPOLOGY_SESSION_REAP_INTERVAL_MS.
+ *
  *--------------------------------------------------------------------------
  */
 
@@ -1409,13 +1988,62 @@ _mongoc_topology_push_server_session (mongoc_topology_t *topology,
                                       mongoc_server_session_t *server_session)
 {
    int64_t timeout;
-   mongoc_server_session_t *ss;
+   bool reap = false;
 
    ENTRY;
 
-   bson_mutex_lock (&topology->mutex);
+   bson_mutex_lock (&topology->session_pool_mutex);
+   timeout = _mongoc_topology_session_timeout (topology, NULL);
 
-   timeout = topology->description.session_timeout_minutes;
+   if (_mongoc_server_session_timed_out (server_session, timeout)) {
+      bson_mutex_unlock (&topology->session_pool_mutex);
+      _mongoc_server_session_destroy (server_session);
+      EXIT;
+   }
+
+   /* silences clang scan-build */
+   BSON_ASSERT (!topology->session_pool || (topology->session_pool->next &&
+                                            topology->session_pool->prev));
+   CDL_PREPEND (topology->session_pool, server_session);
+
+   if (topology->single_threaded &&
+       bson_get_monotonic_time () - topology->last_session_reap >
+          MONGOC_TOPOLOGY_SESSION_REAP_INTERVAL_MS * 1000) {
+      reap = true;
+   }
+
+   bson_mutex_unlock (&topology->session_pool_mutex);
+
+   if (reap) {
+      _mongoc_topology_reap_server_sessions (topology);
+   }
+
+   EXIT;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_topology_reap_server_sessions --
+ *
+ *       Internal function. Destroy the sessions that timed out in the
+ *       pool. They are at its back, the least recently used.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_topology_reap_server_sessions (mongoc_topology_t *topology)
+{
+   int64_t timeout;
+   mongoc_server_session_t *ss;
+
+   ENTRY;
+
+   bson_mutex_lock (&topology->session_pool_mutex);
+   timeout = _mongoc_topology_session_timeout (topology, NULL);
+   topology->last_session_reap = bson_get_monotonic_time ();
 
    /* start at back of queue and reap timed-out sessions */
    while (topology->session_pool && topology->session_pool->prev) {
@@ -1430,16 +2058,7 @@ _mongoc_topology_push_server_session (mongoc_topology_t *topology,
       }
    }
 
-   if (_mongoc_server_session_timed_out (server_session, timeout)) {
-      _mongoc_server_session_destroy (server_session);
-   } else {
-      /* silences clang scan-build */
-      BSON_ASSERT (!topology->session_pool || (topology->session_pool->next &&
-                                               topology->session_pool->prev));
-      CDL_PREPEND (topology->session_pool, server_session);
-   }
-
-   bson_mutex_unlock (&topology->mutex);
+   bson_mutex_unlock (&topology->session_pool_mutex);
 
    EXIT;
 }
@@ -1478,6 +2097,7 @@ _mongoc_topology_end_sessions_cmd (mongoc_topology_t *topology, bson_t *cmd)
    BSON_APPEND_ARRAY_BEGIN (cmd, "endSessions", &ar);
 
    i = 0;
+   bson_mutex_lock (&topology->session_pool_mutex);
    CDL_FOREACH_SAFE (topology->session_pool, ss, tmp1, tmp2)
    {
       bson_uint32_to_string (i, &key, buf, sizeof buf);
@@ -1490,6 +2110,8 @@ _mongoc_topology_end_sessions_cmd (mongoc_topology_t *topology, bson_t *cmd)
       }
    }
 
+   bson_mutex_unlock (&topology->session_pool_mutex);
+
    bson_append_array_end (cmd, &ar);
 
    return i > 0;
@@ -1517,3 +2139,252 @@ _mongoc_topology_get_ismaster (mongoc_topology_t *topology)
    bson_mutex_unlock (&topology->mutex);
    return cmd;
 }
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_topology_publish_snapshot --
+ *
+ *       Replace the topology's snapshot with a copy of its current
+ *       description, and update the session pool's copy of its session
+ *       timeout. Threads still using the old snapshot keep it alive until
+ *       they release it. Does nothing in single-threaded mode.
+ *
+ *       NOTE: this method expects @topology's mutex to be locked on entry.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_topology_publish_snapshot (mongoc_topology_t *topology)
+{
+   mongoc_topology_snapshot_t *snapshot;
+   mongoc_topology_snapshot_t *old;
+
+   if (topology->single_threaded) {
+      return;
+   }
+
+   snapshot = bson_malloc0 (sizeof *snapshot);
+   _mongoc_topology_description_copy_to (&topology->description,
+                                         &snapshot->description);
+   snapshot->scanner_valid = mongoc_topology_scanner_valid (topology->scanner);
+   if (!snapshot->scanner_valid) {
+      mongoc_topology_scanner_get_error (topology->scanner,
+                                         &snapshot->scanner_error);
+   }
+
+   snapshot->ref_count = 1;
+   bson_mutex_init (&snapshot->cache_mutex);
+
+   bson_mutex_lock (&topology->session_pool_mutex);
+   topology->session_timeout_minutes =
+      topology->description.session_timeout_minutes;
+   topology->session_has_data_node =
+      mongoc_topology_description_has_data_node (&topology->description);
+   bson_mutex_unlock (&topology->session_pool_mutex);
+
+   bson_mutex_lock (&topology->snapshot_mutex);
+   old = topology->snapshot;
+   topology->snapshot = snapshot;
+   bson_mutex_unlock (&topology->snapshot_mutex);
+
+   if (old) {
+      _mongoc_topology_snapshot_release (old);
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_topology_snapshot_acquire --
+ *
+ *       Get a reference to the latest topology snapshot, or NULL if none
+ *       has been published yet. Release it with
+ *       _mongoc_topology_snapshot_release. The snapshot must not be
+ *       modified.
+ *
+ *       NOTE: this method does not lock @topology's mutex.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_topology_snapshot_t *
+_mongoc_topology_snapshot_acquire (mongoc_topology_t *topology)
+{
+   mongoc_topology_snapshot_t *snapshot;
+
+   if (topology->single_threaded) {
+      return NULL;
+   }
+
+   /* held just long enough to take a reference, never during a copy */
+   bson_mutex_lock (&topology->snapshot_mutex);
+   snapshot = topology->snapshot;
+   if (snapshot) {
+      bson_atomic_int_add (&snapshot->ref_count, 1);
+   }
+   bson_mutex_unlock (&topology->snapshot_mutex);
+
+   return snapshot;
+}
+
+
+void
+_mongoc_topology_snapshot_release (mongoc_topology_snapshot_t *snapshot)
+{
+   int32_t i;
+
+   BSON_ASSERT (snapshot);
+
+   if (bson_atomic_int_add (&snapshot->ref_count, -1) == 0) {
+      for (i = 0; i < snapshot->cache_len; i++) {
+         bson_destroy (&snapshot->cache[i].tags);
+         _mongoc_array_destroy (&snapshot->cache[i].servers);
+      }
+
+      bson_mutex_destroy (&snapshot->cache_mutex);
+      mongoc_topology_description_destroy (&snapshot->description);
+      bson_free (snapshot);
+   }
+}
+
+
+static mongoc_topology_cached_selection_t *
+_mongoc_topology_snapshot_find_selection (mongoc_topology_snapshot_t *snapshot,
+                                          int32_t start,
+                                          int32_t end,
+                                          mongoc_ss_optype_t optype,
+                                          const mongoc_read_prefs_t *read_prefs,
+                                          int64_t local_threshold_ms)
+{
+   mongoc_topology_cached_selection_t *entry;
+   mongoc_read_mode_t mode = mongoc_read_prefs_get_mode (read_prefs);
+   const bson_t *tags = NULL;
+   int64_t max_staleness_seconds = MONGOC_NO_MAX_STALENESS;
+   int32_t i;
+
+   if (read_prefs) {
+      tags = mongoc_read_prefs_get_tags (read_prefs);
+      max_staleness_seconds =
+         mongoc_read_prefs_get_max_staleness_seconds (read_prefs);
+   }
+
+   for (i = start; i < end; i++) {
+      entry = &snapshot->cache[i];
+      if (entry->optype == optype && entry->mode == mode &&
+          entry->max_staleness_seconds == max_staleness_seconds &&
+          entry->local_threshold_ms == local_threshold_ms &&
+          (tags ? bson_equal (&entry->tags, tags)
+                : bson_empty (&entry->tags))) {
+         return entry;
+      }
+   }
+
+   return NULL;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_topology_snapshot_select --
+ *
+ *       Like mongoc_topology_description_select on the snapshot's
+ *       description, but remembers the suitable servers for each optype
+ *       and read preference. Since the snapshot never changes, later
+ *       selections with the same arguments only pick one of them at random.
+ *
+ *       NOTE: @snapshot may be used by other threads concurrently.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_server_description_t *
+_mongoc_topology_snapshot_select (mongoc_topology_snapshot_t *snapshot,
+                                  mongoc_ss_optype_t optype,
+                                  const mongoc_read_prefs_t *read_prefs,
+                                  int64_t local_threshold_ms,
+                                  unsigned int *rand_seed)
+{
+   mongoc_topology_cached_selection_t *entry;
+   mongoc_server_description_t *sd = NULL;
+   mongoc_array_t servers;
+   int32_t cache_len;
+
+   /* selection from a Single topology is already trivial */
+   if (snapshot->description.type == MONGOC_TOPOLOGY_SINGLE) {
+      return _mongoc_topology_description_select_with_seed (
+         &snapshot->description,
+         optype,
+         read_prefs,
+         local_threshold_ms,
+         rand_seed);
+   }
+
+   cache_len = snapshot->cache_len;
+   bson_memory_barrier ();
+   entry = _mongoc_topology_snapshot_find_selection (
+      snapshot, 0, cache_len, optype, read_prefs, local_threshold_ms);
+
+   if (!entry) {
+      _mongoc_array_init (&servers, sizeof (mongoc_server_description_t *));
+      mongoc_topology_description_suitable_servers (&servers,
+                                                    optype,
+                                                    &snapshot->description,
+                                                    read_prefs,
+                                                    local_threshold_ms);
+
+      bson_mutex_lock (&snapshot->cache_mutex);
+      /* another thread may have added it meanwhile */
+      entry = _mongoc_topology_snapshot_find_selection (snapshot,
+                                                        cache_len,
+                                                        snapshot->cache_len,
+                                                        optype,
+                                                        read_prefs,
+                                                        local_threshold_ms);
+
+      if (!entry &&
+          snapshot->cache_len < MONGOC_TOPOLOGY_SELECTION_CACHE_SIZE) {
+         entry = &snapshot->cache[snapshot->cache_len];
+         entry->optype = optype;
+         entry->mode = mongoc_read_prefs_get_mode (read_prefs);
+         entry->max_staleness_seconds =
+            read_prefs ? mongoc_read_prefs_get_max_staleness_seconds (
+                            read_prefs)
+                       : MONGOC_NO_MAX_STALENESS;
+         if (read_prefs) {
+            bson_copy_to (mongoc_read_prefs_get_tags (read_prefs),
+                          &entry->tags);
+         } else {
+            bson_init (&entry->tags);
+         }
+
+         entry->local_threshold_ms = local_threshold_ms;
+         memcpy (&entry->servers, &servers, sizeof (mongoc_array_t));
+         _mongoc_array_init (&servers, sizeof (mongoc_server_description_t *));
+
+         /* publish the entry only once it is complete */
+         bson_memory_barrier ();
+         snapshot->cache_len++;
+      }
+
+      bson_mutex_unlock (&snapshot->cache_mutex);
+
+      if (!entry) {
+         /* the cache is full: select without it */
+         sd = _mongoc_topology_description_pick_server (
+            &snapshot->description, &servers, rand_seed);
+
+         _mongoc_array_destroy (&servers);
+         return sd;
+      }
+
+      _mongoc_array_destroy (&servers);
+   }
+
+   return _mongoc_topology_description_pick_server (
+      &snapshot->description, &entry->servers, rand_seed);
+}
@@ -725,6 +725,8 @@ mongoc_uri_option_is_utf8 (const char *key)
    return !strcasecmp (key, MONGOC_URI_APPNAME) ||
           !strcasecmp (key, MONGOC_URI_REPLICASET) ||
           !strcasecmp (key, MONGOC_URI_READPREFERENCE) ||
+          !strcasecmp (key, MONGOC_URI_SERVERMONITORINGMODE) ||
+          !strcasecmp (key, MONGOC_URI_SERVERSELECTIONMODE) ||
           !strcasecmp (key, MONGOC_URI_SSLCLIENTCERTIFICATEKEYFILE) ||
           !strcasecmp (key, MONGOC_URI_SSLCLIENTCERTIFICATEKEYPASSWORD) ||
           !strcasecmp (key, MONGOC_URI_SSLCERTIFICATEAUTHORITYFILE);
@@ -931,6 +933,17 @@ mongoc_uri_parse_option (mongoc_uri_t *uri,
       if (!mongoc_uri_set_compressors (uri, value)) {
          goto UNSUPPORTED_VALUE;
       }
+   } else if (!strcmp (lkey, MONGOC_URI_SERVERSELECTIONMODE)) {
+      if (strcasecmp (value, "random") &&
+          strcasecmp (value, "powerOfTwoChoices")) {
+         goto UNSUPPORTED_VALUE;
+      }
+      mongoc_uri_bson_append_or_replace_key (&uri->options, lkey, value);
+   } else if (!strcmp (lkey, MONGOC_URI_SERVERMONITORINGMODE)) {
+      if (strcasecmp (value, "stream") && strcasecmp (value, "poll")) {
+         goto UNSUPPORTED_VALUE;
+      }
+      mongoc_uri_bson_append_or_replace_key (&uri->options, lkey, value);
    } else if (mongoc_uri_option_is_utf8 (lkey)) {
       mongoc_uri_bson_append_or_replace_key (&uri->options, lkey, value);
    } else {
@@ -37,12 +37,16 @@ struct _mongoc_crud_opts_t;
 #define MONGOC_WRITE_COMMAND_INSERT 1
 #define MONGOC_WRITE_COMMAND_UPDATE 2
 
+/* the most batches mongoc_bulk_operation_set_pipeline_depth allows in flight */
+#define MONGOC_WRITE_PIPELINE_DEPTH_MAX 100
+
 struct _mongoc_bulk_write_flags_t {
    bool ordered;
    bool bypass_document_validation;
    bool has_collation;
    bool has_multi_write;
    bool has_array_filters;
+   uint32_t pipeline_depth;
 };
 
 
@@ -80,6 +84,11 @@ typedef struct {
    bool must_stop; /* The stream may have been disconnected */
    bson_error_t error;
    uint32_t upsert_append_count;
+   uint32_t write_error_append_count;
+   /* keep counts and the first write error, not every error and upsert */
+   bool counts_only;
+   mongoc_bulk_operation_batch_cb_t batch_cb;
+   void *batch_cb_ctx;
 } mongoc_write_result_t;
 
 
@@ -115,6 +124,14 @@ _mongoc_write_command_init_insert_idl (mongoc_write_command_t *command,
                                        const bson_t *cmd_opts,
                                        int64_t operation_id,
                                        bool allow_bulk_op_insert);
+bool
+_mongoc_write_command_init_insert_raw (mongoc_write_command_t *command,
+                                       const uint8_t *data,
+                                       size_t data_len,
+                                       bson_validate_flags_t vflags,
+                                       const bson_t *cmd_opts,
+                                       int64_t operation_id,
+                                       bson_error_t *error);
 void
 _mongoc_write_command_init_delete (mongoc_write_command_t *command,
                                    const bson_t *selectors,
@@ -186,10 +203,9 @@ _mongoc_write_result_append_upsert (mongoc_write_result_t *result,
                                     int32_t idx,
                                     const bson_value_t *value);
 int32_t
-_mongoc_write_result_merge_arrays (uint32_t offset,
-                                   mongoc_write_result_t *result,
-                                   bson_t *dest,
-                                   bson_iter_t *iter);
+_mongoc_write_result_merge_write_errors (uint32_t offset,
+                                         mongoc_write_result_t *result,
+                                         bson_iter_t *iter);
 void
 _mongoc_write_result_merge (mongoc_write_result_t *result,
                             mongoc_write_command_t *command,
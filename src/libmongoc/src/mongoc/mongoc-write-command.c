@@ -18,6 +18,7 @@
 
 #include "mongoc/mongoc-client-private.h"
 #include "mongoc/mongoc-client-session-private.h"
+#include "mongoc/mongoc-cluster-private.h"
 #include "mongoc/mongoc-error.h"
 #include "mongoc/mongoc-trace-private.h"
 #include "mongoc/mongoc-write-command-private.h"
@@ -48,6 +49,11 @@ static const char *gCommandNames[] = {"delete", "insert", "update"};
 static const char *gCommandFields[] = {"deletes", "documents", "updates"};
 static const uint32_t gCommandFieldLens[] = {7, 9, 7};
 
+/* MongoDB has a extra allowance to allow updating 16mb document,
+ * as the update operators would otherwise overflow the 16mb object limit
+ */
+#define BSON_OBJECT_ALLOWANCE (16 * 1024)
+
 static mongoc_write_op_t gLegacyWriteOps[3] = {
    _mongoc_write_command_delete_legacy,
    _mongoc_write_command_insert_legacy,
@@ -240,6 +246,87 @@ _mongoc_write_command_init_insert_idl (mongoc_write_command_t *command,
 }
 
 
+/*
+ *-------------------------------------------------------------------------
+ *
+ * _mongoc_write_command_init_insert_raw --
+ *
+ *       Initialize an insert command whose payload is @data, @data_len
+ *       bytes of concatenated BSON documents. @data is not copied and
+ *       must outlive @command. Unlike _mongoc_write_command_insert_append,
+ *       documents without an "_id" are sent as-is, so the server
+ *       generates their "_id".
+ *
+ * Returns:
+ *       true if each document's length is consistent with @data_len and
+ *       each passes validation with @vflags. Otherwise false and @error
+ *       is set.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_write_command_init_insert_raw (mongoc_write_command_t *command,
+                                       const uint8_t *data,
+                                       size_t data_len,
+                                       bson_validate_flags_t vflags,
+                                       const bson_t *cmd_opts,
+                                       int64_t operation_id,
+                                       bson_error_t *error)
+{
+   mongoc_bulk_write_flags_t flags = MONGOC_BULK_WRITE_FLAGS_INIT;
+   size_t offset = 0;
+   int32_t len;
+   bson_t doc;
+
+   ENTRY;
+
+   BSON_ASSERT (command);
+   BSON_ASSERT (data || !data_len);
+
+   _mongoc_write_command_init_bulk (
+      command, MONGOC_WRITE_COMMAND_INSERT, flags, operation_id, cmd_opts);
+   command->u.insert.allow_bulk_op_insert = false;
+
+   /* borrow @data, without a realloc_func the payload is never freed */
+   _mongoc_buffer_destroy (&command->payload);
+   command->payload.data = (uint8_t *) data;
+   command->payload.datalen = data_len;
+   command->payload.len = data_len;
+
+   while (offset < data_len) {
+      if (data_len - offset < 5) {
+         GOTO (invalid);
+      }
+
+      memcpy (&len, data + offset, sizeof (len));
+      len = BSON_UINT32_FROM_LE (len);
+
+      if (len < 5 || (size_t) len > data_len - offset ||
+          !bson_init_static (&doc, data + offset, (size_t) len)) {
+         GOTO (invalid);
+      }
+
+      if (!_mongoc_validate_new_document (&doc, vflags, error)) {
+         RETURN (false);
+      }
+
+      command->n_documents++;
+      offset += (size_t) len;
+   }
+
+   RETURN (true);
+
+invalid:
+   bson_set_error (error,
+                   MONGOC_ERROR_BSON,
+                   MONGOC_ERROR_BSON_INVALID,
+                   "Invalid BSON document at index %" PRIu32,
+                   command->n_documents);
+   RETURN (false);
+}
+
+
 void
 _mongoc_write_command_init_delete (mongoc_write_command_t *command, /* IN */
                                    const bson_t *selector,          /* IN */
@@ -429,6 +516,188 @@ _mongoc_write_command_will_overflow (uint32_t len_so_far,
 }
 
 
+/* a batch whose reply hasn't been read, see _mongoc_write_opmsg_pipeline */
+typedef struct {
+   mongoc_cluster_pending_cmd_t pending;
+   uint32_t index_offset;
+} mongoc_write_batch_in_flight_t;
+
+
+/*
+ *-------------------------------------------------------------------------
+ *
+ * _mongoc_write_opmsg_can_pipeline --
+ *
+ *       Whether the batches of an unordered write command may be sent
+ *       back to back on one connection before their replies are read.
+ *       Retryable writes and transactions must see each reply before the
+ *       next batch is sent, so they are never pipelined.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_write_opmsg_can_pipeline (mongoc_write_command_t *command,
+                                  mongoc_client_t *client,
+                                  mongoc_cmd_parts_t *parts,
+                                  mongoc_client_session_t *cs)
+{
+   return !command->flags.ordered && command->flags.pipeline_depth > 1 &&
+          parts->assembled.is_acknowledged && !parts->is_retryable_write &&
+          !_mongoc_client_session_in_txn (cs) && !client->in_exhaust;
+}
+
+
+/*
+ *-------------------------------------------------------------------------
+ *
+ * _mongoc_write_opmsg_pipeline --
+ *
+ *       Split @command into OP_MSG batches like _mongoc_write_opmsg, but
+ *       keep up to command->flags.pipeline_depth batches in flight on the
+ *       stream. Replies are read and merged into @result in the order the
+ *       batches were sent, each with its own index offset.
+ *
+ *       After a network error the stream is gone: no further batches are
+ *       sent, and batches still in flight are finished as failed so that
+ *       each gets its APM failed event and leaves the server's load.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+static void
+_mongoc_write_opmsg_pipeline (mongoc_write_command_t *command,
+                              mongoc_client_t *client,
+                              mongoc_cmd_parts_t *parts,
+                              uint32_t header,
+                              int32_t max_msg_size,
+                              int32_t max_bson_obj_size,
+                              int32_t max_document_count,
+                              uint32_t index_offset,
+                              mongoc_write_result_t *result,
+                              bson_error_t *error)
+{
+   mongoc_write_batch_in_flight_t *in_flight;
+   mongoc_write_batch_in_flight_t *batch;
+   uint32_t depth = command->flags.pipeline_depth;
+   uint32_t head = 0;
+   uint32_t n_in_flight = 0;
+   uint32_t payload_batch_size;
+   uint32_t payload_total_offset = 0;
+   int document_count;
+   bool sending = true;
+   bool ret;
+   int32_t len;
+   bson_t reply;
+
+   ENTRY;
+
+   /* each batch holds at least one document */
+   BSON_ASSERT (depth <= MONGOC_WRITE_PIPELINE_DEPTH_MAX);
+   depth = BSON_MAX (1, BSON_MIN (depth, command->n_documents));
+   in_flight = (mongoc_write_batch_in_flight_t *) bson_malloc (
+      depth * sizeof (mongoc_write_batch_in_flight_t));
+
+   parts->assembled.payload_identifier = gCommandFields[command->type];
+
+   while (n_in_flight ||
+          (sending && payload_total_offset < command->payload.len)) {
+      if (sending && payload_total_offset < command->payload.len &&
+          n_in_flight < depth) {
+         payload_batch_size = 0;
+         document_count = 0;
+
+         while (payload_total_offset + payload_batch_size <
+                command->payload.len) {
+            memcpy (&len,
+                    command->payload.data + payload_total_offset +
+                       payload_batch_size,
+                    4);
+            len = BSON_UINT32_FROM_LE (len);
+
+            if (len > max_bson_obj_size + BSON_OBJECT_ALLOWANCE) {
+               /* Quit if the document is too large */
+               _mongoc_write_command_too_large_error (
+                  error, index_offset, len, max_bson_obj_size);
+               result->failed = true;
+               sending = false;
+               break;
+            }
+
+            if (document_count &&
+                (payload_batch_size + header) + len > max_msg_size) {
+               break;
+            }
+
+            payload_batch_size += len;
+            if (++document_count == max_document_count) {
+               break;
+            }
+         }
+
+         if (!sending) {
+            continue;
+         }
+
+         /* Seek past the document offset we have already sent */
+         parts->assembled.payload =
+            command->payload.data + payload_total_offset;
+         /* Only send the documents up to this size */
+         parts->assembled.payload_size = payload_batch_size;
+
+         batch = &in_flight[(head + n_in_flight) % depth];
+         batch->index_offset = index_offset;
+
+         if (!mongoc_cluster_send_command_monitored (
+                &client->cluster, &parts->assembled, &batch->pending, error)) {
+            result->failed = true;
+            result->must_stop = true;
+            break;
+         }
+
+         n_in_flight++;
+         payload_total_offset += payload_batch_size;
+         index_offset += document_count;
+         continue;
+      }
+
+      batch = &in_flight[head];
+      head = (head + 1) % depth;
+      n_in_flight--;
+
+      ret = mongoc_cluster_recv_command_monitored (
+         &client->cluster, &parts->assembled, &batch->pending, &reply, error);
+
+      if (!ret) {
+         result->failed = true;
+         result->must_stop = true;
+      }
+
+      _mongoc_write_result_merge (result, command, &reply, batch->index_offset);
+
+      if (!ret && bson_empty (&reply)) {
+         /* network error, the node was disconnected */
+         bson_destroy (&reply);
+         break;
+      }
+
+      bson_destroy (&reply);
+   }
+
+   /* the stream failed: finish the batches whose replies can't be read */
+   while (n_in_flight) {
+      mongoc_cluster_fail_pending_monitored (
+         &client->cluster, &parts->assembled, &in_flight[head].pending, error);
+      head = (head + 1) % depth;
+      n_in_flight--;
+   }
+
+   bson_free (in_flight);
+
+   EXIT;
+}
+
+
 static void
 _mongoc_write_opmsg (mongoc_write_command_t *command,
                      mongoc_client_t *client,
@@ -465,10 +734,6 @@ _mongoc_write_opmsg (mongoc_write_command_t *command,
    BSON_ASSERT (server_stream);
    BSON_ASSERT (collection);
 
-/* MongoDB has a extra allowance to allow updating 16mb document,
- * as the update operators would otherwise overflow the 16mb object limit
- */
-#define BSON_OBJECT_ALLOWANCE (16 * 1024)
    max_bson_obj_size = mongoc_server_stream_max_bson_obj_size (server_stream);
    max_msg_size = mongoc_server_stream_max_msg_size (server_stream);
    max_document_count =
@@ -526,6 +791,22 @@ _mongoc_write_opmsg (mongoc_write_command_t *command,
    header =
       26 + parts.assembled.command->len + gCommandFieldLens[command->type] + 1;
 
+   if (_mongoc_write_opmsg_can_pipeline (command, client, &parts, cs)) {
+      _mongoc_write_opmsg_pipeline (command,
+                                    client,
+                                    &parts,
+                                    header,
+                                    max_msg_size,
+                                    max_bson_obj_size,
+                                    max_document_count,
+                                    index_offset,
+                                    result,
+                                    error);
+      bson_destroy (&cmd);
+      mongoc_cmd_parts_cleanup (&parts);
+      EXIT;
+   }
+
    do {
       memcpy (&len,
               command->payload.data + payload_batch_size + payload_total_offset,
@@ -1071,17 +1352,15 @@ _mongoc_write_result_append_upsert (mongoc_write_result_t *result,
 
 
 int32_t
-_mongoc_write_result_merge_arrays (uint32_t offset,
-                                   mongoc_write_result_t *result, /* IN */
-                                   bson_t *dest,                  /* IN */
-                                   bson_iter_t *iter)             /* IN */
+_mongoc_write_result_merge_write_errors (uint32_t offset,
+                                         mongoc_write_result_t *result, /* IN */
+                                         bson_iter_t *iter)             /* IN */
 {
    const bson_value_t *value;
    bson_iter_t ar;
    bson_iter_t citer;
    int32_t idx;
    int32_t count = 0;
-   int32_t aridx;
    bson_t child;
    const char *keyptr = NULL;
    char key[12];
@@ -1090,19 +1369,21 @@ _mongoc_write_result_merge_arrays (uint32_t offset,
    ENTRY;
 
    BSON_ASSERT (result);
-   BSON_ASSERT (dest);
    BSON_ASSERT (iter);
    BSON_ASSERT (BSON_ITER_HOLDS_ARRAY (iter));
 
-   aridx = bson_count_keys (dest);
-
    if (bson_iter_recurse (iter, &ar)) {
       while (bson_iter_next (&ar)) {
+         if (result->counts_only && result->write_error_append_count) {
+            break;
+         }
+
          if (BSON_ITER_HOLDS_DOCUMENT (&ar) &&
              bson_iter_recurse (&ar, &citer)) {
-            len =
-               (int) bson_uint32_to_string (aridx++, &keyptr, key, sizeof key);
-            bson_append_document_begin (dest, keyptr, len, &child);
+            len = (int) bson_uint32_to_string (
+               result->write_error_append_count, &keyptr, key, sizeof key);
+            bson_append_document_begin (
+               &result->writeErrors, keyptr, len, &child);
             while (bson_iter_next (&citer)) {
                if (BSON_ITER_IS_KEY (&citer, "index")) {
                   idx = bson_iter_int32 (&citer) + offset;
@@ -1112,7 +1393,8 @@ _mongoc_write_result_merge_arrays (uint32_t offset,
                   BSON_APPEND_VALUE (&child, bson_iter_key (&citer), value);
                }
             }
-            bson_append_document_end (dest, &child);
+            bson_append_document_end (&result->writeErrors, &child);
+            result->write_error_append_count++;
             count++;
          }
       }
@@ -1141,6 +1423,12 @@ _mongoc_write_result_merge (mongoc_write_result_t *result,   /* IN */
    BSON_ASSERT (result);
    BSON_ASSERT (reply);
 
+   /* an empty reply is from a batch that failed before the server replied,
+    * its error is returned by mongoc_bulk_operation_execute */
+   if (result->batch_cb && !bson_empty (reply)) {
+      result->batch_cb (reply, offset, result->batch_cb_ctx);
+   }
+
    if (bson_iter_init_find (&iter, reply, "n") &&
        BSON_ITER_HOLDS_INT32 (&iter)) {
       affected = bson_iter_int32 (&iter);
@@ -1175,9 +1463,11 @@ _mongoc_write_result_merge (mongoc_write_result_t *result,   /* IN */
 
                   if (bson_iter_recurse (&ar, &citer) &&
                       bson_iter_find (&citer, "_id")) {
-                     value = bson_iter_value (&citer);
-                     _mongoc_write_result_append_upsert (
-                        result, offset + server_index, value);
+                     if (!result->counts_only) {
+                        value = bson_iter_value (&citer);
+                        _mongoc_write_result_append_upsert (
+                           result, offset + server_index, value);
+                     }
                      n_upserted++;
                   }
                }
@@ -1204,12 +1494,13 @@ _mongoc_write_result_merge (mongoc_write_result_t *result,   /* IN */
 
    if (bson_iter_init_find (&iter, reply, "writeErrors") &&
        BSON_ITER_HOLDS_ARRAY (&iter)) {
-      _mongoc_write_result_merge_arrays (
-         offset, result, &result->writeErrors, &iter);
+      _mongoc_write_result_merge_write_errors (offset, result, &iter);
    }
 
+   /* in counts-only mode keep the first, which sets the bson_error_t */
    if (bson_iter_init_find (&iter, reply, "writeConcernError") &&
-       BSON_ITER_HOLDS_DOCUMENT (&iter)) {
+       BSON_ITER_HOLDS_DOCUMENT (&iter) &&
+       !(result->counts_only && result->n_writeConcernErrors)) {
       uint32_t len;
       const uint8_t *data;
       bson_t write_concern_error;
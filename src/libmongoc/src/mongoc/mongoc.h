@@ -29,6 +29,7 @@
 #include "mongoc/mongoc-client.h"
 #include "mongoc/mongoc-client-pool.h"
 #include "mongoc/mongoc-collection.h"
+#include "mongoc/mongoc-counters.h"
 #include "mongoc/mongoc-config.h"
 #include "mongoc/mongoc-cursor.h"
 #include "mongoc/mongoc-database.h"
@@ -47,6 +48,7 @@
 #include "mongoc/mongoc-opcode.h"
 #include "mongoc/mongoc-log.h"
 #include "mongoc/mongoc-socket.h"
+#include "mongoc/mongoc-span.h"
 #include "mongoc/mongoc-client-session.h"
 #include "mongoc/mongoc-stream.h"
 #include "mongoc/mongoc-stream-buffered.h"
@@ -92,7 +92,8 @@ started_cb (const mongoc_apm_command_started_t *event)
    bson_t *new_event;
 
    if (ctx->verbose) {
-      cmd_json = bson_as_canonical_extended_json (event->command, NULL);
+      cmd_json = bson_as_canonical_extended_json (
+         mongoc_apm_command_started_get_command (event), NULL);
       printf ("%s\n", cmd_json);
       fflush (stdout);
       bson_free (cmd_json);
@@ -105,7 +106,8 @@ started_cb (const mongoc_apm_command_started_t *event)
    new_event = BCON_NEW ("command_started_event",
                          "{",
                          "command",
-                         BCON_DOCUMENT (event->command),
+                         BCON_DOCUMENT (
+                            mongoc_apm_command_started_get_command (event)),
                          "command_name",
                          BCON_UTF8 (event->command_name),
                          "database_name",
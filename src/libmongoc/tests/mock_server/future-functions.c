@@ -1190,6 +1190,30 @@ background_mongoc_collection_remove (void *data)
    return NULL;
 }
 
+static void *
+background_mongoc_collection_insert_raw (void *data)
+{
+   future_t *future = (future_t *) data;
+   future_value_t return_value;
+
+   return_value.type = future_value_bool_type;
+
+   future_value_set_bool (
+      &return_value,
+      mongoc_collection_insert_raw (
+         future_value_get_mongoc_collection_ptr (future_get_param (future, 0)),
+         future_value_get_const_uint8_ptr (future_get_param (future, 1)),
+         future_value_get_size_t (future_get_param (future, 2)),
+         future_value_get_const_bson_ptr (future_get_param (future, 3)),
+         future_value_get_bson_ptr (future_get_param (future, 4)),
+         future_value_get_bson_error_ptr (future_get_param (future, 5))
+      ));
+
+   future_resolve (future, return_value);
+
+   return NULL;
+}
+
 static void *
 background_mongoc_collection_update_one (void *data)
 {
@@ -1262,6 +1286,49 @@ background_mongoc_collection_replace_one (void *data)
    return NULL;
 }
 
+static void *
+background_mongoc_prepared_find_execute (void *data)
+{
+   future_t *future = (future_t *) data;
+   future_value_t return_value;
+
+   return_value.type = future_value_mongoc_cursor_ptr_type;
+
+   future_value_set_mongoc_cursor_ptr (
+      &return_value,
+      mongoc_prepared_find_execute (
+         future_value_get_mongoc_prepared_find_ptr (future_get_param (future, 0)),
+         future_value_get_const_bson_ptr (future_get_param (future, 1))
+      ));
+
+   future_resolve (future, return_value);
+
+   return NULL;
+}
+
+static void *
+background_mongoc_prepared_update_execute (void *data)
+{
+   future_t *future = (future_t *) data;
+   future_value_t return_value;
+
+   return_value.type = future_value_bool_type;
+
+   future_value_set_bool (
+      &return_value,
+      mongoc_prepared_update_execute (
+         future_value_get_mongoc_prepared_update_ptr (future_get_param (future, 0)),
+         future_value_get_const_bson_ptr (future_get_param (future, 1)),
+         future_value_get_const_bson_ptr (future_get_param (future, 2)),
+         future_value_get_bson_ptr (future_get_param (future, 3)),
+         future_value_get_bson_error_ptr (future_get_param (future, 4))
+      ));
+
+   future_resolve (future, return_value);
+
+   return NULL;
+}
+
 static void *
 background_mongoc_collection_count_documents (void *data)
 {
@@ -2753,6 +2820,40 @@ future_collection_remove (
    return future;
 }
 
+future_t *
+future_collection_insert_raw (
+   mongoc_collection_ptr collection,
+   const_uint8_ptr data,
+   size_t data_len,
+   const_bson_ptr opts,
+   bson_ptr reply,
+   bson_error_ptr error)
+{
+   future_t *future = future_new (future_value_bool_type,
+                                  6);
+   
+   future_value_set_mongoc_collection_ptr (
+      future_get_param (future, 0), collection);
+   
+   future_value_set_const_uint8_ptr (
+      future_get_param (future, 1), data);
+   
+   future_value_set_size_t (
+      future_get_param (future, 2), data_len);
+   
+   future_value_set_const_bson_ptr (
+      future_get_param (future, 3), opts);
+   
+   future_value_set_bson_ptr (
+      future_get_param (future, 4), reply);
+   
+   future_value_set_bson_error_ptr (
+      future_get_param (future, 5), error);
+   
+   future_start (future, background_mongoc_collection_insert_raw);
+   return future;
+}
+
 future_t *
 future_collection_update_one (
    mongoc_collection_ptr coll,
@@ -2855,6 +2956,54 @@ future_collection_replace_one (
    return future;
 }
 
+future_t *
+future_prepared_find_execute (
+   mongoc_prepared_find_ptr prepared,
+   const_bson_ptr filter)
+{
+   future_t *future = future_new (future_value_mongoc_cursor_ptr_type,
+                                  2);
+   
+   future_value_set_mongoc_prepared_find_ptr (
+      future_get_param (future, 0), prepared);
+   
+   future_value_set_const_bson_ptr (
+      future_get_param (future, 1), filter);
+   
+   future_start (future, background_mongoc_prepared_find_execute);
+   return future;
+}
+
+future_t *
+future_prepared_update_execute (
+   mongoc_prepared_update_ptr prepared,
+   const_bson_ptr selector,
+   const_bson_ptr update,
+   bson_ptr reply,
+   bson_error_ptr error)
+{
+   future_t *future = future_new (future_value_bool_type,
+                                  5);
+   
+   future_value_set_mongoc_prepared_update_ptr (
+      future_get_param (future, 0), prepared);
+   
+   future_value_set_const_bson_ptr (
+      future_get_param (future, 1), selector);
+   
+   future_value_set_const_bson_ptr (
+      future_get_param (future, 2), update);
+   
+   future_value_set_bson_ptr (
+      future_get_param (future, 3), reply);
+   
+   future_value_set_bson_error_ptr (
+      future_get_param (future, 4), error);
+   
+   future_start (future, background_mongoc_prepared_update_execute);
+   return future;
+}
+
 future_t *
 future_collection_count_documents (
    mongoc_collection_ptr coll,
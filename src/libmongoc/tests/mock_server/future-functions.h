@@ -561,6 +561,18 @@ future_collection_remove (
 );
 
 
+future_t *
+future_collection_insert_raw (
+
+   mongoc_collection_ptr collection,
+   const_uint8_ptr data,
+   size_t data_len,
+   const_bson_ptr opts,
+   bson_ptr reply,
+   bson_error_ptr error
+);
+
+
 future_t *
 future_collection_update_one (
 
@@ -597,6 +609,25 @@ future_collection_replace_one (
 );
 
 
+future_t *
+future_prepared_find_execute (
+
+   mongoc_prepared_find_ptr prepared,
+   const_bson_ptr filter
+);
+
+
+future_t *
+future_prepared_update_execute (
+
+   mongoc_prepared_update_ptr prepared,
+   const_bson_ptr selector,
+   const_bson_ptr update,
+   bson_ptr reply,
+   bson_error_ptr error
+);
+
+
 future_t *
 future_collection_count_documents (
 
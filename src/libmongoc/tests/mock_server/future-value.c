@@ -504,6 +504,34 @@ future_value_get_mongoc_change_stream_ptr (future_value_t *future_value)
    return future_value->value.mongoc_change_stream_ptr_value;
 }
 
+void
+future_value_set_mongoc_prepared_find_ptr (future_value_t *future_value, mongoc_prepared_find_ptr value)
+{
+   future_value->type = future_value_mongoc_prepared_find_ptr_type;
+   future_value->value.mongoc_prepared_find_ptr_value = value;
+}
+
+mongoc_prepared_find_ptr
+future_value_get_mongoc_prepared_find_ptr (future_value_t *future_value)
+{
+   BSON_ASSERT (future_value->type == future_value_mongoc_prepared_find_ptr_type);
+   return future_value->value.mongoc_prepared_find_ptr_value;
+}
+
+void
+future_value_set_mongoc_prepared_update_ptr (future_value_t *future_value, mongoc_prepared_update_ptr value)
+{
+   future_value->type = future_value_mongoc_prepared_update_ptr_type;
+   future_value->value.mongoc_prepared_update_ptr_value = value;
+}
+
+mongoc_prepared_update_ptr
+future_value_get_mongoc_prepared_update_ptr (future_value_t *future_value)
+{
+   BSON_ASSERT (future_value->type == future_value_mongoc_prepared_update_ptr_type);
+   return future_value->value.mongoc_prepared_update_ptr_value;
+}
+
 void
 future_value_set_mongoc_remove_flags_t (future_value_t *future_value, mongoc_remove_flags_t value)
 {
@@ -574,3 +602,17 @@ future_value_get_const_mongoc_write_concern_ptr (future_value_t *future_value)
    return future_value->value.const_mongoc_write_concern_ptr_value;
 }
 
+void
+future_value_set_const_uint8_ptr (future_value_t *future_value, const_uint8_ptr value)
+{
+   future_value->type = future_value_const_uint8_ptr_type;
+   future_value->value.const_uint8_ptr_value = value;
+}
+
+const_uint8_ptr
+future_value_get_const_uint8_ptr (future_value_t *future_value)
+{
+   BSON_ASSERT (future_value->type == future_value_const_uint8_ptr_type);
+   return future_value->value.const_uint8_ptr_value;
+}
+
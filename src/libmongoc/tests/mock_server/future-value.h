@@ -45,10 +45,13 @@ typedef mongoc_server_description_t * mongoc_server_description_ptr;
 typedef mongoc_topology_t * mongoc_topology_ptr;
 typedef mongoc_write_concern_t * mongoc_write_concern_ptr;
 typedef mongoc_change_stream_t * mongoc_change_stream_ptr;
+typedef mongoc_prepared_find_t * mongoc_prepared_find_ptr;
+typedef mongoc_prepared_update_t * mongoc_prepared_update_ptr;
 typedef const mongoc_find_and_modify_opts_t * const_mongoc_find_and_modify_opts_ptr;
 typedef const mongoc_iovec_t * const_mongoc_iovec_ptr;
 typedef const mongoc_read_prefs_t * const_mongoc_read_prefs_ptr;
 typedef const mongoc_write_concern_t * const_mongoc_write_concern_ptr;
+typedef const uint8_t * const_uint8_ptr;
 
 typedef enum {
    future_value_no_type = 0,
@@ -86,11 +89,14 @@ typedef enum {
    future_value_mongoc_topology_ptr_type,
    future_value_mongoc_write_concern_ptr_type,
    future_value_mongoc_change_stream_ptr_type,
+   future_value_mongoc_prepared_find_ptr_type,
+   future_value_mongoc_prepared_update_ptr_type,
    future_value_mongoc_remove_flags_t_type,
    future_value_const_mongoc_find_and_modify_opts_ptr_type,
    future_value_const_mongoc_iovec_ptr_type,
    future_value_const_mongoc_read_prefs_ptr_type,
    future_value_const_mongoc_write_concern_ptr_type,
+   future_value_const_uint8_ptr_type,
    future_value_void_type,
 
 } future_value_type_t;
@@ -133,11 +139,14 @@ typedef struct _future_value_t
       mongoc_topology_ptr mongoc_topology_ptr_value;
       mongoc_write_concern_ptr mongoc_write_concern_ptr_value;
       mongoc_change_stream_ptr mongoc_change_stream_ptr_value;
+      mongoc_prepared_find_ptr mongoc_prepared_find_ptr_value;
+      mongoc_prepared_update_ptr mongoc_prepared_update_ptr_value;
       mongoc_remove_flags_t mongoc_remove_flags_t_value;
       const_mongoc_find_and_modify_opts_ptr const_mongoc_find_and_modify_opts_ptr_value;
       const_mongoc_iovec_ptr const_mongoc_iovec_ptr_value;
       const_mongoc_read_prefs_ptr const_mongoc_read_prefs_ptr_value;
       const_mongoc_write_concern_ptr const_mongoc_write_concern_ptr_value;
+      const_uint8_ptr const_uint8_ptr_value;
 
    } value;
 } future_value_t;
@@ -460,6 +469,24 @@ mongoc_change_stream_ptr
 future_value_get_mongoc_change_stream_ptr (
    future_value_t *future_value);
 
+void
+future_value_set_mongoc_prepared_find_ptr(
+   future_value_t *future_value,
+   mongoc_prepared_find_ptr value);
+
+mongoc_prepared_find_ptr
+future_value_get_mongoc_prepared_find_ptr (
+   future_value_t *future_value);
+
+void
+future_value_set_mongoc_prepared_update_ptr(
+   future_value_t *future_value,
+   mongoc_prepared_update_ptr value);
+
+mongoc_prepared_update_ptr
+future_value_get_mongoc_prepared_update_ptr (
+   future_value_t *future_value);
+
 void
 future_value_set_mongoc_remove_flags_t(
    future_value_t *future_value,
@@ -505,6 +532,15 @@ const_mongoc_write_concern_ptr
 future_value_get_const_mongoc_write_concern_ptr (
    future_value_t *future_value);
 
+void
+future_value_set_const_uint8_ptr(
+   future_value_t *future_value,
+   const_uint8_ptr value);
+
+const_uint8_ptr
+future_value_get_const_uint8_ptr (
+   future_value_t *future_value);
+
 
 #ifdef __clang__
 #pragma clang diagnostic pop
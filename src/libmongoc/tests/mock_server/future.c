@@ -433,6 +433,30 @@ future_get_mongoc_change_stream_ptr (future_t *future)
    abort ();
 }
 
+mongoc_prepared_find_ptr
+future_get_mongoc_prepared_find_ptr (future_t *future)
+{
+   if (future_wait (future)) {
+      return future_value_get_mongoc_prepared_find_ptr (&future->return_value);
+   }
+
+   fprintf (stderr, "%s timed out\n", BSON_FUNC);
+   fflush (stderr);
+   abort ();
+}
+
+mongoc_prepared_update_ptr
+future_get_mongoc_prepared_update_ptr (future_t *future)
+{
+   if (future_wait (future)) {
+      return future_value_get_mongoc_prepared_update_ptr (&future->return_value);
+   }
+
+   fprintf (stderr, "%s timed out\n", BSON_FUNC);
+   fflush (stderr);
+   abort ();
+}
+
 mongoc_remove_flags_t
 future_get_mongoc_remove_flags_t (future_t *future)
 {
@@ -493,6 +517,18 @@ future_get_const_mongoc_write_concern_ptr (future_t *future)
    abort ();
 }
 
+const_uint8_ptr
+future_get_const_uint8_ptr (future_t *future)
+{
+   if (future_wait (future)) {
+      return future_value_get_const_uint8_ptr (&future->return_value);
+   }
+
+   fprintf (stderr, "%s timed out\n", BSON_FUNC);
+   fflush (stderr);
+   abort ();
+}
+
 
 future_t *
 future_new (future_value_type_t return_type, int argc)
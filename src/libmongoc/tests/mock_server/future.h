@@ -144,6 +144,12 @@ future_get_mongoc_write_concern_ptr (future_t *future);
 mongoc_change_stream_ptr
 future_get_mongoc_change_stream_ptr (future_t *future);
 
+mongoc_prepared_find_ptr
+future_get_mongoc_prepared_find_ptr (future_t *future);
+
+mongoc_prepared_update_ptr
+future_get_mongoc_prepared_update_ptr (future_t *future);
+
 mongoc_remove_flags_t
 future_get_mongoc_remove_flags_t (future_t *future);
 
@@ -159,6 +165,9 @@ future_get_const_mongoc_read_prefs_ptr (future_t *future);
 const_mongoc_write_concern_ptr
 future_get_const_mongoc_write_concern_ptr (future_t *future);
 
+const_uint8_ptr
+future_get_const_uint8_ptr (future_t *future);
+
 
 void future_destroy (future_t *future);
 
@@ -41,6 +41,7 @@ struct _mock_server_t {
    bool running;
    bool stopped;
    bool rand_delay;
+   bool quiet;
    int64_t request_timeout_msec;
    uint16_t port;
    mongoc_socket_t *sock;
@@ -750,6 +751,47 @@ mock_server_set_rand_delay (mock_server_t *server, bool rand_delay)
 }
 
 
+/*--------------------------------------------------------------------------
+ *
+ * mock_server_get_quiet --
+ *
+ *       Does the server skip logging requests and replies?
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mock_server_get_quiet (mock_server_t *server)
+{
+   bool quiet;
+
+   bson_mutex_lock (&server->mutex);
+   quiet = server->quiet;
+   bson_mutex_unlock (&server->mutex);
+
+   return quiet;
+}
+
+
+/*--------------------------------------------------------------------------
+ *
+ * mock_server_set_quiet --
+ *
+ *       Whether to skip logging requests and replies, and converting them
+ *       to JSON, for a server that autoresponds to a high rate of requests.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+mock_server_set_quiet (mock_server_t *server, bool quiet)
+{
+   bson_mutex_lock (&server->mutex);
+   server->quiet = quiet;
+   bson_mutex_unlock (&server->mutex);
+}
+
+
 /*--------------------------------------------------------------------------
  *
  * mock_server_get_uptime_sec --
@@ -1720,11 +1762,13 @@ again:
       _mongoc_array_copy (&autoresponders, &server->autoresponders);
       bson_mutex_unlock (&server->mutex);
 
-      test_suite_mock_server_log ("%5.2f  %hu -> %hu %s",
-                                  mock_server_get_uptime_sec (server),
-                                  closure->port,
-                                  server->port,
-                                  request->as_str);
+      if (!mock_server_get_quiet (server)) {
+         test_suite_mock_server_log ("%5.2f  %hu -> %hu %s",
+                                     mock_server_get_uptime_sec (server),
+                                     closure->port,
+                                     server->port,
+                                     request->as_str);
+      }
 
       /* run responders most-recently-added-first */
       handled = false;
@@ -1841,24 +1885,27 @@ _mock_server_reply_with_stream (mock_server_t *server,
    int n_docs = reply->n_docs;
    int64_t cursor_id = reply->cursor_id;
 
-   docs_json = bson_string_new ("");
-   for (i = 0; i < n_docs; i++) {
-      doc_json = bson_as_json (&docs[i], NULL);
-      bson_string_append (docs_json, doc_json);
-      bson_free (doc_json);
-      if (i < n_docs - 1) {
-         bson_string_append (docs_json, ", ");
-      }
-   }
-
    is_op_msg = reply->request_opcode == MONGOC_OPCODE_MSG;
 
-   test_suite_mock_server_log ("%5.2f  %hu <- %hu %s %s",
-                               mock_server_get_uptime_sec (server),
-                               reply->client_port,
-                               mock_server_get_port (server),
-                               is_op_msg ? "OP_MSG" : "OP_REPLY",
-                               docs_json->str);
+   if (!mock_server_get_quiet (server)) {
+      docs_json = bson_string_new ("");
+      for (i = 0; i < n_docs; i++) {
+         doc_json = bson_as_json (&docs[i], NULL);
+         bson_string_append (docs_json, doc_json);
+         bson_free (doc_json);
+         if (i < n_docs - 1) {
+            bson_string_append (docs_json, ", ");
+         }
+      }
+
+      test_suite_mock_server_log ("%5.2f  %hu <- %hu %s %s",
+                                  mock_server_get_uptime_sec (server),
+                                  reply->client_port,
+                                  mock_server_get_port (server),
+                                  is_op_msg ? "OP_MSG" : "OP_REPLY",
+                                  docs_json->str);
+      bson_string_free (docs_json, true);
+   }
 
    len = 0;
 
@@ -1917,7 +1964,6 @@ _mock_server_reply_with_stream (mock_server_t *server,
 
    BSON_ASSERT (n_written == expected);
 
-   bson_string_free (docs_json, true);
    _mongoc_array_destroy (&ar);
    bson_free (buf);
 }
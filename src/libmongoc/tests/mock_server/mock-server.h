@@ -106,6 +106,12 @@ mock_server_get_rand_delay (mock_server_t *server);
 void
 mock_server_set_rand_delay (mock_server_t *server, bool rand_delay);
 
+bool
+mock_server_get_quiet (mock_server_t *server);
+
+void
+mock_server_set_quiet (mock_server_t *server, bool quiet);
+
 double
 mock_server_get_uptime_sec (mock_server_t *server);
 
@@ -1058,8 +1058,11 @@ parse_op_msg_doc (request_t *request,
    int32_t doc_len;
    bson_t *doc;
    const uint8_t *pos;
+   bool quiet;
    char *str;
 
+   quiet = mock_server_get_quiet (request->server);
+
    if (len == -1) {
       data_len = length_prefix (data);
    } else {
@@ -1077,9 +1080,13 @@ parse_op_msg_doc (request_t *request,
       BSON_ASSERT (doc);
       _mongoc_array_append_val (&request->docs, doc);
 
-      str = bson_as_json (doc, NULL);
-      bson_string_append (msg_as_str, str);
-      bson_free (str);
+      if (quiet) {
+         bson_string_append (msg_as_str, "{...}");
+      } else {
+         str = bson_as_json (doc, NULL);
+         bson_string_append (msg_as_str, str);
+         bson_free (str);
+      }
 
       pos += doc_len;
    }
@@ -0,0 +1,914 @@
+/*
+ * Copyright 2018-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * mongoc-perf runs the driver benchmarks: BSON encoding and decoding,
+ * single- and multi-document CRUD, bulk inserts, GridFS, parallel imports
+ * and exports, and client pools under load, against a mongod or an
+ * in-process mock server.
+ *
+ * Like the common driver benchmark specification, each benchmark repeats a
+ * task until it has run for a minimum time and a minimum number of
+ * iterations, then reports the median task's throughput. Datasets are
+ * generated rather than read from the specification's files; --scale
+ * shrinks or grows them. Results are printed as JSON, and --compare fails
+ * if any benchmark is slower than in an earlier run's results.
+ */
+
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mongoc-perf.h"
+#include "TestSuite.h"
+#include "test-libmongoc.h"
+
+
+static int
+_cmp_int64 (const void *a, const void *b)
+{
+   int64_t x = *(const int64_t *) a;
+   int64_t y = *(const int64_t *) b;
+
+   return x < y ? -1 : x > y ? 1 : 0;
+}
+
+
+static bool
+_perf_selected (const perf_suite_t *suite, const perf_test_t *test)
+{
+   int i;
+
+   if (!suite->n_filters) {
+      return true;
+   }
+
+   for (i = 0; i < suite->n_filters; i++) {
+      if (strstr (test->name, suite->filters[i]) ||
+          strstr (test->group, suite->filters[i])) {
+         return true;
+      }
+   }
+
+   return false;
+}
+
+
+/* the value at percentile @p of @n sorted times, in seconds */
+static double
+_percentile (const int64_t *times, int n, double p)
+{
+   double pos = (n - 1) * p;
+   int i = (int) pos;
+
+   if (i + 1 >= n) {
+      return times[n - 1] / 1e6;
+   }
+
+   return (times[i] + (pos - i) * (times[i + 1] - times[i])) / 1e6;
+}
+
+
+void
+perf_append_metric (bson_t *metrics,
+                    uint32_t *n,
+                    const char *name,
+                    double value)
+{
+   bson_t metric;
+   char buf[16];
+   const char *key;
+
+   bson_uint32_to_string ((*n)++, &key, buf, sizeof buf);
+   BSON_APPEND_DOCUMENT_BEGIN (metrics, key, &metric);
+   BSON_APPEND_UTF8 (&metric, "name", name);
+   BSON_APPEND_DOUBLE (&metric, "value", value);
+   bson_append_document_end (metrics, &metric);
+}
+
+
+static void
+_perf_record (perf_suite_t *suite,
+              perf_test_t *test,
+              int64_t *times,
+              int n)
+{
+   bson_t result;
+   bson_t info;
+   bson_t args;
+   bson_t metrics;
+   bson_iter_t iter;
+   bson_iter_t result_iter;
+   bson_iter_t metric;
+   uint32_t n_metrics = 0;
+   double median;
+   double mb_per_sec;
+   char buf[16];
+   const char *key;
+
+   qsort (times, (size_t) n, sizeof (int64_t), _cmp_int64);
+   median = _percentile (times, n, 0.5);
+   mb_per_sec = median > 0 ? test->data_size / 1e6 / median : 0;
+
+   bson_uint32_to_string (suite->n_results++, &key, buf, sizeof buf);
+   BSON_APPEND_DOCUMENT_BEGIN (&suite->results, key, &result);
+   BSON_APPEND_DOCUMENT_BEGIN (&result, "info", &info);
+   BSON_APPEND_UTF8 (&info, "test_name", test->name);
+   BSON_APPEND_DOCUMENT_BEGIN (&info, "args", &args);
+   BSON_APPEND_UTF8 (&args, "group", test->group);
+   BSON_APPEND_DOUBLE (&args, "scale", suite->scale);
+   if (!strcmp (test->group, "ParallelBench") ||
+       !strcmp (test->group, "LoadBench")) {
+      BSON_APPEND_INT32 (&args, "threads", suite->n_threads);
+   }
+
+   bson_append_document_end (&info, &args);
+   bson_append_document_end (&result, &info);
+
+   BSON_APPEND_ARRAY_BEGIN (&result, "metrics", &metrics);
+   perf_append_metric (&metrics, &n_metrics, "megabytes_per_sec", mb_per_sec);
+   perf_append_metric (&metrics, &n_metrics, "median_seconds", median);
+   perf_append_metric (
+      &metrics, &n_metrics, "p10_seconds", _percentile (times, n, 0.1));
+   perf_append_metric (
+      &metrics, &n_metrics, "p90_seconds", _percentile (times, n, 0.9));
+   if (test->metrics) {
+      test->metrics (test, &metrics, &n_metrics);
+   }
+
+   bson_append_array_end (&result, &metrics);
+
+   BSON_APPEND_INT32 (&result, "iterations", n);
+   BSON_APPEND_INT64 (&result, "data_size", test->data_size);
+   bson_append_document_end (&suite->results, &result);
+
+   fprintf (stderr,
+            "%-14s %-30s %10.2f MB/s  median %.6f s  (%d iterations)\n",
+            test->group,
+            test->name,
+            mb_per_sec,
+            median,
+            n);
+
+   /* and any others on the next line */
+   if (test->metrics && bson_iter_init_find (&iter, &suite->results, key) &&
+       bson_iter_recurse (&iter, &result_iter) &&
+       bson_iter_find (&result_iter, "metrics") &&
+       bson_iter_recurse (&result_iter, &iter)) {
+      fprintf (stderr, "%-14s", "");
+      while (bson_iter_next (&iter)) {
+         if (atoi (bson_iter_key (&iter)) >= 4 &&
+             bson_iter_recurse (&iter, &metric) &&
+             bson_iter_find (&metric, "name")) {
+            fprintf (stderr, " %s", bson_iter_utf8 (&metric, NULL));
+            if (bson_iter_next (&metric)) {
+               fprintf (stderr, " %.2f", bson_iter_double (&metric));
+            }
+         }
+      }
+
+      fprintf (stderr, "\n");
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * perf_run --
+ *
+ *       Run a benchmark if it matches the command line's filters. Repeats
+ *       the task until it has run for --min-time seconds and at least
+ *       --min-iterations times, or until --max-time seconds or
+ *       --max-iterations have passed, and records its timings. Only the
+ *       task itself is timed.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+perf_run (perf_suite_t *suite, perf_test_t *test)
+{
+   int64_t *times;
+   int64_t total = 0;
+   int64_t started;
+   int64_t t;
+   bool ok = true;
+   int n;
+
+   if (!_perf_selected (suite, test)) {
+      return;
+   }
+
+   if (suite->list) {
+      printf ("%s %s\n", test->group, test->name);
+      return;
+   }
+
+   test->suite = suite;
+   if (test->setup && !test->setup (test)) {
+      ok = false;
+      goto done;
+   }
+
+   times = bson_malloc (suite->max_iterations * sizeof (int64_t));
+   started = bson_get_monotonic_time ();
+
+   for (n = 0; n < suite->max_iterations; n++) {
+      if (n >= suite->min_iterations && total >= suite->min_time * 1e6) {
+         break;
+      }
+
+      if (n > 0 &&
+          bson_get_monotonic_time () - started >= suite->max_time * 1e6) {
+         break;
+      }
+
+      if (test->before_task && !test->before_task (test)) {
+         ok = false;
+         break;
+      }
+
+      t = bson_get_monotonic_time ();
+      if (!test->task (test)) {
+         ok = false;
+         break;
+      }
+
+      times[n] = bson_get_monotonic_time () - t;
+      total += times[n];
+
+      if (test->after_task && !test->after_task (test)) {
+         ok = false;
+         break;
+      }
+   }
+
+   if (ok) {
+      _perf_record (suite, test, times, n);
+   }
+
+   bson_free (times);
+
+done:
+   if (test->teardown) {
+      test->teardown (test);
+   }
+
+   if (!ok) {
+      fprintf (stderr, "%-14s %-30s FAILED\n", test->group, test->name);
+      suite->n_failed++;
+   }
+}
+
+
+/* n, multiplied by --scale, and at least 1 */
+int
+perf_scaled (const perf_suite_t *suite, int n)
+{
+   return BSON_MAX (1, (int) (n * suite->scale));
+}
+
+
+mongoc_client_t *
+perf_client_new (const perf_suite_t *suite)
+{
+   mongoc_client_t *client;
+
+   client = mongoc_client_new_from_uri (suite->uri);
+   BSON_ASSERT (client);
+   mongoc_client_set_error_api (client, MONGOC_ERROR_API_VERSION_2);
+
+   return client;
+}
+
+
+mongoc_client_pool_t *
+perf_pool_new (const perf_suite_t *suite)
+{
+   mongoc_client_pool_t *pool;
+
+   pool = mongoc_client_pool_new (suite->uri);
+   BSON_ASSERT (pool);
+   mongoc_client_pool_set_error_api (pool, MONGOC_ERROR_API_VERSION_2);
+
+   return pool;
+}
+
+
+bool
+perf_drop_database (mongoc_client_t *client)
+{
+   mongoc_database_t *db;
+   bson_error_t error;
+   bool r;
+
+   db = mongoc_client_get_database (client, PERF_DB);
+   r = mongoc_database_drop (db, &error);
+   if (!r) {
+      fprintf (stderr, "failed to drop \"%s\": %s\n", PERF_DB, error.message);
+   }
+
+   mongoc_database_destroy (db);
+
+   return r;
+}
+
+
+/* drop a collection, if it exists, and create it again */
+bool
+perf_reset_collection (mongoc_client_t *client, const char *name)
+{
+   mongoc_database_t *db;
+   mongoc_collection_t *collection;
+   bson_error_t error;
+   bool r = true;
+
+   db = mongoc_client_get_database (client, PERF_DB);
+   collection = mongoc_database_get_collection (db, name);
+   if (!mongoc_collection_drop (collection, &error) &&
+       error.code != MONGOC_ERROR_COLLECTION_DOES_NOT_EXIST) {
+      fprintf (stderr, "failed to drop \"%s\": %s\n", name, error.message);
+      r = false;
+   }
+
+   mongoc_collection_destroy (collection);
+
+   if (r) {
+      collection = mongoc_database_create_collection (db, name, NULL, &error);
+      if (collection) {
+         mongoc_collection_destroy (collection);
+      } else {
+         fprintf (
+            stderr, "failed to create \"%s\": %s\n", name, error.message);
+         r = false;
+      }
+   }
+
+   mongoc_database_destroy (db);
+
+   return r;
+}
+
+
+/* create a directory @name in the work directory, return its path */
+char *
+perf_mkdir (const perf_suite_t *suite, const char *name)
+{
+   char *path;
+
+   path = bson_strdup_printf ("%s/%s", suite->workdir, name);
+   if (mkdir (path, 0755) && errno != EEXIST) {
+      fprintf (stderr, "Failed to create directory \"%s\"\n", path);
+      bson_free (path);
+      return NULL;
+   }
+
+   return path;
+}
+
+
+void
+perf_error (const perf_test_t *test, const char *what, const char *message)
+{
+   fprintf (stderr, "%s: %s: %s\n", test->name, what, message);
+}
+
+
+/* remove the work directory and the files the benchmarks left in it */
+static void
+_perf_remove_tree (const char *path)
+{
+   DIR *dir;
+   struct dirent *entry;
+   struct stat st;
+   char *child;
+
+   dir = opendir (path);
+   if (dir) {
+      while ((entry = readdir (dir))) {
+         if (!strcmp (entry->d_name, ".") || !strcmp (entry->d_name, "..")) {
+            continue;
+         }
+
+         child = bson_strdup_printf ("%s/%s", path, entry->d_name);
+         if (0 == lstat (child, &st) && S_ISDIR (st.st_mode)) {
+            _perf_remove_tree (child);
+         } else {
+            unlink (child);
+         }
+
+         bson_free (child);
+      }
+
+      closedir (dir);
+   }
+
+   rmdir (path);
+}
+
+
+static void
+_perf_composites (perf_suite_t *suite, bson_t *out)
+{
+   const char *groups[] = {
+      "BSONBench", "SingleBench", "MultiBench", "ParallelBench"};
+   bson_iter_t iter;
+   bson_iter_t group;
+   bson_iter_t mb;
+   bson_t composites;
+   bson_t composite;
+   uint32_t n_composites = 0;
+   double sum;
+   int n;
+   size_t i;
+   char buf[16];
+   const char *key;
+
+   BSON_APPEND_ARRAY_BEGIN (out, "composites", &composites);
+
+   for (i = 0; i < sizeof groups / sizeof groups[0]; i++) {
+      sum = 0;
+      n = 0;
+      BSON_ASSERT (bson_iter_init (&iter, &suite->results));
+      while (bson_iter_next (&iter)) {
+         if (bson_iter_recurse (&iter, &group) &&
+             bson_iter_find_descendant (&group, "info.args.group", &group) &&
+             !strcmp (bson_iter_utf8 (&group, NULL), groups[i]) &&
+             bson_iter_recurse (&iter, &mb) &&
+             bson_iter_find_descendant (&mb, "metrics.0.value", &mb)) {
+            sum += bson_iter_double (&mb);
+            n++;
+         }
+      }
+
+      if (!n) {
+         continue;
+      }
+
+      bson_uint32_to_string (n_composites++, &key, buf, sizeof buf);
+      BSON_APPEND_DOCUMENT_BEGIN (&composites, key, &composite);
+      BSON_APPEND_UTF8 (&composite, "name", groups[i]);
+      BSON_APPEND_DOUBLE (&composite, "megabytes_per_sec", sum / n);
+      bson_append_document_end (&composites, &composite);
+   }
+
+   bson_append_array_end (out, &composites);
+}
+
+
+/* find a benchmark's throughput in an earlier run's results */
+static bool
+_perf_find_score (const bson_t *results, const char *name, double *score)
+{
+   bson_iter_t iter;
+   bson_iter_t result;
+   bson_iter_t value;
+
+   if (!bson_iter_init_find (&iter, results, "results") ||
+       !BSON_ITER_HOLDS_ARRAY (&iter) || !bson_iter_recurse (&iter, &iter)) {
+      return false;
+   }
+
+   while (bson_iter_next (&iter)) {
+      if (bson_iter_recurse (&iter, &result) &&
+          bson_iter_find_descendant (&result, "info.test_name", &result) &&
+          BSON_ITER_HOLDS_UTF8 (&result) &&
+          !strcmp (bson_iter_utf8 (&result, NULL), name) &&
+          bson_iter_recurse (&iter, &value) &&
+          bson_iter_find_descendant (&value, "metrics.0.value", &value) &&
+          BSON_ITER_HOLDS_NUMBER (&value)) {
+         *score = bson_iter_as_double (&value);
+         return true;
+      }
+   }
+
+   return false;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _perf_compare --
+ *
+ *       Compare this run's throughput with a results file from an earlier
+ *       run. Returns false if any benchmark in both is more than
+ *       @tolerance percent slower.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_perf_compare (perf_suite_t *suite, const char *path, double tolerance)
+{
+   bson_json_reader_t *reader;
+   bson_t baseline = BSON_INITIALIZER;
+   bson_error_t error;
+   bson_iter_t iter;
+   bson_iter_t name;
+   bson_iter_t value;
+   double before;
+   double after;
+   bool ok = true;
+
+   reader = bson_json_reader_new_from_file (path, &error);
+   if (!reader || bson_json_reader_read (reader, &baseline, &error) != 1) {
+      fprintf (stderr,
+               "Failed to read \"%s\": %s\n",
+               path,
+               reader ? error.message : strerror (errno));
+      bson_json_reader_destroy (reader);
+      bson_destroy (&baseline);
+      return false;
+   }
+
+   BSON_ASSERT (bson_iter_init (&iter, &suite->results));
+   while (bson_iter_next (&iter)) {
+      BSON_ASSERT (bson_iter_recurse (&iter, &name));
+      BSON_ASSERT (bson_iter_find_descendant (&name, "info.test_name", &name));
+      BSON_ASSERT (bson_iter_recurse (&iter, &value));
+      BSON_ASSERT (
+         bson_iter_find_descendant (&value, "metrics.0.value", &value));
+
+      if (!_perf_find_score (
+             &baseline, bson_iter_utf8 (&name, NULL), &before) ||
+          before <= 0) {
+         continue;
+      }
+
+      after = bson_iter_double (&value);
+      if (after < before * (1 - tolerance / 100)) {
+         fprintf (stderr,
+                  "%s is %.1f%% slower: %.2f MB/s, was %.2f MB/s\n",
+                  bson_iter_utf8 (&name, NULL),
+                  100 * (1 - after / before),
+                  after,
+                  before);
+         ok = false;
+      }
+   }
+
+   bson_json_reader_destroy (reader);
+   bson_destroy (&baseline);
+
+   return ok;
+}
+
+
+/* keep stdout for the results */
+static void
+_perf_log_handler (mongoc_log_level_t log_level,
+                   const char *log_domain,
+                   const char *message,
+                   void *user_data)
+{
+   if (log_level < MONGOC_LOG_LEVEL_INFO) {
+      mongoc_log_default_handler (log_level, log_domain, message, user_data);
+   }
+}
+
+
+static void
+usage (FILE *stream)
+{
+   fprintf (stream,
+            "Usage: mongoc-perf [OPTIONS] [FILTER ...]\n"
+            "\n"
+            "Runs the benchmarks whose name or group contains a FILTER, or "
+            "all of them.\n"
+            "\n"
+            "Options:\n"
+            "\n"
+            "  --uri URI             Optional connection string "
+            "[mongodb://localhost:27017].\n"
+            "  --mock                Use an in-process mock server instead "
+            "of --uri.\n"
+            "  --mock-topology TOPO  Optional mock topology: standalone, "
+            "rs:N, or mongos:N\n"
+            "                        [standalone].\n"
+            "  --latency OP=DIST:MS[:JITTER]\n"
+            "                        Optional mock server latency, OP is "
+            "ismaster, find,\n"
+            "                        getMore, insert, other, or all, DIST "
+            "is fixed,\n"
+            "                        uniform, normal, or exponential "
+            "[all=fixed:0].\n"
+            "  --drop-rate FRACTION  Optional fraction of requests the mock "
+            "hangs up on [0].\n"
+            "  --stepdown-interval SECONDS\n"
+            "                        Optional seconds between the mock "
+            "primary's stepdowns\n"
+            "                        [0, never].\n"
+            "  --election-time SECONDS\n"
+            "                        Optional seconds the mock has no "
+            "primary after a\n"
+            "                        stepdown [0].\n"
+            "  --seed N              Optional seed for the mock's random "
+            "numbers [1].\n"
+            "  --output FILE         Optional file for the JSON results "
+            "[stdout].\n"
+            "  --compare FILE        Fail if slower than the results in "
+            "FILE.\n"
+            "  --tolerance PERCENT   Optional slowdown --compare allows "
+            "[10].\n"
+            "  --scale FACTOR        Optional dataset size multiplier [1].\n"
+            "  --min-time SECONDS    Optional minimum time per benchmark "
+            "[1].\n"
+            "  --max-time SECONDS    Optional maximum time per benchmark "
+            "[60].\n"
+            "  --min-iterations N    Optional minimum iterations [5].\n"
+            "  --max-iterations N    Optional maximum iterations [100].\n"
+            "  --threads N           Optional threads for ParallelBench "
+            "and LoadBench [8].\n"
+            "  --workdir DIR         Optional directory for temporary files "
+            "[/tmp].\n"
+            "  --list                List the benchmarks and exit.\n"
+            "\n");
+}
+
+
+static bool
+_parse_double (const char *arg, double *out)
+{
+   char *end;
+
+   *out = strtod (arg, &end);
+   if (*end || *out < 0) {
+      fprintf (stderr, "Invalid number \"%s\"\n", arg);
+      return false;
+   }
+
+   return true;
+}
+
+
+static bool
+_parse_int (const char *arg, int *out)
+{
+   char *end;
+   long l;
+
+   l = strtol (arg, &end, 10);
+   if (*end || l < 1 || l > INT32_MAX) {
+      fprintf (stderr, "Invalid count \"%s\"\n", arg);
+      return false;
+   }
+
+   *out = (int) l;
+   return true;
+}
+
+
+int
+main (int argc, char *argv[])
+{
+   perf_suite_t suite = {0};
+   const char *uri_arg = "mongodb://localhost:27017";
+   const char *output = NULL;
+   const char *compare = NULL;
+   const char *tmpdir = "/tmp";
+   double tolerance = 10;
+   bool mock = false;
+   int seed;
+   bson_error_t error;
+   bson_t out;
+   char *json;
+   FILE *stream;
+   int ret = EXIT_SUCCESS;
+   int i;
+
+   suite.scale = 1;
+   suite.min_time = 1;
+   suite.max_time = 60;
+   suite.min_iterations = 5;
+   suite.max_iterations = 100;
+   suite.n_threads = 8;
+   suite.filters = bson_malloc0 (argc * sizeof (char *));
+   perf_mock_opts_init (&suite.mock_opts);
+
+   for (i = 1; i < argc; i++) {
+      if (0 == strcmp (argv[i], "--help")) {
+         usage (stdout);
+         bson_free (suite.filters);
+         return EXIT_SUCCESS;
+      } else if (0 == strcmp (argv[i], "--uri") && ((i + 1) < argc)) {
+         uri_arg = argv[++i];
+      } else if (0 == strcmp (argv[i], "--mock")) {
+         mock = true;
+      } else if (0 == strcmp (argv[i], "--mock-topology") &&
+                 ((i + 1) < argc)) {
+         if (!perf_mock_parse_topology (&suite.mock_opts, argv[++i])) {
+            return EXIT_FAILURE;
+         }
+      } else if (0 == strcmp (argv[i], "--latency") && ((i + 1) < argc)) {
+         if (!perf_mock_parse_latency (&suite.mock_opts, argv[++i])) {
+            return EXIT_FAILURE;
+         }
+      } else if (0 == strcmp (argv[i], "--drop-rate") && ((i + 1) < argc)) {
+         if (!_parse_double (argv[++i], &suite.mock_opts.drop_rate)) {
+            return EXIT_FAILURE;
+         }
+      } else if (0 == strcmp (argv[i], "--stepdown-interval") &&
+                 ((i + 1) < argc)) {
+         if (!_parse_double (argv[++i], &suite.mock_opts.stepdown_interval)) {
+            return EXIT_FAILURE;
+         }
+      } else if (0 == strcmp (argv[i], "--election-time") &&
+                 ((i + 1) < argc)) {
+         if (!_parse_double (argv[++i], &suite.mock_opts.election_time)) {
+            return EXIT_FAILURE;
+         }
+      } else if (0 == strcmp (argv[i], "--seed") && ((i + 1) < argc)) {
+         if (!_parse_int (argv[++i], &seed)) {
+            return EXIT_FAILURE;
+         }
+
+         suite.mock_opts.seed = (uint32_t) seed;
+      } else if (0 == strcmp (argv[i], "--output") && ((i + 1) < argc)) {
+         output = argv[++i];
+      } else if (0 == strcmp (argv[i], "--compare") && ((i + 1) < argc)) {
+         compare = argv[++i];
+      } else if (0 == strcmp (argv[i], "--tolerance") && ((i + 1) < argc)) {
+         if (!_parse_double (argv[++i], &tolerance)) {
+            return EXIT_FAILURE;
+         }
+      } else if (0 == strcmp (argv[i], "--scale") && ((i + 1) < argc)) {
+         if (!_parse_double (argv[++i], &suite.scale)) {
+            return EXIT_FAILURE;
+         }
+      } else if (0 == strcmp (argv[i], "--min-time") && ((i + 1) < argc)) {
+         if (!_parse_double (argv[++i], &suite.min_time)) {
+            return EXIT_FAILURE;
+         }
+      } else if (0 == strcmp (argv[i], "--max-time") && ((i + 1) < argc)) {
+         if (!_parse_double (argv[++i], &suite.max_time)) {
+            return EXIT_FAILURE;
+         }
+      } else if (0 == strcmp (argv[i], "--min-iterations") &&
+                 ((i + 1) < argc)) {
+         if (!_parse_int (argv[++i], &suite.min_iterations)) {
+            return EXIT_FAILURE;
+         }
+      } else if (0 == strcmp (argv[i], "--max-iterations") &&
+                 ((i + 1) < argc)) {
+         if (!_parse_int (argv[++i], &suite.max_iterations)) {
+            return EXIT_FAILURE;
+         }
+      } else if (0 == strcmp (argv[i], "--threads") && ((i + 1) < argc)) {
+         if (!_parse_int (argv[++i], &suite.n_threads)) {
+            return EXIT_FAILURE;
+         }
+      } else if (0 == strcmp (argv[i], "--workdir") && ((i + 1) < argc)) {
+         tmpdir = argv[++i];
+      } else if (0 == strcmp (argv[i], "--list")) {
+         suite.list = true;
+      } else if (argv[i][0] == '-') {
+         fprintf (stderr, "Unknown argument \"%s\"\n", argv[i]);
+         return EXIT_FAILURE;
+      } else {
+         suite.filters[suite.n_filters++] = argv[i];
+      }
+   }
+
+   if (suite.min_iterations > suite.max_iterations) {
+      fprintf (stderr, "--min-iterations is more than --max-iterations\n");
+      return EXIT_FAILURE;
+   }
+
+   if (suite.mock_opts.drop_rate > 1) {
+      fprintf (stderr, "--drop-rate is more than 1\n");
+      return EXIT_FAILURE;
+   }
+
+   mongoc_init ();
+   mongoc_log_set_handler (_perf_log_handler, NULL);
+
+   if (mock) {
+      suite.mock = perf_mock_new (&suite.mock_opts);
+      suite.uri = mongoc_uri_copy (perf_mock_get_uri (suite.mock));
+   } else {
+      suite.uri = mongoc_uri_new_with_error (uri_arg, &error);
+      if (!suite.uri) {
+         fprintf (stderr,
+                  "failed to parse URI: %s\n"
+                  "error message:       %s\n",
+                  uri_arg,
+                  error.message);
+         return EXIT_FAILURE;
+      }
+   }
+
+   mongoc_uri_set_appname (suite.uri, "mongoc-perf");
+
+   suite.workdir = bson_strdup_printf ("%s/mongoc-perf-XXXXXX", tmpdir);
+   if (!suite.list && !mkdtemp (suite.workdir)) {
+      fprintf (stderr,
+               "Failed to create a directory in \"%s\": %s\n",
+               tmpdir,
+               strerror (errno));
+      return EXIT_FAILURE;
+   }
+
+   bson_init (&suite.results);
+
+   perf_bson_run (&suite);
+   perf_single_run (&suite);
+   perf_multi_run (&suite);
+   perf_parallel_run (&suite);
+   perf_load_run (&suite);
+
+   if (!suite.list) {
+      _perf_remove_tree (suite.workdir);
+
+      bson_init (&out);
+      BSON_APPEND_UTF8 (&out, "driver", "mongoc");
+      BSON_APPEND_UTF8 (&out, "driver_version", MONGOC_VERSION_S);
+      BSON_APPEND_UTF8 (&out, "target", mock ? "mock" : uri_arg);
+      BSON_APPEND_ARRAY (&out, "results", &suite.results);
+      _perf_composites (&suite, &out);
+
+      json = bson_as_relaxed_extended_json (&out, NULL);
+      stream = output ? fopen (output, "w") : stdout;
+      if (stream) {
+         fprintf (stream, "%s\n", json);
+         if (output) {
+            fclose (stream);
+         }
+      } else {
+         fprintf (stderr, "Failed to open \"%s\"\n", output);
+         ret = EXIT_FAILURE;
+      }
+
+      bson_free (json);
+      bson_destroy (&out);
+
+      if (compare && !_perf_compare (&suite, compare, tolerance)) {
+         ret = EXIT_FAILURE;
+      }
+   }
+
+   if (suite.n_failed) {
+      ret = EXIT_FAILURE;
+   }
+
+   bson_destroy (&suite.results);
+   bson_free (suite.workdir);
+   bson_free (suite.filters);
+   mongoc_uri_destroy (suite.uri);
+   if (suite.mock) {
+      perf_mock_destroy (suite.mock);
+   }
+
+   mongoc_cleanup ();
+
+   return ret;
+}
+
+
+/* the mock server reports to the test framework through these */
+
+int64_t
+get_future_timeout_ms (void)
+{
+   return 60 * 1000;
+}
+
+
+void
+test_error (const char *format, ...)
+{
+   va_list ap;
+
+   va_start (ap, format);
+   vfprintf (stderr, format, ap);
+   va_end (ap);
+   fprintf (stderr, "\n");
+   fflush (stderr);
+   abort ();
+}
+
+
+void
+test_suite_mock_server_log (const char *msg, ...)
+{
+   (void) msg;
+}
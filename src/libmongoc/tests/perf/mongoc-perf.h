@@ -0,0 +1,212 @@
+/*
+ * Copyright 2018-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MONGOC_PERF_H
+#define MONGOC_PERF_H
+
+#include <bson/bson.h>
+#include <mongoc/mongoc.h>
+
+BSON_BEGIN_DECLS
+
+/* the database the driver benchmarks use */
+#define PERF_DB "perftest"
+#define PERF_COLLECTION "corpus"
+
+typedef struct _perf_mock_t perf_mock_t;
+typedef struct _perf_test_t perf_test_t;
+
+/* the kinds of requests the mock server can delay differently */
+typedef enum {
+   PERF_MOCK_OP_ISMASTER,
+   PERF_MOCK_OP_FIND,
+   PERF_MOCK_OP_GETMORE,
+   PERF_MOCK_OP_INSERT,
+   PERF_MOCK_OP_OTHER,
+   PERF_MOCK_N_OPS,
+} perf_mock_op_t;
+
+typedef enum {
+   PERF_LATENCY_FIXED,
+   PERF_LATENCY_UNIFORM,
+   PERF_LATENCY_NORMAL,
+   PERF_LATENCY_EXPONENTIAL,
+} perf_latency_dist_t;
+
+/* how long the mock server waits before it replies. a uniform latency is
+ * within jitter_ms of ms, a normal latency has a standard deviation of
+ * jitter_ms, and an exponential latency has a mean of ms */
+typedef struct {
+   perf_latency_dist_t dist;
+   double ms;
+   double jitter_ms;
+} perf_latency_t;
+
+typedef struct {
+   /* the replica set members or mongoses; a standalone if 1 and !mongos */
+   int n_members;
+   bool mongos;
+   perf_latency_t latency[PERF_MOCK_N_OPS];
+   /* the fraction of requests answered by hanging up */
+   double drop_rate;
+   /* seconds between a replica set's stepdowns, 0 for none */
+   double stepdown_interval;
+   /* seconds a replica set has no primary after a stepdown */
+   double election_time;
+   uint32_t seed;
+} perf_mock_opts_t;
+
+typedef struct {
+   int64_t requests;
+   int64_t dropped;
+   int64_t not_master;
+   int64_t stepdowns;
+} perf_mock_stats_t;
+
+typedef struct {
+   mongoc_uri_t *uri;
+   perf_mock_t *mock; /* NULL unless --mock */
+   perf_mock_opts_t mock_opts;
+   char **filters;
+   int n_filters;
+   bool list;
+   double scale;
+   double min_time;
+   double max_time;
+   int min_iterations;
+   int max_iterations;
+   int n_threads;
+   char *workdir; /* created for the parallel benchmarks' files */
+   bson_t results;
+   uint32_t n_results;
+   int n_failed;
+} perf_suite_t;
+
+/* a benchmark. groups of benchmarks embed this as the first member of their
+ * own struct, and pass it to perf_run. each callback but task is optional,
+ * and any returns false to abandon the benchmark. */
+struct _perf_test_t {
+   const char *group;
+   const char *name;
+   perf_suite_t *suite;
+   /* bytes processed by one task, set by setup */
+   int64_t data_size;
+   bool (*setup) (perf_test_t *test);
+   bool (*before_task) (perf_test_t *test);
+   bool (*task) (perf_test_t *test);
+   bool (*after_task) (perf_test_t *test);
+   /* append metrics besides the standard ones with perf_append_metric */
+   void (*metrics) (perf_test_t *test, bson_t *metrics, uint32_t *n);
+   void (*teardown) (perf_test_t *test);
+};
+
+void
+perf_run (perf_suite_t *suite, perf_test_t *test);
+
+void
+perf_append_metric (bson_t *metrics,
+                    uint32_t *n,
+                    const char *name,
+                    double value);
+
+int
+perf_scaled (const perf_suite_t *suite, int n);
+
+mongoc_client_t *
+perf_client_new (const perf_suite_t *suite);
+
+mongoc_client_pool_t *
+perf_pool_new (const perf_suite_t *suite);
+
+bool
+perf_drop_database (mongoc_client_t *client);
+
+bool
+perf_reset_collection (mongoc_client_t *client, const char *name);
+
+char *
+perf_mkdir (const perf_suite_t *suite, const char *name);
+
+void
+perf_error (const perf_test_t *test, const char *what, const char *message);
+
+/* datasets */
+void
+perf_make_flat (bson_t *doc);
+
+void
+perf_make_deep (bson_t *doc);
+
+void
+perf_make_full (bson_t *doc);
+
+void
+perf_make_tweet (bson_t *doc, int32_t seq);
+
+void
+perf_make_small (bson_t *doc);
+
+void
+perf_make_large (bson_t *doc);
+
+void
+perf_fill_bytes (uint8_t *buf, size_t len, uint32_t seed);
+
+/* benchmark groups */
+void
+perf_bson_run (perf_suite_t *suite);
+
+void
+perf_single_run (perf_suite_t *suite);
+
+void
+perf_multi_run (perf_suite_t *suite);
+
+void
+perf_parallel_run (perf_suite_t *suite);
+
+void
+perf_load_run (perf_suite_t *suite);
+
+/* an in-process stand-in for a mongod, a replica set, or mongoses, built on
+ * the test suite's mock server */
+void
+perf_mock_opts_init (perf_mock_opts_t *opts);
+
+bool
+perf_mock_parse_topology (perf_mock_opts_t *opts, const char *spec);
+
+bool
+perf_mock_parse_latency (perf_mock_opts_t *opts, const char *spec);
+
+perf_mock_t *
+perf_mock_new (const perf_mock_opts_t *opts);
+
+const mongoc_uri_t *
+perf_mock_get_uri (perf_mock_t *mock);
+
+void
+perf_mock_step_down (perf_mock_t *mock);
+
+void
+perf_mock_get_stats (perf_mock_t *mock, perf_mock_stats_t *stats);
+
+void
+perf_mock_destroy (perf_mock_t *mock);
+
+BSON_END_DECLS
+
+#endif /* MONGOC_PERF_H */
@@ -0,0 +1,283 @@
+/*
+ * Copyright 2018-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * BSONBench: encoding and decoding the flat, deep, and full documents, and
+ * converting them to Extended JSON and back.
+ *
+ * C has no native document type to encode from, so "encoding" builds a
+ * document from a tree of bson_value_t, as an application appends its own
+ * values, and "decoding" visits every value in a document.
+ */
+
+
+#include "mongoc-perf.h"
+
+
+/* each task encodes or decodes its document this many times */
+#define PERF_BSON_ITERATIONS 10000
+
+/* JSON is slower, a JSON round trip converts its document this many times */
+#define PERF_JSON_ITERATIONS 1000
+
+
+typedef struct _perf_node_t {
+   const char *key;
+   uint32_t key_len;
+   bson_value_t value; /* the type, and the value unless it's a container */
+   struct _perf_node_t *children;
+   uint32_t n_children;
+} perf_node_t;
+
+
+typedef enum {
+   PERF_BSON_ENCODE,
+   PERF_BSON_DECODE,
+   PERF_BSON_JSON,
+} perf_bson_op_t;
+
+
+typedef struct {
+   perf_test_t base;
+   void (*make) (bson_t *doc);
+   perf_bson_op_t op;
+   bson_t doc;
+   perf_node_t root;
+   int n;
+   /* keeps the compiler from skipping the decoded values */
+   volatile uint32_t sink;
+} perf_bson_test_t;
+
+
+static void
+_perf_node_init (perf_node_t *node, bson_iter_t *iter)
+{
+   bson_iter_t child;
+   bson_iter_t count;
+   uint32_t i = 0;
+
+   node->key = bson_iter_key (iter);
+   node->key_len = bson_iter_key_len (iter);
+
+   if (!BSON_ITER_HOLDS_DOCUMENT (iter) && !BSON_ITER_HOLDS_ARRAY (iter)) {
+      /* values borrow from the document, which outlives the tree */
+      memcpy (&node->value, bson_iter_value (iter), sizeof node->value);
+      return;
+   }
+
+   node->value.value_type = bson_iter_type (iter);
+   BSON_ASSERT (bson_iter_recurse (iter, &count));
+   while (bson_iter_next (&count)) {
+      node->n_children++;
+   }
+
+   node->children = bson_malloc0 (node->n_children * sizeof (perf_node_t));
+   BSON_ASSERT (bson_iter_recurse (iter, &child));
+   while (bson_iter_next (&child)) {
+      _perf_node_init (&node->children[i++], &child);
+   }
+}
+
+
+static void
+_perf_node_destroy (perf_node_t *node)
+{
+   uint32_t i;
+
+   for (i = 0; i < node->n_children; i++) {
+      _perf_node_destroy (&node->children[i]);
+   }
+
+   bson_free (node->children);
+}
+
+
+static void
+_perf_encode (bson_t *bson, const perf_node_t *parent)
+{
+   const perf_node_t *node;
+   bson_t child;
+   uint32_t i;
+
+   for (i = 0; i < parent->n_children; i++) {
+      node = &parent->children[i];
+      if (node->value.value_type == BSON_TYPE_DOCUMENT) {
+         bson_append_document_begin (bson, node->key, node->key_len, &child);
+         _perf_encode (&child, node);
+         bson_append_document_end (bson, &child);
+      } else if (node->value.value_type == BSON_TYPE_ARRAY) {
+         bson_append_array_begin (bson, node->key, node->key_len, &child);
+         _perf_encode (&child, node);
+         bson_append_array_end (bson, &child);
+      } else {
+         BSON_ASSERT (
+            bson_append_value (bson, node->key, node->key_len, &node->value));
+      }
+   }
+}
+
+
+static uint32_t
+_perf_decode (bson_iter_t *iter)
+{
+   bson_iter_t child;
+   const bson_value_t *value;
+   uint32_t sum = 0;
+
+   while (bson_iter_next (iter)) {
+      sum += bson_iter_key_len (iter);
+      if (BSON_ITER_HOLDS_DOCUMENT (iter) || BSON_ITER_HOLDS_ARRAY (iter)) {
+         BSON_ASSERT (bson_iter_recurse (iter, &child));
+         sum += _perf_decode (&child);
+      } else {
+         value = bson_iter_value (iter);
+         sum += (uint32_t) value->value_type;
+      }
+   }
+
+   return sum;
+}
+
+
+static bool
+_perf_bson_setup (perf_test_t *test)
+{
+   perf_bson_test_t *bson_test = (perf_bson_test_t *) test;
+   bson_iter_t iter;
+
+   bson_test->make (&bson_test->doc);
+   bson_test->n = perf_scaled (test->suite,
+                               bson_test->op == PERF_BSON_JSON
+                                  ? PERF_JSON_ITERATIONS
+                                  : PERF_BSON_ITERATIONS);
+   test->data_size = (int64_t) bson_test->doc.len * bson_test->n;
+
+   memset (&bson_test->root, 0, sizeof bson_test->root);
+   bson_test->root.value.value_type = BSON_TYPE_DOCUMENT;
+   BSON_ASSERT (bson_iter_init (&iter, &bson_test->doc));
+   while (bson_iter_next (&iter)) {
+      bson_test->root.n_children++;
+   }
+
+   bson_test->root.children =
+      bson_malloc0 (bson_test->root.n_children * sizeof (perf_node_t));
+   BSON_ASSERT (bson_iter_init (&iter, &bson_test->doc));
+   bson_test->root.n_children = 0;
+   while (bson_iter_next (&iter)) {
+      _perf_node_init (&bson_test->root.children[bson_test->root.n_children++],
+                       &iter);
+   }
+
+   return true;
+}
+
+
+static bool
+_perf_bson_task (perf_test_t *test)
+{
+   perf_bson_test_t *bson_test = (perf_bson_test_t *) test;
+   bson_iter_t iter;
+   bson_error_t error;
+   bson_t bson;
+   char *json;
+   size_t len;
+   int i;
+
+   for (i = 0; i < bson_test->n; i++) {
+      switch (bson_test->op) {
+      case PERF_BSON_ENCODE:
+         bson_init (&bson);
+         _perf_encode (&bson, &bson_test->root);
+         bson_test->sink += bson.len;
+         bson_destroy (&bson);
+         break;
+      case PERF_BSON_DECODE:
+         BSON_ASSERT (bson_iter_init (&iter, &bson_test->doc));
+         bson_test->sink += _perf_decode (&iter);
+         break;
+      case PERF_BSON_JSON:
+      default:
+         json = bson_as_canonical_extended_json (&bson_test->doc, &len);
+         if (!bson_init_from_json (&bson, json, (ssize_t) len, &error)) {
+            perf_error (test, "bson_init_from_json", error.message);
+            bson_free (json);
+            return false;
+         }
+
+         bson_test->sink += bson.len;
+         bson_destroy (&bson);
+         bson_free (json);
+         break;
+      }
+   }
+
+   return true;
+}
+
+
+static void
+_perf_bson_teardown (perf_test_t *test)
+{
+   perf_bson_test_t *bson_test = (perf_bson_test_t *) test;
+
+   _perf_node_destroy (&bson_test->root);
+   bson_destroy (&bson_test->doc);
+}
+
+
+static void
+_perf_bson_test (perf_suite_t *suite,
+                 const char *name,
+                 void (*make) (bson_t *doc),
+                 perf_bson_op_t op)
+{
+   perf_bson_test_t test = {{0}};
+
+   test.base.group = "BSONBench";
+   test.base.name = name;
+   test.base.setup = _perf_bson_setup;
+   test.base.task = _perf_bson_task;
+   test.base.teardown = _perf_bson_teardown;
+   test.make = make;
+   test.op = op;
+
+   perf_run (suite, &test.base);
+}
+
+
+void
+perf_bson_run (perf_suite_t *suite)
+{
+   _perf_bson_test (
+      suite, "TestFlatEncoding", perf_make_flat, PERF_BSON_ENCODE);
+   _perf_bson_test (
+      suite, "TestFlatDecoding", perf_make_flat, PERF_BSON_DECODE);
+   _perf_bson_test (
+      suite, "TestDeepEncoding", perf_make_deep, PERF_BSON_ENCODE);
+   _perf_bson_test (
+      suite, "TestDeepDecoding", perf_make_deep, PERF_BSON_DECODE);
+   _perf_bson_test (
+      suite, "TestFullEncoding", perf_make_full, PERF_BSON_ENCODE);
+   _perf_bson_test (
+      suite, "TestFullDecoding", perf_make_full, PERF_BSON_DECODE);
+   _perf_bson_test (
+      suite, "TestFlatJsonRoundTrip", perf_make_flat, PERF_BSON_JSON);
+   _perf_bson_test (
+      suite, "TestDeepJsonRoundTrip", perf_make_deep, PERF_BSON_JSON);
+   _perf_bson_test (
+      suite, "TestFullJsonRoundTrip", perf_make_full, PERF_BSON_JSON);
+}
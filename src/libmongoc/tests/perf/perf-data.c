@@ -0,0 +1,344 @@
+/*
+ * Copyright 2018-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * Datasets shaped like the driver benchmark specification's: the generated
+ * documents have about the same sizes, depths, and mixes of types as its
+ * flat, deep, and full BSON files, its tweet, and its small and large
+ * documents. They are the same on every run.
+ */
+
+
+#include "mongoc-perf.h"
+
+
+/* the flat document has this many fields, about 7.5 KB */
+#define PERF_FLAT_FIELDS 190
+
+/* the deep document nests this deep, about 2 KB */
+#define PERF_DEEP_LEVELS 24
+
+/* the full document repeats each type this many times, about 5.5 KB */
+#define PERF_FULL_ROUNDS 18
+
+/* the large document has this many fields, about 2.7 MB */
+#define PERF_LARGE_FIELDS 24000
+
+
+static uint32_t
+_perf_rand (uint32_t *state)
+{
+   *state = *state * 1103515245u + 12345u;
+   return (*state >> 16) & 0x7fff;
+}
+
+
+static void
+_perf_rand_string (uint32_t *state, char *buf, size_t len)
+{
+   const char chars[] = "abcdefghijklmnopqrstuvwxyz"
+                        "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 ";
+   size_t i;
+
+   for (i = 0; i < len; i++) {
+      buf[i] = chars[_perf_rand (state) % (sizeof chars - 1)];
+   }
+
+   buf[len] = '\0';
+}
+
+
+void
+perf_make_flat (bson_t *doc)
+{
+   uint32_t state = 1;
+   char key[32];
+   char word[8];
+   char str[64];
+   int i;
+
+   bson_init (doc);
+
+   for (i = 0; i < PERF_FLAT_FIELDS; i++) {
+      _perf_rand_string (&state, word, 6);
+      bson_snprintf (key, sizeof key, "%s_%d", word, i);
+
+      switch (i % 6) {
+      case 0:
+      case 1:
+         _perf_rand_string (&state, str, 10 + _perf_rand (&state) % 50);
+         BSON_APPEND_UTF8 (doc, key, str);
+         break;
+      case 2:
+         BSON_APPEND_INT32 (doc, key, (int32_t) _perf_rand (&state));
+         break;
+      case 3:
+         BSON_APPEND_INT64 (
+            doc, key, (int64_t) _perf_rand (&state) * _perf_rand (&state));
+         break;
+      case 4:
+         BSON_APPEND_DOUBLE (doc, key, _perf_rand (&state) / 7.0);
+         break;
+      default:
+         BSON_APPEND_BOOL (doc, key, _perf_rand (&state) % 2);
+         break;
+      }
+   }
+}
+
+
+static void
+_perf_make_deep_level (bson_t *doc, uint32_t *state, int level)
+{
+   bson_t child;
+   char str[32];
+
+   _perf_rand_string (state, str, 20);
+   BSON_APPEND_UTF8 (doc, "ab", str);
+   _perf_rand_string (state, str, 20);
+   BSON_APPEND_UTF8 (doc, "cd", str);
+
+   if (level > 0) {
+      BSON_APPEND_DOCUMENT_BEGIN (doc, "nested", &child);
+      _perf_make_deep_level (&child, state, level - 1);
+      bson_append_document_end (doc, &child);
+   }
+}
+
+
+void
+perf_make_deep (bson_t *doc)
+{
+   uint32_t state = 2;
+
+   bson_init (doc);
+   _perf_make_deep_level (doc, &state, PERF_DEEP_LEVELS);
+}
+
+
+/* each BSON type, except the deprecated ones */
+void
+perf_make_full (bson_t *doc)
+{
+   uint32_t state = 3;
+   bson_decimal128_t dec;
+   bson_oid_t oid;
+   bson_t scope;
+   uint8_t bytes[16];
+   char str[48];
+   char key[32];
+   int i;
+
+   bson_init (doc);
+   BSON_ASSERT (bson_decimal128_from_string ("1234.5678E+90", &dec));
+
+   for (i = 0; i < PERF_FULL_ROUNDS; i++) {
+#define KEY(_name) (bson_snprintf (key, sizeof key, "%s%d", _name, i), key)
+      BSON_APPEND_DOUBLE (doc, KEY ("double"), _perf_rand (&state) / 3.0);
+      _perf_rand_string (&state, str, 32);
+      BSON_APPEND_UTF8 (doc, KEY ("string"), str);
+      BCON_APPEND (doc,
+                   KEY ("document"),
+                   "{",
+                   "a",
+                   BCON_INT32 (i),
+                   "b",
+                   BCON_UTF8 ("hello"),
+                   "}");
+      BCON_APPEND (doc,
+                   KEY ("array"),
+                   "[",
+                   BCON_INT32 (1),
+                   BCON_UTF8 ("two"),
+                   BCON_DOUBLE (3.0),
+                   "]");
+      perf_fill_bytes (bytes, sizeof bytes, (uint32_t) i);
+      BSON_APPEND_BINARY (
+         doc, KEY ("binary"), BSON_SUBTYPE_BINARY, bytes, sizeof bytes);
+      bson_oid_init_from_data (&oid, bytes);
+      BSON_APPEND_OID (doc, KEY ("oid"), &oid);
+      BSON_APPEND_BOOL (doc, KEY ("bool"), i % 2);
+      BSON_APPEND_DATE_TIME (doc, KEY ("date"), 1500000000000LL + i);
+      BSON_APPEND_NULL (doc, KEY ("null"));
+      BSON_APPEND_REGEX (doc, KEY ("regex"), "^ab+c.*$", "i");
+      BSON_APPEND_CODE (doc, KEY ("code"), "function () { return 1; }");
+      bson_init (&scope);
+      BSON_APPEND_INT32 (&scope, "x", i);
+      BSON_APPEND_CODE_WITH_SCOPE (
+         doc, KEY ("code_w_scope"), "function () { return x; }", &scope);
+      bson_destroy (&scope);
+      BSON_APPEND_INT32 (doc, KEY ("int32"), (int32_t) _perf_rand (&state));
+      BSON_APPEND_TIMESTAMP (doc, KEY ("timestamp"), (uint32_t) i, 1);
+      BSON_APPEND_INT64 (doc, KEY ("int64"), INT64_MAX - i);
+      BSON_APPEND_DECIMAL128 (doc, KEY ("decimal"), &dec);
+      BSON_APPEND_MINKEY (doc, KEY ("minkey"));
+      BSON_APPEND_MAXKEY (doc, KEY ("maxkey"));
+#undef KEY
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * perf_make_tweet --
+ *
+ *       Append the fields of a document like the specification's tweet,
+ *       about 1.5 KB, to @doc. @seq is stored in its "id" and "seq" fields.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+perf_make_tweet (bson_t *doc, int32_t seq)
+{
+   uint32_t state = (uint32_t) seq;
+   char text[141];
+   char description[161];
+   char screen_name[16];
+   char name[24];
+
+   _perf_rand_string (&state, text, sizeof text - 1);
+   _perf_rand_string (&state, description, sizeof description - 1);
+   _perf_rand_string (&state, screen_name, sizeof screen_name - 1);
+   _perf_rand_string (&state, name, sizeof name - 1);
+
+   /* clang-format off */
+   BCON_APPEND (
+      doc,
+      "text", BCON_UTF8 (text),
+      "in_reply_to_status_id", BCON_INT64 (22773233453LL),
+      "retweet_count", BCON_NULL,
+      "contributors", BCON_NULL,
+      "created_at", BCON_UTF8 ("Thu Sep 02 19:38:18 +0000 2010"),
+      "geo", BCON_NULL,
+      "source", BCON_UTF8 ("<a href=\"http://twitter.com/\">web</a>"),
+      "coordinates", BCON_NULL,
+      "in_reply_to_screen_name", BCON_UTF8 (screen_name),
+      "truncated", BCON_BOOL (false),
+      "entities", "{",
+         "user_mentions", "[",
+            "{",
+               "indices", "[", BCON_INT32 (0), BCON_INT32 (9), "]",
+               "screen_name", BCON_UTF8 (screen_name),
+               "name", BCON_UTF8 (name),
+               "id", BCON_INT64 (12345678),
+            "}",
+         "]",
+         "urls", "[", "]",
+         "hashtags", "[",
+            "{",
+               "text", BCON_UTF8 ("mongodb"),
+               "indices", "[", BCON_INT32 (10), BCON_INT32 (18), "]",
+            "}",
+         "]",
+      "}",
+      "retweeted", BCON_BOOL (false),
+      "place", BCON_NULL,
+      "user", "{",
+         "friends_count", BCON_INT32 (204),
+         "profile_sidebar_fill_color", BCON_UTF8 ("B8A6C2"),
+         "location", BCON_UTF8 ("Cincinnati, OH"),
+         "verified", BCON_BOOL (false),
+         "follow_request_sent", BCON_NULL,
+         "favourites_count", BCON_INT32 (59),
+         "profile_sidebar_border_color", BCON_UTF8 ("A0A0A0"),
+         "profile_image_url", BCON_UTF8 (
+            "http://a1.twimg.com/profile_images/1131437034/normal.jpg"),
+         "geo_enabled", BCON_BOOL (false),
+         "created_at", BCON_UTF8 ("Thu Nov 20 02:07:34 +0000 2008"),
+         "description", BCON_UTF8 (description),
+         "time_zone", BCON_UTF8 ("Eastern Time (US & Canada)"),
+         "url", BCON_NULL,
+         "screen_name", BCON_UTF8 (screen_name),
+         "notifications", BCON_NULL,
+         "profile_background_color", BCON_UTF8 ("ABB8C2"),
+         "listed_count", BCON_INT32 (54),
+         "lang", BCON_UTF8 ("en"),
+         "statuses_count", BCON_INT32 (4379),
+         "following", BCON_NULL,
+         "profile_text_color", BCON_UTF8 ("333333"),
+         "protected", BCON_BOOL (false),
+         "show_all_inline_media", BCON_BOOL (false),
+         "profile_background_tile", BCON_BOOL (true),
+         "name", BCON_UTF8 (name),
+         "contributors_enabled", BCON_BOOL (false),
+         "profile_link_color", BCON_UTF8 ("0084B4"),
+         "followers_count", BCON_INT32 (403),
+         "id", BCON_INT64 (17294516),
+         "utc_offset", BCON_INT32 (-18000),
+      "}",
+      "favorited", BCON_BOOL (false),
+      "in_reply_to_user_id", BCON_INT64 (12345678),
+      "id", BCON_INT64 (22800000000LL + seq),
+      "seq", BCON_INT32 (seq));
+   /* clang-format on */
+}
+
+
+/* about 275 bytes */
+void
+perf_make_small (bson_t *doc)
+{
+   uint32_t state = 4;
+   char key[16];
+   char str[24];
+   int i;
+
+   bson_init (doc);
+
+   for (i = 0; i < 12; i++) {
+      bson_snprintf (key, sizeof key, "field%d", i);
+      if (i % 2) {
+         BSON_APPEND_INT32 (doc, key, (int32_t) _perf_rand (&state));
+      } else {
+         _perf_rand_string (&state, str, 16);
+         BSON_APPEND_UTF8 (doc, key, str);
+      }
+   }
+}
+
+
+void
+perf_make_large (bson_t *doc)
+{
+   uint32_t state = 5;
+   char key[16];
+   char str[101];
+   int i;
+
+   bson_init (doc);
+
+   for (i = 0; i < PERF_LARGE_FIELDS; i++) {
+      bson_snprintf (key, sizeof key, "f%d", i);
+      _perf_rand_string (&state, str, sizeof str - 1);
+      BSON_APPEND_UTF8 (doc, key, str);
+   }
+}
+
+
+/* bytes to upload with GridFS */
+void
+perf_fill_bytes (uint8_t *buf, size_t len, uint32_t seed)
+{
+   uint32_t state = seed;
+   size_t i;
+
+   for (i = 0; i < len; i++) {
+      buf[i] = (uint8_t) (_perf_rand (&state) & 0xff);
+   }
+}
@@ -0,0 +1,597 @@
+/*
+ * Copyright 2018-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * SingleBench and MultiBench: one client running commands, finding and
+ * inserting documents one at a time and in bulk, and uploading and
+ * downloading a GridFS file.
+ */
+
+
+#include "mongoc-perf.h"
+
+
+/* commands, finds, and small inserts per task */
+#define PERF_SMALL_OPS 10000
+
+/* large documents inserted per task */
+#define PERF_LARGE_OPS 10
+
+/* size of the GridFS file, 50 MB */
+#define PERF_GRIDFS_SIZE (50 * 1000 * 1000)
+
+
+typedef struct _perf_driver_test_t perf_driver_test_t;
+
+struct _perf_driver_test_t {
+   perf_test_t base;
+   mongoc_client_t *client;
+   mongoc_database_t *db;
+   mongoc_collection_t *collection;
+   mongoc_gridfs_bucket_t *bucket;
+   /* the document a task inserts, or the command it runs */
+   bson_t doc;
+   const bson_t **docs;
+   int n;
+   uint8_t *data;
+   size_t data_len;
+   bson_value_t file_id;
+};
+
+
+static bool
+_perf_driver_setup (perf_test_t *test)
+{
+   perf_driver_test_t *driver_test = (perf_driver_test_t *) test;
+
+   driver_test->client = perf_client_new (test->suite);
+   if (!perf_drop_database (driver_test->client)) {
+      return false;
+   }
+
+   driver_test->db = mongoc_client_get_database (driver_test->client, PERF_DB);
+   driver_test->collection =
+      mongoc_database_get_collection (driver_test->db, PERF_COLLECTION);
+
+   return true;
+}
+
+
+static void
+_perf_driver_teardown (perf_test_t *test)
+{
+   perf_driver_test_t *driver_test = (perf_driver_test_t *) test;
+
+   if (driver_test->client) {
+      perf_drop_database (driver_test->client);
+   }
+
+   mongoc_gridfs_bucket_destroy (driver_test->bucket);
+   mongoc_collection_destroy (driver_test->collection);
+   mongoc_database_destroy (driver_test->db);
+   mongoc_client_destroy (driver_test->client);
+   bson_free ((void *) driver_test->docs);
+   bson_free (driver_test->data);
+}
+
+
+/* fill the collection with n tweets with _ids from 1 to n */
+static bool
+_perf_insert_tweets (perf_driver_test_t *driver_test)
+{
+   bson_t **tweets;
+   bson_error_t error;
+   bool r;
+   int i;
+
+   tweets = bson_malloc (driver_test->n * sizeof (bson_t *));
+   for (i = 0; i < driver_test->n; i++) {
+      tweets[i] = bson_new ();
+      BSON_APPEND_INT32 (tweets[i], "_id", i + 1);
+      perf_make_tweet (tweets[i], i + 1);
+   }
+
+   r = mongoc_collection_insert_many (driver_test->collection,
+                                      (const bson_t **) tweets,
+                                      (size_t) driver_test->n,
+                                      NULL,
+                                      NULL,
+                                      &error);
+   if (!r) {
+      perf_error (&driver_test->base, "insert", error.message);
+   }
+
+   for (i = 0; i < driver_test->n; i++) {
+      bson_destroy (tweets[i]);
+   }
+
+   bson_free (tweets);
+
+   return r;
+}
+
+
+/* TestRunCommand */
+
+static bool
+_run_command_setup (perf_test_t *test)
+{
+   perf_driver_test_t *driver_test = (perf_driver_test_t *) test;
+
+   if (!_perf_driver_setup (test)) {
+      return false;
+   }
+
+   bson_init (&driver_test->doc);
+   BSON_APPEND_BOOL (&driver_test->doc, "ismaster", true);
+   driver_test->n = perf_scaled (test->suite, PERF_SMALL_OPS);
+   test->data_size = (int64_t) driver_test->doc.len * driver_test->n;
+
+   return true;
+}
+
+
+static bool
+_run_command_task (perf_test_t *test)
+{
+   perf_driver_test_t *driver_test = (perf_driver_test_t *) test;
+   bson_error_t error;
+   bson_t reply;
+   int i;
+
+   for (i = 0; i < driver_test->n; i++) {
+      if (!mongoc_client_command_simple (driver_test->client,
+                                         "admin",
+                                         &driver_test->doc,
+                                         NULL,
+                                         &reply,
+                                         &error)) {
+         perf_error (test, "ismaster", error.message);
+         bson_destroy (&reply);
+         return false;
+      }
+
+      bson_destroy (&reply);
+   }
+
+   return true;
+}
+
+
+/* TestFindOneByID */
+
+static bool
+_find_one_setup (perf_test_t *test)
+{
+   perf_driver_test_t *driver_test = (perf_driver_test_t *) test;
+
+   if (!_perf_driver_setup (test)) {
+      return false;
+   }
+
+   driver_test->n = perf_scaled (test->suite, PERF_SMALL_OPS);
+   perf_make_tweet (&driver_test->doc, 1);
+   test->data_size = (int64_t) driver_test->doc.len * driver_test->n;
+
+   return _perf_insert_tweets (driver_test);
+}
+
+
+static bool
+_find_one_task (perf_test_t *test)
+{
+   perf_driver_test_t *driver_test = (perf_driver_test_t *) test;
+   mongoc_cursor_t *cursor;
+   const bson_t *doc;
+   bson_error_t error;
+   bson_t filter;
+   bson_t opts = BSON_INITIALIZER;
+   bool found;
+   int i;
+
+   BSON_APPEND_INT32 (&opts, "limit", 1);
+
+   for (i = 0; i < driver_test->n; i++) {
+      bson_init (&filter);
+      BSON_APPEND_INT32 (&filter, "_id", i + 1);
+      cursor = mongoc_collection_find_with_opts (
+         driver_test->collection, &filter, &opts, NULL);
+      found = mongoc_cursor_next (cursor, &doc);
+      if (mongoc_cursor_error (cursor, &error)) {
+         perf_error (test, "find", error.message);
+         found = false;
+      } else if (!found) {
+         perf_error (test, "find", "no document");
+      }
+
+      mongoc_cursor_destroy (cursor);
+      bson_destroy (&filter);
+      if (!found) {
+         bson_destroy (&opts);
+         return false;
+      }
+   }
+
+   bson_destroy (&opts);
+
+   return true;
+}
+
+
+/* TestSmallDocInsertOne, TestLargeDocInsertOne, and the bulk inserts */
+
+static bool
+_insert_setup (perf_test_t *test, void (*make) (bson_t *doc), int n)
+{
+   perf_driver_test_t *driver_test = (perf_driver_test_t *) test;
+   int i;
+
+   if (!_perf_driver_setup (test)) {
+      return false;
+   }
+
+   make (&driver_test->doc);
+   driver_test->n = perf_scaled (test->suite, n);
+   test->data_size = (int64_t) driver_test->doc.len * driver_test->n;
+
+   driver_test->docs = bson_malloc (driver_test->n * sizeof (bson_t *));
+   for (i = 0; i < driver_test->n; i++) {
+      driver_test->docs[i] = &driver_test->doc;
+   }
+
+   return true;
+}
+
+
+static bool
+_small_insert_setup (perf_test_t *test)
+{
+   return _insert_setup (test, perf_make_small, PERF_SMALL_OPS);
+}
+
+
+static bool
+_large_insert_setup (perf_test_t *test)
+{
+   return _insert_setup (test, perf_make_large, PERF_LARGE_OPS);
+}
+
+
+static bool
+_insert_before (perf_test_t *test)
+{
+   perf_driver_test_t *driver_test = (perf_driver_test_t *) test;
+
+   return perf_reset_collection (driver_test->client, PERF_COLLECTION);
+}
+
+
+static bool
+_insert_one_task (perf_test_t *test)
+{
+   perf_driver_test_t *driver_test = (perf_driver_test_t *) test;
+   bson_error_t error;
+   int i;
+
+   for (i = 0; i < driver_test->n; i++) {
+      /* the driver adds an _id to its copy of the document */
+      if (!mongoc_collection_insert_one (driver_test->collection,
+                                         &driver_test->doc,
+                                         NULL,
+                                         NULL,
+                                         &error)) {
+         perf_error (test, "insert", error.message);
+         return false;
+      }
+   }
+
+   return true;
+}
+
+
+static bool
+_bulk_insert_task (perf_test_t *test)
+{
+   perf_driver_test_t *driver_test = (perf_driver_test_t *) test;
+   bson_error_t error;
+
+   if (!mongoc_collection_insert_many (driver_test->collection,
+                                       driver_test->docs,
+                                       (size_t) driver_test->n,
+                                       NULL,
+                                       NULL,
+                                       &error)) {
+      perf_error (test, "insert", error.message);
+      return false;
+   }
+
+   return true;
+}
+
+
+/* TestFindManyAndEmptyCursor */
+
+static bool
+_find_many_setup (perf_test_t *test)
+{
+   perf_driver_test_t *driver_test = (perf_driver_test_t *) test;
+
+   if (!_perf_driver_setup (test)) {
+      return false;
+   }
+
+   driver_test->n = perf_scaled (test->suite, PERF_SMALL_OPS);
+   perf_make_tweet (&driver_test->doc, 1);
+   test->data_size = (int64_t) driver_test->doc.len * driver_test->n;
+
+   return _perf_insert_tweets (driver_test);
+}
+
+
+static bool
+_find_many_task (perf_test_t *test)
+{
+   perf_driver_test_t *driver_test = (perf_driver_test_t *) test;
+   mongoc_cursor_t *cursor;
+   const bson_t *doc;
+   bson_error_t error;
+   bson_t filter = BSON_INITIALIZER;
+   int n = 0;
+
+   cursor = mongoc_collection_find_with_opts (
+      driver_test->collection, &filter, NULL, NULL);
+   while (mongoc_cursor_next (cursor, &doc)) {
+      n++;
+   }
+
+   if (mongoc_cursor_error (cursor, &error)) {
+      perf_error (test, "find", error.message);
+      n = -1;
+   } else if (n != driver_test->n) {
+      perf_error (test, "find", "wrong number of documents");
+      n = -1;
+   }
+
+   mongoc_cursor_destroy (cursor);
+
+   return n >= 0;
+}
+
+
+/* TestGridFsUpload and TestGridFsDownload */
+
+static bool
+_gridfs_setup (perf_test_t *test)
+{
+   perf_driver_test_t *driver_test = (perf_driver_test_t *) test;
+
+   if (!_perf_driver_setup (test)) {
+      return false;
+   }
+
+   driver_test->data_len =
+      (size_t) perf_scaled (test->suite, PERF_GRIDFS_SIZE);
+   driver_test->data = bson_malloc (driver_test->data_len);
+   perf_fill_bytes (driver_test->data, driver_test->data_len, 6);
+   test->data_size = (int64_t) driver_test->data_len;
+
+   driver_test->bucket =
+      mongoc_gridfs_bucket_new (driver_test->db, NULL, NULL);
+
+   return true;
+}
+
+
+static bool
+_gridfs_upload (perf_driver_test_t *driver_test,
+                const uint8_t *data,
+                size_t len)
+{
+   mongoc_stream_t *stream;
+   bson_error_t error;
+   ssize_t n;
+   bool r;
+
+   stream = mongoc_gridfs_bucket_open_upload_stream (
+      driver_test->bucket, "gridfstest", NULL, &driver_test->file_id, &error);
+   if (!stream) {
+      perf_error (&driver_test->base, "upload", error.message);
+      return false;
+   }
+
+   n = mongoc_stream_write (stream, (void *) data, len, 0);
+   r = n == (ssize_t) len && 0 == mongoc_stream_close (stream);
+   if (!r) {
+      mongoc_gridfs_bucket_stream_error (stream, &error);
+      perf_error (&driver_test->base, "upload", error.message);
+   }
+
+   mongoc_stream_destroy (stream);
+
+   return r;
+}
+
+
+static bool
+_gridfs_upload_before (perf_test_t *test)
+{
+   perf_driver_test_t *driver_test = (perf_driver_test_t *) test;
+   const uint8_t one = 1;
+
+   if (!perf_drop_database (driver_test->client)) {
+      return false;
+   }
+
+   /* a new bucket creates indexes before its first upload, do it now */
+   mongoc_gridfs_bucket_destroy (driver_test->bucket);
+   driver_test->bucket =
+      mongoc_gridfs_bucket_new (driver_test->db, NULL, NULL);
+
+   return _gridfs_upload (driver_test, &one, 1);
+}
+
+
+static bool
+_gridfs_upload_task (perf_test_t *test)
+{
+   perf_driver_test_t *driver_test = (perf_driver_test_t *) test;
+
+   return _gridfs_upload (
+      driver_test, driver_test->data, driver_test->data_len);
+}
+
+
+static bool
+_gridfs_download_setup (perf_test_t *test)
+{
+   perf_driver_test_t *driver_test = (perf_driver_test_t *) test;
+
+   return _gridfs_setup (test) &&
+          _gridfs_upload (
+             driver_test, driver_test->data, driver_test->data_len);
+}
+
+
+static bool
+_gridfs_download_task (perf_test_t *test)
+{
+   perf_driver_test_t *driver_test = (perf_driver_test_t *) test;
+   mongoc_stream_t *stream;
+   bson_error_t error;
+   size_t total = 0;
+   ssize_t n;
+
+   stream = mongoc_gridfs_bucket_open_download_stream (
+      driver_test->bucket, &driver_test->file_id, &error);
+   if (!stream) {
+      perf_error (test, "download", error.message);
+      return false;
+   }
+
+   /* read the file over the data it was uploaded from */
+   while ((n = mongoc_stream_read (stream,
+                                   driver_test->data + total,
+                                   driver_test->data_len - total,
+                                   0,
+                                   0)) > 0) {
+      total += (size_t) n;
+      if (total == driver_test->data_len) {
+         break;
+      }
+   }
+
+   if (n < 0 || total != driver_test->data_len) {
+      mongoc_gridfs_bucket_stream_error (stream, &error);
+      perf_error (test, "download", n < 0 ? error.message : "short file");
+      mongoc_stream_destroy (stream);
+      return false;
+   }
+
+   mongoc_stream_destroy (stream);
+
+   return true;
+}
+
+
+static void
+_perf_driver_test (perf_suite_t *suite,
+                   const char *group,
+                   const char *name,
+                   bool (*setup) (perf_test_t *test),
+                   bool (*before_task) (perf_test_t *test),
+                   bool (*task) (perf_test_t *test))
+{
+   perf_driver_test_t test = {{0}};
+
+   test.base.group = group;
+   test.base.name = name;
+   test.base.setup = setup;
+   test.base.before_task = before_task;
+   test.base.task = task;
+   test.base.teardown = _perf_driver_teardown;
+   bson_init (&test.doc);
+
+   perf_run (suite, &test.base);
+
+   bson_destroy (&test.doc);
+}
+
+
+void
+perf_single_run (perf_suite_t *suite)
+{
+   _perf_driver_test (suite,
+                      "SingleBench",
+                      "TestRunCommand",
+                      _run_command_setup,
+                      NULL,
+                      _run_command_task);
+   _perf_driver_test (suite,
+                      "SingleBench",
+                      "TestFindOneByID",
+                      _find_one_setup,
+                      NULL,
+                      _find_one_task);
+   _perf_driver_test (suite,
+                      "SingleBench",
+                      "TestSmallDocInsertOne",
+                      _small_insert_setup,
+                      _insert_before,
+                      _insert_one_task);
+   _perf_driver_test (suite,
+                      "SingleBench",
+                      "TestLargeDocInsertOne",
+                      _large_insert_setup,
+                      _insert_before,
+                      _insert_one_task);
+}
+
+
+void
+perf_multi_run (perf_suite_t *suite)
+{
+   _perf_driver_test (suite,
+                      "MultiBench",
+                      "TestFindManyAndEmptyCursor",
+                      _find_many_setup,
+                      NULL,
+                      _find_many_task);
+   _perf_driver_test (suite,
+                      "MultiBench",
+                      "TestSmallDocBulkInsert",
+                      _small_insert_setup,
+                      _insert_before,
+                      _bulk_insert_task);
+   _perf_driver_test (suite,
+                      "MultiBench",
+                      "TestLargeDocBulkInsert",
+                      _large_insert_setup,
+                      _insert_before,
+                      _bulk_insert_task);
+   _perf_driver_test (suite,
+                      "MultiBench",
+                      "TestGridFsUpload",
+                      _gridfs_setup,
+                      _gridfs_upload_before,
+                      _gridfs_upload_task);
+   _perf_driver_test (suite,
+                      "MultiBench",
+                      "TestGridFsDownload",
+                      _gridfs_download_setup,
+                      NULL,
+                      _gridfs_download_task);
+}
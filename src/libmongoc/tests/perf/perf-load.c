@@ -0,0 +1,432 @@
+/*
+ * Copyright 2018-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * LoadBench: --threads threads sharing a client pool, popping a client for
+ * each operation like an application server does. Besides throughput, each
+ * benchmark reports its operations per second, their latencies, and how many
+ * failed.
+ *
+ * Against the mock server, --latency, --drop-rate, and the other mock
+ * options measure the pool and server selection under those conditions.
+ * TestFailover always runs against its own mock replica set of three, with
+ * those options, and steps down the primary twice in each task: its slowest
+ * operations show how long the driver takes to find the new primary.
+ */
+
+
+#include <pthread.h>
+
+#include "mongoc-perf.h"
+
+
+/* each task runs this many operations */
+#define PERF_LOAD_OPS 10000
+#define PERF_FAILOVER_OPS 2000
+
+/* finds choose among this many documents */
+#define PERF_LOAD_DOCS 1000
+
+/* setup retries, in case the mock server drops requests */
+#define PERF_LOAD_SETUP_ATTEMPTS 10
+
+
+typedef enum {
+   PERF_LOAD_FIND_ONE,
+   PERF_LOAD_INSERT_ONE,
+} perf_load_op_t;
+
+
+typedef struct {
+   perf_test_t base;
+   perf_load_op_t op;
+   bool failover;
+   perf_mock_t *mock; /* TestFailover's replica set */
+   mongoc_client_pool_t *pool;
+   bson_t doc;
+   int n_ops;
+   pthread_mutex_t mutex;
+   int next_op;
+   /* every operation's latency in microseconds, in all tasks */
+   int64_t *latencies;
+   size_t n_latencies;
+   int64_t task_usec;
+   int task_errors;
+   int64_t n_errors;
+   bson_error_t error;
+} perf_load_test_t;
+
+
+/* the next operation's number, or -1 when the task is done */
+static int
+_next_op (perf_load_test_t *test)
+{
+   int op = -1;
+
+   pthread_mutex_lock (&test->mutex);
+   if (test->next_op < test->n_ops) {
+      op = test->next_op++;
+   }
+
+   pthread_mutex_unlock (&test->mutex);
+
+   return op;
+}
+
+
+static bool
+_perf_load_op (perf_load_test_t *test,
+               mongoc_client_t *client,
+               int i,
+               bson_error_t *error)
+{
+   mongoc_collection_t *collection;
+   mongoc_cursor_t *cursor;
+   const bson_t *doc;
+   bson_t filter = BSON_INITIALIZER;
+   bson_t opts = BSON_INITIALIZER;
+   bool r;
+
+   collection = mongoc_client_get_collection (client, PERF_DB, PERF_COLLECTION);
+
+   if (test->op == PERF_LOAD_FIND_ONE) {
+      BSON_APPEND_INT32 (&filter, "_id", i % PERF_LOAD_DOCS);
+      BSON_APPEND_INT32 (&opts, "limit", 1);
+      cursor =
+         mongoc_collection_find_with_opts (collection, &filter, &opts, NULL);
+      r = mongoc_cursor_next (cursor, &doc);
+      if (!r && !mongoc_cursor_error (cursor, error)) {
+         bson_set_error (error, 0, 0, "document %d not found", i);
+      }
+
+      mongoc_cursor_destroy (cursor);
+   } else {
+      r = mongoc_collection_insert_one (
+         collection, &test->doc, NULL, NULL, error);
+   }
+
+   mongoc_collection_destroy (collection);
+   bson_destroy (&opts);
+   bson_destroy (&filter);
+
+   return r;
+}
+
+
+static void *
+_perf_load_worker (void *data)
+{
+   perf_load_test_t *test = (perf_load_test_t *) data;
+   mongoc_client_t *client;
+   bson_error_t error;
+   int64_t t;
+   bool r;
+   int i;
+
+   while ((i = _next_op (test)) >= 0) {
+      if (test->failover && i > 0 &&
+          (i == test->n_ops / 3 || i == 2 * test->n_ops / 3)) {
+         perf_mock_step_down (test->mock);
+      }
+
+      t = bson_get_monotonic_time ();
+      client = mongoc_client_pool_pop (test->pool);
+      r = _perf_load_op (test, client, i, &error);
+      mongoc_client_pool_push (test->pool, client);
+      t = bson_get_monotonic_time () - t;
+
+      pthread_mutex_lock (&test->mutex);
+      test->latencies[test->n_latencies++] = t;
+      if (!r) {
+         test->task_errors++;
+         test->n_errors++;
+         memcpy (&test->error, &error, sizeof error);
+      }
+
+      pthread_mutex_unlock (&test->mutex);
+   }
+
+   return NULL;
+}
+
+
+static bool
+_perf_load_task (perf_test_t *base)
+{
+   perf_load_test_t *test = (perf_load_test_t *) base;
+   pthread_t *threads;
+   int n_threads = base->suite->n_threads;
+   int64_t t;
+   int i;
+
+   test->next_op = 0;
+   test->task_errors = 0;
+
+   t = bson_get_monotonic_time ();
+   threads = bson_malloc (n_threads * sizeof (pthread_t));
+   for (i = 0; i < n_threads; i++) {
+      pthread_create (&threads[i], NULL, _perf_load_worker, test);
+   }
+
+   for (i = 0; i < n_threads; i++) {
+      pthread_join (threads[i], NULL);
+   }
+
+   bson_free (threads);
+   test->task_usec += bson_get_monotonic_time () - t;
+
+   /* some operations may fail against a mock server that drops requests,
+    * but not all */
+   if (test->task_errors == test->n_ops) {
+      perf_error (base, "every operation failed", test->error.message);
+      return false;
+   }
+
+   return true;
+}
+
+
+/* insert the documents to find */
+static bool
+_perf_load_insert_docs (perf_load_test_t *test, mongoc_client_t *client)
+{
+   mongoc_collection_t *collection;
+   mongoc_bulk_operation_t *bulk;
+   bson_error_t error;
+   bson_t doc;
+   bool r;
+   int i;
+
+   if (!perf_reset_collection (client, PERF_COLLECTION)) {
+      return false;
+   }
+
+   collection = mongoc_client_get_collection (client, PERF_DB, PERF_COLLECTION);
+   bulk = mongoc_collection_create_bulk_operation_with_opts (collection, NULL);
+   for (i = 0; i < PERF_LOAD_DOCS; i++) {
+      bson_init (&doc);
+      BSON_APPEND_INT32 (&doc, "_id", i);
+      bson_concat (&doc, &test->doc);
+      mongoc_bulk_operation_insert (bulk, &doc);
+      bson_destroy (&doc);
+   }
+
+   r = mongoc_bulk_operation_execute (bulk, NULL, &error);
+   if (!r) {
+      perf_error (&test->base, "mongoc_bulk_operation_execute", error.message);
+   }
+
+   mongoc_bulk_operation_destroy (bulk);
+   mongoc_collection_destroy (collection);
+
+   return r;
+}
+
+
+static bool
+_perf_load_setup (perf_test_t *base)
+{
+   perf_load_test_t *test = (perf_load_test_t *) base;
+   perf_suite_t *suite = base->suite;
+   perf_mock_opts_t opts;
+   mongoc_uri_t *uri;
+   mongoc_client_t *client;
+   bool r = false;
+   int i;
+
+   if (test->failover) {
+      memcpy (&opts, &suite->mock_opts, sizeof opts);
+      opts.n_members = 3;
+      opts.mongos = false;
+      opts.stepdown_interval = 0;
+      test->mock = perf_mock_new (&opts);
+      uri = mongoc_uri_copy (perf_mock_get_uri (test->mock));
+      mongoc_uri_set_appname (uri, "mongoc-perf");
+      mongoc_uri_set_option_as_bool (uri, MONGOC_URI_RETRYWRITES, true);
+      test->pool = mongoc_client_pool_new (uri);
+      mongoc_client_pool_set_error_api (test->pool, MONGOC_ERROR_API_VERSION_2);
+      mongoc_uri_destroy (uri);
+   } else {
+      test->pool = perf_pool_new (suite);
+   }
+
+   pthread_mutex_init (&test->mutex, NULL);
+   perf_make_small (&test->doc);
+   test->n_ops = perf_scaled (
+      suite, test->failover ? PERF_FAILOVER_OPS : PERF_LOAD_OPS);
+   test->latencies = bson_malloc ((size_t) suite->max_iterations *
+                                  test->n_ops * sizeof (int64_t));
+   base->data_size = (int64_t) test->doc.len * test->n_ops;
+
+   client = mongoc_client_pool_pop (test->pool);
+   for (i = 0; i < PERF_LOAD_SETUP_ATTEMPTS && !r; i++) {
+      if (test->op == PERF_LOAD_FIND_ONE) {
+         r = _perf_load_insert_docs (test, client);
+      } else {
+         r = perf_reset_collection (client, PERF_COLLECTION);
+      }
+   }
+
+   mongoc_client_pool_push (test->pool, client);
+
+   return r;
+}
+
+
+/* start each insert task with an empty collection */
+static bool
+_perf_load_before_task (perf_test_t *base)
+{
+   perf_load_test_t *test = (perf_load_test_t *) base;
+   mongoc_client_t *client;
+   bool r = false;
+   int i;
+
+   if (test->op != PERF_LOAD_INSERT_ONE) {
+      return true;
+   }
+
+   client = mongoc_client_pool_pop (test->pool);
+   for (i = 0; i < PERF_LOAD_SETUP_ATTEMPTS && !r; i++) {
+      r = perf_reset_collection (client, PERF_COLLECTION);
+   }
+
+   mongoc_client_pool_push (test->pool, client);
+
+   return r;
+}
+
+
+static int
+_cmp_int64 (const void *a, const void *b)
+{
+   int64_t x = *(const int64_t *) a;
+   int64_t y = *(const int64_t *) b;
+
+   return x < y ? -1 : x > y ? 1 : 0;
+}
+
+
+static int64_t
+_stat (const bson_t *pool_stats, const char *path)
+{
+   bson_iter_t iter;
+
+   BSON_ASSERT (bson_iter_init (&iter, pool_stats) &&
+                bson_iter_find_descendant (&iter, path, &iter));
+
+   return bson_iter_as_int64 (&iter);
+}
+
+
+static void
+_perf_load_metrics (perf_test_t *base, bson_t *metrics, uint32_t *n)
+{
+   perf_load_test_t *test = (perf_load_test_t *) base;
+   perf_mock_stats_t stats;
+   bson_t pool_stats;
+   size_t len = test->n_latencies;
+
+   if (!len) {
+      return;
+   }
+
+   qsort (test->latencies, len, sizeof (int64_t), _cmp_int64);
+   perf_append_metric (
+      metrics, n, "ops_per_sec", len / (test->task_usec / 1e6));
+   perf_append_metric (
+      metrics, n, "op_median_ms", test->latencies[len / 2] / 1e3);
+   perf_append_metric (metrics,
+                       n,
+                       "op_p99_ms",
+                       test->latencies[(size_t) (len * 0.99)] / 1e3);
+   perf_append_metric (metrics, n, "op_max_ms", test->latencies[len - 1] / 1e3);
+   perf_append_metric (metrics, n, "errors", (double) test->n_errors);
+
+   /* with a maxPoolSize below --threads, how long threads wait for clients */
+   mongoc_client_pool_get_stats (test->pool, &pool_stats);
+   perf_append_metric (
+      metrics, n, "pool_waits", (double) _stat (&pool_stats, "waits.count"));
+   perf_append_metric (metrics,
+                       n,
+                       "pool_wait_p99_ms",
+                       _stat (&pool_stats, "waits.p99Micros") / 1e3);
+   bson_destroy (&pool_stats);
+
+   if (test->mock) {
+      perf_mock_get_stats (test->mock, &stats);
+      perf_append_metric (metrics, n, "stepdowns", (double) stats.stepdowns);
+      perf_append_metric (
+         metrics, n, "not_master_replies", (double) stats.not_master);
+   }
+}
+
+
+static void
+_perf_load_teardown (perf_test_t *base)
+{
+   perf_load_test_t *test = (perf_load_test_t *) base;
+   mongoc_client_t *client;
+
+   if (test->pool) {
+      client = mongoc_client_pool_pop (test->pool);
+      perf_drop_database (client);
+      mongoc_client_pool_push (test->pool, client);
+      mongoc_client_pool_destroy (test->pool);
+   }
+
+   if (test->mock) {
+      perf_mock_destroy (test->mock);
+   }
+
+   if (test->latencies) {
+      pthread_mutex_destroy (&test->mutex);
+      bson_destroy (&test->doc);
+      bson_free (test->latencies);
+   }
+}
+
+
+static void
+_perf_load_test (perf_suite_t *suite,
+                 const char *name,
+                 perf_load_op_t op,
+                 bool failover)
+{
+   perf_load_test_t test = {{0}};
+
+   test.base.group = "LoadBench";
+   test.base.name = name;
+   test.base.setup = _perf_load_setup;
+   test.base.before_task = _perf_load_before_task;
+   test.base.task = _perf_load_task;
+   test.base.metrics = _perf_load_metrics;
+   test.base.teardown = _perf_load_teardown;
+   test.op = op;
+   test.failover = failover;
+
+   perf_run (suite, &test.base);
+}
+
+
+void
+perf_load_run (perf_suite_t *suite)
+{
+   _perf_load_test (suite, "TestPoolFindOne", PERF_LOAD_FIND_ONE, false);
+   _perf_load_test (suite, "TestPoolInsertOne", PERF_LOAD_INSERT_ONE, false);
+   _perf_load_test (suite, "TestFailover", PERF_LOAD_INSERT_ONE, true);
+}
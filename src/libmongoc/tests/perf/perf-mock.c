@@ -0,0 +1,1038 @@
+/*
+ * Copyright 2018-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * A stand-in for a mongod, a replica set, or mongoses: the test suite's mock
+ * servers, with an autoresponder that keeps collections in memory. It
+ * implements just enough for the benchmarks: insert, find with equality
+ * filters, getMore, killCursors, and dropping collections and databases.
+ * Other commands reply {ok: 1}, and list commands reply with an empty
+ * cursor. Each connection is served by its own thread.
+ *
+ * To measure the driver under realistic conditions, it can delay each kind
+ * of reply by a fixed or random latency, hang up on a fraction of requests,
+ * and step down a replica set's primary, on demand or at an interval. Its
+ * random numbers come from a seed, so runs are reproducible.
+ */
+
+
+#include <math.h>
+#include <pthread.h>
+#include <strings.h>
+
+#include "mongoc/mongoc-array-private.h"
+#include "mongoc/mongoc-client-private.h"
+#include "mongoc/mongoc-util-private.h"
+#include "mock_server/mock-server.h"
+
+#include "mongoc-perf.h"
+
+
+/* the most a batch of a cursor holds, like mongod */
+#define PERF_MOCK_BATCH_BYTES (16 * 1024 * 1024)
+
+/* the number of documents in a first batch, unless the find sets batchSize */
+#define PERF_MOCK_FIRST_BATCH 101
+
+#define PERF_MOCK_SET_NAME "rs"
+
+#define PERF_TWO_PI 6.283185307179586
+
+
+typedef struct {
+   char *ns;
+   mongoc_array_t docs; /* bson_t pointers */
+} perf_mock_collection_t;
+
+
+typedef struct {
+   int64_t id;
+   char *ns;
+   /* the rest of the results, borrowed from the collection */
+   bson_t **docs;
+   size_t n_docs;
+   size_t pos;
+} perf_mock_cursor_t;
+
+
+typedef struct {
+   perf_mock_t *mock;
+   int i;
+   mock_server_t *server;
+} perf_mock_member_t;
+
+
+struct _perf_mock_t {
+   perf_mock_opts_t opts;
+   perf_mock_member_t *members;
+   mongoc_uri_t *uri;
+   pthread_mutex_t mutex;
+   mongoc_array_t collections; /* perf_mock_collection_t pointers */
+   mongoc_array_t cursors;     /* perf_mock_cursor_t pointers */
+   int64_t next_cursor_id;
+   uint32_t rand_state;
+   /* the replica set's primary, or -1 during an election */
+   int primary;
+   int next_primary;
+   int64_t election_ends;
+   int64_t next_stepdown;
+   uint32_t election_id;
+   perf_mock_stats_t stats;
+};
+
+
+static perf_mock_collection_t *
+_find_collection (perf_mock_t *mock, const char *ns, bool create)
+{
+   perf_mock_collection_t *collection;
+   size_t i;
+
+   for (i = 0; i < mock->collections.len; i++) {
+      collection =
+         _mongoc_array_index (&mock->collections, perf_mock_collection_t *, i);
+      if (!strcmp (collection->ns, ns)) {
+         return collection;
+      }
+   }
+
+   if (!create) {
+      return NULL;
+   }
+
+   collection = bson_malloc0 (sizeof *collection);
+   collection->ns = bson_strdup (ns);
+   _mongoc_array_init (&collection->docs, sizeof (bson_t *));
+   _mongoc_array_append_val (&mock->collections, collection);
+
+   return collection;
+}
+
+
+static void
+_cursor_destroy (perf_mock_cursor_t *cursor)
+{
+   bson_free (cursor->ns);
+   bson_free (cursor->docs);
+   bson_free (cursor);
+}
+
+
+/* remove a cursor, or every cursor on @ns if @id is 0 */
+static void
+_remove_cursors (perf_mock_t *mock, int64_t id, const char *ns)
+{
+   perf_mock_cursor_t *cursor;
+   size_t i = 0;
+
+   while (i < mock->cursors.len) {
+      cursor = _mongoc_array_index (&mock->cursors, perf_mock_cursor_t *, i);
+      if (id ? cursor->id == id : !strcmp (cursor->ns, ns)) {
+         _cursor_destroy (cursor);
+         mock->cursors.len--;
+         _mongoc_array_index (&mock->cursors, perf_mock_cursor_t *, i) =
+            _mongoc_array_index (
+               &mock->cursors, perf_mock_cursor_t *, mock->cursors.len);
+      } else {
+         i++;
+      }
+   }
+}
+
+
+static void
+_drop_collection (perf_mock_t *mock, perf_mock_collection_t *collection)
+{
+   size_t i;
+
+   _remove_cursors (mock, 0, collection->ns);
+
+   for (i = 0; i < collection->docs.len; i++) {
+      bson_destroy (_mongoc_array_index (&collection->docs, bson_t *, i));
+   }
+
+   _mongoc_array_destroy (&collection->docs);
+   bson_free (collection->ns);
+   bson_free (collection);
+}
+
+
+/* drop the collection @ns, or each whose namespace starts with @ns */
+static void
+_drop_collections (perf_mock_t *mock, const char *ns, bool prefix)
+{
+   perf_mock_collection_t *collection;
+   bool match;
+   size_t i = 0;
+
+   while (i < mock->collections.len) {
+      collection =
+         _mongoc_array_index (&mock->collections, perf_mock_collection_t *, i);
+      match = prefix ? !strncmp (collection->ns, ns, strlen (ns))
+                     : !strcmp (collection->ns, ns);
+      if (match) {
+         _drop_collection (mock, collection);
+         mock->collections.len--;
+         _mongoc_array_index (
+            &mock->collections, perf_mock_collection_t *, i) =
+            _mongoc_array_index (&mock->collections,
+                                 perf_mock_collection_t *,
+                                 mock->collections.len);
+      } else {
+         i++;
+      }
+   }
+}
+
+
+static bool
+_is_number (const bson_value_t *value, double *number)
+{
+   if (value->value_type == BSON_TYPE_INT32) {
+      *number = value->value.v_int32;
+   } else if (value->value_type == BSON_TYPE_INT64) {
+      *number = (double) value->value.v_int64;
+   } else if (value->value_type == BSON_TYPE_DOUBLE) {
+      *number = value->value.v_double;
+   } else {
+      return false;
+   }
+
+   return true;
+}
+
+
+static bool
+_values_equal (const bson_value_t *a, const bson_value_t *b)
+{
+   double x;
+   double y;
+
+   if (_is_number (a, &x) && _is_number (b, &y)) {
+      return x == y;
+   }
+
+   if (a->value_type != b->value_type) {
+      return false;
+   }
+
+   if (a->value_type == BSON_TYPE_UTF8) {
+      return a->value.v_utf8.len == b->value.v_utf8.len &&
+             !memcmp (a->value.v_utf8.str,
+                      b->value.v_utf8.str,
+                      a->value.v_utf8.len);
+   } else if (a->value_type == BSON_TYPE_OID) {
+      return bson_oid_equal (&a->value.v_oid, &b->value.v_oid);
+   } else if (a->value_type == BSON_TYPE_BOOL) {
+      return a->value.v_bool == b->value.v_bool;
+   } else if (a->value_type == BSON_TYPE_DATE_TIME) {
+      return a->value.v_datetime == b->value.v_datetime;
+   } else if (a->value_type == BSON_TYPE_NULL) {
+      return true;
+   } else if (a->value_type == BSON_TYPE_DOCUMENT ||
+              a->value_type == BSON_TYPE_ARRAY) {
+      return a->value.v_doc.data_len == b->value.v_doc.data_len &&
+             !memcmp (a->value.v_doc.data,
+                      b->value.v_doc.data,
+                      a->value.v_doc.data_len);
+   }
+
+   return false;
+}
+
+
+/* equality on top-level fields only, like {_id: 1} or {files_id: id} */
+static bool
+_matches (const bson_t *doc, const bson_t *filter)
+{
+   bson_iter_t iter;
+   bson_iter_t field;
+
+   BSON_ASSERT (bson_iter_init (&iter, filter));
+   while (bson_iter_next (&iter)) {
+      if (!bson_iter_init_find (&field, doc, bson_iter_key (&iter)) ||
+          !_values_equal (bson_iter_value (&field), bson_iter_value (&iter))) {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+
+/* append a batch of a cursor's results to @reply, and forget the cursor if
+ * it's exhausted */
+static void
+_append_batch (perf_mock_t *mock,
+               perf_mock_cursor_t *cursor,
+               const char *field,
+               int64_t batch_size,
+               bson_t *reply)
+{
+   bson_t cursor_doc;
+   bson_t batch;
+   const bson_t *doc;
+   size_t bytes = 0;
+   int64_t n = 0;
+   char buf[16];
+   const char *key;
+
+   BSON_APPEND_DOCUMENT_BEGIN (reply, "cursor", &cursor_doc);
+   BSON_APPEND_ARRAY_BEGIN (&cursor_doc, field, &batch);
+
+   while (cursor->pos < cursor->n_docs && (!batch_size || n < batch_size)) {
+      doc = cursor->docs[cursor->pos];
+      if (n > 0 && bytes + doc->len > PERF_MOCK_BATCH_BYTES) {
+         break;
+      }
+
+      bson_uint32_to_string ((uint32_t) n, &key, buf, sizeof buf);
+      BSON_APPEND_DOCUMENT (&batch, key, doc);
+      bytes += doc->len;
+      cursor->pos++;
+      n++;
+   }
+
+   bson_append_array_end (&cursor_doc, &batch);
+   BSON_APPEND_UTF8 (&cursor_doc, "ns", cursor->ns);
+
+   if (cursor->pos < cursor->n_docs) {
+      if (!cursor->id) {
+         cursor->id = mock->next_cursor_id++;
+         _mongoc_array_append_val (&mock->cursors, cursor);
+      }
+
+      BSON_APPEND_INT64 (&cursor_doc, "id", cursor->id);
+   } else {
+      if (cursor->id) {
+         _remove_cursors (mock, cursor->id, NULL);
+      } else {
+         _cursor_destroy (cursor);
+      }
+
+      BSON_APPEND_INT64 (&cursor_doc, "id", 0);
+   }
+
+   bson_append_document_end (reply, &cursor_doc);
+}
+
+
+static int64_t
+_get_int64 (const bson_t *cmd, const char *field)
+{
+   bson_iter_t iter;
+
+   if (bson_iter_init_find (&iter, cmd, field) &&
+       BSON_ITER_HOLDS_NUMBER (&iter)) {
+      return bson_iter_as_int64 (&iter);
+   }
+
+   return 0;
+}
+
+
+static void
+_insert (perf_mock_t *mock,
+         request_t *request,
+         const bson_t *cmd,
+         const char *ns,
+         bson_t *reply)
+{
+   perf_mock_collection_t *collection;
+   bson_iter_t iter;
+   bson_iter_t docs;
+   bson_t *doc;
+   uint32_t len;
+   const uint8_t *data;
+   int32_t n = 0;
+   int i;
+
+   collection = _find_collection (mock, ns, true);
+
+   /* documents in an OP_MSG document sequence, after the command */
+   for (i = 1; i < (int) request->docs.len; i++) {
+      doc = bson_copy (request_get_doc (request, i));
+      _mongoc_array_append_val (&collection->docs, doc);
+      n++;
+   }
+
+   /* or in the command itself */
+   if (bson_iter_init_find (&iter, cmd, "documents") &&
+       BSON_ITER_HOLDS_ARRAY (&iter) && bson_iter_recurse (&iter, &docs)) {
+      while (bson_iter_next (&docs)) {
+         bson_iter_document (&docs, &len, &data);
+         doc = bson_new_from_data (data, len);
+         _mongoc_array_append_val (&collection->docs, doc);
+         n++;
+      }
+   }
+
+   BSON_APPEND_INT32 (reply, "n", n);
+   BSON_APPEND_INT32 (reply, "ok", 1);
+}
+
+
+static void
+_find (perf_mock_t *mock, const bson_t *cmd, const char *ns, bson_t *reply)
+{
+   perf_mock_collection_t *collection;
+   perf_mock_cursor_t *cursor;
+   bson_iter_t iter;
+   bson_t filter;
+   bson_t *doc;
+   uint32_t len;
+   const uint8_t *data;
+   int64_t limit;
+   int64_t batch_size;
+   size_t i;
+
+   if (bson_iter_init_find (&iter, cmd, "filter") &&
+       BSON_ITER_HOLDS_DOCUMENT (&iter)) {
+      bson_iter_document (&iter, &len, &data);
+      BSON_ASSERT (bson_init_static (&filter, data, len));
+   } else {
+      bson_init (&filter);
+   }
+
+   if (bson_iter_init (&iter, &filter) && bson_iter_next (&iter) &&
+       bson_iter_key (&iter)[0] == '$') {
+      BSON_APPEND_INT32 (reply, "ok", 0);
+      BSON_APPEND_UTF8 (reply, "errmsg", "the mock supports equality only");
+      return;
+   }
+
+   limit = BSON_ABS (_get_int64 (cmd, "limit"));
+   batch_size = _get_int64 (cmd, "batchSize");
+   if (!batch_size) {
+      batch_size = PERF_MOCK_FIRST_BATCH;
+   }
+
+   collection = _find_collection (mock, ns, false);
+   cursor = bson_malloc0 (sizeof *cursor);
+   cursor->ns = bson_strdup (ns);
+   if (collection) {
+      cursor->docs = bson_malloc (collection->docs.len * sizeof (bson_t *));
+      for (i = 0; i < collection->docs.len; i++) {
+         if (limit && cursor->n_docs == (size_t) limit) {
+            break;
+         }
+
+         doc = _mongoc_array_index (&collection->docs, bson_t *, i);
+         if (_matches (doc, &filter)) {
+            cursor->docs[cursor->n_docs++] = doc;
+         }
+      }
+   }
+
+   _append_batch (mock,
+                  cursor,
+                  "firstBatch",
+                  limit ? BSON_MIN (limit, batch_size) : batch_size,
+                  reply);
+   BSON_APPEND_INT32 (reply, "ok", 1);
+}
+
+
+static void
+_get_more (perf_mock_t *mock, const bson_t *cmd, bson_t *reply)
+{
+   perf_mock_cursor_t *cursor;
+   int64_t id;
+   size_t i;
+
+   id = _get_int64 (cmd, "getMore");
+   for (i = 0; i < mock->cursors.len; i++) {
+      cursor = _mongoc_array_index (&mock->cursors, perf_mock_cursor_t *, i);
+      if (cursor->id == id) {
+         _append_batch (
+            mock, cursor, "nextBatch", _get_int64 (cmd, "batchSize"), reply);
+         BSON_APPEND_INT32 (reply, "ok", 1);
+         return;
+      }
+   }
+
+   BSON_APPEND_INT32 (reply, "ok", 0);
+   BSON_APPEND_INT32 (reply, "code", 43);
+   BSON_APPEND_UTF8 (reply, "errmsg", "cursor not found");
+}
+
+
+static void
+_kill_cursors (perf_mock_t *mock, const bson_t *cmd, bson_t *reply)
+{
+   bson_iter_t iter;
+   bson_iter_t ids;
+
+   if (bson_iter_init_find (&iter, cmd, "cursors") &&
+       BSON_ITER_HOLDS_ARRAY (&iter) && bson_iter_recurse (&iter, &ids)) {
+      while (bson_iter_next (&ids)) {
+         _remove_cursors (mock, bson_iter_as_int64 (&ids), NULL);
+      }
+   }
+
+   BSON_APPEND_INT32 (reply, "ok", 1);
+}
+
+
+/* a number from 0 up to 1. call with the mutex locked */
+static double
+_perf_mock_rand (perf_mock_t *mock)
+{
+   mock->rand_state = mock->rand_state * 1664525u + 1013904223u;
+   return (mock->rand_state >> 8) / 16777216.0;
+}
+
+
+static int64_t
+_latency_usec (perf_mock_t *mock, perf_mock_op_t op)
+{
+   const perf_latency_t *latency = &mock->opts.latency[op];
+   double ms;
+   double u;
+
+   switch (latency->dist) {
+   case PERF_LATENCY_UNIFORM:
+      ms = latency->ms + (2 * _perf_mock_rand (mock) - 1) * latency->jitter_ms;
+      break;
+   case PERF_LATENCY_NORMAL:
+      /* Box-Muller */
+      u = 1 - _perf_mock_rand (mock);
+      ms = latency->ms + latency->jitter_ms * sqrt (-2 * log (u)) *
+                            cos (PERF_TWO_PI * _perf_mock_rand (mock));
+      break;
+   case PERF_LATENCY_EXPONENTIAL:
+      ms = -latency->ms * log (1 - _perf_mock_rand (mock));
+      break;
+   case PERF_LATENCY_FIXED:
+   default:
+      ms = latency->ms;
+      break;
+   }
+
+   return ms > 0 ? (int64_t) (ms * 1000) : 0;
+}
+
+
+static perf_mock_op_t
+_op_type (const char *name)
+{
+   if (!strcasecmp (name, "ismaster")) {
+      return PERF_MOCK_OP_ISMASTER;
+   } else if (!strcmp (name, "find")) {
+      return PERF_MOCK_OP_FIND;
+   } else if (!strcmp (name, "getMore")) {
+      return PERF_MOCK_OP_GETMORE;
+   } else if (!strcmp (name, "insert")) {
+      return PERF_MOCK_OP_INSERT;
+   }
+
+   return PERF_MOCK_OP_OTHER;
+}
+
+
+static bool
+_is_replica_set (const perf_mock_t *mock)
+{
+   return !mock->opts.mongos && mock->opts.n_members > 1;
+}
+
+
+/* call with the mutex locked */
+static void
+_step_down (perf_mock_t *mock, int64_t now)
+{
+   if (!_is_replica_set (mock) || mock->primary < 0) {
+      return;
+   }
+
+   mock->next_primary = (mock->primary + 1) % mock->opts.n_members;
+   mock->primary = -1;
+   mock->election_ends = now + (int64_t) (mock->opts.election_time * 1e6);
+   mock->next_stepdown =
+      now + (int64_t) (mock->opts.stepdown_interval * 1e6);
+   mock->stats.stepdowns++;
+}
+
+
+/* the replica set's primary, or -1 during an election, after any election
+ * or stepdown that is due. call with the mutex locked */
+static int
+_primary (perf_mock_t *mock, int64_t now)
+{
+   if (mock->primary < 0 && now >= mock->election_ends) {
+      mock->primary = mock->next_primary;
+      mock->election_id++;
+   }
+
+   if (mock->opts.stepdown_interval > 0 && now >= mock->next_stepdown) {
+      _step_down (mock, now);
+   }
+
+   return mock->primary;
+}
+
+
+static void
+_ismaster (perf_mock_member_t *member, int64_t now, bson_t *reply)
+{
+   perf_mock_t *mock = member->mock;
+   bson_t hosts;
+   bson_oid_t election_id;
+   uint8_t bytes[12] = {0};
+   char buf[16];
+   const char *key;
+   int primary;
+   int i;
+
+   if (mock->opts.mongos) {
+      BSON_APPEND_BOOL (reply, "ismaster", true);
+      BSON_APPEND_UTF8 (reply, "msg", "isdbgrid");
+   } else if (_is_replica_set (mock)) {
+      primary = _primary (mock, now);
+      BSON_APPEND_BOOL (reply, "ismaster", member->i == primary);
+      BSON_APPEND_BOOL (reply, "secondary", member->i != primary);
+      BSON_APPEND_UTF8 (reply, "setName", PERF_MOCK_SET_NAME);
+      BSON_APPEND_INT32 (reply, "setVersion", 1);
+      BSON_APPEND_ARRAY_BEGIN (reply, "hosts", &hosts);
+      for (i = 0; i < mock->opts.n_members; i++) {
+         bson_uint32_to_string ((uint32_t) i, &key, buf, sizeof buf);
+         BSON_APPEND_UTF8 (
+            &hosts,
+            key,
+            mock_server_get_host_and_port (mock->members[i].server));
+      }
+
+      bson_append_array_end (reply, &hosts);
+      BSON_APPEND_UTF8 (
+         reply, "me", mock_server_get_host_and_port (member->server));
+
+      if (primary >= 0) {
+         BSON_APPEND_UTF8 (
+            reply,
+            "primary",
+            mock_server_get_host_and_port (mock->members[primary].server));
+      }
+
+      if (member->i == primary) {
+         /* later elections have greater ids */
+         bytes[8] = (uint8_t) (mock->election_id >> 24);
+         bytes[9] = (uint8_t) (mock->election_id >> 16);
+         bytes[10] = (uint8_t) (mock->election_id >> 8);
+         bytes[11] = (uint8_t) mock->election_id;
+         bson_oid_init_from_data (&election_id, bytes);
+         BSON_APPEND_OID (reply, "electionId", &election_id);
+      }
+   } else {
+      BSON_APPEND_BOOL (reply, "ismaster", true);
+   }
+
+   BSON_APPEND_INT32 (reply, "minWireVersion", 0);
+   BSON_APPEND_INT32 (reply, "maxWireVersion", WIRE_VERSION_MAX);
+   BSON_APPEND_INT32 (reply, "maxBsonObjectSize", 16777216);
+   BSON_APPEND_INT32 (reply, "maxMessageSizeBytes", 48000000);
+   BSON_APPEND_INT32 (reply, "maxWriteBatchSize", 100000);
+   BSON_APPEND_INT32 (reply, "logicalSessionTimeoutMinutes", 30);
+   BSON_APPEND_DOUBLE (reply, "ok", 1.0);
+}
+
+
+/* does a replica set member that isn't primary refuse the command? */
+static bool
+_needs_primary (const char *name, const bson_t *cmd)
+{
+   bson_iter_t iter;
+   bson_iter_t mode;
+
+   if (!strcmp (name, "getMore") || !strcmp (name, "killCursors") ||
+       !strcmp (name, "endSessions") || !strcmp (name, "ping") ||
+       !strcasecmp (name, "buildinfo")) {
+      return false;
+   }
+
+   if (!strcmp (name, "find") &&
+       bson_iter_init_find (&iter, cmd, "$readPreference") &&
+       BSON_ITER_HOLDS_DOCUMENT (&iter) && bson_iter_recurse (&iter, &mode) &&
+       bson_iter_find (&mode, "mode") && BSON_ITER_HOLDS_UTF8 (&mode) &&
+       strcmp (bson_iter_utf8 (&mode, NULL), "primary")) {
+      return false;
+   }
+
+   return true;
+}
+
+
+/* call with the mutex locked */
+static void
+_run_command (perf_mock_t *mock,
+              request_t *request,
+              const char *name,
+              const bson_t *cmd,
+              bson_t *reply)
+{
+   const char *db;
+   bson_iter_t iter;
+   bson_t cursor;
+   bson_t batch;
+   char *ns = NULL;
+
+   db = bson_iter_init_find (&iter, cmd, "$db") && BSON_ITER_HOLDS_UTF8 (&iter)
+           ? bson_iter_utf8 (&iter, NULL)
+           : "admin";
+
+   /* the first field names the collection, in most commands */
+   if (bson_iter_init (&iter, cmd) && bson_iter_next (&iter) &&
+       BSON_ITER_HOLDS_UTF8 (&iter)) {
+      ns = bson_strdup_printf ("%s.%s", db, bson_iter_utf8 (&iter, NULL));
+   } else if (bson_iter_init_find (&iter, cmd, "collection") &&
+              BSON_ITER_HOLDS_UTF8 (&iter)) {
+      ns = bson_strdup_printf ("%s.%s", db, bson_iter_utf8 (&iter, NULL));
+   }
+
+   if (!strcmp (name, "insert") && ns) {
+      _insert (mock, request, cmd, ns, reply);
+   } else if (!strcmp (name, "find") && ns) {
+      _find (mock, cmd, ns, reply);
+   } else if (!strcmp (name, "getMore")) {
+      _get_more (mock, cmd, reply);
+   } else if (!strcmp (name, "killCursors")) {
+      _kill_cursors (mock, cmd, reply);
+   } else if (!strcmp (name, "drop") && ns) {
+      _drop_collections (mock, ns, false);
+      BSON_APPEND_INT32 (reply, "ok", 1);
+   } else if (!strcmp (name, "dropDatabase")) {
+      bson_free (ns);
+      ns = bson_strdup_printf ("%s.", db);
+      _drop_collections (mock, ns, true);
+      BSON_APPEND_INT32 (reply, "ok", 1);
+   } else if (!strncmp (name, "list", 4)) {
+      BSON_APPEND_DOCUMENT_BEGIN (reply, "cursor", &cursor);
+      BSON_APPEND_INT64 (&cursor, "id", 0);
+      bson_free (ns);
+      ns = bson_strdup_printf ("%s.$cmd.%s", db, name);
+      BSON_APPEND_UTF8 (&cursor, "ns", ns);
+      BSON_APPEND_ARRAY_BEGIN (&cursor, "firstBatch", &batch);
+      bson_append_array_end (&cursor, &batch);
+      bson_append_document_end (reply, &cursor);
+      BSON_APPEND_INT32 (reply, "ok", 1);
+   } else {
+      BSON_APPEND_INT32 (reply, "ok", 1);
+   }
+
+   bson_free (ns);
+}
+
+
+static bool
+_perf_mock_respond (request_t *request, void *data)
+{
+   perf_mock_member_t *member = (perf_mock_member_t *) data;
+   perf_mock_t *mock = member->mock;
+   const char *name;
+   perf_mock_op_t op;
+   bson_t reply = BSON_INITIALIZER;
+   int64_t now;
+   int64_t delay;
+   bool drop;
+
+   /* legacy opcodes only for the handshake */
+   name = request->command_name;
+   if (!request->is_command || !name) {
+      return false;
+   }
+
+   if (request->opcode != MONGOC_OPCODE_MSG && strcasecmp (name, "ismaster")) {
+      return false;
+   }
+
+   op = _op_type (name);
+
+   pthread_mutex_lock (&mock->mutex);
+   now = bson_get_monotonic_time ();
+   mock->stats.requests++;
+   delay = _latency_usec (mock, op);
+   drop = mock->opts.drop_rate > 0 &&
+          _perf_mock_rand (mock) < mock->opts.drop_rate;
+
+   if (drop) {
+      mock->stats.dropped++;
+   } else if (op == PERF_MOCK_OP_ISMASTER) {
+      _ismaster (member, now, &reply);
+   } else if (_is_replica_set (mock) && member->i != _primary (mock, now) &&
+              _needs_primary (name, request_get_doc (request, 0))) {
+      BSON_APPEND_INT32 (&reply, "ok", 0);
+      BSON_APPEND_INT32 (&reply, "code", 10107);
+      BSON_APPEND_UTF8 (&reply, "errmsg", "not master");
+      mock->stats.not_master++;
+   } else {
+      _run_command (mock, request, name, request_get_doc (request, 0), &reply);
+   }
+
+   pthread_mutex_unlock (&mock->mutex);
+
+   /* wait outside the lock, other connections' threads go on */
+   if (delay) {
+      _mongoc_usleep (delay);
+   }
+
+   if (drop) {
+      mock_server_hangs_up (request);
+   } else {
+      mock_server_reply_multi (request, MONGOC_REPLY_NONE, &reply, 1, 0);
+   }
+
+   bson_destroy (&reply);
+   request_destroy (request);
+
+   return true;
+}
+
+
+/* no latency, drops, or stepdowns, for a standalone */
+void
+perf_mock_opts_init (perf_mock_opts_t *opts)
+{
+   memset (opts, 0, sizeof *opts);
+   opts->n_members = 1;
+   opts->seed = 1;
+}
+
+
+/* "standalone", "rs:N" for a replica set of N members, or "mongos:N" */
+bool
+perf_mock_parse_topology (perf_mock_opts_t *opts, const char *spec)
+{
+   char *end;
+   long n = 1;
+
+   if (!strcmp (spec, "standalone")) {
+      opts->mongos = false;
+   } else if (!strncmp (spec, "rs:", 3)) {
+      opts->mongos = false;
+      n = strtol (spec + 3, &end, 10);
+      if (*end || n < 2) {
+         n = 0;
+      }
+   } else if (!strncmp (spec, "mongos:", 7)) {
+      opts->mongos = true;
+      n = strtol (spec + 7, &end, 10);
+      if (*end) {
+         n = 0;
+      }
+   } else {
+      n = 0;
+   }
+
+   if (n < 1 || n > 50) {
+      fprintf (stderr, "Invalid topology \"%s\"\n", spec);
+      return false;
+   }
+
+   opts->n_members = (int) n;
+   return true;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * perf_mock_parse_latency --
+ *
+ *       Parse a latency like "find=normal:2:0.5", in milliseconds. Before
+ *       the "=" is "ismaster", "find", "getMore", "insert", "other", or
+ *       "all", after it is "fixed:MS", "uniform:MS:JITTER",
+ *       "normal:MS:STDDEV", or "exponential:MEAN".
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+perf_mock_parse_latency (perf_mock_opts_t *opts, const char *spec)
+{
+   const char *ops[] = {"ismaster", "find", "getMore", "insert", "other"};
+   const char *dists[] = {"fixed", "uniform", "normal", "exponential"};
+   perf_latency_t latency = {PERF_LATENCY_FIXED};
+   const char *eq;
+   const char *colon;
+   char *end;
+   size_t len;
+   int op = -1;
+   int i;
+
+   eq = strchr (spec, '=');
+   colon = eq ? strchr (eq, ':') : NULL;
+   if (!colon) {
+      goto fail;
+   }
+
+   len = (size_t) (eq - spec);
+   for (i = 0; i < PERF_MOCK_N_OPS; i++) {
+      if (strlen (ops[i]) == len && !strncmp (spec, ops[i], len)) {
+         op = i;
+      }
+   }
+
+   if (op < 0 && !(len == 3 && !strncmp (spec, "all", 3))) {
+      goto fail;
+   }
+
+   len = (size_t) (colon - eq - 1);
+   for (i = 0; i < (int) (sizeof dists / sizeof dists[0]); i++) {
+      if (strlen (dists[i]) == len && !strncmp (eq + 1, dists[i], len)) {
+         latency.dist = (perf_latency_dist_t) i;
+         break;
+      }
+   }
+
+   if (i == (int) (sizeof dists / sizeof dists[0])) {
+      goto fail;
+   }
+
+   latency.ms = strtod (colon + 1, &end);
+   if (*end == ':' && (latency.dist == PERF_LATENCY_UNIFORM ||
+                       latency.dist == PERF_LATENCY_NORMAL)) {
+      latency.jitter_ms = strtod (end + 1, &end);
+   }
+
+   if (*end || latency.ms < 0 || latency.jitter_ms < 0) {
+      goto fail;
+   }
+
+   for (i = 0; i < PERF_MOCK_N_OPS; i++) {
+      if (op < 0 || op == i) {
+         opts->latency[i] = latency;
+      }
+   }
+
+   return true;
+
+fail:
+   fprintf (stderr, "Invalid latency \"%s\"\n", spec);
+   return false;
+}
+
+
+perf_mock_t *
+perf_mock_new (const perf_mock_opts_t *opts)
+{
+   perf_mock_t *mock;
+   bson_string_t *uri_str;
+   int i;
+
+   mock = bson_malloc0 (sizeof *mock);
+   if (opts) {
+      memcpy (&mock->opts, opts, sizeof *opts);
+   } else {
+      perf_mock_opts_init (&mock->opts);
+   }
+
+   pthread_mutex_init (&mock->mutex, NULL);
+   _mongoc_array_init (&mock->collections, sizeof (perf_mock_collection_t *));
+   _mongoc_array_init (&mock->cursors, sizeof (perf_mock_cursor_t *));
+   mock->next_cursor_id = 1;
+   mock->rand_state = mock->opts.seed;
+   mock->election_id = 1;
+   mock->next_stepdown = bson_get_monotonic_time () +
+                         (int64_t) (mock->opts.stepdown_interval * 1e6);
+
+   mock->members =
+      bson_malloc0 (mock->opts.n_members * sizeof (perf_mock_member_t));
+   uri_str = bson_string_new ("mongodb://");
+
+   for (i = 0; i < mock->opts.n_members; i++) {
+      mock->members[i].mock = mock;
+      mock->members[i].i = i;
+      mock->members[i].server = mock_server_new ();
+      mock_server_set_quiet (mock->members[i].server, true);
+      mock_server_autoresponds (
+         mock->members[i].server, _perf_mock_respond, &mock->members[i], NULL);
+      mock_server_run (mock->members[i].server);
+      bson_string_append_printf (
+         uri_str,
+         "%s%s",
+         i ? "," : "",
+         mock_server_get_host_and_port (mock->members[i].server));
+   }
+
+   bson_string_append (uri_str, "/");
+   if (_is_replica_set (mock)) {
+      bson_string_append (uri_str, "?replicaSet=" PERF_MOCK_SET_NAME);
+   }
+
+   mock->uri = mongoc_uri_new (uri_str->str);
+   BSON_ASSERT (mock->uri);
+   bson_string_free (uri_str, true);
+
+   return mock;
+}
+
+
+const mongoc_uri_t *
+perf_mock_get_uri (perf_mock_t *mock)
+{
+   return mock->uri;
+}
+
+
+/* step down a replica set's primary now, the next member is elected after
+ * the election time */
+void
+perf_mock_step_down (perf_mock_t *mock)
+{
+   int64_t now;
+
+   pthread_mutex_lock (&mock->mutex);
+   now = bson_get_monotonic_time ();
+   if (_primary (mock, now) >= 0) {
+      _step_down (mock, now);
+   }
+
+   pthread_mutex_unlock (&mock->mutex);
+}
+
+
+void
+perf_mock_get_stats (perf_mock_t *mock, perf_mock_stats_t *stats)
+{
+   pthread_mutex_lock (&mock->mutex);
+   memcpy (stats, &mock->stats, sizeof *stats);
+   pthread_mutex_unlock (&mock->mutex);
+}
+
+
+void
+perf_mock_destroy (perf_mock_t *mock)
+{
+   size_t i;
+   int j;
+
+   for (j = 0; j < mock->opts.n_members; j++) {
+      mock_server_destroy (mock->members[j].server);
+   }
+
+   _drop_collections (mock, "", true);
+
+   for (i = 0; i < mock->cursors.len; i++) {
+      _cursor_destroy (
+         _mongoc_array_index (&mock->cursors, perf_mock_cursor_t *, i));
+   }
+
+   _mongoc_array_destroy (&mock->cursors);
+   _mongoc_array_destroy (&mock->collections);
+   mongoc_uri_destroy (mock->uri);
+   bson_free (mock->members);
+   pthread_mutex_destroy (&mock->mutex);
+   bson_free (mock);
+}
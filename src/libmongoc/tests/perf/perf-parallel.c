@@ -0,0 +1,605 @@
+/*
+ * Copyright 2018-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * ParallelBench: --threads threads sharing a client pool import and export
+ * files of line-delimited JSON, and upload and download files with GridFS.
+ * Each thread takes the next file until all are done.
+ */
+
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+
+#include "mongoc-perf.h"
+
+
+/* files of line-delimited JSON, of this many tweets each */
+#define PERF_LDJSON_FILES 100
+#define PERF_LDJSON_DOCS 5000
+
+/* files uploaded to GridFS, of 5 MB each */
+#define PERF_GRIDFS_FILES 50
+#define PERF_GRIDFS_FILE_SIZE (5 * 1000 * 1000)
+
+
+typedef struct _perf_parallel_test_t perf_parallel_test_t;
+
+struct _perf_parallel_test_t {
+   perf_test_t base;
+   mongoc_client_pool_t *pool;
+   int n_files;
+   char *in_dir;
+   char *out_dir;
+   bson_value_t *file_ids; /* each file's GridFS id */
+   /* process one file with a client from the pool */
+   bool (*work) (perf_parallel_test_t *test, mongoc_client_t *client, int i);
+   pthread_mutex_t mutex;
+   int next_file;
+   bool failed;
+};
+
+
+static char *
+_perf_path (const char *dir, int i, const char *ext)
+{
+   return bson_strdup_printf ("%s/%03d.%s", dir, i, ext);
+}
+
+
+static void *
+_perf_worker (void *data)
+{
+   perf_parallel_test_t *test = (perf_parallel_test_t *) data;
+   mongoc_client_t *client;
+   int i;
+
+   client = mongoc_client_pool_pop (test->pool);
+
+   for (;;) {
+      pthread_mutex_lock (&test->mutex);
+      i = test->failed ? test->n_files : test->next_file++;
+      pthread_mutex_unlock (&test->mutex);
+
+      if (i >= test->n_files) {
+         break;
+      }
+
+      if (!test->work (test, client, i)) {
+         pthread_mutex_lock (&test->mutex);
+         test->failed = true;
+         pthread_mutex_unlock (&test->mutex);
+      }
+   }
+
+   mongoc_client_pool_push (test->pool, client);
+
+   return NULL;
+}
+
+
+/* process every file with --threads threads */
+static bool
+_perf_parallel_task (perf_test_t *base)
+{
+   perf_parallel_test_t *test = (perf_parallel_test_t *) base;
+   pthread_t *threads;
+   int n_threads = base->suite->n_threads;
+   int i;
+
+   test->next_file = 0;
+   test->failed = false;
+
+   threads = bson_malloc (n_threads * sizeof (pthread_t));
+   for (i = 0; i < n_threads; i++) {
+      pthread_create (&threads[i], NULL, _perf_worker, test);
+   }
+
+   for (i = 0; i < n_threads; i++) {
+      pthread_join (threads[i], NULL);
+   }
+
+   bson_free (threads);
+
+   return !test->failed;
+}
+
+
+static bool
+_perf_parallel_setup (perf_parallel_test_t *test,
+                      const char *in_dir,
+                      const char *out_dir)
+{
+   mongoc_client_t *client;
+   bool r;
+
+   test->pool = perf_pool_new (test->base.suite);
+   client = mongoc_client_pool_pop (test->pool);
+   r = perf_drop_database (client);
+   mongoc_client_pool_push (test->pool, client);
+
+   test->in_dir = perf_mkdir (test->base.suite, in_dir);
+   if (out_dir) {
+      test->out_dir = perf_mkdir (test->base.suite, out_dir);
+   }
+
+   return r && test->in_dir && (!out_dir || test->out_dir);
+}
+
+
+static void
+_perf_parallel_teardown (perf_test_t *base)
+{
+   perf_parallel_test_t *test = (perf_parallel_test_t *) base;
+   mongoc_client_t *client;
+   int i;
+
+   if (test->pool) {
+      client = mongoc_client_pool_pop (test->pool);
+      perf_drop_database (client);
+      mongoc_client_pool_push (test->pool, client);
+      mongoc_client_pool_destroy (test->pool);
+   }
+
+   if (test->file_ids) {
+      for (i = 0; i < test->n_files; i++) {
+         bson_value_destroy (&test->file_ids[i]);
+      }
+   }
+
+   bson_free (test->file_ids);
+   bson_free (test->in_dir);
+   bson_free (test->out_dir);
+}
+
+
+/* TestJsonMultiImport and TestJsonMultiExport */
+
+/* write the line-delimited JSON files, unless an earlier benchmark did */
+static bool
+_ldjson_setup (perf_parallel_test_t *test)
+{
+   char *path;
+   char *json;
+   FILE *stream;
+   bson_t tweet;
+   size_t len;
+   int docs_per_file;
+   int i;
+   int j;
+
+   if (!_perf_parallel_setup (test, "ldjson", "ldjson-out")) {
+      return false;
+   }
+
+   test->n_files = PERF_LDJSON_FILES;
+   docs_per_file = perf_scaled (test->base.suite, PERF_LDJSON_DOCS);
+   test->base.data_size = 0;
+
+   for (i = 0; i < test->n_files; i++) {
+      path = _perf_path (test->in_dir, i, "json");
+      stream = fopen (path, "r");
+      if (stream) {
+         fseek (stream, 0, SEEK_END);
+         test->base.data_size += ftell (stream);
+         fclose (stream);
+         bson_free (path);
+         continue;
+      }
+
+      stream = fopen (path, "w");
+      if (!stream) {
+         perf_error (&test->base, "failed to open", path);
+         bson_free (path);
+         return false;
+      }
+
+      for (j = 0; j < docs_per_file; j++) {
+         bson_init (&tweet);
+         BSON_APPEND_INT32 (&tweet, "file", i);
+         perf_make_tweet (&tweet, i * docs_per_file + j);
+         json = bson_as_relaxed_extended_json (&tweet, &len);
+         fprintf (stream, "%s\n", json);
+         test->base.data_size += (int64_t) len + 1;
+         bson_free (json);
+         bson_destroy (&tweet);
+      }
+
+      fclose (stream);
+      bson_free (path);
+   }
+
+   return true;
+}
+
+
+static bool
+_import_work (perf_parallel_test_t *test, mongoc_client_t *client, int i)
+{
+   mongoc_collection_t *collection;
+   mongoc_bulk_operation_t *bulk;
+   bson_json_reader_t *reader;
+   bson_error_t error;
+   bson_t doc = BSON_INITIALIZER;
+   bson_t opts = BSON_INITIALIZER;
+   char *path;
+   int r;
+
+   path = _perf_path (test->in_dir, i, "json");
+   reader = bson_json_reader_new_from_file (path, &error);
+   bson_free (path);
+   if (!reader) {
+      perf_error (&test->base, "import", error.message);
+      return false;
+   }
+
+   collection = mongoc_client_get_collection (client, PERF_DB, PERF_COLLECTION);
+   BSON_APPEND_BOOL (&opts, "ordered", false);
+   bulk = mongoc_collection_create_bulk_operation_with_opts (collection, &opts);
+
+   while ((r = bson_json_reader_read (reader, &doc, &error)) == 1) {
+      mongoc_bulk_operation_insert (bulk, &doc);
+      bson_reinit (&doc);
+   }
+
+   if (r < 0) {
+      perf_error (&test->base, "import", error.message);
+   } else if (!mongoc_bulk_operation_execute (bulk, NULL, &error)) {
+      perf_error (&test->base, "import", error.message);
+      r = -1;
+   }
+
+   mongoc_bulk_operation_destroy (bulk);
+   mongoc_collection_destroy (collection);
+   bson_json_reader_destroy (reader);
+   bson_destroy (&opts);
+   bson_destroy (&doc);
+
+   return r == 0;
+}
+
+
+static bool
+_import_setup (perf_test_t *base)
+{
+   perf_parallel_test_t *test = (perf_parallel_test_t *) base;
+
+   test->work = _import_work;
+
+   return _ldjson_setup (test);
+}
+
+
+static bool
+_import_before (perf_test_t *base)
+{
+   perf_parallel_test_t *test = (perf_parallel_test_t *) base;
+   mongoc_client_t *client;
+   bool r;
+
+   client = mongoc_client_pool_pop (test->pool);
+   r = perf_reset_collection (client, PERF_COLLECTION);
+   mongoc_client_pool_push (test->pool, client);
+
+   return r;
+}
+
+
+static bool
+_export_work (perf_parallel_test_t *test, mongoc_client_t *client, int i)
+{
+   mongoc_collection_t *collection;
+   mongoc_cursor_t *cursor;
+   const bson_t *doc;
+   bson_error_t error;
+   bson_t filter = BSON_INITIALIZER;
+   char *path;
+   char *json;
+   FILE *stream;
+   bool r = true;
+
+   path = _perf_path (test->out_dir, i, "json");
+   stream = fopen (path, "w");
+   if (!stream) {
+      perf_error (&test->base, "failed to open", path);
+      bson_free (path);
+      return false;
+   }
+
+   bson_free (path);
+
+   collection = mongoc_client_get_collection (client, PERF_DB, PERF_COLLECTION);
+   BSON_APPEND_INT32 (&filter, "file", i);
+   cursor = mongoc_collection_find_with_opts (collection, &filter, NULL, NULL);
+
+   while (mongoc_cursor_next (cursor, &doc)) {
+      json = bson_as_relaxed_extended_json (doc, NULL);
+      fprintf (stream, "%s\n", json);
+      bson_free (json);
+   }
+
+   if (mongoc_cursor_error (cursor, &error)) {
+      perf_error (&test->base, "export", error.message);
+      r = false;
+   }
+
+   mongoc_cursor_destroy (cursor);
+   mongoc_collection_destroy (collection);
+   bson_destroy (&filter);
+   fclose (stream);
+
+   return r;
+}
+
+
+static bool
+_export_setup (perf_test_t *base)
+{
+   perf_parallel_test_t *test = (perf_parallel_test_t *) base;
+
+   /* import the files once, then export them in each task */
+   test->work = _import_work;
+   if (!_ldjson_setup (test) || !_import_before (base) ||
+       !_perf_parallel_task (base)) {
+      return false;
+   }
+
+   test->work = _export_work;
+
+   return true;
+}
+
+
+/* TestGridFsMultiFileUpload and TestGridFsMultiFileDownload */
+
+/* write the files to upload, unless an earlier benchmark did */
+static bool
+_gridfs_files_setup (perf_parallel_test_t *test)
+{
+   uint8_t *data;
+   size_t len;
+   char *path;
+   FILE *stream;
+   bool r = true;
+   int i;
+
+   if (!_perf_parallel_setup (test, "gridfs", "gridfs-out")) {
+      return false;
+   }
+
+   test->n_files = PERF_GRIDFS_FILES;
+   test->file_ids = bson_malloc0 (test->n_files * sizeof (bson_value_t));
+   len = (size_t) perf_scaled (test->base.suite, PERF_GRIDFS_FILE_SIZE);
+   test->base.data_size = (int64_t) len * test->n_files;
+   data = bson_malloc (len);
+
+   for (i = 0; r && i < test->n_files; i++) {
+      path = _perf_path (test->in_dir, i, "bin");
+      stream = fopen (path, "r");
+      if (stream) {
+         fclose (stream);
+         bson_free (path);
+         continue;
+      }
+
+      stream = fopen (path, "w");
+      perf_fill_bytes (data, len, (uint32_t) i);
+      if (!stream || fwrite (data, 1, len, stream) != len) {
+         perf_error (&test->base, "failed to write", path);
+         r = false;
+      }
+
+      if (stream) {
+         fclose (stream);
+      }
+
+      bson_free (path);
+   }
+
+   bson_free (data);
+
+   return r;
+}
+
+
+/* a new bucket, which creates indexes before its first upload */
+static mongoc_gridfs_bucket_t *
+_perf_bucket_new (mongoc_client_t *client)
+{
+   mongoc_database_t *db;
+   mongoc_gridfs_bucket_t *bucket;
+
+   db = mongoc_client_get_database (client, PERF_DB);
+   bucket = mongoc_gridfs_bucket_new (db, NULL, NULL);
+   mongoc_database_destroy (db);
+
+   return bucket;
+}
+
+
+static bool
+_upload_work (perf_parallel_test_t *test, mongoc_client_t *client, int i)
+{
+   mongoc_gridfs_bucket_t *bucket;
+   mongoc_stream_t *stream;
+   bson_error_t error;
+   char *path;
+   char *name;
+   bool r;
+
+   path = _perf_path (test->in_dir, i, "bin");
+   stream = mongoc_stream_file_new_for_path (path, O_RDONLY, 0);
+   if (!stream) {
+      perf_error (&test->base, "failed to open", path);
+      bson_free (path);
+      return false;
+   }
+
+   bson_free (path);
+   name = bson_strdup_printf ("file%03d.bin", i);
+   bucket = _perf_bucket_new (client);
+   bson_value_destroy (&test->file_ids[i]);
+
+   r = mongoc_gridfs_bucket_upload_from_stream (
+      bucket, name, stream, NULL, &test->file_ids[i], &error);
+   if (!r) {
+      perf_error (&test->base, "upload", error.message);
+   }
+
+   mongoc_gridfs_bucket_destroy (bucket);
+   mongoc_stream_destroy (stream);
+   bson_free (name);
+
+   return r;
+}
+
+
+static bool
+_upload_setup (perf_test_t *base)
+{
+   perf_parallel_test_t *test = (perf_parallel_test_t *) base;
+
+   test->work = _upload_work;
+
+   return _gridfs_files_setup (test);
+}
+
+
+static bool
+_upload_before (perf_test_t *base)
+{
+   perf_parallel_test_t *test = (perf_parallel_test_t *) base;
+   mongoc_client_t *client;
+   mongoc_gridfs_bucket_t *bucket;
+   mongoc_stream_t *stream;
+   bson_error_t error;
+   bool r;
+
+   client = mongoc_client_pool_pop (test->pool);
+   r = perf_drop_database (client);
+
+   /* create the indexes, so the first uploads don't race to */
+   if (r) {
+      bucket = _perf_bucket_new (client);
+      stream = mongoc_gridfs_bucket_open_upload_stream (
+         bucket, "one-byte", NULL, NULL, &error);
+      r = stream && mongoc_stream_write (stream, (void *) "1", 1, 0) == 1 &&
+          0 == mongoc_stream_close (stream);
+      if (!r) {
+         if (stream) {
+            mongoc_gridfs_bucket_stream_error (stream, &error);
+         }
+
+         perf_error (base, "upload", error.message);
+      }
+
+      mongoc_stream_destroy (stream);
+      mongoc_gridfs_bucket_destroy (bucket);
+   }
+
+   mongoc_client_pool_push (test->pool, client);
+
+   return r;
+}
+
+
+static bool
+_download_work (perf_parallel_test_t *test, mongoc_client_t *client, int i)
+{
+   mongoc_gridfs_bucket_t *bucket;
+   mongoc_stream_t *stream;
+   bson_error_t error;
+   char *path;
+   bool r;
+
+   path = _perf_path (test->out_dir, i, "bin");
+   stream = mongoc_stream_file_new_for_path (
+      path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   if (!stream) {
+      perf_error (&test->base, "failed to open", path);
+      bson_free (path);
+      return false;
+   }
+
+   bson_free (path);
+   bucket = _perf_bucket_new (client);
+
+   r = mongoc_gridfs_bucket_download_to_stream (
+      bucket, &test->file_ids[i], stream, &error);
+   if (!r) {
+      perf_error (&test->base, "download", error.message);
+   }
+
+   mongoc_gridfs_bucket_destroy (bucket);
+   mongoc_stream_destroy (stream);
+
+   return r;
+}
+
+
+static bool
+_download_setup (perf_test_t *base)
+{
+   perf_parallel_test_t *test = (perf_parallel_test_t *) base;
+
+   /* upload the files once, then download them in each task */
+   test->work = _upload_work;
+   if (!_gridfs_files_setup (test) || !_upload_before (base) ||
+       !_perf_parallel_task (base)) {
+      return false;
+   }
+
+   test->work = _download_work;
+
+   return true;
+}
+
+
+static void
+_perf_parallel_test (perf_suite_t *suite,
+                     const char *name,
+                     bool (*setup) (perf_test_t *test),
+                     bool (*before_task) (perf_test_t *test))
+{
+   perf_parallel_test_t test = {{0}};
+
+   test.base.group = "ParallelBench";
+   test.base.name = name;
+   test.base.setup = setup;
+   test.base.before_task = before_task;
+   test.base.task = _perf_parallel_task;
+   test.base.teardown = _perf_parallel_teardown;
+   pthread_mutex_init (&test.mutex, NULL);
+
+   perf_run (suite, &test.base);
+
+   pthread_mutex_destroy (&test.mutex);
+}
+
+
+void
+perf_parallel_run (perf_suite_t *suite)
+{
+   _perf_parallel_test (
+      suite, "TestJsonMultiImport", _import_setup, _import_before);
+   _perf_parallel_test (suite, "TestJsonMultiExport", _export_setup, NULL);
+   _perf_parallel_test (
+      suite, "TestGridFsMultiFileUpload", _upload_setup, _upload_before);
+   _perf_parallel_test (
+      suite, "TestGridFsMultiFileDownload", _download_setup, NULL);
+}
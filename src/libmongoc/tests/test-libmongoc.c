@@ -167,10 +167,14 @@ test_opts_install (TestSuite *suite);
 extern void
 test_socket_install (TestSuite *suite);
 extern void
+test_span_install (TestSuite *suite);
+extern void
 test_stream_install (TestSuite *suite);
 extern void
 test_thread_install (TestSuite *suite);
 extern void
+test_tools_install (TestSuite *suite);
+extern void
 test_topology_install (TestSuite *suite);
 extern void
 test_topology_description_install (TestSuite *suite);
@@ -2330,8 +2334,10 @@ main (int argc, char *argv[])
    test_server_selection_errors_install (&suite);
    test_session_install (&suite);
    test_set_install (&suite);
+   test_span_install (&suite);
    test_stream_install (&suite);
    test_thread_install (&suite);
+   test_tools_install (&suite);
    test_topology_install (&suite);
    test_topology_description_install (&suite);
    test_uri_install (&suite);
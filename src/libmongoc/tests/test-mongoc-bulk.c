@@ -3322,6 +3322,517 @@ test_numerous_unordered (void *ctx)
 }
 
 
+static request_t *
+_receives_pipeline_batch (mock_server_t *server, bool ordered, int n_docs)
+{
+   request_t *request;
+   const bson_t *docs[4];
+   int i;
+
+   docs[0] = tmp_bson ("{'insert': 'collection', 'ordered': %s}",
+                       ordered ? "true" : "false");
+   for (i = 1; i <= n_docs; i++) {
+      docs[i] = tmp_bson ("{}");
+   }
+
+   request = mock_server_receives_request (server);
+   BSON_ASSERT (request_matches_msg (request, 0, &docs[0], n_docs + 1));
+
+   return request;
+}
+
+
+static void
+_test_pipeline (bool ordered)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_bulk_operation_t *bulk;
+   bson_t reply;
+   bson_error_t error;
+   future_t *future;
+   request_t *requests[3];
+   int i;
+
+   server = mock_server_new ();
+   mock_server_auto_ismaster (server,
+                              "{'ok': 1.0,"
+                              " 'ismaster': true,"
+                              " 'minWireVersion': 0,"
+                              " 'maxWireVersion': %d,"
+                              " 'maxWriteBatchSize': 3}",
+                              WIRE_VERSION_OP_MSG);
+
+   mock_server_run (server);
+
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "collection");
+   bulk = mongoc_collection_create_bulk_operation_with_opts (
+      collection, tmp_bson ("{'ordered': %s}", ordered ? "true" : "false"));
+
+   for (i = 0; i < 7; i++) {
+      mongoc_bulk_operation_insert (bulk, tmp_bson ("{'_id': %d}", i));
+   }
+
+   mongoc_bulk_operation_set_pipeline_depth (bulk, 3);
+   future = future_bulk_operation_execute (bulk, &reply, &error);
+
+   if (ordered) {
+      /* ordered bulks wait for each reply before sending the next batch */
+      for (i = 0; i < 3; i++) {
+         requests[0] = _receives_pipeline_batch (server, true, i < 2 ? 3 : 1);
+         mock_server_replies_simple (requests[0],
+                                     i < 2 ? "{'ok': 1, 'n': 3}"
+                                           : "{'ok': 1, 'n': 1}");
+         request_destroy (requests[0]);
+      }
+
+      ASSERT_OR_PRINT (future_get_uint32_t (future), error);
+      ASSERT_MATCH (&reply, "{'nInserted': 7}");
+   } else {
+      /* all three batches are sent before any reply */
+      for (i = 0; i < 3; i++) {
+         requests[i] = _receives_pipeline_batch (server, false, i < 2 ? 3 : 1);
+      }
+
+      mock_server_replies_simple (requests[0], "{'ok': 1, 'n': 3}");
+      mock_server_replies_simple (
+         requests[1],
+         "{'ok': 1, 'n': 2,"
+         " 'writeErrors': [{'index': 1, 'code': 11000, 'errmsg': 'dupe'}]}");
+      mock_server_replies_simple (requests[2], "{'ok': 1, 'n': 1}");
+
+      for (i = 0; i < 3; i++) {
+         request_destroy (requests[i]);
+      }
+
+      BSON_ASSERT (!future_get_uint32_t (future));
+      ASSERT_ERROR_CONTAINS (error, MONGOC_ERROR_COMMAND, 11000, "dupe");
+      /* the error index is offset by the size of the first batch */
+      ASSERT_MATCH (&reply,
+                    "{'nInserted': 6,"
+                    " 'writeErrors': [{'index': 4, 'code': 11000}]}");
+   }
+
+   future_destroy (future);
+   bson_destroy (&reply);
+   mongoc_bulk_operation_destroy (bulk);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_pipeline_ordered (void)
+{
+   _test_pipeline (true);
+}
+
+
+static void
+test_pipeline_unordered (void)
+{
+   _test_pipeline (false);
+}
+
+
+/* counted by the client's thread, read by the test's */
+typedef struct {
+   volatile int32_t started;
+   volatile int32_t succeeded;
+   volatile int32_t failed;
+} pipeline_stats_t;
+
+
+static void
+_pipeline_started (const mongoc_apm_command_started_t *event)
+{
+   bson_atomic_int_add (
+      &((pipeline_stats_t *) mongoc_apm_command_started_get_context (event))
+          ->started,
+      1);
+}
+
+
+static void
+_pipeline_succeeded (const mongoc_apm_command_succeeded_t *event)
+{
+   bson_atomic_int_add (
+      &((pipeline_stats_t *) mongoc_apm_command_succeeded_get_context (event))
+          ->succeeded,
+      1);
+}
+
+
+static void
+_pipeline_failed (const mongoc_apm_command_failed_t *event)
+{
+   bson_error_t error;
+
+   mongoc_apm_command_failed_get_error (event, &error);
+   ASSERT_CMPINT (error.domain, ==, MONGOC_ERROR_STREAM);
+   bson_atomic_int_add (
+      &((pipeline_stats_t *) mongoc_apm_command_failed_get_context (event))
+          ->failed,
+      1);
+}
+
+
+/* the server hangs up while three batches are in flight */
+static void
+test_pipeline_hangup (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_apm_callbacks_t *callbacks;
+   mongoc_collection_t *collection;
+   mongoc_bulk_operation_t *bulk;
+   mongoc_server_description_t *sd;
+   pipeline_stats_t stats = {0};
+   bson_t reply;
+   bson_error_t error;
+   future_t *future;
+   request_t *requests[3];
+   int i;
+
+   server = mock_server_new ();
+   mock_server_auto_ismaster (server,
+                              "{'ok': 1.0,"
+                              " 'ismaster': true,"
+                              " 'minWireVersion': 0,"
+                              " 'maxWireVersion': %d,"
+                              " 'maxWriteBatchSize': 3}",
+                              WIRE_VERSION_OP_MSG);
+
+   mock_server_run (server);
+
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   callbacks = mongoc_apm_callbacks_new ();
+   mongoc_apm_set_command_started_cb (callbacks, _pipeline_started);
+   mongoc_apm_set_command_succeeded_cb (callbacks, _pipeline_succeeded);
+   mongoc_apm_set_command_failed_cb (callbacks, _pipeline_failed);
+   mongoc_client_set_apm_callbacks (client, callbacks, &stats);
+   collection = mongoc_client_get_collection (client, "db", "collection");
+   bulk = mongoc_collection_create_bulk_operation_with_opts (
+      collection, tmp_bson ("{'ordered': false}"));
+
+   for (i = 0; i < 7; i++) {
+      mongoc_bulk_operation_insert (bulk, tmp_bson ("{'_id': %d}", i));
+   }
+
+   mongoc_bulk_operation_set_pipeline_depth (bulk, 3);
+   future = future_bulk_operation_execute (bulk, &reply, &error);
+
+   for (i = 0; i < 3; i++) {
+      requests[i] = _receives_pipeline_batch (server, false, i < 2 ? 3 : 1);
+   }
+
+   mock_server_replies_simple (requests[0], "{'ok': 1, 'n': 3}");
+   /* replies are written by another thread, don't hang up before it */
+   WAIT_UNTIL (bson_atomic_int_add (&stats.succeeded, 0) == 1);
+   mock_server_hangs_up (requests[1]);
+
+   for (i = 0; i < 3; i++) {
+      request_destroy (requests[i]);
+   }
+
+   BSON_ASSERT (!future_get_uint32_t (future));
+   ASSERT_CMPINT (error.domain, ==, MONGOC_ERROR_STREAM);
+   ASSERT_MATCH (&reply, "{'nInserted': 3}");
+
+   /* the batch whose reply was never read is finished too */
+   ASSERT_CMPINT (stats.started, ==, 3);
+   ASSERT_CMPINT (stats.succeeded, ==, 1);
+   ASSERT_CMPINT (stats.failed, ==, 2);
+
+   sd = mongoc_client_get_server_description (client, 1);
+   ASSERT_CMPINT32 (mongoc_server_description_in_flight_count (sd), ==, 0);
+   mongoc_server_description_destroy (sd);
+
+   future_destroy (future);
+   bson_destroy (&reply);
+   mongoc_bulk_operation_destroy (bulk);
+   mongoc_collection_destroy (collection);
+   mongoc_apm_callbacks_destroy (callbacks);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_pipeline_depth_too_large (void)
+{
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_bulk_operation_t *bulk;
+   bson_t reply;
+   bson_error_t error;
+
+   client = mongoc_client_new ("mongodb://localhost");
+   collection = mongoc_client_get_collection (client, "db", "collection");
+   bulk = mongoc_collection_create_bulk_operation_with_opts (collection, NULL);
+   mongoc_bulk_operation_insert (bulk, tmp_bson ("{}"));
+
+   capture_logs (true);
+   mongoc_bulk_operation_set_pipeline_depth (bulk, UINT32_MAX);
+   ASSERT_CAPTURED_LOG ("set_pipeline_depth",
+                        MONGOC_LOG_LEVEL_WARNING,
+                        "Pipeline depth 4294967295 is greater than 100");
+
+   BSON_ASSERT (!mongoc_bulk_operation_execute (bulk, &reply, &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_COMMAND,
+                          MONGOC_ERROR_COMMAND_INVALID_ARG,
+                          "Pipeline depth 4294967295 is greater than 100");
+
+   bson_destroy (&reply);
+   mongoc_bulk_operation_destroy (bulk);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+}
+
+
+typedef struct {
+   int n_calls;
+   uint32_t offsets[2];
+   bson_t replies[2];
+} batch_cb_ctx_t;
+
+
+static void
+_batch_cb (const bson_t *reply, uint32_t offset, void *ctx)
+{
+   batch_cb_ctx_t *batch_ctx = (batch_cb_ctx_t *) ctx;
+
+   ASSERT_CMPINT (batch_ctx->n_calls, <, 2);
+   batch_ctx->offsets[batch_ctx->n_calls] = offset;
+   bson_copy_to (reply, &batch_ctx->replies[batch_ctx->n_calls]);
+   batch_ctx->n_calls++;
+}
+
+
+static void
+_test_counts_only (bool use_callback)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_bulk_operation_t *bulk;
+   batch_cb_ctx_t ctx = {0};
+   bson_t reply;
+   bson_error_t error;
+   future_t *future;
+   request_t *request;
+   bson_iter_t iter;
+   bson_t write_errors;
+   uint32_t len;
+   const uint8_t *data;
+   int i;
+
+   server = mock_server_new ();
+   mock_server_auto_ismaster (server,
+                              "{'ok': 1.0,"
+                              " 'ismaster': true,"
+                              " 'minWireVersion': 0,"
+                              " 'maxWireVersion': %d,"
+                              " 'maxWriteBatchSize': 2}",
+                              WIRE_VERSION_OP_MSG);
+
+   mock_server_run (server);
+
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "collection");
+   bulk = mongoc_collection_create_bulk_operation_with_opts (
+      collection, tmp_bson ("{'ordered': false}"));
+
+   for (i = 0; i < 4; i++) {
+      ASSERT_OR_PRINT (mongoc_bulk_operation_update_one_with_opts (
+                          bulk,
+                          tmp_bson ("{'_id': %d}", i),
+                          tmp_bson ("{'$set': {'x': 1}}"),
+                          tmp_bson ("{'upsert': true}"),
+                          &error),
+                       error);
+   }
+
+   if (use_callback) {
+      mongoc_bulk_operation_set_batch_callback (bulk, _batch_cb, &ctx);
+   } else {
+      mongoc_bulk_operation_set_counts_only (bulk, true);
+   }
+
+   future = future_bulk_operation_execute (bulk, &reply, &error);
+
+   request = mock_server_receives_msg (
+      server,
+      0,
+      tmp_bson ("{'update': 'collection'}"),
+      tmp_bson ("{'q': {'_id': 0}}"),
+      tmp_bson ("{'q': {'_id': 1}}"));
+   mock_server_replies_simple (
+      request,
+      "{'ok': 1, 'n': 1, 'nModified': 0,"
+      " 'upserted': [{'index': 0, '_id': 0}],"
+      " 'writeErrors': [{'index': 1, 'code': 11000, 'errmsg': 'dupe 1'}]}");
+   request_destroy (request);
+
+   request = mock_server_receives_msg (
+      server,
+      0,
+      tmp_bson ("{'update': 'collection'}"),
+      tmp_bson ("{'q': {'_id': 2}}"),
+      tmp_bson ("{'q': {'_id': 3}}"));
+   mock_server_replies_simple (
+      request,
+      "{'ok': 1, 'n': 1, 'nModified': 0,"
+      " 'upserted': [{'index': 1, '_id': 3}],"
+      " 'writeErrors': [{'index': 0, 'code': 11000, 'errmsg': 'dupe 2'}]}");
+   request_destroy (request);
+
+   BSON_ASSERT (!future_get_uint32_t (future));
+   ASSERT_ERROR_CONTAINS (error, MONGOC_ERROR_COMMAND, 11000, "dupe 1");
+
+   /* counts are summed, but the upserted ids and all but the first write
+    * error are not accumulated */
+   ASSERT_MATCH (&reply,
+                 "{'nUpserted': 2, 'nMatched': 0,"
+                 " 'upserted': {'$exists': false},"
+                 " 'writeErrors': [{'index': 1, 'errmsg': 'dupe 1'}]}");
+   BSON_ASSERT (bson_iter_init_find (&iter, &reply, "writeErrors"));
+   bson_iter_array (&iter, &len, &data);
+   BSON_ASSERT (bson_init_static (&write_errors, data, len));
+   ASSERT_CMPUINT32 (bson_count_keys (&write_errors), ==, (uint32_t) 1);
+
+   if (use_callback) {
+      /* each batch's reply is passed to the callback, with the index of the
+       * batch's first operation */
+      ASSERT_CMPINT (ctx.n_calls, ==, 2);
+      ASSERT_CMPUINT32 (ctx.offsets[0], ==, (uint32_t) 0);
+      ASSERT_MATCH (&ctx.replies[0],
+                    "{'upserted': [{'index': 0, '_id': 0}],"
+                    " 'writeErrors': [{'index': 1, 'errmsg': 'dupe 1'}]}");
+      ASSERT_CMPUINT32 (ctx.offsets[1], ==, (uint32_t) 2);
+      ASSERT_MATCH (&ctx.replies[1],
+                    "{'upserted': [{'index': 1, '_id': 3}],"
+                    " 'writeErrors': [{'index': 0, 'errmsg': 'dupe 2'}]}");
+
+      bson_destroy (&ctx.replies[0]);
+      bson_destroy (&ctx.replies[1]);
+   } else {
+      ASSERT_CMPINT (ctx.n_calls, ==, 0);
+   }
+
+   future_destroy (future);
+   bson_destroy (&reply);
+   mongoc_bulk_operation_destroy (bulk);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_counts_only (void)
+{
+   _test_counts_only (false);
+}
+
+
+static void
+test_batch_callback (void)
+{
+   _test_counts_only (true);
+}
+
+
+/* the callback isn't passed the empty reply from a network error, and only
+ * the first write concern error is kept */
+static void
+test_batch_callback_errors (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_bulk_operation_t *bulk;
+   batch_cb_ctx_t ctx = {0};
+   bson_t reply;
+   bson_error_t error;
+   future_t *future;
+   request_t *request;
+   bson_iter_t iter;
+   bson_t wc_errors;
+   uint32_t len;
+   const uint8_t *data;
+   int i;
+
+   server = mock_server_new ();
+   mock_server_auto_ismaster (server,
+                              "{'ok': 1.0,"
+                              " 'ismaster': true,"
+                              " 'minWireVersion': 0,"
+                              " 'maxWireVersion': %d,"
+                              " 'maxWriteBatchSize': 1}",
+                              WIRE_VERSION_OP_MSG);
+
+   mock_server_run (server);
+
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "collection");
+   bulk = mongoc_collection_create_bulk_operation_with_opts (collection, NULL);
+
+   for (i = 0; i < 3; i++) {
+      mongoc_bulk_operation_insert (bulk, tmp_bson ("{'_id': %d}", i));
+   }
+
+   mongoc_bulk_operation_set_batch_callback (bulk, _batch_cb, &ctx);
+   future = future_bulk_operation_execute (bulk, &reply, &error);
+
+   for (i = 0; i < 2; i++) {
+      request = mock_server_receives_msg (server,
+                                          0,
+                                          tmp_bson ("{'insert': 'collection'}"),
+                                          tmp_bson ("{'_id': %d}", i));
+      mock_server_replies_simple (
+         request,
+         "{'ok': 1, 'n': 1,"
+         " 'writeConcernError': {'code': 64, 'errmsg': 'wc error'}}");
+      request_destroy (request);
+   }
+
+   request = mock_server_receives_msg (server,
+                                       0,
+                                       tmp_bson ("{'insert': 'collection'}"),
+                                       tmp_bson ("{'_id': 2}"));
+   mock_server_hangs_up (request);
+   request_destroy (request);
+
+   BSON_ASSERT (!future_get_uint32_t (future));
+   ASSERT_CMPINT (error.domain, ==, MONGOC_ERROR_STREAM);
+
+   ASSERT_CMPINT (ctx.n_calls, ==, 2);
+   ASSERT_CMPUINT32 (ctx.offsets[1], ==, (uint32_t) 1);
+
+   ASSERT_MATCH (&reply,
+                 "{'nInserted': 2, 'writeConcernErrors':"
+                 " [{'code': 64, 'errmsg': 'wc error'}]}");
+   BSON_ASSERT (bson_iter_init_find (&iter, &reply, "writeConcernErrors"));
+   bson_iter_array (&iter, &len, &data);
+   BSON_ASSERT (bson_init_static (&wc_errors, data, len));
+   ASSERT_CMPUINT32 (bson_count_keys (&wc_errors), ==, (uint32_t) 1);
+
+   bson_destroy (&ctx.replies[0]);
+   bson_destroy (&ctx.replies[1]);
+   future_destroy (future);
+   bson_destroy (&reply);
+   mongoc_bulk_operation_destroy (bulk);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
 static void
 test_bulk_split (void)
 {
@@ -4791,6 +5302,22 @@ test_bulk_install (TestSuite *suite)
                       NULL,
                       NULL,
                       test_framework_skip_if_slow_or_live);
+   TestSuite_AddMockServerTest (
+      suite, "/BulkOperation/pipeline/ordered", test_pipeline_ordered);
+   TestSuite_AddMockServerTest (
+      suite, "/BulkOperation/pipeline/unordered", test_pipeline_unordered);
+   TestSuite_AddMockServerTest (
+      suite, "/BulkOperation/pipeline/hangup", test_pipeline_hangup);
+   TestSuite_Add (suite,
+                  "/BulkOperation/pipeline/depth_too_large",
+                  test_pipeline_depth_too_large);
+   TestSuite_AddMockServerTest (
+      suite, "/BulkOperation/counts_only", test_counts_only);
+   TestSuite_AddMockServerTest (
+      suite, "/BulkOperation/batch_callback", test_batch_callback);
+   TestSuite_AddMockServerTest (suite,
+                                "/BulkOperation/batch_callback/errors",
+                                test_batch_callback_errors);
    TestSuite_AddLive (suite,
                       "/BulkOperation/CDRIVER-372_ordered",
                       test_bulk_edge_case_372_ordered);
@@ -4,6 +4,7 @@
 
 
 #include "TestSuite.h"
+#include "test-conveniences.h"
 #include "test-libmongoc.h"
 
 
@@ -282,6 +283,118 @@ test_mongoc_client_pool_handshake (void)
    mongoc_client_pool_destroy (pool);
 }
 
+static void *
+pop_and_push_worker (void *data)
+{
+   mongoc_client_pool_t *pool = (mongoc_client_pool_t *) data;
+   mongoc_client_t *client;
+
+   client = mongoc_client_pool_pop (pool);
+   mongoc_client_pool_push (pool, client);
+
+   return NULL;
+}
+
+
+static int64_t
+stats_get (mongoc_client_pool_t *pool, const char *key)
+{
+   bson_t stats;
+   int64_t value;
+
+   mongoc_client_pool_get_stats (pool, &stats);
+   value = bson_lookup_int64 (&stats, key);
+   bson_destroy (&stats);
+
+   return value;
+}
+
+
+static void
+test_mongoc_client_pool_stats (void)
+{
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   mongoc_client_t *client2;
+   mongoc_uri_t *uri;
+   bson_thread_t thread;
+   bson_t stats;
+   int64_t at_max_usec;
+
+   uri = mongoc_uri_new ("mongodb://127.0.0.1/?maxpoolsize=1");
+   pool = mongoc_client_pool_new (uri);
+
+   mongoc_client_pool_get_stats (pool, &stats);
+   ASSERT_MATCH (&stats,
+                 "{'size': 0, 'maxSize': 1, 'available': 0, 'waiting': 0,"
+                 " 'pops': 0, 'created': 0, 'destroyed': 0, 'atMaxMicros': 0,"
+                 " 'waits': {'count': 0, 'totalMicros': 0, 'maxMicros': 0,"
+                 "           'p50Micros': 0, 'p90Micros': 0, 'p99Micros': 0}}");
+   bson_destroy (&stats);
+
+   /* the pool is at its max size with no client available */
+   client = mongoc_client_pool_pop (pool);
+   BSON_ASSERT (!bson_thread_create (&thread, pop_and_push_worker, pool));
+   while (stats_get (pool, "waiting") == 0) {
+      _mongoc_usleep (1000);
+   }
+
+   _mongoc_usleep (50 * 1000);
+   mongoc_client_pool_push (pool, client);
+   bson_thread_join (thread);
+
+   mongoc_client_pool_get_stats (pool, &stats);
+   ASSERT_MATCH (&stats,
+                 "{'size': 1, 'maxSize': 1, 'available': 1, 'waiting': 0,"
+                 " 'pops': 2, 'created': 1, 'destroyed': 0,"
+                 " 'waits': {'count': 1}}");
+   ASSERT_CMPINT64 (bson_lookup_int64 (&stats, "atMaxMicros"), >=, 50 * 1000);
+   ASSERT_CMPINT64 (
+      bson_lookup_int64 (&stats, "waits.maxMicros"), >=, 50 * 1000);
+   ASSERT_CMPINT64 (bson_lookup_int64 (&stats, "waits.totalMicros"),
+                    ==,
+                    bson_lookup_int64 (&stats, "waits.maxMicros"));
+   /* the one wait is every percentile */
+   ASSERT_CMPINT64 (bson_lookup_int64 (&stats, "waits.p50Micros"),
+                    ==,
+                    bson_lookup_int64 (&stats, "waits.maxMicros"));
+   ASSERT_CMPINT64 (bson_lookup_int64 (&stats, "waits.p99Micros"),
+                    ==,
+                    bson_lookup_int64 (&stats, "waits.maxMicros"));
+   bson_destroy (&stats);
+
+   /* the pool is no longer at its max size */
+   at_max_usec = stats_get (pool, "atMaxMicros");
+   mongoc_client_pool_max_size (pool, 2);
+   client = mongoc_client_pool_pop (pool);
+   _mongoc_usleep (10 * 1000);
+   ASSERT_CMPINT64 (stats_get (pool, "atMaxMicros"), ==, at_max_usec);
+   mongoc_client_pool_push (pool, client);
+
+   mongoc_client_pool_destroy (pool);
+   mongoc_uri_destroy (uri);
+
+   /* clients over minPoolSize are destroyed when pushed */
+   capture_logs (true);
+   uri = mongoc_uri_new ("mongodb://127.0.0.1/?minpoolsize=1");
+   pool = mongoc_client_pool_new (uri);
+
+   client = mongoc_client_pool_pop (pool);
+   client2 = mongoc_client_pool_pop (pool);
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_push (pool, client2);
+
+   mongoc_client_pool_get_stats (pool, &stats);
+   ASSERT_MATCH (&stats,
+                 "{'size': 1, 'available': 1, 'pops': 2, 'created': 2,"
+                 " 'destroyed': 1, 'atMaxMicros': 0, 'waits': {'count': 0}}");
+   bson_destroy (&stats);
+
+   mongoc_client_pool_destroy (pool);
+   mongoc_uri_destroy (uri);
+}
+
+
 void
 test_client_pool_install (TestSuite *suite)
 {
@@ -301,6 +414,7 @@ test_client_pool_install (TestSuite *suite)
 
    TestSuite_Add (
       suite, "/ClientPool/handshake", test_mongoc_client_pool_handshake);
+   TestSuite_Add (suite, "/ClientPool/stats", test_mongoc_client_pool_stats);
 
 #ifndef MONGOC_ENABLE_SSL
    TestSuite_Add (
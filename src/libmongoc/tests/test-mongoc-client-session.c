@@ -241,8 +241,8 @@ test_session_pool_timeout_pooled (void *ctx)
 }
 
 
-/* test that a session that times out while it's in the pool is reaped when
- * another session is added
+/* test that a session that times out while it's in the pool is reaped, and
+ * that returning another session doesn't do it, it's off the hot path
  */
 static void
 _test_session_pool_reap (bool pooled)
@@ -291,12 +291,17 @@ _test_session_pool_reap (bool pooled)
    _mongoc_usleep (1500 * 1000);
 
    /*
-    * returning session B causes session A to be reaped
+    * returning session B leaves session A in the pool, reaping removes it
     */
    b->server_session->last_used_usec = bson_get_monotonic_time ();
    mongoc_client_session_destroy (b);
    BSON_ASSERT (client->topology->session_pool);
    ASSERT_SESSIONS_MATCH (&lsid_b, &client->topology->session_pool->lsid);
+   session_pool = client->topology->session_pool;
+   BSON_ASSERT (session_pool != session_pool->next);
+
+   _mongoc_topology_reap_server_sessions (client->topology);
+   ASSERT_SESSIONS_MATCH (&lsid_b, &client->topology->session_pool->lsid);
    /* session B is the only session in the pool */
    session_pool = client->topology->session_pool;
    BSON_ASSERT (session_pool == session_pool->prev);
@@ -501,6 +506,44 @@ test_mock_end_sessions_pooled (void)
    _test_mock_end_sessions (true);
 }
 
+
+/* in pooled mode, taking and returning a server session doesn't wait for the
+ * topology mutex, which server selection and the scanner use */
+static void
+test_session_pool_no_topology_lock (void)
+{
+   mock_server_t *server;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   mongoc_topology_t *topology;
+   mongoc_server_session_t *ss;
+   bson_error_t error;
+   uint32_t server_id;
+
+   server = mock_mongos_new (WIRE_VERSION_OP_MSG);
+   mock_server_run (server);
+   pool = mongoc_client_pool_new (mock_server_get_uri (server));
+   client = mongoc_client_pool_pop (pool);
+   topology = client->topology;
+
+   server_id = mongoc_topology_select_server_id (
+      topology, MONGOC_SS_READ, NULL, &error);
+   ASSERT_OR_PRINT (server_id, error);
+
+   bson_mutex_lock (&topology->mutex);
+   ss = _mongoc_topology_pop_server_session (topology, &error);
+   ASSERT_OR_PRINT (ss, error);
+   _mongoc_topology_push_server_session (topology, ss);
+   BSON_ASSERT (topology->session_pool == ss);
+   bson_mutex_unlock (&topology->mutex);
+
+   /* don't send endSessions */
+   _mongoc_topology_clear_session_pool (topology);
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+   mock_server_destroy (server);
+}
+
 typedef struct {
    int started_calls;
    int succeeded_calls;
@@ -2555,6 +2598,10 @@ test_session_install (TestSuite *suite)
                                 "/Session/end/mock/pooled",
                                 test_mock_end_sessions_pooled,
                                 test_framework_skip_if_no_crypto);
+   TestSuite_AddMockServerTest (suite,
+                                "/Session/pool/no_topology_lock",
+                                test_session_pool_no_topology_lock,
+                                test_framework_skip_if_no_crypto);
    TestSuite_AddFull (suite,
                       "/Session/end/single",
                       test_end_sessions_single,
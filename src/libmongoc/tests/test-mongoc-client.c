@@ -2150,6 +2150,120 @@ test_mongoc_client_ipv6_pooled (void)
 }
 
 
+/* cache @addresses, each a numeric host, as the results of resolving @host */
+static void
+_cache_addresses (const mongoc_host_list_t *host,
+                  const char **addresses,
+                  size_t n)
+{
+   struct addrinfo hints = {0};
+   struct addrinfo **results;
+   char portstr[8];
+   size_t i;
+
+   hints.ai_family = AF_UNSPEC;
+   hints.ai_socktype = SOCK_STREAM;
+   hints.ai_flags = AI_NUMERICHOST;
+   bson_snprintf (portstr, sizeof portstr, "%hu", host->port);
+   results = bson_malloc0 (n * sizeof *results);
+   for (i = 0; i < n; i++) {
+      BSON_ASSERT (
+         0 == getaddrinfo (addresses[i], portstr, &hints, &results[i]));
+      BSON_ASSERT (!results[i]->ai_next);
+      if (i > 0) {
+         results[i - 1]->ai_next = results[i];
+      }
+   }
+
+   _mongoc_client_dns_cache_add (host, results[0]);
+
+   for (i = 0; i < n; i++) {
+      results[i]->ai_next = NULL;
+      freeaddrinfo (results[i]);
+   }
+
+   bson_free (results);
+}
+
+
+/* an unreachable address doesn't delay connecting to the next one for the
+ * full connectTimeoutMS */
+static void
+test_client_connect_happy_eyeballs (void)
+{
+   mock_server_t *server;
+   mongoc_uri_t *uri;
+   mongoc_host_list_t host;
+   /* a non-routable address first, then the mock server */
+   const char *addresses[] = {"192.0.2.1", "127.0.0.1"};
+   mongoc_stream_t *stream;
+   bson_error_t error;
+   int64_t start;
+
+   server = mock_server_new ();
+   mock_server_run (server);
+   uri = mongoc_uri_copy (mock_server_get_uri (server));
+   mongoc_uri_set_option_as_int32 (uri, MONGOC_URI_CONNECTTIMEOUTMS, 10000);
+   BSON_ASSERT (_mongoc_host_list_from_hostport_with_err (
+      &host, "happy-eyeballs.invalid", mock_server_get_port (server), &error));
+
+   _mongoc_client_dns_cache_clear ();
+   _cache_addresses (&host, addresses, 2);
+
+   start = bson_get_monotonic_time ();
+   stream = _mongoc_client_connect (uri, &host, NULL, &error);
+   ASSERT_OR_PRINT (stream, error);
+   ASSERT_CMPINT64 (
+      bson_get_monotonic_time () - start, <, (int64_t) 5000 * 1000);
+
+   mongoc_stream_destroy (stream);
+   _mongoc_client_dns_cache_clear ();
+   mongoc_uri_destroy (uri);
+   mock_server_destroy (server);
+}
+
+
+/* cached addresses are forgotten if none of them can be connected to */
+static void
+test_client_connect_dns_cache_evicted (void)
+{
+   mock_server_t *server;
+   mongoc_uri_t *uri;
+   mongoc_host_list_t host;
+   const char *addresses[] = {"127.0.0.1"};
+   mongoc_stream_t *stream;
+   bson_error_t error;
+
+   /* nothing listens on the port once the server is destroyed */
+   server = mock_server_new ();
+   mock_server_run (server);
+   uri = mongoc_uri_copy (mock_server_get_uri (server));
+   BSON_ASSERT (_mongoc_host_list_from_hostport_with_err (
+      &host, "happy-eyeballs.invalid", mock_server_get_port (server), &error));
+   mock_server_destroy (server);
+
+   _mongoc_client_dns_cache_clear ();
+   _cache_addresses (&host, addresses, 1);
+
+   stream = _mongoc_client_connect (uri, &host, NULL, &error);
+   BSON_ASSERT (!stream);
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_STREAM,
+                          MONGOC_ERROR_STREAM_CONNECT,
+                          "Failed to connect to target host");
+
+   /* the next attempt resolves the host again */
+   stream = _mongoc_client_connect (uri, &host, NULL, &error);
+   BSON_ASSERT (!stream);
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_STREAM,
+                          MONGOC_ERROR_STREAM_NAME_RESOLUTION,
+                          "Failed to resolve");
+
+   mongoc_uri_destroy (uri);
+}
+
+
 static void
 test_mongoc_client_unix_domain_socket (void *context)
 {
@@ -3405,6 +3519,7 @@ test_client_reset_sessions (void *ctx)
    bson_t opts = BSON_INITIALIZER;
    uint32_t csid;
    bson_t lsid;
+   bool res;
 
    server = mock_mongos_new (WIRE_VERSION_OP_MSG);
    mock_server_run (server);
@@ -3439,13 +3554,13 @@ test_client_reset_sessions (void *ctx)
 
    /* Ensure that a session left over from before the reset call cannot
       be used for any operations. */
-   bson_copy_to (mongoc_client_session_get_lsid (session, &lsid));
-   res = (mongoc_client_session_append (session, opts, &error));
+   bson_copy_to (mongoc_client_session_get_lsid (session), &lsid);
+   res = (mongoc_client_session_append (session, &opts, &error));
    ASSERT_OR_PRINT (res, error);
    future = future_client_command_with_opts (
       client, "admin", tmp_bson ("{'ping': 1}"), NULL, &opts, NULL, &error);
 
-   ASSERT (future_get_bool (!future));
+   ASSERT (!future_get_bool (future));
 
    request_destroy (request);
    future_destroy (future);
@@ -3838,4 +3953,10 @@ test_client_install (TestSuite *suite)
                       NULL,
                       test_framework_skip_if_slow);
    TestSuite_Add (suite, "/Client/get_database", test_get_database);
+   TestSuite_AddMockServerTest (suite,
+                                "/Client/connect/happy_eyeballs",
+                                test_client_connect_happy_eyeballs);
+   TestSuite_AddMockServerTest (suite,
+                                "/Client/connect/dns_cache_evicted",
+                                test_client_connect_dns_cache_evicted);
 }
@@ -3,6 +3,7 @@
 
 #include "mongoc/mongoc-client-private.h"
 #include "mongoc/mongoc-uri-private.h"
+#include "common-b64-private.h"
 
 #include "mock_server/mock-server.h"
 #include "mock_server/future.h"
@@ -448,7 +449,8 @@ test_cluster_time_cmd_started_cb (const mongoc_apm_command_started_t *event)
          bson_destroy (&client_cluster_time);
       }
    } else {
-      BSON_ASSERT (!bson_has_field (event->command, "$clusterTime"));
+      BSON_ASSERT (!bson_has_field (
+         mongoc_apm_command_started_get_command (event), "$clusterTime"));
    }
 }
 
@@ -928,6 +930,84 @@ test_cluster_time_comparison_pooled (void)
 }
 
 
+static void
+_ping_with_session (mongoc_client_session_t *cs,
+                    mock_server_t *server,
+                    uint32_t timestamp,
+                    uint32_t increment)
+{
+   bson_t opts = BSON_INITIALIZER;
+   bson_error_t error;
+   future_t *future;
+   request_t *request;
+
+   ASSERT_OR_PRINT (mongoc_client_session_append (cs, &opts, &error), error);
+   future = future_client_command_with_opts (cs->client,
+                                             "test",
+                                             tmp_bson ("{'ping': 1}"),
+                                             NULL,
+                                             &opts,
+                                             NULL,
+                                             &error);
+
+   request = receives_with_cluster_time (
+      server,
+      timestamp,
+      increment,
+      tmp_bson ("{'ping': 1, 'lsid': {'$exists': true}}"));
+   mock_server_replies_ok_and_destroys (request);
+   assert_ok (future, &error);
+   bson_destroy (&opts);
+}
+
+
+/* the larger of the session's and the topology's cluster time is sent */
+static void
+test_cluster_time_session_vs_topology (void)
+{
+   const char *ismaster = "{'ok': 1.0, 'ismaster': true, 'msg': 'isdbgrid',"
+                          " 'maxWireVersion': 6,"
+                          " 'logicalSessionTimeoutMinutes': 30}";
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_client_session_t *cs;
+   bson_error_t error;
+   future_t *future;
+   request_t *request;
+
+   server = mock_server_new ();
+   mock_server_auto_endsessions (server);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+
+   /* the topology's cluster time is 2, 2 */
+   future = future_ping (client, &error);
+   request = mock_server_receives_ismaster (server);
+   replies_with_cluster_time (request, 2, 2, ismaster);
+   request = receives_with_cluster_time (
+      server, 2, 2, tmp_bson ("{'ping': 1, 'lsid': {'$exists': true}}"));
+   mock_server_replies_ok_and_destroys (request);
+   assert_ok (future, &error);
+
+   cs = mongoc_client_start_session (client, NULL, &error);
+   ASSERT_OR_PRINT (cs, error);
+   mongoc_client_session_advance_cluster_time (
+      cs, tmp_bson ("{'clusterTime': {'$timestamp': {'t': 3, 'i': 1}}}"));
+   _ping_with_session (cs, server, 3, 1);
+   mongoc_client_session_destroy (cs);
+
+   cs = mongoc_client_start_session (client, NULL, &error);
+   ASSERT_OR_PRINT (cs, error);
+   mongoc_client_session_advance_cluster_time (
+      cs, tmp_bson ("{'clusterTime': {'$timestamp': {'t': 1, 'i': 1}}}"));
+   _ping_with_session (cs, server, 2, 2);
+   mongoc_client_session_destroy (cs);
+
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
 typedef future_t *(*run_command_fn_t) (mongoc_client_t *);
 typedef void (*cleanup_fn_t) (future_t *);
 
@@ -1553,6 +1633,210 @@ test_advanced_cluster_time_not_sent_to_standalone (void)
    mock_server_destroy (server);
 }
 
+#ifdef MONGOC_ENABLE_CRYPTO
+/* returns the fields of a reply to the client's first SCRAM message in
+ * @request's field named @field, as JSON. @salt must be as long as the
+ * mechanism requires */
+static char *
+_scram_server_first (request_t *request, const char *field, const char *salt)
+{
+   bson_iter_t iter;
+   bson_subtype_t subtype;
+   uint32_t len;
+   const uint8_t *data;
+   const char *client_nonce;
+   char *client_first;
+   char *server_first;
+   char encoded[256];
+   char *reply;
+
+   BSON_ASSERT (bson_iter_init (&iter, request_get_doc (request, 0)));
+   BSON_ASSERT (bson_iter_find_descendant (&iter, field, &iter));
+   BSON_ASSERT (BSON_ITER_HOLDS_BINARY (&iter));
+   bson_iter_binary (&iter, &subtype, &len, &data);
+
+   /* "n,,n=user,r=<client nonce>" */
+   client_first = bson_strndup ((const char *) data, len);
+   client_nonce = strstr (client_first, ",r=");
+   BSON_ASSERT (client_nonce);
+   server_first = bson_strdup_printf (
+      "r=%sc2VydmVy,s=%s,i=4096", client_nonce + 3, salt);
+   BSON_ASSERT (bson_b64_ntop ((const uint8_t *) server_first,
+                               strlen (server_first),
+                               encoded,
+                               sizeof encoded) > 0);
+   reply = bson_strdup_printf (
+      "'conversationId': 1, 'done': false,"
+      " 'payload': {'$binary': {'subType': '0', 'base64': '%s'}}",
+      encoded);
+
+   bson_free (server_first);
+   bson_free (client_first);
+
+   return reply;
+}
+
+
+typedef struct {
+   bool server_supports_speculative_auth;
+   int32_t n_speculative_ismasters;
+} speculative_auth_test_t;
+
+
+static bool
+_speculative_auth_ismaster (request_t *request, void *data)
+{
+   speculative_auth_test_t *test = (speculative_auth_test_t *) data;
+   char *server_first = NULL;
+   char *reply;
+
+   if (!request->is_command ||
+       strcasecmp (request->command_name, "ismaster")) {
+      return false;
+   }
+
+   if (bson_has_field (request_get_doc (request, 0),
+                       "speculativeAuthenticate")) {
+      bson_atomic_int_add (&test->n_speculative_ismasters, 1);
+      if (test->server_supports_speculative_auth) {
+         server_first = _scram_server_first (
+            request,
+            "speculativeAuthenticate.payload",
+            "c2FsdHNhbHRzYWx0c2FsdHNhbHRzYWx0c2FsdA==");
+      }
+   }
+
+   reply = bson_strdup_printf ("{'ok': 1, 'ismaster': true,"
+                               " 'minWireVersion': 0, 'maxWireVersion': %d"
+                               "%s%s%s}",
+                               WIRE_VERSION_OP_MSG,
+                               server_first ? ", 'speculativeAuthenticate': {"
+                                            : "",
+                               server_first ? server_first : "",
+                               server_first ? "}" : "");
+   mock_server_replies_simple (request, reply);
+   request_destroy (request);
+
+   bson_free (reply);
+   bson_free (server_first);
+
+   return true;
+}
+
+
+/* a new authenticated connection begins SCRAM-SHA-256 in its handshake,
+ * saving the saslStart round trip, or falls back to the negotiated mechanism
+ * if the server ignores speculativeAuthenticate */
+static void
+_test_speculative_auth (bool pooled, bool server_supports_speculative_auth)
+{
+   mock_server_t *server;
+   speculative_auth_test_t test = {0};
+   mongoc_uri_t *uri;
+   mongoc_client_pool_t *pool = NULL;
+   mongoc_client_t *client;
+   future_t *future;
+   request_t *request;
+   char *server_first;
+   char *reply;
+   bson_error_t error;
+
+   test.server_supports_speculative_auth = server_supports_speculative_auth;
+   server = mock_server_new ();
+   mock_server_autoresponds (
+      server, _speculative_auth_ismaster, &test, NULL);
+   mock_server_run (server);
+
+   uri = mongoc_uri_copy (mock_server_get_uri (server));
+   mongoc_uri_set_username (uri, "user");
+   mongoc_uri_set_password (uri, "pencil");
+
+   if (pooled) {
+      pool = mongoc_client_pool_new (uri);
+      client = mongoc_client_pool_pop (pool);
+   } else {
+      client = mongoc_client_new_from_uri (uri);
+   }
+
+   future = future_client_command_simple (
+      client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+
+   if (!server_supports_speculative_auth) {
+      /* no saslSupportedMechs in the ismaster reply, use SCRAM-SHA-1 */
+      request = mock_server_receives_msg (
+         server,
+         0,
+         tmp_bson ("{'saslStart': 1, 'mechanism': 'SCRAM-SHA-1',"
+                   " '$db': 'admin'}"));
+      server_first =
+         _scram_server_first (request, "payload", "c2FsdHNhbHRzYWx0c2FsdA==");
+      reply = bson_strdup_printf ("{'ok': 1, %s}", server_first);
+      mock_server_replies_simple (request, reply);
+      request_destroy (request);
+      bson_free (reply);
+      bson_free (server_first);
+   }
+
+   request = mock_server_receives_msg (
+      server,
+      0,
+      tmp_bson ("{'saslContinue': 1, 'conversationId': 1, '$db': 'admin'}"));
+   mock_server_replies_simple (
+      request,
+      "{'ok': 1, 'conversationId': 1, 'done': true,"
+      " 'payload': {'$binary': {'subType': '0', 'base64': ''}}}");
+   request_destroy (request);
+
+   request = mock_server_receives_msg (
+      server, 0, tmp_bson ("{'ping': 1, '$db': 'admin'}"));
+   mock_server_replies_ok_and_destroys (request);
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+
+   /* only the connection the client authenticated began a conversation */
+   ASSERT_CMPINT32 (test.n_speculative_ismasters, ==, 1);
+
+   if (pooled) {
+      mongoc_client_pool_push (pool, client);
+      mongoc_client_pool_destroy (pool);
+   } else {
+      mongoc_client_destroy (client);
+   }
+
+   mongoc_uri_destroy (uri);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_speculative_auth_single (void)
+{
+   _test_speculative_auth (false, true);
+}
+
+
+static void
+test_speculative_auth_pooled (void)
+{
+   _test_speculative_auth (true, true);
+}
+
+
+static void
+test_speculative_auth_unsupported_single (void)
+{
+   _test_speculative_auth (false, false);
+}
+
+
+static void
+test_speculative_auth_unsupported_pooled (void)
+{
+   _test_speculative_auth (true, false);
+}
+#endif
+
+
 void
 test_cluster_install (TestSuite *suite)
 {
@@ -1641,6 +1925,10 @@ test_cluster_install (TestSuite *suite)
                                 "/Cluster/cluster_time/comparison/pooled",
                                 test_cluster_time_comparison_pooled,
                                 test_framework_skip_if_slow);
+   TestSuite_AddMockServerTest (suite,
+                                "/Cluster/cluster_time/session_vs_topology",
+                                test_cluster_time_session_vs_topology,
+                                test_framework_skip_if_no_crypto);
    TestSuite_AddMockServerTest (
       suite,
       "/Cluster/cluster_time/advanced_not_sent_to_standalone",
@@ -1688,4 +1976,18 @@ test_cluster_install (TestSuite *suite)
    TestSuite_AddMockServerTest (suite,
                                 "/Cluster/command_error/op_query",
                                 test_cluster_command_error_op_query);
+#ifdef MONGOC_ENABLE_CRYPTO
+   TestSuite_AddMockServerTest (suite,
+                                "/Cluster/speculative_auth/single",
+                                test_speculative_auth_single);
+   TestSuite_AddMockServerTest (suite,
+                                "/Cluster/speculative_auth/pooled",
+                                test_speculative_auth_pooled);
+   TestSuite_AddMockServerTest (suite,
+                                "/Cluster/speculative_auth/unsupported/single",
+                                test_speculative_auth_unsupported_single);
+   TestSuite_AddMockServerTest (suite,
+                                "/Cluster/speculative_auth/unsupported/pooled",
+                                test_speculative_auth_unsupported_pooled);
+#endif
 }
@@ -607,6 +607,120 @@ test_insert_oversize (void *ctx)
 }
 
 
+static void
+test_insert_raw (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   bson_writer_t *writer;
+   uint8_t *buf = NULL;
+   size_t buflen = 0;
+   bson_t *b;
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+   bson_t reply;
+   const bson_t *docs[5];
+   int i;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_MAX);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "collection");
+
+   writer = bson_writer_new (&buf, &buflen, 0, bson_realloc_ctx, NULL);
+   for (i = 0; i < 3; i++) {
+      BSON_ASSERT (bson_writer_begin (writer, &b));
+      BSON_APPEND_INT32 (b, "_id", i);
+      bson_writer_end (writer);
+   }
+
+   /* no _id is generated for raw documents */
+   BSON_ASSERT (bson_writer_begin (writer, &b));
+   BSON_APPEND_INT32 (b, "x", 1);
+   bson_writer_end (writer);
+
+   future = future_collection_insert_raw (collection,
+                                          buf,
+                                          bson_writer_get_length (writer),
+                                          tmp_bson ("{'ordered': false}"),
+                                          &reply,
+                                          &error);
+
+   docs[0] = tmp_bson ("{'insert': 'collection', 'ordered': false}");
+   docs[1] = tmp_bson ("{'_id': 0}");
+   docs[2] = tmp_bson ("{'_id': 1}");
+   docs[3] = tmp_bson ("{'_id': 2}");
+   docs[4] = tmp_bson ("{'_id': {'$exists': false}, 'x': 1}");
+   request = mock_server_receives_request (server);
+   BSON_ASSERT (request_matches_msg (request, 0, docs, 5));
+   mock_server_replies_simple (request, "{'ok': 1, 'n': 4}");
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   ASSERT_MATCH (&reply, "{'insertedCount': 4}");
+
+   bson_destroy (&reply);
+   request_destroy (request);
+   future_destroy (future);
+
+   /* a truncated buffer is an error */
+   ASSERT (!mongoc_collection_insert_raw (collection,
+                                          buf,
+                                          bson_writer_get_length (writer) - 1,
+                                          NULL,
+                                          &reply,
+                                          &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_BSON,
+                          MONGOC_ERROR_BSON_INVALID,
+                          "Invalid BSON document at index 3");
+   bson_destroy (&reply);
+
+   bson_writer_rollback (writer);
+   bson_writer_destroy (writer);
+   bson_free (buf);
+
+   /* documents are validated unless validate is false */
+   buf = NULL;
+   buflen = 0;
+   writer = bson_writer_new (&buf, &buflen, 0, bson_realloc_ctx, NULL);
+   BSON_ASSERT (bson_writer_begin (writer, &b));
+   BSON_APPEND_INT32 (b, "$x", 1);
+   bson_writer_end (writer);
+
+   ASSERT (!mongoc_collection_insert_raw (collection,
+                                          buf,
+                                          bson_writer_get_length (writer),
+                                          NULL,
+                                          &reply,
+                                          &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_COMMAND,
+                          MONGOC_ERROR_COMMAND_INVALID_ARG,
+                          "invalid document for insert");
+   bson_destroy (&reply);
+
+   future = future_collection_insert_raw (collection,
+                                          buf,
+                                          bson_writer_get_length (writer),
+                                          tmp_bson ("{'validate': false}"),
+                                          NULL,
+                                          &error);
+   request = mock_server_receives_msg (
+      server, 0, tmp_bson ("{'insert': 'collection'}"), tmp_bson ("{'$x': 1}"));
+   mock_server_replies_simple (request, "{'ok': 1, 'n': 1}");
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+
+   request_destroy (request);
+   future_destroy (future);
+   bson_writer_destroy (writer);
+   bson_free (buf);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
 static void
 test_insert_many (void)
 {
@@ -5728,6 +5842,240 @@ test_update_collation (void)
       WIRE_VERSION_COLLATION - 1, true, false);
 }
 
+static void
+test_prepared_update (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_prepared_update_t *prepared;
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+   bson_t reply;
+   int i;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_MAX);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "collection");
+
+   prepared = mongoc_collection_prepare_update_one (
+      collection,
+      tmp_bson ("{'upsert': true, 'collation': {'locale': 'en'},"
+                " 'writeConcern': {'w': 2}}"),
+      &error);
+   ASSERT_OR_PRINT (prepared, error);
+
+   /* the prepared options are reused for each selector and update */
+   for (i = 0; i < 3; i++) {
+      future = future_prepared_update_execute (
+         prepared,
+         tmp_bson ("{'_id': %d}", i),
+         tmp_bson ("{'$set': {'x': %d}}", i),
+         &reply,
+         &error);
+
+      request = mock_server_receives_msg (
+         server,
+         0,
+         tmp_bson ("{'update': 'collection', 'writeConcern': {'w': 2}}"),
+         tmp_bson ("{'q': {'_id': %d}, 'u': {'$set': {'x': %d}},"
+                   " 'upsert': true, 'collation': {'locale': 'en'},"
+                   " 'multi': {'$exists': false}}",
+                   i,
+                   i));
+      mock_server_replies_simple (request, "{'ok': 1, 'n': 1, 'nModified': 1}");
+      ASSERT_OR_PRINT (future_get_bool (future), error);
+      ASSERT_MATCH (&reply, "{'matchedCount': 1, 'modifiedCount': 1}");
+
+      bson_destroy (&reply);
+      request_destroy (request);
+      future_destroy (future);
+   }
+
+   /* the update document is still validated on each execution */
+   ASSERT (!mongoc_prepared_update_execute (
+      prepared, tmp_bson ("{}"), tmp_bson ("{'x': 1}"), &reply, &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_COMMAND,
+                          MONGOC_ERROR_COMMAND_INVALID_ARG,
+                          "Invalid key 'x': update only works with $ operators");
+   bson_destroy (&reply);
+
+   mongoc_prepared_update_destroy (prepared);
+
+   prepared = mongoc_collection_prepare_update_many (
+      collection, tmp_bson ("{'arrayFilters': [{'i': 1}]}"), &error);
+   ASSERT_OR_PRINT (prepared, error);
+   future = future_prepared_update_execute (prepared,
+                                            tmp_bson ("{}"),
+                                            tmp_bson ("{'$set': {'x': 1}}"),
+                                            NULL,
+                                            &error);
+
+   request = mock_server_receives_msg (
+      server,
+      0,
+      tmp_bson ("{'update': 'collection'}"),
+      tmp_bson ("{'q': {}, 'u': {'$set': {'x': 1}}, 'multi': true,"
+                " 'arrayFilters': [{'i': 1}]}"));
+   mock_server_replies_simple (request, "{'ok': 1, 'n': 2}");
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+
+   request_destroy (request);
+   future_destroy (future);
+   mongoc_prepared_update_destroy (prepared);
+
+   prepared = mongoc_collection_prepare_replace_one (
+      collection, tmp_bson ("{'bypassDocumentValidation': true}"), &error);
+   ASSERT_OR_PRINT (prepared, error);
+   future = future_prepared_update_execute (
+      prepared, tmp_bson ("{}"), tmp_bson ("{'x': 1}"), NULL, &error);
+
+   request = mock_server_receives_msg (
+      server,
+      0,
+      tmp_bson ("{'update': 'collection', 'bypassDocumentValidation': true}"),
+      tmp_bson ("{'q': {}, 'u': {'x': 1}}"));
+   mock_server_replies_simple (request, "{'ok': 1, 'n': 1}");
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+
+   request_destroy (request);
+   future_destroy (future);
+   mongoc_prepared_update_destroy (prepared);
+
+   /* invalid opts are reported when preparing */
+   prepared = mongoc_collection_prepare_update_one (
+      collection, tmp_bson ("{'upsert': 1}"), &error);
+   ASSERT (!prepared);
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_COMMAND,
+                          MONGOC_ERROR_COMMAND_INVALID_ARG,
+                          "Invalid field \"upsert\" in opts");
+
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_prepared_find (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_prepared_find_t *prepared;
+   mongoc_cursor_t *cursor;
+   mongoc_cursor_t *first = NULL;
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+   const bson_t *doc;
+   int i;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_MAX);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "collection");
+
+   prepared = mongoc_collection_prepare_find (
+      collection,
+      tmp_bson ("{'projection': {'x': 1}, 'limit': 2, 'sort': {'x': -1}}"),
+      NULL,
+      &error);
+   ASSERT_OR_PRINT (prepared, error);
+
+   for (i = 0; i < 3; i++) {
+      cursor = mongoc_prepared_find_execute (prepared, tmp_bson ("{'x': %d}", i));
+      /* every execute reuses the prepared find's cursor */
+      if (i == 0) {
+         first = cursor;
+      } else {
+         ASSERT (cursor == first);
+      }
+
+      future = future_cursor_next (cursor, &doc);
+      request = mock_server_receives_msg (
+         server,
+         0,
+         tmp_bson ("{'find': 'collection', 'filter': {'x': %d},"
+                   " 'projection': {'x': 1}, 'limit': 2, 'sort': {'x': -1}}",
+                   i));
+      mock_server_replies_simple (request,
+                                  "{'ok': 1, 'cursor': {'id': 0,"
+                                  " 'ns': 'db.collection',"
+                                  " 'firstBatch': [{'x': 1}]}}");
+      ASSERT (future_get_bool (future));
+      ASSERT_MATCH (doc, "{'x': 1}");
+      ASSERT (!mongoc_cursor_next (cursor, &doc));
+      ASSERT_OR_PRINT (!mongoc_cursor_error (cursor, &error), error);
+
+      request_destroy (request);
+      future_destroy (future);
+   }
+
+   /* abandon a server-side cursor, with a batch size set on the cursor */
+   cursor = mongoc_prepared_find_execute (prepared, tmp_bson ("{'x': 3}"));
+   mongoc_cursor_set_batch_size (cursor, 1);
+   future = future_cursor_next (cursor, &doc);
+   request = mock_server_receives_msg (
+      server,
+      0,
+      tmp_bson ("{'find': 'collection', 'filter': {'x': 3},"
+                " 'batchSize': {'$numberLong': '1'}}"));
+   mock_server_replies_simple (request,
+                               "{'ok': 1, 'cursor': {'id': 123,"
+                               " 'ns': 'db.collection',"
+                               " 'firstBatch': [{'x': 1}]}}");
+   ASSERT (future_get_bool (future));
+   request_destroy (request);
+   future_destroy (future);
+
+   /* the next execute kills it, and drops the batch size */
+   future = future_prepared_find_execute (prepared, tmp_bson ("{}"));
+   request = mock_server_receives_msg (
+      server,
+      0,
+      tmp_bson ("{'killCursors': 'collection', 'cursors': [{'$numberLong':"
+                " '123'}]}"));
+   mock_server_replies_simple (request, "{'ok': 1}");
+   ASSERT (future_get_mongoc_cursor_ptr (future) == first);
+   request_destroy (request);
+   future_destroy (future);
+
+   future = future_cursor_next (first, &doc);
+   request = mock_server_receives_msg (
+      server,
+      0,
+      tmp_bson ("{'find': 'collection', 'filter': {},"
+                " 'batchSize': {'$exists': false}}"));
+   mock_server_replies_simple (request,
+                               "{'ok': 1, 'cursor': {'id': 0,"
+                               " 'ns': 'db.collection',"
+                               " 'firstBatch': [{'x': 2}]}}");
+   ASSERT (future_get_bool (future));
+   ASSERT_MATCH (doc, "{'x': 2}");
+   request_destroy (request);
+   future_destroy (future);
+
+   mongoc_prepared_find_destroy (prepared);
+
+   /* invalid opts are reported when preparing */
+   prepared = mongoc_collection_prepare_find (
+      collection, tmp_bson ("{'$orderby': {'x': 1}}"), NULL, &error);
+   ASSERT (!prepared);
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_CURSOR,
+                          MONGOC_ERROR_CURSOR_INVALID_CURSOR,
+                          "Cannot use $-modifiers in opts");
+
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
 void
 test_collection_install (TestSuite *suite)
 {
@@ -5746,6 +6094,8 @@ test_collection_install (TestSuite *suite)
                       NULL,
                       test_framework_skip_if_mongos);
    TestSuite_AddLive (suite, "/Collection/insert_many", test_insert_many);
+   TestSuite_AddMockServerTest (
+      suite, "/Collection/insert_raw", test_insert_raw);
    TestSuite_AddLive (
       suite, "/Collection/insert_bulk_empty", test_insert_bulk_empty);
    TestSuite_AddLive (suite, "/Collection/copy", test_copy);
@@ -5932,6 +6282,10 @@ test_collection_install (TestSuite *suite)
       suite, "/Collection/delete/collation", test_delete_collation);
    TestSuite_AddMockServerTest (
       suite, "/Collection/update/collation", test_update_collation);
+   TestSuite_AddMockServerTest (
+      suite, "/Collection/prepared/update", test_prepared_update);
+   TestSuite_AddMockServerTest (
+      suite, "/Collection/prepared/find", test_prepared_find);
    TestSuite_AddMockServerTest (
       suite, "/Collection/count_documents", test_count_documents);
    TestSuite_AddLive (
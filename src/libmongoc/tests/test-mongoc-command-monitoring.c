@@ -1,4 +1,5 @@
 #include <mongoc/mongoc.h>
+#include <mongoc/mongoc-apm-private.h>
 #include <mongoc/mongoc-bulk-operation-private.h>
 #include <mongoc/mongoc-collection-private.h>
 
@@ -1170,6 +1171,369 @@ test_command_failed_reply_hangup (void)
 }
 
 
+typedef struct {
+   bool get_command;
+   bool copied_before_get;
+   bool copied_after_get;
+   bson_t command;
+} lazy_command_test_t;
+
+
+static void
+lazy_command_started_cb (const mongoc_apm_command_started_t *event)
+{
+   lazy_command_test_t *test;
+
+   test = (lazy_command_test_t *) mongoc_apm_command_started_get_context (
+      event);
+
+   if (strcmp (mongoc_apm_command_started_get_command_name (event),
+               "insert") != 0) {
+      return;
+   }
+
+   test->copied_before_get = event->command_owned;
+   if (test->get_command) {
+      bson_destroy (&test->command);
+      bson_copy_to (mongoc_apm_command_started_get_command (event),
+                    &test->command);
+      /* the command is built once */
+      BSON_ASSERT (mongoc_apm_command_started_get_command (event) ==
+                   mongoc_apm_command_started_get_command (event));
+   }
+
+   test->copied_after_get = event->command_owned;
+}
+
+
+static void
+_insert_two (mongoc_collection_t *collection, mock_server_t *server)
+{
+   const bson_t *docs[2];
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+
+   docs[0] = tmp_bson ("{'_id': 1}");
+   docs[1] = tmp_bson ("{'_id': 2}");
+   future = future_collection_insert_many (
+      collection, docs, 2, NULL, NULL, &error);
+   request = mock_server_receives_msg (server,
+                                       0,
+                                       tmp_bson ("{'insert': 'collection'}"),
+                                       tmp_bson ("{'_id': 1}"),
+                                       tmp_bson ("{'_id': 2}"));
+   mock_server_replies_ok_and_destroys (request);
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+}
+
+
+/* the started event's command is only combined with an OP_MSG document
+ * sequence if the callback asks for it */
+static void
+test_lazy_command (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_apm_callbacks_t *callbacks;
+   mongoc_collection_t *collection;
+   lazy_command_test_t test = {0};
+
+   bson_init (&test.command);
+   server = mock_server_with_autoismaster (WIRE_VERSION_OP_MSG);
+   mock_server_run (server);
+
+   callbacks = mongoc_apm_callbacks_new ();
+   mongoc_apm_set_command_started_cb (callbacks, lazy_command_started_cb);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   ASSERT (mongoc_client_set_apm_callbacks (client, callbacks, (void *) &test));
+   collection = mongoc_client_get_collection (client, "db", "collection");
+
+   _insert_two (collection, server);
+   BSON_ASSERT (!test.copied_before_get);
+   BSON_ASSERT (!test.copied_after_get);
+
+   test.get_command = true;
+   _insert_two (collection, server);
+   BSON_ASSERT (!test.copied_before_get);
+   BSON_ASSERT (test.copied_after_get);
+   ASSERT_MATCH (&test.command,
+                 "{'insert': 'collection',"
+                 " 'documents': [{'_id': 1}, {'_id': 2}]}");
+
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mongoc_apm_callbacks_destroy (callbacks);
+   mock_server_destroy (server);
+   bson_destroy (&test.command);
+}
+
+
+typedef struct {
+   int succeeded_calls;
+   int failed_calls;
+   int64_t duration;
+   int64_t phase_duration[MONGOC_SPAN_PHASE_COUNT];
+} phase_duration_test_t;
+
+
+static void
+phase_duration_succeeded_cb (const mongoc_apm_command_succeeded_t *event)
+{
+   phase_duration_test_t *test;
+   int i;
+
+   test = (phase_duration_test_t *) mongoc_apm_command_succeeded_get_context (
+      event);
+   test->succeeded_calls++;
+   test->duration = mongoc_apm_command_succeeded_get_duration (event);
+   for (i = 0; i < MONGOC_SPAN_PHASE_COUNT; i++) {
+      test->phase_duration[i] =
+         mongoc_apm_command_succeeded_get_phase_duration (
+            event, (mongoc_span_phase_t) i);
+   }
+}
+
+
+static void
+phase_duration_failed_cb (const mongoc_apm_command_failed_t *event)
+{
+   phase_duration_test_t *test;
+   int i;
+
+   test =
+      (phase_duration_test_t *) mongoc_apm_command_failed_get_context (event);
+   test->failed_calls++;
+   test->duration = mongoc_apm_command_failed_get_duration (event);
+   for (i = 0; i < MONGOC_SPAN_PHASE_COUNT; i++) {
+      test->phase_duration[i] = mongoc_apm_command_failed_get_phase_duration (
+         event, (mongoc_span_phase_t) i);
+   }
+}
+
+
+/* the server replies to "ping" after @delay_ms */
+static void
+_ping_with_delay (mongoc_client_t *client,
+                  mock_server_t *server,
+                  int64_t delay_ms,
+                  const char *reply)
+{
+   future_t *future;
+   request_t *request;
+
+   future = future_client_command_simple (
+      client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, NULL);
+   request = mock_server_receives_msg (server, 0, tmp_bson ("{'ping': 1}"));
+   _mongoc_usleep (delay_ms * 1000);
+   mock_server_replies_simple (request, reply);
+   future_wait (future);
+   future_destroy (future);
+   request_destroy (request);
+}
+
+
+static void
+_check_phase_durations (phase_duration_test_t *test, int64_t delay_ms)
+{
+   int64_t sum = 0;
+   int i;
+
+   /* phases before the command's started event aren't in its duration */
+   ASSERT_CMPINT64 (
+      test->phase_duration[MONGOC_SPAN_PHASE_SERVER_SELECTION], ==, 0);
+   ASSERT_CMPINT64 (
+      test->phase_duration[MONGOC_SPAN_PHASE_CONNECTION_CHECKOUT], ==, 0);
+   ASSERT_CMPINT64 (test->phase_duration[MONGOC_SPAN_PHASE_SESSION_POP], ==, 0);
+   ASSERT_CMPINT64 (
+      test->phase_duration[MONGOC_SPAN_PHASE_COMMAND_ASSEMBLY], ==, 0);
+
+   /* the reply isn't compressed */
+   ASSERT_CMPINT64 (test->phase_duration[MONGOC_SPAN_PHASE_DECOMPRESS], ==, 0);
+
+   /* the delay is spent waiting for the server */
+   ASSERT_CMPINT64 (
+      test->phase_duration[MONGOC_SPAN_PHASE_WAIT], >=, delay_ms * 1000);
+
+   for (i = 0; i < MONGOC_SPAN_PHASE_COUNT; i++) {
+      ASSERT_CMPINT64 (test->phase_duration[i], >=, 0);
+      sum += test->phase_duration[i];
+   }
+
+   ASSERT_CMPINT64 (sum, <=, test->duration);
+}
+
+
+static void
+test_phase_durations (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_apm_callbacks_t *callbacks;
+   phase_duration_test_t test = {0};
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_OP_MSG);
+   mock_server_run (server);
+
+   callbacks = mongoc_apm_callbacks_new ();
+   mongoc_apm_set_command_succeeded_cb (callbacks, phase_duration_succeeded_cb);
+   mongoc_apm_set_command_failed_cb (callbacks, phase_duration_failed_cb);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   ASSERT (mongoc_client_set_apm_callbacks (client, callbacks, (void *) &test));
+
+   _ping_with_delay (client, server, 50, "{'ok': 1}");
+   ASSERT_CMPINT (test.succeeded_calls, ==, 1);
+   _check_phase_durations (&test, 50);
+
+   _ping_with_delay (
+      client, server, 20, "{'ok': 0, 'code': 42, 'errmsg': 'bad!'}");
+   ASSERT_CMPINT (test.failed_calls, ==, 1);
+   _check_phase_durations (&test, 20);
+
+   mongoc_client_destroy (client);
+   mongoc_apm_callbacks_destroy (callbacks);
+   mock_server_destroy (server);
+}
+
+
+/* commands and cursors sent to servers older than 3.6, as OP_QUERY, and to
+ * servers older than 3.2, as legacy OP_QUERY and OP_GET_MORE */
+static void
+test_phase_durations_op_query (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_apm_callbacks_t *callbacks;
+   mongoc_collection_t *collection;
+   mongoc_cursor_t *cursor;
+   phase_duration_test_t test = {0};
+   const bson_t *doc;
+   future_t *future;
+   request_t *request;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_FIND_CMD - 1);
+   mock_server_run (server);
+
+   callbacks = mongoc_apm_callbacks_new ();
+   mongoc_apm_set_command_succeeded_cb (callbacks, phase_duration_succeeded_cb);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   ASSERT (mongoc_client_set_apm_callbacks (client, callbacks, (void *) &test));
+
+   future = future_client_command_simple (
+      client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, NULL);
+   request = mock_server_receives_command (
+      server, "admin", MONGOC_QUERY_SLAVE_OK, "{'ping': 1}");
+   _mongoc_usleep (50 * 1000);
+   mock_server_replies_simple (request, "{'ok': 1}");
+   ASSERT (future_get_bool (future));
+   future_destroy (future);
+   request_destroy (request);
+   ASSERT_CMPINT (test.succeeded_calls, ==, 1);
+   _check_phase_durations (&test, 50);
+
+   collection = mongoc_client_get_collection (client, "db", "collection");
+   cursor = mongoc_collection_find_with_opts (
+      collection, tmp_bson ("{}"), tmp_bson ("{'batchSize': 1}"), NULL);
+
+   future = future_cursor_next (cursor, &doc);
+   request = mock_server_receives_query (
+      server, "db.collection", MONGOC_QUERY_SLAVE_OK, 0, 1, "{}", NULL);
+   _mongoc_usleep (20 * 1000);
+   mock_server_replies (request, MONGOC_REPLY_NONE, 123, 0, 1, "{'_id': 1}");
+   ASSERT (future_get_bool (future));
+   future_destroy (future);
+   request_destroy (request);
+   ASSERT_CMPINT (test.succeeded_calls, ==, 2);
+   _check_phase_durations (&test, 20);
+
+   future = future_cursor_next (cursor, &doc);
+   request = mock_server_receives_getmore (server, "db.collection", 1, 123);
+   _mongoc_usleep (30 * 1000);
+   mock_server_replies (request, MONGOC_REPLY_NONE, 0, 1, 1, "{'_id': 2}");
+   ASSERT (future_get_bool (future));
+   future_destroy (future);
+   request_destroy (request);
+   ASSERT_CMPINT (test.succeeded_calls, ==, 3);
+   _check_phase_durations (&test, 30);
+
+   mongoc_cursor_destroy (cursor);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mongoc_apm_callbacks_destroy (callbacks);
+   mock_server_destroy (server);
+}
+
+
+/* two batches of a bulk write are in flight at once; the second's reply is
+ * read after the first's, but its wait began when it was sent */
+static void
+test_phase_durations_pipelined (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_apm_callbacks_t *callbacks;
+   mongoc_collection_t *collection;
+   mongoc_bulk_operation_t *bulk;
+   phase_duration_test_t test = {0};
+   bson_error_t error;
+   future_t *future;
+   request_t *requests[2];
+   int i;
+
+   server = mock_server_new ();
+   mock_server_auto_ismaster (server,
+                              "{'ok': 1.0,"
+                              " 'ismaster': true,"
+                              " 'minWireVersion': 0,"
+                              " 'maxWireVersion': %d,"
+                              " 'maxWriteBatchSize': 1}",
+                              WIRE_VERSION_OP_MSG);
+   mock_server_run (server);
+
+   callbacks = mongoc_apm_callbacks_new ();
+   mongoc_apm_set_command_succeeded_cb (callbacks, phase_duration_succeeded_cb);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   ASSERT (mongoc_client_set_apm_callbacks (client, callbacks, (void *) &test));
+   collection = mongoc_client_get_collection (client, "db", "collection");
+   bulk = mongoc_collection_create_bulk_operation_with_opts (
+      collection, tmp_bson ("{'ordered': false}"));
+   for (i = 0; i < 2; i++) {
+      mongoc_bulk_operation_insert (bulk, tmp_bson ("{'_id': %d}", i));
+   }
+
+   mongoc_bulk_operation_set_pipeline_depth (bulk, 2);
+   future = future_bulk_operation_execute (bulk, NULL, &error);
+   for (i = 0; i < 2; i++) {
+      requests[i] =
+         mock_server_receives_msg (server,
+                                   0,
+                                   tmp_bson ("{'insert': 'collection',"
+                                             " 'ordered': false}"),
+                                   tmp_bson ("{'_id': %d}", i));
+   }
+
+   /* the server answers both at once, after a delay */
+   _mongoc_usleep (50 * 1000);
+   for (i = 0; i < 2; i++) {
+      mock_server_replies_simple (requests[i], "{'ok': 1, 'n': 1}");
+      request_destroy (requests[i]);
+   }
+
+   ASSERT_OR_PRINT (future_get_uint32_t (future), error);
+   ASSERT_CMPINT (test.succeeded_calls, ==, 2);
+   /* the second batch's wait overlaps the first's */
+   _check_phase_durations (&test, 50);
+
+   future_destroy (future);
+   mongoc_bulk_operation_destroy (bulk);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mongoc_apm_callbacks_destroy (callbacks);
+   mock_server_destroy (server);
+}
+
+
 void
 test_command_monitoring_install (TestSuite *suite)
 {
@@ -1221,4 +1585,14 @@ test_command_monitoring_install (TestSuite *suite)
    TestSuite_AddMockServerTest (suite,
                                 "/command_monitoring/failed_reply_hangup",
                                 test_command_failed_reply_hangup);
+   TestSuite_AddMockServerTest (
+      suite, "/command_monitoring/lazy_command", test_lazy_command);
+   TestSuite_AddMockServerTest (
+      suite, "/command_monitoring/phase_durations", test_phase_durations);
+   TestSuite_AddMockServerTest (suite,
+                                "/command_monitoring/phase_durations/op_query",
+                                test_phase_durations_op_query);
+   TestSuite_AddMockServerTest (suite,
+                                "/command_monitoring/phase_durations/pipelined",
+                                test_phase_durations_pipelined);
 }
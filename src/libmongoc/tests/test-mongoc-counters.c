@@ -15,6 +15,7 @@
  */
 
 #include <mongoc/mongoc-util-private.h>
+#include "mongoc/mongoc-client-private.h"
 #include "mongoc/mongoc-counters-private.h"
 #include "mock_server/mock-server.h"
 #include "test-conveniences.h"
@@ -52,6 +53,20 @@
       RESET (id)                              \
    } while (0);
 
+/* sum each histogram's count of values over all CPUs. */
+#define HISTOGRAM(id, category, name, description)               \
+   int64_t histogram_count_##id (void)                           \
+   {                                                             \
+      int64_t _sum = 0;                                          \
+      uint32_t _i;                                               \
+      for (_i = 0; _i < _mongoc_get_cpu_count (); _i++) {        \
+         _sum += __mongoc_histogram_##id.cpus[_i].count;         \
+      }                                                          \
+      return _sum;                                               \
+   }
+#include "mongoc/mongoc-histograms.defs"
+#undef HISTOGRAM
+
 static void
 reset_all_counters ()
 {
@@ -324,6 +339,9 @@ test_counters_clients (void)
    DIFF_AND_RESET (clients_disposed, ==, 0);
    DIFF_AND_RESET (client_pools_active, ==, 0);
    DIFF_AND_RESET (client_pools_disposed, ==, 0);
+   DIFF_AND_RESET (client_pools_created, ==, 1);
+   DIFF_AND_RESET (client_pools_destroyed, ==, 0);
+   DIFF_AND_RESET (client_pools_waits, ==, 0);
    mongoc_client_destroy (client);
    DIFF_AND_RESET (clients_active, ==, -1);
    DIFF_AND_RESET (clients_disposed, ==, 1);
@@ -485,6 +503,16 @@ test_counters_auth (void *ctx)
    ASSERT_OR_PRINT (ret, err);
    DIFF_AND_RESET (auth_success, ==, 1);
    DIFF_AND_RESET (auth_failure, ==, 0);
+   mongoc_client_destroy (client);
+   /* a new client reuses the SCRAM keys the first one derived */
+   client = mongoc_client_new_from_uri (uri);
+   test_framework_set_ssl_opts (client);
+   ret = mongoc_client_command_simple (
+      client, "test", tmp_bson ("{'ping': 1}"), NULL, NULL, &err);
+   ASSERT_OR_PRINT (ret, err);
+   DIFF_AND_RESET (auth_success, ==, 1);
+   DIFF_AND_RESET (auth_scram_cache_hit, ==, 1);
+   DIFF_AND_RESET (auth_scram_cache_miss, ==, 0);
    mongoc_uri_destroy (uri);
    bson_free (uri_str);
    bson_free (uri_str_bad);
@@ -517,6 +545,395 @@ test_counters_dns (void)
 }
 
 
+static void
+_ping_mock_server (mongoc_client_t *client, mock_server_t *server)
+{
+   future_t *future;
+   request_t *request;
+
+   future = future_client_command_simple (
+      client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, NULL);
+   request = mock_server_receives_msg (server, 0, tmp_bson ("{'ping': 1}"));
+   mock_server_replies_ok_and_destroys (request);
+   BSON_ASSERT (future_get_bool (future));
+   future_destroy (future);
+}
+
+
+/* a pooled client's new connections reuse the host's resolved addresses */
+static void
+test_counters_dns_cache (void)
+{
+   mock_server_t *server;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_MAX);
+   mock_server_run (server);
+   pool = mongoc_client_pool_new (mock_server_get_uri (server));
+   client = mongoc_client_pool_pop (pool);
+   _mongoc_client_dns_cache_clear ();
+   reset_all_counters ();
+   _ping_mock_server (client, server);
+   DIFF_AND_RESET (dns_cache_hit, ==, 0);
+   mongoc_cluster_disconnect_node (&client->cluster, 1, false, NULL);
+   _ping_mock_server (client, server);
+   DIFF_AND_RESET (dns_cache_hit, ==, 1);
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_counters_histogram_buckets (void)
+{
+   uint32_t i;
+   int64_t usec;
+
+   ASSERT_CMPUINT32 (_mongoc_histogram_bucket (-1), ==, 0);
+   ASSERT_CMPUINT32 (_mongoc_histogram_bucket (0), ==, 0);
+   ASSERT_CMPUINT32 (_mongoc_histogram_bucket (7), ==, 7);
+   ASSERT_CMPUINT32 (_mongoc_histogram_bucket (8), ==, 8);
+   ASSERT_CMPUINT32 (_mongoc_histogram_bucket (15), ==, 15);
+   ASSERT_CMPUINT32 (_mongoc_histogram_bucket (16), ==, 16);
+   ASSERT_CMPUINT32 (_mongoc_histogram_bucket (17), ==, 16);
+   ASSERT_CMPUINT32 (_mongoc_histogram_bucket (18), ==, 17);
+   ASSERT_CMPUINT32 (_mongoc_histogram_bucket (1000), ==, 63);
+   ASSERT_CMPUINT32 (_mongoc_histogram_bucket (INT64_MAX),
+                     ==,
+                     MONGOC_HISTOGRAM_N_BUCKETS - 1);
+
+   /* each bucket begins where the previous one ends */
+   for (i = 0; i < MONGOC_HISTOGRAM_N_BUCKETS; i++) {
+      usec = _mongoc_histogram_bucket_min (i);
+      ASSERT_CMPUINT32 (_mongoc_histogram_bucket (usec), ==, i);
+      if (i > 0) {
+         ASSERT_CMPUINT32 (_mongoc_histogram_bucket (usec - 1), ==, i - 1);
+      }
+   }
+
+   /* a bucket is at most 1/8 as wide as its values */
+   for (i = MONGOC_HISTOGRAM_SUB_BUCKETS; i < MONGOC_HISTOGRAM_N_BUCKETS - 1;
+        i++) {
+      usec = _mongoc_histogram_bucket_min (i);
+      ASSERT_CMPINT64 ((_mongoc_histogram_bucket_min (i + 1) - usec) * 8,
+                       <=,
+                       usec);
+   }
+}
+
+
+static void
+test_counters_histograms (void)
+{
+   mock_server_t *server;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   mongoc_collection_t *coll;
+   mongoc_cursor_t *cursor;
+   const bson_t *doc;
+   future_t *future;
+   request_t *request;
+   int64_t command_count;
+   int64_t getmore_count;
+   int64_t server_selection_count;
+   int64_t pool_checkout_count;
+   int64_t connect_count;
+   int64_t handshake_count;
+   int64_t send_count;
+   int64_t wait_count;
+   int64_t receive_count;
+   int64_t decompress_count;
+   int64_t parse_count;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_MAX);
+   mock_server_run (server);
+   pool = mongoc_client_pool_new (mock_server_get_uri (server));
+
+   command_count = histogram_count_command ();
+   getmore_count = histogram_count_getmore ();
+   server_selection_count = histogram_count_server_selection ();
+   pool_checkout_count = histogram_count_pool_checkout ();
+   connect_count = histogram_count_connect ();
+   handshake_count = histogram_count_handshake ();
+   send_count = histogram_count_command_send ();
+   wait_count = histogram_count_command_wait ();
+   receive_count = histogram_count_command_receive ();
+   decompress_count = histogram_count_command_decompress ();
+   parse_count = histogram_count_command_parse ();
+
+   client = mongoc_client_pool_pop (pool);
+   coll = mongoc_client_get_collection (client, "db", "collection");
+   cursor = mongoc_collection_find_with_opts (
+      coll, tmp_bson ("{}"), tmp_bson ("{'batchSize': 1}"), NULL);
+   future = future_cursor_next (cursor, &doc);
+   request = mock_server_receives_msg (
+      server, 0, tmp_bson ("{'find': 'collection'}"));
+   mock_server_replies_simple (request,
+                               "{'ok': 1, 'cursor': {'id': {'$numberLong': "
+                               "'123'}, 'ns': 'db.collection', "
+                               "'firstBatch': [{}]}}");
+   BSON_ASSERT (future_get_bool (future));
+   future_destroy (future);
+   request_destroy (request);
+
+   future = future_cursor_next (cursor, &doc);
+   request = mock_server_receives_msg (
+      server, 0, tmp_bson ("{'getMore': {'$numberLong': '123'}}"));
+   mock_server_replies_simple (request,
+                               "{'ok': 1, 'cursor': {'id': 0, 'ns': "
+                               "'db.collection', 'nextBatch': [{}]}}");
+   BSON_ASSERT (future_get_bool (future));
+   future_destroy (future);
+   request_destroy (request);
+
+   /* the handshake, find, and getMore */
+   ASSERT_CMPINT64 (histogram_count_command () - command_count, ==, 3);
+   ASSERT_CMPINT64 (histogram_count_getmore () - getmore_count, ==, 1);
+   ASSERT_CMPINT64 (
+      histogram_count_server_selection () - server_selection_count, >=, 1);
+   ASSERT_CMPINT64 (
+      histogram_count_pool_checkout () - pool_checkout_count, ==, 1);
+   ASSERT_CMPINT64 (histogram_count_connect () - connect_count, ==, 1);
+   ASSERT_CMPINT64 (histogram_count_handshake () - handshake_count, ==, 1);
+
+   /* each command's phases, the replies aren't compressed */
+   ASSERT_CMPINT64 (histogram_count_command_send () - send_count, ==, 3);
+   ASSERT_CMPINT64 (histogram_count_command_wait () - wait_count, ==, 3);
+   ASSERT_CMPINT64 (
+      histogram_count_command_receive () - receive_count, ==, 3);
+   ASSERT_CMPINT64 (
+      histogram_count_command_decompress () - decompress_count, ==, 0);
+   ASSERT_CMPINT64 (histogram_count_command_parse () - parse_count, ==, 3);
+
+   mongoc_cursor_destroy (cursor);
+   mongoc_collection_destroy (coll);
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+   mock_server_destroy (server);
+}
+
+
+/* commands are counted per server and per namespace */
+/* the change in an entry's counter since get_entry_values */
+#define ENTRY_DIFF(_entry, _before, _slot)                              \
+   (_mongoc_counters_entry_get ((_entry), MONGOC_COUNTERS_SLOT_##_slot) - \
+    (_before)[MONGOC_COUNTERS_SLOT_##_slot])
+
+
+static void
+get_entry_values (const mongoc_counters_entry_t *entry, int64_t *values)
+{
+   uint32_t slot;
+
+   for (slot = 0; slot < MONGOC_COUNTERS_N_SLOTS; slot++) {
+      values[slot] = _mongoc_counters_entry_get (entry, slot);
+   }
+}
+
+
+static void
+test_counters_table (void)
+{
+   mock_server_t *server;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   mongoc_collection_t *coll;
+   mongoc_cursor_t *cursor;
+   mongoc_counters_entry_t *server_entry;
+   mongoc_counters_entry_t *ns_entry;
+   int64_t before_server[MONGOC_COUNTERS_N_SLOTS];
+   int64_t before_ns[MONGOC_COUNTERS_N_SLOTS];
+   mongoc_counters_entry_t *long_entry;
+   char long_ns[200];
+   const char *host;
+   const bson_t *doc;
+   future_t *future;
+   request_t *request;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_MAX);
+   mock_server_run (server);
+   host = mock_server_get_host_and_port (server);
+
+   /* lookups are stable, and keys are truncated to fit */
+   server_entry = _mongoc_counters_entry (host, NULL);
+   ASSERT (server_entry == _mongoc_counters_entry (host, ""));
+   ns_entry = _mongoc_counters_entry (host, "db.collection");
+   ASSERT (ns_entry != server_entry);
+   ASSERT (ns_entry == _mongoc_counters_entry (host, "db.collection"));
+   ASSERT_CMPSTR (server_entry->host, host);
+   ASSERT_CMPSTR (ns_entry->ns, "db.collection");
+   memset (long_ns, 'a', sizeof long_ns - 1);
+   long_ns[sizeof long_ns - 1] = '\0';
+   long_entry = _mongoc_counters_entry (host, long_ns);
+   long_ns[sizeof long_ns - 2] = 'b';
+   ASSERT (long_entry == _mongoc_counters_entry (host, long_ns));
+
+   get_entry_values (server_entry, before_server);
+   get_entry_values (ns_entry, before_ns);
+
+   _mongoc_counters_set_namespaces_enabled (true);
+   pool = mongoc_client_pool_new (mock_server_get_uri (server));
+   client = mongoc_client_pool_pop (pool);
+   coll = mongoc_client_get_collection (client, "db", "collection");
+   cursor = mongoc_collection_find_with_opts (
+      coll, tmp_bson ("{}"), tmp_bson ("{'batchSize': 1}"), NULL);
+   future = future_cursor_next (cursor, &doc);
+   request = mock_server_receives_msg (
+      server, 0, tmp_bson ("{'find': 'collection'}"));
+   mock_server_replies_simple (request,
+                               "{'ok': 1, 'cursor': {'id': {'$numberLong': "
+                               "'123'}, 'ns': 'db.collection', "
+                               "'firstBatch': [{}]}}");
+   BSON_ASSERT (future_get_bool (future));
+   future_destroy (future);
+   request_destroy (request);
+
+   future = future_cursor_next (cursor, &doc);
+   request = mock_server_receives_msg (
+      server, 0, tmp_bson ("{'getMore': {'$numberLong': '123'}}"));
+   mock_server_replies_simple (request,
+                               "{'ok': 1, 'cursor': {'id': 0, 'ns': "
+                               "'db.collection', 'nextBatch': [{}]}}");
+   BSON_ASSERT (future_get_bool (future));
+   future_destroy (future);
+   request_destroy (request);
+
+   future = future_collection_count (
+      coll, MONGOC_QUERY_NONE, NULL, 0, 0, NULL, NULL);
+   request = mock_server_receives_msg (
+      server, 0, tmp_bson ("{'count': 'collection'}"));
+   mock_server_replies_simple (request, "{'ok': 0, 'errmsg': 'failed'}");
+   ASSERT_CMPINT64 (future_get_int64_t (future), ==, -1);
+   future_destroy (future);
+   request_destroy (request);
+
+   /* the handshake, find, getMore, and count */
+   ASSERT_CMPINT64 (ENTRY_DIFF (server_entry, before_server, OPS), ==, 4);
+   ASSERT_CMPINT64 (ENTRY_DIFF (server_entry, before_server, ERRORS), ==, 1);
+   /* the client's connection, and the pool's monitor's */
+   ASSERT_CMPINT64 (
+      ENTRY_DIFF (server_entry, before_server, CONNECTIONS), >=, 1);
+   ASSERT_CMPINT64 (
+      ENTRY_DIFF (server_entry, before_server, EGRESS_BYTES), >, 0);
+   ASSERT_CMPINT64 (
+      ENTRY_DIFF (server_entry, before_server, INGRESS_BYTES), >, 0);
+
+   ASSERT_CMPINT64 (ENTRY_DIFF (ns_entry, before_ns, OPS), ==, 3);
+   ASSERT_CMPINT64 (ENTRY_DIFF (ns_entry, before_ns, ERRORS), ==, 1);
+   ASSERT_CMPINT64 (ENTRY_DIFF (ns_entry, before_ns, CONNECTIONS), ==, 0);
+
+   /* by default only the server is counted */
+   _mongoc_counters_set_namespaces_enabled (false);
+   get_entry_values (server_entry, before_server);
+   get_entry_values (ns_entry, before_ns);
+   future = future_client_command_simple (
+      client, "db", tmp_bson ("{'count': 'collection'}"), NULL, NULL, NULL);
+   request = mock_server_receives_msg (
+      server, 0, tmp_bson ("{'count': 'collection'}"));
+   mock_server_replies_ok_and_destroys (request);
+   BSON_ASSERT (future_get_bool (future));
+   future_destroy (future);
+
+   ASSERT_CMPINT64 (ENTRY_DIFF (server_entry, before_server, OPS), ==, 1);
+   ASSERT_CMPINT64 (ENTRY_DIFF (ns_entry, before_ns, OPS), ==, 0);
+
+   mongoc_cursor_destroy (cursor);
+   mongoc_collection_destroy (coll);
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+   mock_server_destroy (server);
+}
+
+
+static void
+_assert_openmetrics (const char *metrics, const char *labels)
+{
+   char *expected;
+
+   ASSERT_CONTAINS (metrics, "# TYPE mongoc_op_egress counter\n");
+   ASSERT_CONTAINS (metrics, "# TYPE mongoc_clients_active gauge\n");
+   ASSERT_CONTAINS (metrics,
+                    "# HELP mongoc_clients_active "
+                    "The number of active clients.\n");
+   ASSERT_CONTAINS (metrics,
+                    "# TYPE mongoc_command_duration_seconds histogram\n"
+                    "# UNIT mongoc_command_duration_seconds seconds\n"
+                    "# HELP mongoc_command_duration_seconds "
+                    "Command round trip time.\n");
+   ASSERT_CONTAINS (metrics, "# TYPE mongoc_server_commands counter\n");
+
+   expected = bson_strdup_printf ("\nmongoc_op_egress_total%s ", labels);
+   ASSERT_CONTAINS (metrics, expected);
+   bson_free (expected);
+
+   /* the server's totals, and the ping's namespace */
+   ASSERT_CONTAINS (metrics, "mongoc_server_commands_total{");
+   ASSERT_CONTAINS (metrics, "namespace=\"admin\"} ");
+
+   ASSERT (strlen (metrics) > 6);
+   ASSERT_CMPSTR (metrics + strlen (metrics) - 6, "# EOF\n");
+}
+
+
+/* counters are exported in the OpenMetrics text format */
+static void
+test_counters_openmetrics (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   char *metrics;
+   char *labels;
+   char *expected;
+   const char *sample;
+   int pid;
+
+   /* namespaces are counted only if enabled */
+   _mongoc_counters_set_namespaces_enabled (true);
+   server = mock_server_with_autoismaster (WIRE_VERSION_MAX);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   _ping_mock_server (client, server);
+   _mongoc_counters_set_namespaces_enabled (false);
+
+   metrics = mongoc_counters_openmetrics ();
+   _assert_openmetrics (metrics, "");
+   ASSERT_CONTAINS (metrics,
+                    "mongoc_command_duration_seconds_bucket{le=\"+Inf\"} ");
+
+   /* the entry's values are summed over the CPUs */
+   expected = bson_strdup_printf (
+      "\nmongoc_namespace_commands_total{host=\"%s\",namespace=\"admin\"} ",
+      mock_server_get_host_and_port (server));
+   sample = strstr (metrics, expected);
+   ASSERT (sample);
+   ASSERT_CMPINT (atoi (sample + strlen (expected)), >=, 1);
+   bson_free (expected);
+   bson_free (metrics);
+
+   /* read from the shared memory segment, if there is one */
+   if (!getenv ("MONGOC_DISABLE_SHM")) {
+      pid = (int) getpid ();
+      labels = bson_strdup_printf ("{pid=\"%d\"}", pid);
+      metrics = mongoc_counters_openmetrics_for_pids (&pid, 1);
+      _assert_openmetrics (metrics, labels);
+      bson_free (labels);
+      bson_free (metrics);
+   }
+
+   /* processes without a segment are skipped */
+   pid = -1;
+   metrics = mongoc_counters_openmetrics_for_pids (&pid, 1);
+   ASSERT (!strstr (metrics, "mongoc_op_egress_total"));
+   ASSERT_CONTAINS (metrics, "# TYPE mongoc_op_egress counter\n");
+   bson_free (metrics);
+
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
 static void
 test_counters_streams_timeout ()
 {
@@ -528,6 +945,8 @@ test_counters_streams_timeout ()
    request_t *request;
    mongoc_uri_t *uri;
    mongoc_server_description_t *sd;
+   mongoc_counters_entry_t *entry;
+   int64_t timeouts;
 
    server = mock_server_with_autoismaster (WIRE_VERSION_MAX);
    mock_server_run (server);
@@ -539,6 +958,9 @@ test_counters_streams_timeout ()
    sd = mongoc_client_select_server (client, true, NULL, &err);
    mongoc_server_description_destroy (sd);
    reset_all_counters ();
+   entry =
+      _mongoc_counters_entry (mock_server_get_host_and_port (server), NULL);
+   timeouts = _mongoc_counters_entry_get (entry, MONGOC_COUNTERS_SLOT_TIMEOUTS);
    future = future_client_command_simple (
       client, "test", tmp_bson ("{'ping': 1}"), NULL, NULL, &err);
    request = mock_server_receives_msg (
@@ -550,6 +972,11 @@ test_counters_streams_timeout ()
    future_destroy (future);
    /* can't ASSERT == because the mock server times out normally reading. */
    DIFF_AND_RESET (streams_timeout, >=, 1);
+   ASSERT_CMPINT64 (
+      _mongoc_counters_entry_get (entry, MONGOC_COUNTERS_SLOT_TIMEOUTS) -
+         timeouts,
+      ==,
+      1);
    mongoc_client_destroy (client);
    mock_server_destroy (server);
 }
@@ -610,6 +1037,16 @@ test_counters_install (TestSuite *suite)
                       test_framework_skip_if_no_auth,
                       test_framework_skip_if_not_single);
    TestSuite_AddLive (suite, "/counters/dns", test_counters_dns);
+   TestSuite_AddMockServerTest (
+      suite, "/counters/dns_cache", test_counters_dns_cache);
+   TestSuite_Add (suite,
+                  "/counters/histograms/buckets",
+                  test_counters_histogram_buckets);
+   TestSuite_AddMockServerTest (
+      suite, "/counters/histograms", test_counters_histograms);
+   TestSuite_AddMockServerTest (suite, "/counters/table", test_counters_table);
+   TestSuite_AddMockServerTest (
+      suite, "/counters/openmetrics", test_counters_openmetrics);
    TestSuite_AddMockServerTest (
       suite, "/counters/streams_timeout", test_counters_streams_timeout);
 #endif
@@ -17,6 +17,7 @@
 #include <mongoc/mongoc.h>
 
 #include "mongoc/mongoc-log-private.h"
+#include "mongoc/mongoc-thread-private.h"
 #include "mongoc/mongoc-trace-private.h"
 #include "TestSuite.h"
 
@@ -113,6 +114,152 @@ test_mongoc_log_null (void)
    restore_state (&old_state);
 }
 
+struct async_log_data {
+   bson_mutex_t mutex;
+   int n_messages;
+   int n_summaries;
+   int last;
+   bool in_order;
+};
+
+
+static void
+async_log_func (mongoc_log_level_t log_level,
+                const char *log_domain,
+                const char *message,
+                void *user_data)
+{
+   struct async_log_data *data = (struct async_log_data *) user_data;
+   int i;
+
+   /* the test holds the mutex to stall the log thread */
+   bson_mutex_lock (&data->mutex);
+
+   if (!strcmp (log_domain, "async-test")) {
+      i = atoi (message);
+      if (i <= data->last) {
+         data->in_order = false;
+      }
+
+      data->last = i;
+      data->n_messages++;
+   } else if (strstr (message, "log queue was full")) {
+      data->n_summaries++;
+   }
+
+   bson_mutex_unlock (&data->mutex);
+}
+
+
+static void
+test_mongoc_log_async (void)
+{
+   struct log_state old_state;
+   struct async_log_data data;
+   int64_t dropped_before;
+   int64_t dropped;
+   int64_t rate_limited;
+   int i;
+
+   memset (&data, 0, sizeof data);
+   bson_mutex_init (&data.mutex);
+   data.last = -1;
+   data.in_order = true;
+
+   save_state (&old_state);
+   mongoc_log_set_handler (async_log_func, &data);
+   mongoc_log_async_enable ();
+
+   for (i = 0; i < 100; i++) {
+      mongoc_log (MONGOC_LOG_LEVEL_INFO, "async-test", "%d", i);
+   }
+
+   /* disabling handles the queued messages */
+   mongoc_log_async_disable ();
+   ASSERT_CMPINT (data.n_messages, ==, 100);
+   ASSERT (data.in_order);
+
+   /* stall the log thread, messages that don't fit in the queue are
+    * dropped without blocking */
+   _mongoc_log_get_async_stats (&dropped_before, &rate_limited);
+   data.n_messages = 0;
+   data.last = -1;
+   mongoc_log_async_enable ();
+   bson_mutex_lock (&data.mutex);
+
+   for (i = 0; i < MONGOC_LOG_ASYNC_QUEUE_SIZE + 100; i++) {
+      mongoc_log (MONGOC_LOG_LEVEL_INFO, "async-test", "%d", i);
+   }
+
+   bson_mutex_unlock (&data.mutex);
+   mongoc_log_async_disable ();
+
+   _mongoc_log_get_async_stats (&dropped, &rate_limited);
+   ASSERT_CMPINT64 (dropped - dropped_before, >=, (int64_t) 99);
+   ASSERT_CMPINT64 ((int64_t) data.n_messages + dropped - dropped_before,
+                    ==,
+                    (int64_t) MONGOC_LOG_ASYNC_QUEUE_SIZE + 100);
+   ASSERT (data.in_order);
+   ASSERT_CMPINT (data.n_summaries, >=, 1);
+
+   /* synchronous again */
+   data.n_messages = 0;
+   mongoc_log (MONGOC_LOG_LEVEL_INFO, "async-test", "%d", 1 << 20);
+   ASSERT_CMPINT (data.n_messages, ==, 1);
+
+   restore_state (&old_state);
+   bson_mutex_destroy (&data.mutex);
+}
+
+
+static void
+test_mongoc_log_rate_limit (void)
+{
+   struct log_state old_state;
+   struct async_log_data data;
+   int64_t dropped;
+   int64_t rate_limited_before;
+   int64_t rate_limited;
+   int i;
+
+   memset (&data, 0, sizeof data);
+   bson_mutex_init (&data.mutex);
+   data.last = -1;
+   data.in_order = true;
+
+   save_state (&old_state);
+   mongoc_log_set_handler (async_log_func, &data);
+   _mongoc_log_get_async_stats (&dropped, &rate_limited_before);
+   mongoc_log_set_rate_limit (5);
+
+   for (i = 0; i < 20; i++) {
+      mongoc_log (MONGOC_LOG_LEVEL_INFO, "async-test", "%d", i);
+   }
+
+   /* a second may have begun during the loop, allowing 5 more */
+   _mongoc_log_get_async_stats (&dropped, &rate_limited);
+   ASSERT_CMPINT (data.n_messages, >=, 5);
+   ASSERT_CMPINT (data.n_messages, <=, 10);
+   ASSERT_CMPINT64 (
+      rate_limited - rate_limited_before, ==, (int64_t) 20 - data.n_messages);
+
+   /* another call site has its own limit */
+   mongoc_log (MONGOC_LOG_LEVEL_INFO, "async-test", "%d!", 100);
+   ASSERT_CMPINT (data.last, ==, 100);
+
+   mongoc_log_set_rate_limit (0);
+   data.n_messages = 0;
+   for (i = 200; i < 220; i++) {
+      mongoc_log (MONGOC_LOG_LEVEL_INFO, "async-test", "%d", i);
+   }
+
+   ASSERT_CMPINT (data.n_messages, ==, 20);
+
+   restore_state (&old_state);
+   bson_mutex_destroy (&data.mutex);
+}
+
+
 static int
 should_run_trace_tests (void)
 {
@@ -199,4 +346,6 @@ test_log_install (TestSuite *suite)
                       NULL,
                       should_not_run_trace_tests);
    TestSuite_Add (suite, "/Log/null", test_mongoc_log_null);
+   TestSuite_Add (suite, "/Log/async", test_mongoc_log_async);
+   TestSuite_Add (suite, "/Log/rate_limit", test_mongoc_log_rate_limit);
 }
@@ -5,6 +5,7 @@
 
 #include "mongoc/mongoc-crypto-private.h"
 #include "mongoc/mongoc-scram-private.h"
+#include "common-b64-private.h"
 
 #include "TestSuite.h"
 #include "test-conveniences.h"
@@ -93,6 +94,158 @@ test_mongoc_scram_iteration_count (void)
    test_iteration_count (10000, true);
 }
 
+/* run the client side of a SCRAM-SHA-256 conversation from the server's
+ * first message on, and store the client's final message in client_final.
+ * the server's final message is signed with the keys the client derived,
+ * or with corrupted keys if bad_signature is true. */
+static bool
+_scram_sha_256_conversation (mongoc_scram_t *scram,
+                             const char *user,
+                             bool bad_signature,
+                             char **client_final,
+                             bson_error_t *error)
+{
+   uint8_t buf[4096] = {0};
+   uint32_t buflen = 0;
+   const char *client_nonce = "YWJjZA==";
+   /* the salt is "saltsaltsaltsaltsaltsaltsalt", the length mongod uses */
+   const char *server_first =
+      "r=YWJjZA==YWJjZA==,s=c2FsdHNhbHRzYWx0c2FsdHNhbHRzYWx0c2FsdA==,i=4096";
+   char *client_first_bare;
+   uint8_t server_key[MONGOC_SCRAM_HASH_MAX_SIZE];
+   uint8_t server_signature[MONGOC_SCRAM_HASH_MAX_SIZE];
+   char *server_final;
+   int n;
+
+   _mongoc_scram_set_user (scram, user);
+   _mongoc_scram_set_pass (scram, "pencil");
+   bson_strncpy (
+      scram->encoded_nonce, client_nonce, sizeof (scram->encoded_nonce));
+   scram->encoded_nonce_len = (int32_t) strlen (client_nonce);
+   /* the auth message as step 1 leaves it */
+   client_first_bare = bson_strdup_printf ("n=%s,r=%s,", user, client_nonce);
+   scram->auth_message = bson_malloc0 (4096);
+   scram->auth_messagemax = 4096;
+   scram->auth_messagelen = (uint32_t) strlen (client_first_bare);
+   memcpy (scram->auth_message, client_first_bare, scram->auth_messagelen);
+   bson_free (client_first_bare);
+   scram->step = 1;
+
+   buflen = (uint32_t) strlen (server_first);
+   memcpy (buf, server_first, buflen);
+   if (!_mongoc_scram_step (
+          scram, buf, buflen, buf, sizeof buf, &buflen, error)) {
+      return false;
+   }
+
+   *client_final = bson_strndup ((const char *) buf, buflen);
+
+   /* ServerSignature := HMAC(HMAC(SaltedPassword, "Server Key"), AuthMessage)
+    */
+   mongoc_crypto_hmac (&scram->crypto,
+                       scram->salted_password,
+                       MONGOC_SCRAM_SHA_256_HASH_SIZE,
+                       (uint8_t *) "Server Key",
+                       strlen ("Server Key"),
+                       server_key);
+   if (bad_signature) {
+      server_key[0] ^= 0xff;
+   }
+
+   mongoc_crypto_hmac (&scram->crypto,
+                       server_key,
+                       MONGOC_SCRAM_SHA_256_HASH_SIZE,
+                       scram->auth_message,
+                       scram->auth_messagelen,
+                       server_signature);
+
+   server_final = bson_malloc0 (MONGOC_SCRAM_B64_HASH_MAX_SIZE);
+   n = bson_b64_ntop (server_signature,
+                      MONGOC_SCRAM_SHA_256_HASH_SIZE,
+                      server_final,
+                      MONGOC_SCRAM_B64_HASH_MAX_SIZE);
+   BSON_ASSERT (n > 0);
+   buflen = (uint32_t) bson_snprintf (
+      (char *) buf, sizeof buf, "v=%s", server_final);
+   bson_free (server_final);
+
+   return _mongoc_scram_step (
+      scram, buf, buflen, buf, sizeof buf, &buflen, error);
+}
+
+
+/* test that keys derived in one SCRAM conversation are reused by later
+ * conversations with the same user, mechanism, password, salt, and
+ * iteration count, no matter which client they belong to */
+static void
+test_mongoc_scram_global_cache (void)
+{
+   mongoc_scram_t scram;
+   mongoc_scram_t other;
+   char *client_final;
+   char *other_client_final;
+   bson_error_t error;
+   bool r;
+
+   _mongoc_scram_global_cache_clear ();
+
+   /* a conversation that fails to verify the server isn't cached */
+   _mongoc_scram_init (&scram, MONGOC_CRYPTO_ALGORITHM_SHA_256);
+   r = _scram_sha_256_conversation (
+      &scram, "user", true /* bad signature */, &client_final, &error);
+   BSON_ASSERT (!r);
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_SCRAM,
+                          MONGOC_ERROR_SCRAM_PROTOCOL_ERROR,
+                          "could not verify server signature");
+   BSON_ASSERT (!_mongoc_scram_global_cache_get (&scram));
+   bson_free (client_final);
+   _mongoc_scram_destroy (&scram);
+
+   _mongoc_scram_init (&scram, MONGOC_CRYPTO_ALGORITHM_SHA_256);
+   r = _scram_sha_256_conversation (
+      &scram, "user", false, &client_final, &error);
+   ASSERT_OR_PRINT (r, error);
+   BSON_ASSERT (_mongoc_scram_global_cache_get (&scram));
+
+   /* a new conversation, e.g. from another pooled client, finds the keys */
+   _mongoc_scram_init (&other, MONGOC_CRYPTO_ALGORITHM_SHA_256);
+   r = _scram_sha_256_conversation (
+      &other, "user", false, &other_client_final, &error);
+   ASSERT_OR_PRINT (r, error);
+   ASSERT_CMPSTR (client_final, other_client_final);
+   BSON_ASSERT (!memcmp (
+      scram.client_key, other.client_key, sizeof (scram.client_key)));
+   bson_free (other_client_final);
+   _mongoc_scram_destroy (&other);
+
+   /* same password, salt, and iteration count, but another user */
+   _mongoc_scram_init (&other, MONGOC_CRYPTO_ALGORITHM_SHA_256);
+   _mongoc_scram_set_user (&other, "other");
+   other.hashed_password = bson_strdup (scram.hashed_password);
+   other.iterations = scram.iterations;
+   memcpy (
+      other.decoded_salt, scram.decoded_salt, sizeof (other.decoded_salt));
+   BSON_ASSERT (!_mongoc_scram_global_cache_get (&other));
+
+   /* another mechanism */
+   _mongoc_scram_set_user (&other, "user");
+   other.crypto.algorithm = MONGOC_CRYPTO_ALGORITHM_SHA_1;
+   BSON_ASSERT (!_mongoc_scram_global_cache_get (&other));
+
+   /* another iteration count */
+   other.crypto.algorithm = MONGOC_CRYPTO_ALGORITHM_SHA_256;
+   BSON_ASSERT (_mongoc_scram_global_cache_get (&other));
+   other.iterations++;
+   BSON_ASSERT (!_mongoc_scram_global_cache_get (&other));
+   _mongoc_scram_destroy (&other);
+
+   _mongoc_scram_global_cache_clear ();
+   BSON_ASSERT (!_mongoc_scram_global_cache_get (&scram));
+   bson_free (client_final);
+   _mongoc_scram_destroy (&scram);
+}
+
 static void
 test_mongoc_scram_sasl_prep (void)
 {
@@ -553,6 +706,8 @@ test_scram_install (TestSuite *suite)
    TestSuite_Add (suite, "/scram/sasl_prep", test_mongoc_scram_sasl_prep);
    TestSuite_Add (
       suite, "/scram/iteration_count", test_mongoc_scram_iteration_count);
+   TestSuite_Add (
+      suite, "/scram/global_cache", test_mongoc_scram_global_cache);
 #endif
    TestSuite_AddFull (suite,
                       "/scram/auth_tests",
@@ -0,0 +1,324 @@
+/*
+ * Copyright 2018-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <mongoc/mongoc.h>
+
+#include "mongoc/mongoc-util-private.h"
+#include "mock_server/future-functions.h"
+#include "mock_server/mock-server.h"
+#include "test-conveniences.h"
+#include "test-libmongoc.h"
+#include "TestSuite.h"
+
+
+typedef struct {
+   int n_spans;
+   char command_name[64];
+   char host_and_port[BSON_HOST_NAME_MAX + 7];
+   bool succeeded;
+   int64_t duration;
+   int64_t phase_start[MONGOC_SPAN_PHASE_COUNT];
+   int64_t phase_duration[MONGOC_SPAN_PHASE_COUNT];
+} span_test_t;
+
+
+static void
+span_cb (const mongoc_span_t *span, void *context)
+{
+   span_test_t *test = (span_test_t *) context;
+   const mongoc_host_list_t *host;
+   int i;
+
+   test->n_spans++;
+   bson_strncpy (test->command_name,
+                 mongoc_span_get_command_name (span),
+                 sizeof test->command_name);
+   host = mongoc_span_get_host (span);
+   BSON_ASSERT (host);
+   bson_strncpy (test->host_and_port,
+                 host->host_and_port,
+                 sizeof test->host_and_port);
+   test->succeeded = mongoc_span_get_succeeded (span);
+   test->duration = mongoc_span_get_duration (span);
+   ASSERT_CMPINT64 (mongoc_span_get_start_time (span), >, (int64_t) 0);
+
+   for (i = 0; i < MONGOC_SPAN_PHASE_COUNT; i++) {
+      test->phase_start[i] =
+         mongoc_span_get_phase_start (span, (mongoc_span_phase_t) i);
+      test->phase_duration[i] =
+         mongoc_span_get_phase_duration (span, (mongoc_span_phase_t) i);
+   }
+}
+
+
+static void
+_ping (mongoc_client_t *client, mock_server_t *server, int64_t delay_ms)
+{
+   future_t *future;
+   request_t *request;
+
+   future = future_client_command_simple (
+      client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, NULL);
+   request = mock_server_receives_msg (server, 0, tmp_bson ("{'ping': 1}"));
+   if (delay_ms) {
+      _mongoc_usleep (delay_ms * 1000);
+   }
+
+   mock_server_replies_ok_and_destroys (request);
+   BSON_ASSERT (future_get_bool (future));
+   future_destroy (future);
+}
+
+
+/* a span has each phase of a command, in order */
+static void
+test_span_phases (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   span_test_t test = {0};
+   size_t i;
+   mongoc_span_phase_t in_order[] = {MONGOC_SPAN_PHASE_SERVER_SELECTION,
+                                     MONGOC_SPAN_PHASE_CONNECTION_CHECKOUT,
+                                     MONGOC_SPAN_PHASE_COMMAND_ASSEMBLY,
+                                     MONGOC_SPAN_PHASE_SEND,
+                                     MONGOC_SPAN_PHASE_WAIT,
+                                     MONGOC_SPAN_PHASE_RECEIVE,
+                                     MONGOC_SPAN_PHASE_PARSE};
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_MAX);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   ASSERT (mongoc_client_set_span_callback (client, 1.0, span_cb, &test));
+
+   /* the server takes 50ms to reply */
+   _ping (client, server, 50);
+
+   ASSERT_CMPINT (test.n_spans, ==, 1);
+   ASSERT_CMPSTR (test.command_name, "ping");
+   ASSERT_CMPSTR (test.host_and_port,
+                  mongoc_uri_get_hosts (mock_server_get_uri (server))
+                     ->host_and_port);
+   ASSERT (test.succeeded);
+
+   for (i = 0; i < sizeof in_order / sizeof in_order[0]; i++) {
+      ASSERT_CMPINT64 (test.phase_start[in_order[i]], >=, (int64_t) 0);
+      ASSERT_CMPINT64 (test.phase_start[in_order[i]] +
+                          test.phase_duration[in_order[i]],
+                       <=,
+                       test.duration);
+      if (i > 0) {
+         ASSERT_CMPINT64 (test.phase_start[in_order[i - 1]],
+                          <=,
+                          test.phase_start[in_order[i]]);
+      }
+   }
+
+   /* an implicit session is popped while assembling the command */
+   ASSERT_CMPINT64 (test.phase_start[MONGOC_SPAN_PHASE_SESSION_POP],
+                    >=,
+                    test.phase_start[MONGOC_SPAN_PHASE_COMMAND_ASSEMBLY]);
+   ASSERT_CMPINT64 (test.phase_duration[MONGOC_SPAN_PHASE_SESSION_POP],
+                    <=,
+                    test.phase_duration[MONGOC_SPAN_PHASE_COMMAND_ASSEMBLY]);
+
+   /* the reply isn't compressed */
+   ASSERT_CMPINT64 (
+      test.phase_start[MONGOC_SPAN_PHASE_DECOMPRESS], ==, (int64_t) -1);
+   ASSERT_CMPINT64 (
+      test.phase_duration[MONGOC_SPAN_PHASE_DECOMPRESS], ==, (int64_t) 0);
+
+   /* the delay is spent waiting for the server */
+   ASSERT_CMPINT64 (
+      test.phase_duration[MONGOC_SPAN_PHASE_WAIT], >=, (int64_t) 50 * 1000);
+   ASSERT_CMPINT64 (test.duration, >=, (int64_t) 50 * 1000);
+
+   ASSERT_CMPSTR (mongoc_span_phase_str (MONGOC_SPAN_PHASE_WAIT), "wait");
+
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+/* a fraction of operations is sampled */
+static void
+test_span_sample_rate (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   span_test_t test = {0};
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+   int i;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_MAX);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   ASSERT (mongoc_client_set_span_callback (client, 0.25, span_cb, &test));
+
+   for (i = 0; i < 8; i++) {
+      _ping (client, server, 0);
+   }
+
+   ASSERT_CMPINT (test.n_spans, ==, 2);
+
+   /* a failed command's span */
+   ASSERT (mongoc_client_set_span_callback (client, 1.0, span_cb, &test));
+   future = future_client_command_simple (
+      client, "admin", tmp_bson ("{'foo': 1}"), NULL, NULL, &error);
+   request = mock_server_receives_msg (server, 0, tmp_bson ("{'foo': 1}"));
+   mock_server_replies_simple (request, "{'ok': 0, 'errmsg': 'bad'}");
+   ASSERT (!future_get_bool (future));
+   future_destroy (future);
+   request_destroy (request);
+
+   ASSERT_CMPINT (test.n_spans, ==, 3);
+   ASSERT_CMPSTR (test.command_name, "foo");
+   ASSERT (!test.succeeded);
+
+   /* no more spans */
+   ASSERT (mongoc_client_set_span_callback (client, 0, span_cb, &test));
+   _ping (client, server, 0);
+   ASSERT_CMPINT (test.n_spans, ==, 3);
+
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+/* a pool's clients share its callback */
+static void
+test_span_pooled (void)
+{
+   mock_server_t *server;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   span_test_t test = {0};
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_MAX);
+   mock_server_run (server);
+   pool = mongoc_client_pool_new (mock_server_get_uri (server));
+   ASSERT (
+      mongoc_client_pool_set_span_callback (pool, 1.0, span_cb, &test));
+   client = mongoc_client_pool_pop (pool);
+
+   capture_logs (true);
+   ASSERT (!mongoc_client_set_span_callback (client, 1.0, span_cb, &test));
+   ASSERT (
+      !mongoc_client_pool_set_span_callback (pool, 1.0, span_cb, &test));
+   capture_logs (false);
+
+   /* the first operation also connects */
+   _ping (client, server, 0);
+   ASSERT_CMPINT (test.n_spans, ==, 1);
+   ASSERT_CMPSTR (test.command_name, "ping");
+   ASSERT_CMPINT64 (test.phase_start[MONGOC_SPAN_PHASE_CONNECTION_CHECKOUT],
+                    >=,
+                    (int64_t) 0);
+
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+   mock_server_destroy (server);
+}
+
+
+/* batches of a bulk write pipelined on one connection share a span */
+static void
+test_span_pipelined (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_bulk_operation_t *bulk;
+   span_test_t test = {0};
+   bson_error_t error;
+   future_t *future;
+   request_t *requests[3];
+   int i;
+
+   server = mock_server_new ();
+   mock_server_auto_ismaster (server,
+                              "{'ok': 1.0,"
+                              " 'ismaster': true,"
+                              " 'minWireVersion': 0,"
+                              " 'maxWireVersion': %d,"
+                              " 'maxWriteBatchSize': 1}",
+                              WIRE_VERSION_OP_MSG);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   ASSERT (mongoc_client_set_span_callback (client, 1.0, span_cb, &test));
+   collection = mongoc_client_get_collection (client, "db", "collection");
+   bulk = mongoc_collection_create_bulk_operation_with_opts (
+      collection, tmp_bson ("{'ordered': false}"));
+   for (i = 0; i < 3; i++) {
+      mongoc_bulk_operation_insert (bulk, tmp_bson ("{'_id': %d}", i));
+   }
+
+   mongoc_bulk_operation_set_pipeline_depth (bulk, 2);
+   future = future_bulk_operation_execute (bulk, NULL, &error);
+
+   /* the third batch is sent once the first's reply is read */
+   for (i = 0; i < 3; i++) {
+      requests[i] = mock_server_receives_msg (
+         server,
+         0,
+         tmp_bson ("{'insert': 'collection', 'ordered': false}"),
+         tmp_bson ("{'_id': %d}", i));
+      if (i == 0) {
+         continue;
+      }
+
+      mock_server_replies_simple (requests[i - 1],
+                                  i == 1 ? "{'ok': 0, 'errmsg': 'bad'}"
+                                         : "{'ok': 1, 'n': 1}");
+   }
+
+   mock_server_replies_simple (requests[2], "{'ok': 1, 'n': 1}");
+   ASSERT (!future_get_uint32_t (future));
+   for (i = 0; i < 3; i++) {
+      request_destroy (requests[i]);
+   }
+
+   /* one span, which failed because the first batch did */
+   ASSERT_CMPINT (test.n_spans, ==, 1);
+   ASSERT_CMPSTR (test.command_name, "insert");
+   ASSERT (!test.succeeded);
+   ASSERT_CMPINT64 (test.phase_duration[MONGOC_SPAN_PHASE_WAIT], >, 0);
+
+   /* the next operation has its own */
+   _ping (client, server, 0);
+   ASSERT_CMPINT (test.n_spans, ==, 2);
+   ASSERT_CMPSTR (test.command_name, "ping");
+   ASSERT (test.succeeded);
+
+   future_destroy (future);
+   mongoc_bulk_operation_destroy (bulk);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+void
+test_span_install (TestSuite *suite)
+{
+   TestSuite_AddMockServerTest (suite, "/span/phases", test_span_phases);
+   TestSuite_AddMockServerTest (
+      suite, "/span/sample_rate", test_span_sample_rate);
+   TestSuite_AddMockServerTest (suite, "/span/pooled", test_span_pooled);
+   TestSuite_AddMockServerTest (suite, "/span/pipelined", test_span_pipelined);
+}
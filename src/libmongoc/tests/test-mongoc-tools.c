@@ -0,0 +1,306 @@
+/*
+ * Copyright 2018-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <mongoc/mongoc.h>
+
+#include "mock_server/mock-server.h"
+#include "test-conveniences.h"
+#include "test-libmongoc.h"
+#include "TestSuite.h"
+
+/* MONGOC_TOOLS_DIR is where CMake built mongoc-dump and mongoc-restore */
+#ifdef MONGOC_TOOLS_DIR
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* enough documents that mongoc-dump splits the collection into 3 ranges */
+#define TOOLS_N_DOCS 30000
+
+
+typedef struct {
+   bson_mutex_t mutex;
+   int n_key_walks;
+   /* which of the 3 ranges were read, by their lower boundary / 10000 */
+   int n_range_reads[3];
+   int n_inserted;
+   int inserted_ids[3];
+   char *unexpected;
+} tools_test_t;
+
+
+/* the _id index walk, which returns every key at once */
+static void
+_reply_with_keys (request_t *request)
+{
+   bson_t reply = BSON_INITIALIZER;
+   bson_t cursor;
+   bson_t batch;
+   bson_t key;
+   const char *k;
+   char buf[16];
+   uint32_t i;
+
+   BSON_APPEND_DOCUMENT_BEGIN (&reply, "cursor", &cursor);
+   BSON_APPEND_INT64 (&cursor, "id", 0);
+   BSON_APPEND_UTF8 (&cursor, "ns", "db.collection");
+   BSON_APPEND_ARRAY_BEGIN (&cursor, "firstBatch", &batch);
+   for (i = 0; i < TOOLS_N_DOCS; i++) {
+      bson_uint32_to_string (i, &k, buf, sizeof buf);
+      bson_append_document_begin (&batch, k, -1, &key);
+      BSON_APPEND_INT32 (&key, "_id", (int32_t) i);
+      bson_append_document_end (&batch, &key);
+   }
+
+   bson_append_array_end (&cursor, &batch);
+   bson_append_document_end (&reply, &cursor);
+   BSON_APPEND_INT32 (&reply, "ok", 1);
+
+   mock_server_reply_multi (request, MONGOC_REPLY_NONE, &reply, 1, 0);
+   bson_destroy (&reply);
+}
+
+
+/* each range is dumped as the one document at its lower boundary */
+static bool
+_reply_with_range (tools_test_t *test, request_t *request, const bson_t *cmd)
+{
+   char *reply;
+   int32_t min = 0;
+   int32_t max = TOOLS_N_DOCS;
+
+   if (bson_has_field (cmd, "min")) {
+      min = bson_lookup_int32 (cmd, "min._id");
+   }
+
+   if (bson_has_field (cmd, "max")) {
+      max = bson_lookup_int32 (cmd, "max._id");
+   }
+
+   /* the index walk chose every 10000th key */
+   if (min % 10000 || max - min != 10000) {
+      return false;
+   }
+
+   test->n_range_reads[min / 10000]++;
+   reply = bson_strdup_printf ("{'ok': 1, 'cursor': {'id': 0,"
+                               " 'ns': 'db.collection',"
+                               " 'firstBatch': [{'_id': %d, 'x': 'foo'}]}}",
+                               min);
+   mock_server_replies_simple (request, reply);
+   bson_free (reply);
+
+   return true;
+}
+
+
+static bool
+_restore_insert (tools_test_t *test, request_t *request)
+{
+   const bson_t *doc;
+   char *reply;
+   size_t i;
+
+   for (i = 1; i < request->docs.len; i++) {
+      doc = request_get_doc (request, (int) i);
+      if (test->n_inserted == 3 ||
+          strcmp (bson_lookup_utf8 (doc, "x"), "foo")) {
+         return false;
+      }
+
+      test->inserted_ids[test->n_inserted++] = bson_lookup_int32 (doc, "_id");
+   }
+
+   reply =
+      bson_strdup_printf ("{'ok': 1, 'n': %d}", (int) request->docs.len - 1);
+   mock_server_replies_simple (request, reply);
+   bson_free (reply);
+
+   return true;
+}
+
+
+static bool
+_tools_responder (request_t *request, void *data)
+{
+   tools_test_t *test = (tools_test_t *) data;
+   const bson_t *cmd;
+   bool handled = false;
+
+   /* let the server's autoresponder handle ismaster */
+   if (!request->is_command ||
+       !strcasecmp (request->command_name, "ismaster")) {
+      return false;
+   }
+
+   cmd = request_get_doc (request, 0);
+
+   bson_mutex_lock (&test->mutex);
+   if (!strcmp (request->command_name, "count")) {
+      mock_server_replies_simple (request, "{'ok': 1, 'n': 30000}");
+      handled = true;
+   } else if (!strcmp (request->command_name, "find") &&
+              bson_has_field (cmd, "returnKey")) {
+      test->n_key_walks++;
+      _reply_with_keys (request);
+      handled = true;
+   } else if (!strcmp (request->command_name, "find")) {
+      handled = _reply_with_range (test, request, cmd);
+   } else if (!strcmp (request->command_name, "insert")) {
+      handled = _restore_insert (test, request);
+   }
+
+   if (!handled && !test->unexpected) {
+      test->unexpected = bson_strdup (request->as_str);
+   }
+
+   bson_mutex_unlock (&test->mutex);
+
+   if (!handled) {
+      mock_server_replies_simple (request,
+                                  "{'ok': 0, 'errmsg': 'unexpected request'}");
+   }
+
+   request_destroy (request);
+
+   return true;
+}
+
+
+/* run a tool to completion and return its exit status */
+static int
+_run_tool (const char *name, char *argv[])
+{
+   char *path;
+   pid_t pid;
+   int status;
+
+   path = bson_strdup_printf ("%s/%s", MONGOC_TOOLS_DIR, name);
+   pid = fork ();
+   ASSERT_CMPINT ((int) pid, !=, -1);
+   if (pid == 0) {
+      execv (path, argv);
+      _exit (127);
+   }
+
+   ASSERT_CMPINT ((int) waitpid (pid, &status, 0), ==, (int) pid);
+   bson_free (path);
+   ASSERT (WIFEXITED (status));
+
+   return WEXITSTATUS (status);
+}
+
+
+/* mongoc-dump splits a collection into ranges in one pass over its _id
+ * index, and mongoc-restore loads the file they are written to */
+static void
+test_dump_restore (void)
+{
+   mock_server_t *server;
+   tools_test_t test = {0};
+   char dir[] = "/tmp/mongoc-tools-XXXXXX";
+   char *uri;
+   char *db_dir;
+   char *path;
+   char *dump_argv[] = {"mongoc-dump",
+                        "--uri",
+                        NULL, /* uri */
+                        "-d",
+                        "db",
+                        "-c",
+                        "collection",
+                        "-o",
+                        NULL, /* dir */
+                        "-j",
+                        "3",
+                        "-r",
+                        "3",
+                        NULL};
+   char *restore_argv[] = {"mongoc-restore",
+                           "--uri",
+                           NULL, /* uri */
+                           "-d",
+                           "db",
+                           "-c",
+                           "collection",
+                           "-i",
+                           NULL, /* dir */
+                           NULL};
+   int seen[3] = {0};
+   int status;
+   int i;
+
+   bson_mutex_init (&test.mutex);
+   server = mock_server_with_autoismaster (WIRE_VERSION_OP_MSG);
+   mock_server_autoresponds (server, _tools_responder, &test, NULL);
+   mock_server_run (server);
+   uri = bson_strdup (mongoc_uri_get_string (mock_server_get_uri (server)));
+   ASSERT (mkdtemp (dir));
+
+   dump_argv[2] = restore_argv[2] = uri;
+   dump_argv[8] = restore_argv[8] = dir;
+   status = _run_tool ("mongoc-dump", dump_argv);
+
+   ASSERT_WITH_MSG (!test.unexpected, "%s", test.unexpected);
+   ASSERT_CMPINT (status, ==, 0);
+   ASSERT_CMPINT (test.n_key_walks, ==, 1);
+   for (i = 0; i < 3; i++) {
+      ASSERT_CMPINT (test.n_range_reads[i], ==, 1);
+   }
+
+   status = _run_tool ("mongoc-restore", restore_argv);
+
+   ASSERT_WITH_MSG (!test.unexpected, "%s", test.unexpected);
+   ASSERT_CMPINT (status, ==, 0);
+   ASSERT_CMPINT (test.n_inserted, ==, 3);
+
+   /* the ranges were appended to the file in any order */
+   for (i = 0; i < 3; i++) {
+      ASSERT_CMPINT (test.inserted_ids[i] % 10000, ==, 0);
+      ASSERT_CMPINT (test.inserted_ids[i], <, TOOLS_N_DOCS);
+      seen[test.inserted_ids[i] / 10000]++;
+   }
+
+   for (i = 0; i < 3; i++) {
+      ASSERT_CMPINT (seen[i], ==, 1);
+   }
+
+   db_dir = bson_strdup_printf ("%s/db", dir);
+   path = bson_strdup_printf ("%s/collection.bson", db_dir);
+   ASSERT_CMPINT (unlink (path), ==, 0);
+   ASSERT_CMPINT (rmdir (db_dir), ==, 0);
+   ASSERT_CMPINT (rmdir (dir), ==, 0);
+
+   bson_free (path);
+   bson_free (db_dir);
+   bson_free (uri);
+   bson_free (test.unexpected);
+   mock_server_destroy (server);
+   bson_mutex_destroy (&test.mutex);
+}
+
+#endif /* MONGOC_TOOLS_DIR */
+
+
+void
+test_tools_install (TestSuite *suite)
+{
+#ifdef MONGOC_TOOLS_DIR
+   TestSuite_AddMockServerTest (
+      suite, "/tools/dump_restore", test_dump_restore);
+#endif
+}
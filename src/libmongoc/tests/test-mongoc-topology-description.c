@@ -141,6 +141,83 @@ test_get_servers (void)
 }
 
 
+static void
+test_power_of_two_choices (void)
+{
+   mongoc_uri_t *uri;
+   mongoc_topology_t *topology;
+   mongoc_topology_description_t *td;
+   mongoc_server_description_t *sd_a;
+   mongoc_server_description_t *sd_b;
+   mongoc_server_description_t *selected;
+   mongoc_server_description_t **sds;
+   bson_error_t error;
+   size_t n;
+   int i;
+
+   ASSERT (!mongoc_uri_new_with_error (
+      "mongodb://a,b/?serverSelectionMode=leastBusy", &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_COMMAND,
+                          MONGOC_ERROR_COMMAND_INVALID_ARG,
+                          "Unsupported value for \"serverSelectionMode\"");
+
+   uri = mongoc_uri_new (
+      "mongodb://a,b/?serverSelectionMode=powerOfTwoChoices");
+   topology = mongoc_topology_new (uri, true /* single-threaded */);
+   td = &topology->description;
+   ASSERT_CMPINT (
+      (int) td->selection_mode, ==, (int) MONGOC_SERVER_SELECTION_POWER_OF_TWO);
+
+   sd_a = _sd_for_host (td, "a");
+   mongoc_topology_description_handle_ismaster (
+      td, sd_a->id, tmp_bson ("{'ok': 1, 'msg': 'isdbgrid'}"), 10, NULL);
+   sd_b = _sd_for_host (td, "b");
+   mongoc_topology_description_handle_ismaster (
+      td, sd_b->id, tmp_bson ("{'ok': 1, 'msg': 'isdbgrid'}"), 10, NULL);
+
+   ASSERT_CMPINT32 (mongoc_server_description_in_flight_count (sd_a), ==, 0);
+   ASSERT_CMPINT64 (
+      mongoc_server_description_command_latency_usec (sd_a), ==, (int64_t) -1);
+
+   /* "a" is busy, so every pair of choices prefers "b" */
+   _mongoc_server_load_begin (sd_a->load);
+   for (i = 0; i < 100; i++) {
+      selected = mongoc_topology_description_select (
+         td, MONGOC_SS_READ, NULL, MONGOC_TOPOLOGY_LOCAL_THRESHOLD_MS);
+      ASSERT (selected == sd_b);
+   }
+
+   /* copies share the counters */
+   sds = mongoc_topology_description_get_servers (td, &n);
+   ASSERT_CMPSIZE_T ((size_t) 2, ==, n);
+   for (i = 0; i < (int) n; i++) {
+      ASSERT_CMPINT32 (mongoc_server_description_in_flight_count (sds[i]),
+                       ==,
+                       sds[i]->id == sd_a->id ? 1 : 0);
+   }
+
+   mongoc_server_descriptions_destroy_all (sds, n);
+
+   /* equally busy, but "a" has been slower */
+   _mongoc_server_load_end (sd_a->load, 1000);
+   _mongoc_server_load_begin (sd_b->load);
+   _mongoc_server_load_end (sd_b->load, 10);
+   ASSERT_CMPINT64 (mongoc_server_description_command_latency_usec (sd_a),
+                    ==,
+                    (int64_t) 1000);
+   ASSERT_CMPINT32 (mongoc_server_description_in_flight_count (sd_a), ==, 0);
+   for (i = 0; i < 100; i++) {
+      selected = mongoc_topology_description_select (
+         td, MONGOC_SS_READ, NULL, MONGOC_TOPOLOGY_LOCAL_THRESHOLD_MS);
+      ASSERT (selected == sd_b);
+   }
+
+   mongoc_topology_destroy (topology);
+   mongoc_uri_destroy (uri);
+}
+
+
 void
 test_topology_description_install (TestSuite *suite)
 {
@@ -151,4 +228,7 @@ test_topology_description_install (TestSuite *suite)
                       "/TopologyDescription/readable_writable/pooled",
                       test_has_readable_writable_server_pooled);
    TestSuite_Add (suite, "/TopologyDescription/get_servers", test_get_servers);
+   TestSuite_Add (suite,
+                  "/TopologyDescription/power_of_two_choices",
+                  test_power_of_two_choices);
 }
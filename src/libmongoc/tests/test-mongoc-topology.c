@@ -8,6 +8,7 @@
 
 #include "test-libmongoc.h"
 #include "mock_server/mock-server.h"
+#include "mock_server/mock-rs.h"
 #include "mock_server/future.h"
 #include "mock_server/future-functions.h"
 #include "test-conveniences.h"
@@ -1082,6 +1083,173 @@ test_rtt (void *ctx)
 }
 
 
+static void
+test_topology_snapshot (void)
+{
+   mock_server_t *server;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   mongoc_topology_t *topology;
+   mongoc_topology_snapshot_t *old_snapshot;
+   mongoc_topology_snapshot_t *new_snapshot;
+   mongoc_server_description_t *sd;
+   future_t *future;
+   bson_error_t error;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_MAX);
+   mock_server_run (server);
+   pool = mongoc_client_pool_new (mock_server_get_uri (server));
+   topology = _mongoc_client_pool_get_topology (pool);
+   client = mongoc_client_pool_pop (pool);
+
+   sd = mongoc_client_select_server (client, true, NULL, &error);
+   ASSERT_OR_PRINT (sd, error);
+   mongoc_server_description_destroy (sd);
+
+   /* the scanner published what it discovered */
+   old_snapshot = _mongoc_topology_snapshot_acquire (topology);
+   BSON_ASSERT (old_snapshot);
+   sd = mongoc_topology_description_server_by_id (
+      &old_snapshot->description, 1, &error);
+   ASSERT_OR_PRINT (sd, error);
+   ASSERT_CMPINT (sd->type, ==, MONGOC_SERVER_STANDALONE);
+
+   /* a change publishes a new snapshot and leaves the old one as it was */
+   bson_set_error (
+      &error, MONGOC_ERROR_STREAM, MONGOC_ERROR_STREAM_SOCKET, "socket error");
+   mongoc_topology_invalidate_server (topology, 1, &error);
+   new_snapshot = _mongoc_topology_snapshot_acquire (topology);
+   BSON_ASSERT (new_snapshot != old_snapshot);
+   ASSERT_CMPINT (sd->type, ==, MONGOC_SERVER_STANDALONE);
+   sd = mongoc_topology_description_server_by_id (
+      &new_snapshot->description, 1, &error);
+   ASSERT_OR_PRINT (sd, error);
+   ASSERT_CMPINT (sd->type, ==, MONGOC_SERVER_UNKNOWN);
+
+   _mongoc_topology_snapshot_release (old_snapshot);
+   _mongoc_topology_snapshot_release (new_snapshot);
+
+   /* selection waits for the scanner to rediscover the server */
+   sd = mongoc_client_select_server (client, true, NULL, &error);
+   ASSERT_OR_PRINT (sd, error);
+   ASSERT_CMPINT (sd->type, ==, MONGOC_SERVER_STANDALONE);
+   mongoc_server_description_destroy (sd);
+
+   /* selecting from a snapshot doesn't wait for the topology's mutex,
+    * which the scanner holds while it probes servers */
+   bson_mutex_lock (&topology->mutex);
+   future = future_topology_select (topology, MONGOC_SS_READ, NULL, &error);
+   sd = future_get_mongoc_server_description_ptr (future);
+   bson_mutex_unlock (&topology->mutex);
+   ASSERT_OR_PRINT (sd, error);
+   ASSERT_CMPINT (sd->type, ==, MONGOC_SERVER_STANDALONE);
+   mongoc_server_description_destroy (sd);
+   future_destroy (future);
+
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+   mock_server_destroy (server);
+}
+
+
+static bool
+_rs_discovered (mongoc_topology_t *topology)
+{
+   mongoc_topology_snapshot_t *snapshot;
+   mongoc_server_description_t *sd;
+   size_t i;
+   bool ret = false;
+
+   snapshot = _mongoc_topology_snapshot_acquire (topology);
+   if (snapshot &&
+       snapshot->description.type == MONGOC_TOPOLOGY_RS_WITH_PRIMARY) {
+      ret = true;
+      for (i = 0; i < snapshot->description.servers->items_len; i++) {
+         sd = mongoc_set_get_item (snapshot->description.servers, (int) i);
+         if (sd->type == MONGOC_SERVER_UNKNOWN) {
+            ret = false;
+         }
+      }
+   }
+
+   if (snapshot) {
+      _mongoc_topology_snapshot_release (snapshot);
+   }
+
+   return ret;
+}
+
+
+static void
+test_topology_snapshot_selection_cache (void)
+{
+   mock_rs_t *rs;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   mongoc_topology_t *topology;
+   mongoc_topology_snapshot_t *snapshot;
+   mongoc_topology_snapshot_t *new_snapshot;
+   mongoc_read_prefs_t *prefs;
+   mongoc_server_description_t *sd;
+   unsigned int seed = 0;
+   int64_t start;
+   int32_t cache_len;
+   bson_error_t error;
+   int i;
+
+   rs = mock_rs_with_autoismaster (WIRE_VERSION_MAX, true, 2, 0);
+   mock_rs_run (rs);
+   pool = mongoc_client_pool_new (mock_rs_get_uri (rs));
+   topology = _mongoc_client_pool_get_topology (pool);
+   client = mongoc_client_pool_pop (pool);
+
+   start = bson_get_monotonic_time ();
+   while (!_rs_discovered (topology)) {
+      ASSERT_CMPINT64 (bson_get_monotonic_time () - start, <, 10 * 1000 * 1000);
+      _mongoc_usleep (1000);
+   }
+
+   /* tags unlike any other test's read prefs, matching every secondary */
+   prefs = mongoc_read_prefs_new (MONGOC_READ_SECONDARY);
+   mongoc_read_prefs_add_tag (prefs, tmp_bson ("{'dc': 'ny'}"));
+   mongoc_read_prefs_add_tag (prefs, NULL);
+
+   snapshot = _mongoc_topology_snapshot_acquire (topology);
+   cache_len = snapshot->cache_len;
+
+   for (i = 0; i < 100; i++) {
+      sd = _mongoc_topology_snapshot_select (
+         snapshot, MONGOC_SS_READ, prefs, 15, &seed);
+      BSON_ASSERT (sd);
+      ASSERT_CMPINT (sd->type, ==, MONGOC_SERVER_RS_SECONDARY);
+      /* the first selection added the suitable servers to the cache */
+      ASSERT_CMPINT (snapshot->cache_len, ==, cache_len + 1);
+      ASSERT_CMPSIZE_T (snapshot->cache[cache_len].servers.len, ==, (size_t) 2);
+   }
+
+   sd = _mongoc_topology_snapshot_select (
+      snapshot, MONGOC_SS_WRITE, NULL, 15, &seed);
+   BSON_ASSERT (sd);
+   ASSERT_CMPINT (sd->type, ==, MONGOC_SERVER_RS_PRIMARY);
+   ASSERT_CMPINT (snapshot->cache_len, >=, cache_len + 1);
+
+   /* a topology change publishes a snapshot with an empty cache */
+   bson_set_error (
+      &error, MONGOC_ERROR_STREAM, MONGOC_ERROR_STREAM_SOCKET, "socket error");
+   mongoc_topology_invalidate_server (topology, 1, &error);
+   new_snapshot = _mongoc_topology_snapshot_acquire (topology);
+   BSON_ASSERT (new_snapshot != snapshot);
+   ASSERT_CMPINT (new_snapshot->cache_len, ==, 0);
+
+   _mongoc_topology_snapshot_release (new_snapshot);
+   _mongoc_topology_snapshot_release (snapshot);
+   mongoc_read_prefs_destroy (prefs);
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+   mock_rs_destroy (rs);
+}
+
+
 /* mongoc_topology_scanner_add and mongoc_topology_scan are called within the
  * topology mutex to add a discovered node and call getaddrinfo on its host
  * immediately - test that this doesn't cause a recursive acquire on the
@@ -1648,6 +1816,7 @@ _get_last_scan (mongoc_client_t *client)
 typedef struct {
    int64_t when_transitioned_to_unknown;
    int64_t server_id;
+   char error_message[BSON_ERROR_BUFFER_SIZE];
 } request_scan_error_ctx_t;
 
 static void
@@ -1662,6 +1831,8 @@ _server_changed (const mongoc_apm_server_changed_t *event)
    if (sd->type == MONGOC_SERVER_UNKNOWN) {
       ctx->when_transitioned_to_unknown = bson_get_monotonic_time ();
       ctx->server_id = sd->id;
+      bson_strncpy (
+         ctx->error_message, sd->error.message, sizeof ctx->error_message);
    }
 }
 
@@ -1756,20 +1927,17 @@ _test_request_scan_on_error (bool pooled,
    bson_destroy (&reply);
 
    if (should_mark_unknown) {
-      mongoc_server_description_t *sd;
       /* between sending the 'ping' command and returning, the server should
        * have been marked as unknown. */
       ASSERT_CMPINT64 (last_scan, <=, ctx.when_transitioned_to_unknown);
       ASSERT_CMPINT64 (
          ctx.when_transitioned_to_unknown, <=, bson_get_monotonic_time ());
-      sd = mongoc_client_get_server_description (client,
-                                                 (uint32_t) ctx.server_id);
       /* check that the error on the server description matches the error
-       * message in the response. */
+       * message in the response. a pooled client probes the server at once,
+       * so check the description it was marked unknown with. */
       if (server_err) {
-         ASSERT_CMPSTR (server_err, sd->error.message);
+         ASSERT_CMPSTR (server_err, ctx.error_message);
       }
-      mongoc_server_description_destroy (sd);
    } else {
       ASSERT_CMPINT64 (ctx.when_transitioned_to_unknown, ==, (int64_t) 0);
    }
@@ -1894,6 +2062,552 @@ test_request_scan_on_error ()
 }
 
 
+/* after a "not master" error, a pooled client checks the old primary and the
+ * secondaries at once, and finds the new primary without a full rescan */
+static void
+test_fast_failover_probe (void)
+{
+   mock_rs_t *rs;
+   mongoc_uri_t *uri;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   mongoc_topology_t *topology;
+   bson_error_t error;
+   future_t *future;
+   request_t *request;
+   int64_t start;
+
+   rs = mock_rs_with_autoismaster (WIRE_VERSION_MAX, true, 2, 0);
+   mock_rs_run (rs);
+   uri = mongoc_uri_copy (mock_rs_get_uri (rs));
+   mongoc_uri_set_option_as_int32 (uri, "heartbeatFrequencyMS", 60 * 1000);
+   pool = mongoc_client_pool_new (uri);
+   topology = _mongoc_client_pool_get_topology (pool);
+   /* no heartbeat or requested full scan can happen during the test */
+   topology->min_heartbeat_frequency_msec = 60 * 1000;
+   client = mongoc_client_pool_pop (pool);
+
+   start = bson_get_monotonic_time ();
+   while (!_rs_discovered (topology)) {
+      ASSERT_CMPINT64 (bson_get_monotonic_time () - start, <, 10 * 1000 * 1000);
+      _mongoc_usleep (1000);
+   }
+
+   future = future_client_command_simple (
+      client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+   request =
+      mock_rs_receives_msg (rs, MONGOC_QUERY_NONE, tmp_bson ("{'ping': 1}"));
+   BSON_ASSERT (mock_rs_request_is_to_primary (rs, request));
+
+   /* an election, which the client learns of from the error */
+   mock_rs_stepdown (rs);
+   mock_rs_elect (rs, 0);
+   mock_server_replies_simple (
+      request, "{'ok': 0, 'code': 10107, 'errmsg': 'not master'}");
+   request_destroy (request);
+   BSON_ASSERT (!future_get_bool (future));
+   future_destroy (future);
+
+   start = bson_get_monotonic_time ();
+   future = future_client_command_simple (
+      client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+   request =
+      mock_rs_receives_msg (rs, MONGOC_QUERY_NONE, tmp_bson ("{'ping': 1}"));
+   BSON_ASSERT (mock_rs_request_is_to_primary (rs, request));
+   mock_server_replies_ok_and_destroys (request);
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+   ASSERT_CMPINT64 (bson_get_monotonic_time () - start, <, 10 * 1000 * 1000);
+
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+   mongoc_uri_destroy (uri);
+   mock_rs_destroy (rs);
+}
+
+
+/* a primary that keeps failing operations with "not master" while its
+ * ismaster says it's primary is probed at once after the first error, but
+ * not again within minHeartbeatFrequencyMS however many errors follow */
+static void
+test_probe_rate_limit (void)
+{
+   mock_rs_t *rs;
+   mongoc_uri_t *uri;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   mongoc_topology_t *topology;
+   mongoc_apm_callbacks_t *callbacks;
+   checks_t checks = {0};
+   bson_error_t error;
+   future_t *future;
+   request_t *request;
+   int n_started = 0;
+   size_t n_probes;
+   int i;
+
+   rs = mock_rs_with_autoismaster (WIRE_VERSION_MAX, true, 1, 0);
+   mock_rs_run (rs);
+   uri = mongoc_uri_copy (mock_rs_get_uri (rs));
+   mongoc_uri_set_option_as_int32 (uri, "heartbeatFrequencyMS", 60 * 1000);
+   pool = mongoc_client_pool_new (uri);
+   topology = _mongoc_client_pool_get_topology (pool);
+   /* no heartbeat or requested full scan can happen during the test */
+   topology->min_heartbeat_frequency_msec = 60 * 1000;
+   callbacks = heartbeat_callbacks ();
+   mongoc_client_pool_set_apm_callbacks (pool, callbacks, &checks);
+   client = mongoc_client_pool_pop (pool);
+
+   WAIT_UNTIL (_rs_discovered (topology));
+
+   for (i = 0; i < 2; i++) {
+      future = future_client_command_simple (
+         client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+      request =
+         mock_rs_receives_msg (rs, MONGOC_QUERY_NONE, tmp_bson ("{'ping': 1}"));
+      BSON_ASSERT (mock_rs_request_is_to_primary (rs, request));
+      mock_server_replies_simple (
+         request, "{'ok': 0, 'code': 10107, 'errmsg': 'not master'}");
+      request_destroy (request);
+      BSON_ASSERT (!future_get_bool (future));
+      future_destroy (future);
+
+      if (i == 0) {
+         /* the first error probes the primary and secondary at once */
+         WAIT_UNTIL (_rs_discovered (topology));
+         n_started = checks.n_started;
+      }
+   }
+
+   /* the second error's probe waits for minHeartbeatFrequencyMS */
+   _mongoc_usleep (500 * 1000);
+   ASSERT_CMPINT (checks.n_started, ==, n_started);
+
+   bson_mutex_lock (&topology->mutex);
+   n_probes = topology->probe_ids.len;
+   bson_mutex_unlock (&topology->mutex);
+   ASSERT_CMPSIZE_T (n_probes, ==, (size_t) 2);
+
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+   mongoc_apm_callbacks_destroy (callbacks);
+   mongoc_uri_destroy (uri);
+   mock_rs_destroy (rs);
+}
+
+
+static void
+_test_server_load (bool pooled)
+{
+   mock_server_t *server;
+   mongoc_client_pool_t *pool = NULL;
+   mongoc_client_t *client;
+   mongoc_server_description_t *sd;
+   bson_error_t error;
+   future_t *future;
+   request_t *request;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_MAX);
+   mock_server_run (server);
+
+   if (pooled) {
+      pool = mongoc_client_pool_new (mock_server_get_uri (server));
+      client = mongoc_client_pool_pop (pool);
+   } else {
+      client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   }
+
+   future = future_client_command_simple (
+      client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+   request = mock_server_receives_msg (
+      server, MONGOC_QUERY_NONE, tmp_bson ("{'ping': 1}"));
+
+   /* the command is counted while it awaits its reply */
+   sd = mongoc_client_get_server_description (client, 1);
+   ASSERT_CMPINT32 (mongoc_server_description_in_flight_count (sd), ==, 1);
+   mongoc_server_description_destroy (sd);
+
+   mock_server_replies_ok_and_destroys (request);
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+
+   sd = mongoc_client_get_server_description (client, 1);
+   ASSERT_CMPINT32 (mongoc_server_description_in_flight_count (sd), ==, 0);
+   ASSERT_CMPINT64 (
+      mongoc_server_description_command_latency_usec (sd), >=, (int64_t) 0);
+   mongoc_server_description_destroy (sd);
+
+   if (pooled) {
+      mongoc_client_pool_push (pool, client);
+      mongoc_client_pool_destroy (pool);
+   } else {
+      mongoc_client_destroy (client);
+   }
+
+   mock_server_destroy (server);
+}
+
+
+static void
+test_server_load_single (void)
+{
+   _test_server_load (false);
+}
+
+
+static void
+test_server_load_pooled (void)
+{
+   _test_server_load (true);
+}
+
+
+typedef struct {
+   bson_mutex_t mutex;
+   int64_t counter;
+   bool mongos;
+   int n_awaited;
+   /* awaitable ismasters to fail with ok: 0 */
+   int n_errors;
+   bool done;
+} stream_monitor_test_t;
+
+
+/* reply to ismaster with a topologyVersion, like MongoDB 4.4. answer an
+ * awaitable ismaster once the state changes */
+static bool
+_stream_monitor_responder (request_t *request, void *data)
+{
+   stream_monitor_test_t *test = (stream_monitor_test_t *) data;
+   const bson_t *doc;
+   int64_t counter;
+   char *reply;
+
+   if (!request->is_command ||
+       strcasecmp (request->command_name, "ismaster") != 0) {
+      return false;
+   }
+
+   doc = request_get_doc (request, 0);
+
+   bson_mutex_lock (&test->mutex);
+   if (bson_has_field (doc, "maxAwaitTimeMS")) {
+      counter = bson_lookup_int64 (doc, "topologyVersion.counter");
+      test->n_awaited++;
+      if (test->n_errors > 0) {
+         test->n_errors--;
+         bson_mutex_unlock (&test->mutex);
+         mock_server_replies_simple (
+            request, "{'ok': 0, 'code': 91, 'errmsg': 'shutting down'}");
+         request_destroy (request);
+         return true;
+      }
+
+      while (!test->done && test->counter == counter) {
+         bson_mutex_unlock (&test->mutex);
+         _mongoc_usleep (10 * 1000);
+         bson_mutex_lock (&test->mutex);
+      }
+   }
+
+   reply = bson_strdup_printf (
+      "{'ok': 1, 'ismaster': true, %s"
+      " 'minWireVersion': 0, 'maxWireVersion': %d,"
+      " 'topologyVersion': {"
+      "    'processId': {'$oid': '000000000000000000000001'},"
+      "    'counter': {'$numberLong': '%" PRId64 "'}}}",
+      test->mongos ? "'msg': 'isdbgrid'," : "",
+      WIRE_VERSION_MAX,
+      test->counter);
+   bson_mutex_unlock (&test->mutex);
+
+   mock_server_replies_simple (request, reply);
+   bson_free (reply);
+   request_destroy (request);
+
+   return true;
+}
+
+
+static mongoc_server_description_type_t
+_single_server_type (mongoc_topology_t *topology)
+{
+   mongoc_topology_snapshot_t *snapshot;
+   mongoc_server_description_t *sd;
+   mongoc_server_description_type_t type;
+
+   snapshot = _mongoc_topology_snapshot_acquire (topology);
+   if (!snapshot) {
+      return MONGOC_SERVER_UNKNOWN;
+   }
+
+   sd = mongoc_set_get_item (snapshot->description.servers, 0);
+   type = sd->type;
+   _mongoc_topology_snapshot_release (snapshot);
+
+   return type;
+}
+
+
+static void
+_test_server_monitor (bool stream)
+{
+   stream_monitor_test_t test = {0};
+   mock_server_t *server;
+   mongoc_uri_t *uri;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   mongoc_topology_t *topology;
+   int64_t start;
+
+   bson_mutex_init (&test.mutex);
+   test.counter = 1;
+
+   server = mock_server_new ();
+   mock_server_autoresponds (server, _stream_monitor_responder, &test, NULL);
+   mock_server_run (server);
+
+   uri = mongoc_uri_copy (mock_server_get_uri (server));
+   /* the topology scanner won't recheck the server during the test */
+   mongoc_uri_set_option_as_int32 (uri, "heartbeatFrequencyMS", 60 * 1000);
+   if (!stream) {
+      mongoc_uri_set_option_as_utf8 (uri, "serverMonitoringMode", "poll");
+   }
+
+   pool = mongoc_client_pool_new (uri);
+   topology = _mongoc_client_pool_get_topology (pool);
+   client = mongoc_client_pool_pop (pool);
+
+   start = bson_get_monotonic_time ();
+   while (_single_server_type (topology) != MONGOC_SERVER_STANDALONE) {
+      ASSERT_CMPINT64 (bson_get_monotonic_time () - start, <, 10 * 1000 * 1000);
+      _mongoc_usleep (1000);
+   }
+
+   if (stream) {
+      /* the monitor's awaitable ismaster is waiting for a change */
+      start = bson_get_monotonic_time ();
+      bson_mutex_lock (&test.mutex);
+      while (test.n_awaited == 0) {
+         bson_mutex_unlock (&test.mutex);
+         ASSERT_CMPINT64 (
+            bson_get_monotonic_time () - start, <, 10 * 1000 * 1000);
+         _mongoc_usleep (1000);
+         bson_mutex_lock (&test.mutex);
+      }
+
+      test.mongos = true;
+      test.counter++;
+      bson_mutex_unlock (&test.mutex);
+
+      /* the client learns of the change long before the next heartbeat */
+      start = bson_get_monotonic_time ();
+      while (_single_server_type (topology) != MONGOC_SERVER_MONGOS) {
+         ASSERT_CMPINT64 (
+            bson_get_monotonic_time () - start, <, 5 * 1000 * 1000);
+         _mongoc_usleep (1000);
+      }
+   } else {
+      _mongoc_usleep (500 * 1000);
+      bson_mutex_lock (&test.mutex);
+      ASSERT_CMPINT (test.n_awaited, ==, 0);
+      bson_mutex_unlock (&test.mutex);
+   }
+
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+
+   bson_mutex_lock (&test.mutex);
+   test.done = true;
+   bson_mutex_unlock (&test.mutex);
+
+   mongoc_uri_destroy (uri);
+   mock_server_destroy (server);
+   bson_mutex_destroy (&test.mutex);
+}
+
+
+static void
+test_server_monitor_stream (void)
+{
+   _test_server_monitor (true);
+}
+
+
+static void
+test_server_monitor_poll (void)
+{
+   _test_server_monitor (false);
+}
+
+
+static void
+_wait_for_awaited (stream_monitor_test_t *test, int n_awaited)
+{
+   int64_t start;
+
+   start = bson_get_monotonic_time ();
+   bson_mutex_lock (&test->mutex);
+   while (test->n_awaited < n_awaited) {
+      bson_mutex_unlock (&test->mutex);
+      ASSERT_CMPINT64 (bson_get_monotonic_time () - start, <, 10 * 1000 * 1000);
+      _mongoc_usleep (1000);
+      bson_mutex_lock (&test->mutex);
+   }
+
+   bson_mutex_unlock (&test->mutex);
+}
+
+
+/* the monitor keeps streaming after an awaitable ismaster fails */
+static void
+test_server_monitor_transient_error (void)
+{
+   stream_monitor_test_t test = {0};
+   mock_server_t *server;
+   mongoc_uri_t *uri;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   mongoc_topology_t *topology;
+   int64_t start;
+
+   bson_mutex_init (&test.mutex);
+   test.counter = 1;
+   test.n_errors = 1;
+
+   server = mock_server_new ();
+   mock_server_autoresponds (server, _stream_monitor_responder, &test, NULL);
+   mock_server_run (server);
+
+   uri = mongoc_uri_copy (mock_server_get_uri (server));
+   /* the topology scanner won't recheck the server during the test */
+   mongoc_uri_set_option_as_int32 (uri, "heartbeatFrequencyMS", 60 * 1000);
+   pool = mongoc_client_pool_new (uri);
+   topology = _mongoc_client_pool_get_topology (pool);
+   client = mongoc_client_pool_pop (pool);
+
+   /* the first awaitable ismaster fails, the monitor reconnects */
+   _wait_for_awaited (&test, 2);
+
+   bson_mutex_lock (&test.mutex);
+   test.mongos = true;
+   test.counter++;
+   bson_mutex_unlock (&test.mutex);
+
+   start = bson_get_monotonic_time ();
+   while (_single_server_type (topology) != MONGOC_SERVER_MONGOS) {
+      ASSERT_CMPINT64 (bson_get_monotonic_time () - start, <, 5 * 1000 * 1000);
+      _mongoc_usleep (1000);
+   }
+
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+
+   bson_mutex_lock (&test.mutex);
+   test.done = true;
+   bson_mutex_unlock (&test.mutex);
+
+   mongoc_uri_destroy (uri);
+   mock_server_destroy (server);
+   bson_mutex_destroy (&test.mutex);
+}
+
+
+static mongoc_stream_t *
+_cannot_resolve (const mongoc_uri_t *uri,
+                 const mongoc_host_list_t *host,
+                 void *user_data,
+                 bson_error_t *error)
+{
+   bson_set_error (error,
+                   MONGOC_ERROR_STREAM,
+                   MONGOC_ERROR_STREAM_NAME_RESOLUTION,
+                   "Fake error for '%s'",
+                   host->host);
+
+   return NULL;
+}
+
+
+static mongoc_server_description_type_t
+_described_server_type (mongoc_topology_t *topology)
+{
+   mongoc_server_description_t *sd;
+   mongoc_server_description_type_t type;
+
+   bson_mutex_lock (&topology->mutex);
+   sd = mongoc_set_get_item (topology->description.servers, 0);
+   type = sd->type;
+   bson_mutex_unlock (&topology->mutex);
+
+   return type;
+}
+
+
+/* a pooled client stops selecting a server once its host can't be resolved */
+static void
+test_setup_error_publishes (void)
+{
+   mock_server_t *server;
+   mongoc_uri_t *uri;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   mongoc_topology_t *topology;
+   mongoc_topology_scanner_node_t *node;
+   mongoc_server_description_t *sd;
+   bson_error_t error;
+   int64_t start;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_MAX);
+   mock_server_run (server);
+
+   uri = mongoc_uri_copy (mock_server_get_uri (server));
+   mongoc_uri_set_option_as_int32 (uri, "heartbeatFrequencyMS", 60 * 1000);
+   mongoc_uri_set_option_as_int32 (uri, "serverSelectionTimeoutMS", 100);
+   pool = mongoc_client_pool_new (uri);
+   topology = _mongoc_client_pool_get_topology (pool);
+   client = mongoc_client_pool_pop (pool);
+
+   start = bson_get_monotonic_time ();
+   while (_single_server_type (topology) != MONGOC_SERVER_STANDALONE) {
+      ASSERT_CMPINT64 (bson_get_monotonic_time () - start, <, 10 * 1000 * 1000);
+      _mongoc_usleep (1000);
+   }
+
+   sd = mongoc_topology_select (topology, MONGOC_SS_READ, NULL, &error);
+   ASSERT_OR_PRINT (sd, error);
+   mongoc_server_description_destroy (sd);
+
+   /* the scanner's connection is lost and the host stops resolving */
+   bson_mutex_lock (&topology->mutex);
+   node = mongoc_topology_scanner_get_node (topology->scanner, 1);
+   mongoc_topology_scanner_node_disconnect (node, false);
+   mongoc_topology_scanner_set_stream_initiator (
+      topology->scanner, _cannot_resolve, NULL);
+   _mongoc_topology_request_scan (topology);
+   bson_mutex_unlock (&topology->mutex);
+
+   start = bson_get_monotonic_time ();
+   while (_described_server_type (topology) != MONGOC_SERVER_UNKNOWN) {
+      ASSERT_CMPINT64 (bson_get_monotonic_time () - start, <, 10 * 1000 * 1000);
+      _mongoc_usleep (1000);
+   }
+
+   BSON_ASSERT (_single_server_type (topology) == MONGOC_SERVER_UNKNOWN);
+   sd = mongoc_topology_select (topology, MONGOC_SS_READ, NULL, &error);
+   BSON_ASSERT (!sd);
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_SERVER_SELECTION,
+                          MONGOC_ERROR_SERVER_SELECTION_FAILURE,
+                          "Fake error for");
+
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+   mongoc_uri_destroy (uri);
+   mock_server_destroy (server);
+}
+
+
 void
 test_topology_install (TestSuite *suite)
 {
@@ -2035,4 +2749,26 @@ test_topology_install (TestSuite *suite)
                                 test_cluster_time_updated_during_handshake);
    TestSuite_AddMockServerTest (
       suite, "/Topology/request_scan_on_error", test_request_scan_on_error);
+   TestSuite_AddMockServerTest (
+      suite, "/Topology/snapshot", test_topology_snapshot);
+   TestSuite_AddMockServerTest (suite,
+                                "/Topology/snapshot/selection_cache",
+                                test_topology_snapshot_selection_cache);
+   TestSuite_AddMockServerTest (
+      suite, "/Topology/fast_failover_probe", test_fast_failover_probe);
+   TestSuite_AddMockServerTest (
+      suite, "/Topology/probe_rate_limit", test_probe_rate_limit);
+   TestSuite_AddMockServerTest (
+      suite, "/Topology/server_load/single", test_server_load_single);
+   TestSuite_AddMockServerTest (
+      suite, "/Topology/server_load/pooled", test_server_load_pooled);
+   TestSuite_AddMockServerTest (
+      suite, "/Topology/server_monitor/stream", test_server_monitor_stream);
+   TestSuite_AddMockServerTest (
+      suite, "/Topology/server_monitor/poll", test_server_monitor_poll);
+   TestSuite_AddMockServerTest (suite,
+                                "/Topology/server_monitor/transient_error",
+                                test_server_monitor_transient_error);
+   TestSuite_AddMockServerTest (
+      suite, "/Topology/setup_error_publishes", test_setup_error_publishes);
 }
@@ -0,0 +1,647 @@
+/*
+ * Copyright 2014 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * mongoc-dump writes each collection to DIR/<db>/<collection>.bson.
+ *
+ * Collections are dumped in parallel by worker threads sharing a
+ * mongoc_client_pool_t. Large collections are split into _id ranges so that
+ * several cursors read one collection at once; the boundaries are found in a
+ * single pass over the _id index. Each range appends to the collection's
+ * file in large chunks built with a bson_writer_t.
+ */
+
+
+#include <bson/bson.h>
+#include <mongoc/mongoc.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+
+/* flush a range's buffered documents to the file at this size */
+#define DUMP_FLUSH_SIZE (4 * 1024 * 1024)
+
+/* don't split collections into ranges smaller than this */
+#define DUMP_MIN_RANGE_DOCS 10000
+
+
+typedef struct {
+   char *database;
+   char *collection;
+   char *path;
+   FILE *stream;
+   pthread_mutex_t mutex;
+   bool failed;
+} dump_file_t;
+
+
+typedef struct {
+   dump_file_t *file;
+   bson_t min; /* empty for the first range */
+   bson_t max; /* empty for the last range */
+} dump_task_t;
+
+
+typedef struct {
+   mongoc_client_pool_t *pool;
+   const char *outdir;
+   int max_ranges;
+   dump_file_t **files;
+   size_t n_files;
+   dump_task_t *tasks;
+   size_t n_tasks;
+   size_t next_task;
+   int64_t n_docs;
+   int64_t n_bytes;
+   bool failed;
+   pthread_mutex_t mutex;
+} dump_t;
+
+
+static bool
+dump_mkdir_p (const char *path, int mode)
+{
+   return (mkdir (path, mode) == 0 || errno == EEXIST);
+}
+
+
+static bool
+dump_file_write (dump_file_t *file, const uint8_t *buf, size_t len)
+{
+   bool ret;
+
+   if (!len) {
+      return true;
+   }
+
+   pthread_mutex_lock (&file->mutex);
+   ret = !file->failed && len == fwrite (buf, 1, len, file->stream);
+   if (!ret && !file->failed) {
+      fprintf (stderr, "Failed to write %zu bytes to %s\n", len, file->path);
+      file->failed = true;
+   }
+   pthread_mutex_unlock (&file->mutex);
+
+   return ret;
+}
+
+
+static bool
+dump_task_run (dump_t *dump, mongoc_client_t *client, dump_task_t *task)
+{
+   mongoc_collection_t *col;
+   mongoc_cursor_t *cursor;
+   bson_writer_t *writer;
+   const bson_t *doc;
+   bson_t *b;
+   bson_t filter = BSON_INITIALIZER;
+   bson_t opts = BSON_INITIALIZER;
+   bson_error_t error;
+   uint8_t *buf = NULL;
+   size_t buflen = 0;
+   int64_t n_docs = 0;
+   int64_t n_bytes = 0;
+   bool ret = true;
+
+   /* index bounds, not $gte / $lt, so that _ids of every type match */
+   if (!bson_empty (&task->min) || !bson_empty (&task->max)) {
+      BCON_APPEND (&opts, "hint", "{", "_id", BCON_INT32 (1), "}");
+   }
+
+   if (!bson_empty (&task->min)) {
+      BSON_APPEND_DOCUMENT (&opts, "min", &task->min);
+   }
+
+   if (!bson_empty (&task->max)) {
+      BSON_APPEND_DOCUMENT (&opts, "max", &task->max);
+   }
+
+   col = mongoc_client_get_collection (
+      client, task->file->database, task->file->collection);
+   cursor = mongoc_collection_find_with_opts (col, &filter, &opts, NULL);
+   writer = bson_writer_new (&buf, &buflen, 0, bson_realloc_ctx, NULL);
+
+   while (mongoc_cursor_next (cursor, &doc)) {
+      bson_writer_begin (writer, &b);
+      bson_concat (b, doc);
+      bson_writer_end (writer);
+
+      n_docs++;
+      n_bytes += doc->len;
+
+      if (bson_writer_get_length (writer) >= DUMP_FLUSH_SIZE) {
+         if (!dump_file_write (
+                task->file, buf, bson_writer_get_length (writer))) {
+            ret = false;
+            goto cleanup;
+         }
+
+         /* start over at the beginning of the same buffer */
+         bson_writer_destroy (writer);
+         writer = bson_writer_new (&buf, &buflen, 0, bson_realloc_ctx, NULL);
+      }
+   }
+
+   if (mongoc_cursor_error (cursor, &error)) {
+      fprintf (stderr,
+               "Failed to dump %s.%s: %s\n",
+               task->file->database,
+               task->file->collection,
+               error.message);
+      ret = false;
+      goto cleanup;
+   }
+
+   ret = dump_file_write (task->file, buf, bson_writer_get_length (writer));
+
+cleanup:
+   pthread_mutex_lock (&dump->mutex);
+   dump->n_docs += n_docs;
+   dump->n_bytes += n_bytes;
+   pthread_mutex_unlock (&dump->mutex);
+
+   bson_writer_destroy (writer);
+   bson_free (buf);
+   mongoc_cursor_destroy (cursor);
+   mongoc_collection_destroy (col);
+   bson_destroy (&opts);
+   bson_destroy (&filter);
+
+   return ret;
+}
+
+
+static void *
+dump_worker (void *data)
+{
+   dump_t *dump = (dump_t *) data;
+   mongoc_client_t *client;
+   dump_task_t *task;
+
+   client = mongoc_client_pool_pop (dump->pool);
+
+   for (;;) {
+      pthread_mutex_lock (&dump->mutex);
+      if (dump->failed || dump->next_task == dump->n_tasks) {
+         pthread_mutex_unlock (&dump->mutex);
+         break;
+      }
+
+      task = &dump->tasks[dump->next_task++];
+      pthread_mutex_unlock (&dump->mutex);
+
+      if (!dump_task_run (dump, client, task)) {
+         pthread_mutex_lock (&dump->mutex);
+         dump->failed = true;
+         pthread_mutex_unlock (&dump->mutex);
+      }
+   }
+
+   mongoc_client_pool_push (dump->pool, client);
+
+   return NULL;
+}
+
+
+/* walk the _id index once, in order, and take the key at every
+ * count / n_ranges position as the upper boundary of a range. returnKey makes
+ * the server read only the index, not the documents. returns the number of
+ * ranges found: fewer than n_ranges if the collection shrank, or 1 if the
+ * index can't be read, e.g. for a view */
+static int
+dump_find_boundaries (mongoc_collection_t *col,
+                      int64_t count,
+                      int n_ranges,
+                      bson_t *boundaries)
+{
+   mongoc_cursor_t *cursor;
+   const bson_t *doc;
+   bson_iter_t iter;
+   bson_t filter = BSON_INITIALIZER;
+   bson_t *opts;
+   int64_t pos = 0;
+   int n_found = 1;
+   int i;
+
+   opts = BCON_NEW ("sort",
+                    "{",
+                    "_id",
+                    BCON_INT32 (1),
+                    "}",
+                    "hint",
+                    "{",
+                    "_id",
+                    BCON_INT32 (1),
+                    "}",
+                    "returnKey",
+                    BCON_BOOL (true));
+
+   cursor = mongoc_collection_find_with_opts (col, &filter, opts, NULL);
+   while (n_found < n_ranges && mongoc_cursor_next (cursor, &doc)) {
+      if (pos++ == count * n_found / n_ranges &&
+          bson_iter_init_find (&iter, doc, "_id")) {
+         BSON_APPEND_VALUE (
+            &boundaries[n_found++], "_id", bson_iter_value (&iter));
+      }
+   }
+
+   if (mongoc_cursor_error (cursor, NULL)) {
+      for (i = 1; i < n_found; i++) {
+         bson_reinit (&boundaries[i]);
+      }
+
+      n_found = 1;
+   }
+
+   mongoc_cursor_destroy (cursor);
+   bson_destroy (opts);
+   bson_destroy (&filter);
+
+   return n_found;
+}
+
+
+static void
+dump_add_task (dump_t *dump,
+               dump_file_t *file,
+               const bson_t *min,
+               const bson_t *max)
+{
+   dump_task_t *task;
+
+   dump->tasks = bson_realloc (dump->tasks,
+                               (dump->n_tasks + 1) * sizeof (dump_task_t));
+   task = &dump->tasks[dump->n_tasks++];
+   task->file = file;
+   bson_copy_to (min, &task->min);
+   bson_copy_to (max, &task->max);
+}
+
+
+static bool
+dump_plan_collection (dump_t *dump,
+                      mongoc_client_t *client,
+                      const char *database,
+                      const char *collection)
+{
+   mongoc_collection_t *col;
+   dump_file_t *file;
+   bson_t *boundaries;
+   int64_t count;
+   int n_ranges = 1;
+   int n_found = 1;
+   int i;
+
+   file = bson_malloc0 (sizeof *file);
+   file->database = bson_strdup (database);
+   file->collection = bson_strdup (collection);
+   file->path =
+      bson_strdup_printf ("%s/%s/%s.bson", dump->outdir, database, collection);
+   pthread_mutex_init (&file->mutex, NULL);
+
+   dump->files = bson_realloc (dump->files,
+                               (dump->n_files + 1) * sizeof (dump_file_t *));
+   dump->files[dump->n_files++] = file;
+
+   file->stream = fopen (file->path, "w");
+   if (!file->stream) {
+      fprintf (stderr, "Failed to open \"%s\", aborting.\n", file->path);
+      return false;
+   }
+
+   col = mongoc_client_get_collection (client, database, collection);
+   count =
+      mongoc_collection_estimated_document_count (col, NULL, NULL, NULL, NULL);
+   if (count > 0) {
+      n_ranges = (int) BSON_MIN (dump->max_ranges, count / DUMP_MIN_RANGE_DOCS);
+      n_ranges = BSON_MAX (n_ranges, 1);
+   }
+
+   /* the first and last ranges are open-ended */
+   boundaries = bson_malloc0 ((n_ranges + 1) * sizeof (bson_t));
+   for (i = 0; i <= n_ranges; i++) {
+      bson_init (&boundaries[i]);
+   }
+
+   if (n_ranges > 1) {
+      n_found = dump_find_boundaries (col, count, n_ranges, boundaries);
+   }
+
+   /* boundaries[n_found] is still empty, the last range is open-ended */
+   for (i = 0; i < n_found; i++) {
+      dump_add_task (dump, file, &boundaries[i], &boundaries[i + 1]);
+   }
+
+   for (i = 0; i <= n_ranges; i++) {
+      bson_destroy (&boundaries[i]);
+   }
+
+   bson_free (boundaries);
+   mongoc_collection_destroy (col);
+
+   return true;
+}
+
+
+static bool
+dump_plan_database (dump_t *dump,
+                    mongoc_client_t *client,
+                    const char *database,
+                    const char *collection)
+{
+   mongoc_database_t *db;
+   bson_error_t error;
+   char *path;
+   char **str;
+   bool ret = true;
+   int i;
+
+   path = bson_strdup_printf ("%s/%s", dump->outdir, database);
+   if (!dump_mkdir_p (path, 0750)) {
+      fprintf (stderr, "Failed to create directory \"%s\"\n", path);
+      bson_free (path);
+      return false;
+   }
+
+   bson_free (path);
+
+   if (collection) {
+      return dump_plan_collection (dump, client, database, collection);
+   }
+
+   db = mongoc_client_get_database (client, database);
+   str = mongoc_database_get_collection_names_with_opts (db, NULL, &error);
+   if (!str) {
+      fprintf (stderr,
+               "Failed to fetch collection names for \"%s\": %s\n",
+               database,
+               error.message);
+      mongoc_database_destroy (db);
+      return false;
+   }
+
+   for (i = 0; str[i]; i++) {
+      if (!dump_plan_collection (dump, client, database, str[i])) {
+         ret = false;
+         break;
+      }
+   }
+
+   mongoc_database_destroy (db);
+   bson_strfreev (str);
+
+   return ret;
+}
+
+
+static bool
+dump_plan (dump_t *dump, const char *database, const char *collection)
+{
+   mongoc_client_t *client;
+   bson_error_t error;
+   char **str;
+   bool ret = true;
+   int i;
+
+   if (!dump_mkdir_p (dump->outdir, 0750)) {
+      fprintf (stderr, "Failed to create directory \"%s\"\n", dump->outdir);
+      return false;
+   }
+
+   client = mongoc_client_pool_pop (dump->pool);
+
+   if (database) {
+      ret = dump_plan_database (dump, client, database, collection);
+      goto done;
+   }
+
+   if (!(str = mongoc_client_get_database_names_with_opts (
+            client, NULL, &error))) {
+      fprintf (stderr, "Failed to fetch database names: %s\n", error.message);
+      ret = false;
+      goto done;
+   }
+
+   for (i = 0; str[i]; i++) {
+      if (!dump_plan_database (dump, client, str[i], NULL)) {
+         ret = false;
+         break;
+      }
+   }
+
+   bson_strfreev (str);
+
+done:
+   mongoc_client_pool_push (dump->pool, client);
+
+   return ret;
+}
+
+
+static void
+dump_cleanup (dump_t *dump)
+{
+   dump_file_t *file;
+   size_t i;
+
+   for (i = 0; i < dump->n_tasks; i++) {
+      bson_destroy (&dump->tasks[i].min);
+      bson_destroy (&dump->tasks[i].max);
+   }
+
+   for (i = 0; i < dump->n_files; i++) {
+      file = dump->files[i];
+      if (file->stream && 0 != fclose (file->stream)) {
+         fprintf (stderr, "Failed to close %s\n", file->path);
+         dump->failed = true;
+      }
+
+      pthread_mutex_destroy (&file->mutex);
+      bson_free (file->database);
+      bson_free (file->collection);
+      bson_free (file->path);
+      bson_free (file);
+   }
+
+   bson_free (dump->tasks);
+   bson_free (dump->files);
+   pthread_mutex_destroy (&dump->mutex);
+}
+
+
+static void
+usage (FILE *stream)
+{
+   fprintf (stream,
+            "Usage: mongoc-dump [OPTIONS]\n"
+            "\n"
+            "Options:\n"
+            "\n"
+            "  -h HOST      Optional hostname to connect to [127.0.0.1].\n"
+            "  -p PORT      Optional port to connect to [27017].\n"
+            "  --uri URI    Optional connection string, instead of -h and -p.\n"
+            "  -d DBNAME    Optional database name to dump.\n"
+            "  -c COLNAME   Optional collection name to dump.\n"
+            "  -o DIR       Optional output directory [dump].\n"
+            "  -j THREADS   Optional number of worker threads [4].\n"
+            "  -r RANGES    Optional maximum _id ranges per collection "
+            "[THREADS].\n"
+            "  --ssl        Use SSL when connecting to server.\n"
+            "\n");
+}
+
+
+int
+main (int argc, char *argv[])
+{
+   dump_t dump = {0};
+   const char *collection = NULL;
+   const char *database = NULL;
+   const char *host = "127.0.0.1";
+   const char *uri_arg = NULL;
+   uint16_t port = 27017;
+   bool ssl = false;
+   int n_threads = 4;
+   char *uri_string;
+   mongoc_uri_t *uri;
+   pthread_t *threads;
+   bson_error_t error;
+   int64_t start;
+   double elapsed;
+   int i;
+
+   dump.outdir = "dump";
+
+   for (i = 1; i < argc; i++) {
+      if (0 == strcmp (argv[i], "-c") && ((i + 1) < argc)) {
+         collection = argv[++i];
+      } else if (0 == strcmp (argv[i], "-d") && ((i + 1) < argc)) {
+         database = argv[++i];
+      } else if (0 == strcmp (argv[i], "--help")) {
+         usage (stdout);
+         return EXIT_SUCCESS;
+      } else if (0 == strcmp (argv[i], "-h") && ((i + 1) < argc)) {
+         host = argv[++i];
+      } else if (0 == strcmp (argv[i], "-j") && ((i + 1) < argc)) {
+         n_threads = atoi (argv[++i]);
+         if (n_threads < 1) {
+            fprintf (stderr, "Invalid thread count \"%s\"\n", argv[i]);
+            return EXIT_FAILURE;
+         }
+      } else if (0 == strcmp (argv[i], "-o") && ((i + 1) < argc)) {
+         dump.outdir = argv[++i];
+      } else if (0 == strcmp (argv[i], "-p") && ((i + 1) < argc)) {
+         port = atoi (argv[++i]);
+         if (!port) {
+            fprintf (stderr, "Invalid port \"%s\"\n", argv[i]);
+            return EXIT_FAILURE;
+         }
+      } else if (0 == strcmp (argv[i], "-r") && ((i + 1) < argc)) {
+         dump.max_ranges = atoi (argv[++i]);
+         if (dump.max_ranges < 1) {
+            fprintf (stderr, "Invalid range count \"%s\"\n", argv[i]);
+            return EXIT_FAILURE;
+         }
+      } else if (0 == strcmp (argv[i], "--ssl")) {
+         ssl = true;
+      } else if (0 == strcmp (argv[i], "--uri") && ((i + 1) < argc)) {
+         uri_arg = argv[++i];
+      } else {
+         fprintf (stderr, "Unknown argument \"%s\"\n", argv[i]);
+         return EXIT_FAILURE;
+      }
+   }
+
+   if (!dump.max_ranges) {
+      dump.max_ranges = n_threads;
+   }
+
+   mongoc_init ();
+
+   if (uri_arg) {
+      uri_string = bson_strdup (uri_arg);
+   } else {
+      uri_string = bson_strdup_printf (
+         "mongodb://%s:%hu/?appname=mongoc-dump&ssl=%s&maxPoolSize=%d",
+         host,
+         port,
+         ssl ? "true" : "false",
+         n_threads);
+   }
+
+   uri = mongoc_uri_new_with_error (uri_string, &error);
+   if (!uri) {
+      fprintf (stderr,
+               "failed to parse URI: %s\n"
+               "error message:       %s\n",
+               uri_string,
+               error.message);
+      bson_free (uri_string);
+      return EXIT_FAILURE;
+   }
+
+   dump.pool = mongoc_client_pool_new (uri);
+   if (!dump.pool) {
+      bson_free (uri_string);
+      mongoc_uri_destroy (uri);
+      return EXIT_FAILURE;
+   }
+
+   mongoc_client_pool_set_error_api (dump.pool, 2);
+   pthread_mutex_init (&dump.mutex, NULL);
+
+   start = bson_get_monotonic_time ();
+
+   if (!dump_plan (&dump, database, collection)) {
+      dump.failed = true;
+   } else {
+      threads = bson_malloc (n_threads * sizeof (pthread_t));
+      for (i = 0; i < n_threads; i++) {
+         pthread_create (&threads[i], NULL, dump_worker, &dump);
+      }
+
+      for (i = 0; i < n_threads; i++) {
+         pthread_join (threads[i], NULL);
+      }
+
+      bson_free (threads);
+   }
+
+   dump_cleanup (&dump);
+
+   elapsed = (bson_get_monotonic_time () - start) / 1e6;
+   fprintf (stderr,
+            "dumped %" PRId64 " documents (%.1f MB) from %zu collections "
+            "in %.2f s: %.0f docs/sec, %.1f MB/sec\n",
+            dump.n_docs,
+            dump.n_bytes / 1e6,
+            dump.n_files,
+            elapsed,
+            elapsed > 0 ? dump.n_docs / elapsed : 0.0,
+            elapsed > 0 ? dump.n_bytes / 1e6 / elapsed : 0.0);
+
+   mongoc_client_pool_destroy (dump.pool);
+   mongoc_uri_destroy (uri);
+   bson_free (uri_string);
+   mongoc_cleanup ();
+
+   return dump.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
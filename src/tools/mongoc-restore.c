@@ -0,0 +1,545 @@
+/*
+ * Copyright 2018 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * mongoc-restore loads DIR/<db>/<collection>.bson files written by
+ * mongoc-dump (or mongodump) back into a server.
+ *
+ * Worker threads share a mongoc_client_pool_t and take turns reading batches
+ * from each file's bson_reader_t, so several threads insert into the same
+ * collection at once. Each batch is sent as a large unordered insert with
+ * mongoc_collection_insert_raw, without re-encoding the documents.
+ */
+
+
+#include <bson/bson.h>
+#include <mongoc/mongoc.h>
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+typedef struct {
+   char *database;
+   char *collection;
+   char *path;
+   bson_reader_t *reader;
+   pthread_mutex_t mutex;
+   bool eof;
+} restore_file_t;
+
+
+typedef struct {
+   mongoc_client_pool_t *pool;
+   const char *indir;
+   size_t batch_size;
+   bool drop;
+   restore_file_t **files;
+   size_t n_files;
+   size_t next_file;
+   int64_t n_docs;
+   int64_t n_bytes;
+   bool failed;
+   pthread_mutex_t mutex;
+} restore_t;
+
+
+static bool
+restore_has_suffix (const char *str, const char *suffix)
+{
+   size_t len = strlen (str);
+   size_t suffix_len = strlen (suffix);
+
+   return len > suffix_len && 0 == strcmp (str + len - suffix_len, suffix);
+}
+
+
+/* append up to batch_size bytes of documents from the file's reader */
+static bool
+restore_read_batch (restore_t *restore,
+                    restore_file_t *file,
+                    bson_writer_t *writer,
+                    int64_t *n_docs)
+{
+   const bson_t *doc;
+   bson_t *b;
+   bool reached_eof = false;
+   bool ret = true;
+
+   *n_docs = 0;
+
+   pthread_mutex_lock (&file->mutex);
+   if (file->eof) {
+      pthread_mutex_unlock (&file->mutex);
+      return true;
+   }
+
+   while (bson_writer_get_length (writer) < restore->batch_size) {
+      doc = bson_reader_read (file->reader, &reached_eof);
+      if (!doc) {
+         if (!reached_eof) {
+            fprintf (stderr, "Corrupt BSON in %s\n", file->path);
+            ret = false;
+         }
+
+         file->eof = true;
+         break;
+      }
+
+      bson_writer_begin (writer, &b);
+      bson_concat (b, doc);
+      bson_writer_end (writer);
+      (*n_docs)++;
+   }
+
+   pthread_mutex_unlock (&file->mutex);
+
+   return ret;
+}
+
+
+static bool
+restore_file_run (restore_t *restore,
+                  mongoc_client_t *client,
+                  restore_file_t *file)
+{
+   mongoc_collection_t *col;
+   bson_writer_t *writer;
+   uint8_t *buf = NULL;
+   size_t buflen = 0;
+   size_t len;
+   int64_t n_docs;
+   bson_t *opts;
+   bson_error_t error;
+   bool ret = true;
+
+   /* the documents were validated when they were first inserted */
+   opts =
+      BCON_NEW ("ordered", BCON_BOOL (false), "validate", BCON_BOOL (false));
+   col =
+      mongoc_client_get_collection (client, file->database, file->collection);
+
+   for (;;) {
+      writer = bson_writer_new (&buf, &buflen, 0, bson_realloc_ctx, NULL);
+      if (!restore_read_batch (restore, file, writer, &n_docs)) {
+         ret = false;
+      }
+
+      len = bson_writer_get_length (writer);
+      bson_writer_destroy (writer);
+
+      if (!n_docs) {
+         break;
+      }
+
+      if (!mongoc_collection_insert_raw (col, buf, len, opts, NULL, &error)) {
+         fprintf (stderr,
+                  "Failed to restore %s.%s: %s\n",
+                  file->database,
+                  file->collection,
+                  error.message);
+         ret = false;
+         break;
+      }
+
+      pthread_mutex_lock (&restore->mutex);
+      restore->n_docs += n_docs;
+      restore->n_bytes += len;
+      pthread_mutex_unlock (&restore->mutex);
+
+      if (!ret) {
+         break;
+      }
+   }
+
+   bson_free (buf);
+   bson_destroy (opts);
+   mongoc_collection_destroy (col);
+
+   return ret;
+}
+
+
+static void *
+restore_worker (void *data)
+{
+   restore_t *restore = (restore_t *) data;
+   mongoc_client_t *client;
+   restore_file_t *file;
+
+   client = mongoc_client_pool_pop (restore->pool);
+
+   for (;;) {
+      pthread_mutex_lock (&restore->mutex);
+      if (restore->failed || restore->next_file == restore->n_files) {
+         pthread_mutex_unlock (&restore->mutex);
+         break;
+      }
+
+      /* stay on a file until it is drained, so files are loaded in order
+       * while still spreading each file across all the workers */
+      file = restore->files[restore->next_file];
+      pthread_mutex_lock (&file->mutex);
+      if (file->eof) {
+         pthread_mutex_unlock (&file->mutex);
+         restore->next_file++;
+         pthread_mutex_unlock (&restore->mutex);
+         continue;
+      }
+
+      pthread_mutex_unlock (&file->mutex);
+      pthread_mutex_unlock (&restore->mutex);
+
+      if (!restore_file_run (restore, client, file)) {
+         pthread_mutex_lock (&restore->mutex);
+         restore->failed = true;
+         pthread_mutex_unlock (&restore->mutex);
+      }
+   }
+
+   mongoc_client_pool_push (restore->pool, client);
+
+   return NULL;
+}
+
+
+static bool
+restore_plan_file (restore_t *restore,
+                   mongoc_client_t *client,
+                   const char *database,
+                   const char *filename)
+{
+   restore_file_t *file;
+   mongoc_collection_t *col;
+   bson_error_t error;
+
+   file = bson_malloc0 (sizeof *file);
+   file->database = bson_strdup (database);
+   file->collection =
+      bson_strndup (filename, strlen (filename) - strlen (".bson"));
+   file->path =
+      bson_strdup_printf ("%s/%s/%s", restore->indir, database, filename);
+   pthread_mutex_init (&file->mutex, NULL);
+
+   restore->files = bson_realloc (
+      restore->files, (restore->n_files + 1) * sizeof (restore_file_t *));
+   restore->files[restore->n_files++] = file;
+
+   file->reader = bson_reader_new_from_file (file->path, &error);
+   if (!file->reader) {
+      fprintf (
+         stderr, "Failed to open \"%s\": %s\n", file->path, error.message);
+      return false;
+   }
+
+   if (restore->drop) {
+      col = mongoc_client_get_collection (client, database, file->collection);
+      if (!mongoc_collection_drop (col, &error) &&
+          !strstr (error.message, "ns not found")) {
+         fprintf (stderr,
+                  "Failed to drop %s.%s: %s\n",
+                  database,
+                  file->collection,
+                  error.message);
+         mongoc_collection_destroy (col);
+         return false;
+      }
+
+      mongoc_collection_destroy (col);
+   }
+
+   return true;
+}
+
+
+static bool
+restore_plan_database (restore_t *restore,
+                       mongoc_client_t *client,
+                       const char *database,
+                       const char *collection)
+{
+   struct dirent *entry;
+   char *path;
+   char *filename;
+   DIR *dir;
+   bool ret = true;
+
+   if (collection) {
+      filename = bson_strdup_printf ("%s.bson", collection);
+      ret = restore_plan_file (restore, client, database, filename);
+      bson_free (filename);
+      return ret;
+   }
+
+   path = bson_strdup_printf ("%s/%s", restore->indir, database);
+   dir = opendir (path);
+   if (!dir) {
+      fprintf (stderr, "Failed to open directory \"%s\"\n", path);
+      bson_free (path);
+      return false;
+   }
+
+   while ((entry = readdir (dir))) {
+      /* system collections like system.profile can't be inserted into */
+      if (restore_has_suffix (entry->d_name, ".bson") &&
+          0 != strncmp (entry->d_name, "system.", 7) &&
+          !restore_plan_file (restore, client, database, entry->d_name)) {
+         ret = false;
+         break;
+      }
+   }
+
+   closedir (dir);
+   bson_free (path);
+
+   return ret;
+}
+
+
+static bool
+restore_plan (restore_t *restore, const char *database, const char *collection)
+{
+   mongoc_client_t *client;
+   struct dirent *entry;
+   DIR *dir;
+   bool ret = true;
+
+   client = mongoc_client_pool_pop (restore->pool);
+
+   if (database) {
+      ret = restore_plan_database (restore, client, database, collection);
+      goto done;
+   }
+
+   dir = opendir (restore->indir);
+   if (!dir) {
+      fprintf (stderr, "Failed to open directory \"%s\"\n", restore->indir);
+      ret = false;
+      goto done;
+   }
+
+   while ((entry = readdir (dir))) {
+      if (entry->d_name[0] == '.') {
+         continue;
+      }
+
+      if (!restore_plan_database (restore, client, entry->d_name, NULL)) {
+         ret = false;
+         break;
+      }
+   }
+
+   closedir (dir);
+
+done:
+   mongoc_client_pool_push (restore->pool, client);
+
+   return ret;
+}
+
+
+static void
+restore_cleanup (restore_t *restore)
+{
+   restore_file_t *file;
+   size_t i;
+
+   for (i = 0; i < restore->n_files; i++) {
+      file = restore->files[i];
+      if (file->reader) {
+         bson_reader_destroy (file->reader);
+      }
+
+      pthread_mutex_destroy (&file->mutex);
+      bson_free (file->database);
+      bson_free (file->collection);
+      bson_free (file->path);
+      bson_free (file);
+   }
+
+   bson_free (restore->files);
+   pthread_mutex_destroy (&restore->mutex);
+}
+
+
+static void
+usage (FILE *stream)
+{
+   fprintf (stream,
+            "Usage: mongoc-restore [OPTIONS]\n"
+            "\n"
+            "Options:\n"
+            "\n"
+            "  -h HOST      Optional hostname to connect to [127.0.0.1].\n"
+            "  -p PORT      Optional port to connect to [27017].\n"
+            "  --uri URI    Optional connection string, instead of -h and -p.\n"
+            "  -d DBNAME    Optional database name to restore.\n"
+            "  -c COLNAME   Optional collection name to restore, with -d.\n"
+            "  -i DIR       Optional input directory [dump].\n"
+            "  -j THREADS   Optional number of worker threads [4].\n"
+            "  -b MB        Optional insert batch size in megabytes [16].\n"
+            "  --drop       Drop each collection before restoring it.\n"
+            "  --ssl        Use SSL when connecting to server.\n"
+            "\n");
+}
+
+
+int
+main (int argc, char *argv[])
+{
+   restore_t restore = {0};
+   const char *collection = NULL;
+   const char *database = NULL;
+   const char *host = "127.0.0.1";
+   const char *uri_arg = NULL;
+   uint16_t port = 27017;
+   bool ssl = false;
+   int n_threads = 4;
+   int batch_mb = 16;
+   char *uri_string;
+   mongoc_uri_t *uri;
+   pthread_t *threads;
+   bson_error_t error;
+   int64_t start;
+   double elapsed;
+   int i;
+
+   restore.indir = "dump";
+
+   for (i = 1; i < argc; i++) {
+      if (0 == strcmp (argv[i], "-b") && ((i + 1) < argc)) {
+         batch_mb = atoi (argv[++i]);
+         if (batch_mb < 1) {
+            fprintf (stderr, "Invalid batch size \"%s\"\n", argv[i]);
+            return EXIT_FAILURE;
+         }
+      } else if (0 == strcmp (argv[i], "-c") && ((i + 1) < argc)) {
+         collection = argv[++i];
+      } else if (0 == strcmp (argv[i], "-d") && ((i + 1) < argc)) {
+         database = argv[++i];
+      } else if (0 == strcmp (argv[i], "--drop")) {
+         restore.drop = true;
+      } else if (0 == strcmp (argv[i], "--help")) {
+         usage (stdout);
+         return EXIT_SUCCESS;
+      } else if (0 == strcmp (argv[i], "-h") && ((i + 1) < argc)) {
+         host = argv[++i];
+      } else if (0 == strcmp (argv[i], "-i") && ((i + 1) < argc)) {
+         restore.indir = argv[++i];
+      } else if (0 == strcmp (argv[i], "-j") && ((i + 1) < argc)) {
+         n_threads = atoi (argv[++i]);
+         if (n_threads < 1) {
+            fprintf (stderr, "Invalid thread count \"%s\"\n", argv[i]);
+            return EXIT_FAILURE;
+         }
+      } else if (0 == strcmp (argv[i], "-p") && ((i + 1) < argc)) {
+         port = atoi (argv[++i]);
+         if (!port) {
+            fprintf (stderr, "Invalid port \"%s\"\n", argv[i]);
+            return EXIT_FAILURE;
+         }
+      } else if (0 == strcmp (argv[i], "--ssl")) {
+         ssl = true;
+      } else if (0 == strcmp (argv[i], "--uri") && ((i + 1) < argc)) {
+         uri_arg = argv[++i];
+      } else {
+         fprintf (stderr, "Unknown argument \"%s\"\n", argv[i]);
+         return EXIT_FAILURE;
+      }
+   }
+
+   if (collection && !database) {
+      fprintf (stderr, "-c requires -d\n");
+      return EXIT_FAILURE;
+   }
+
+   restore.batch_size = (size_t) batch_mb * 1024 * 1024;
+
+   mongoc_init ();
+
+   if (uri_arg) {
+      uri_string = bson_strdup (uri_arg);
+   } else {
+      uri_string = bson_strdup_printf (
+         "mongodb://%s:%hu/?appname=mongoc-restore&ssl=%s&maxPoolSize=%d",
+         host,
+         port,
+         ssl ? "true" : "false",
+         n_threads);
+   }
+
+   uri = mongoc_uri_new_with_error (uri_string, &error);
+   if (!uri) {
+      fprintf (stderr,
+               "failed to parse URI: %s\n"
+               "error message:       %s\n",
+               uri_string,
+               error.message);
+      bson_free (uri_string);
+      return EXIT_FAILURE;
+   }
+
+   restore.pool = mongoc_client_pool_new (uri);
+   if (!restore.pool) {
+      bson_free (uri_string);
+      mongoc_uri_destroy (uri);
+      return EXIT_FAILURE;
+   }
+
+   mongoc_client_pool_set_error_api (restore.pool, 2);
+   pthread_mutex_init (&restore.mutex, NULL);
+
+   start = bson_get_monotonic_time ();
+
+   if (!restore_plan (&restore, database, collection)) {
+      restore.failed = true;
+   } else {
+      threads = bson_malloc (n_threads * sizeof (pthread_t));
+      for (i = 0; i < n_threads; i++) {
+         pthread_create (&threads[i], NULL, restore_worker, &restore);
+      }
+
+      for (i = 0; i < n_threads; i++) {
+         pthread_join (threads[i], NULL);
+      }
+
+      bson_free (threads);
+   }
+
+   restore_cleanup (&restore);
+
+   elapsed = (bson_get_monotonic_time () - start) / 1e6;
+   fprintf (stderr,
+            "restored %" PRId64 " documents (%.1f MB) to %zu collections "
+            "in %.2f s: %.0f docs/sec, %.1f MB/sec\n",
+            restore.n_docs,
+            restore.n_bytes / 1e6,
+            restore.n_files,
+            elapsed,
+            elapsed > 0 ? restore.n_docs / elapsed : 0.0,
+            elapsed > 0 ? restore.n_bytes / 1e6 / elapsed : 0.0);
+
+   mongoc_client_pool_destroy (restore.pool);
+   mongoc_uri_destroy (uri);
+   bson_free (uri_string);
+   mongoc_cleanup ();
+
+   return restore.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -22,11 +22,19 @@
 #if defined(BSON_OS_UNIX) && defined(MONGOC_ENABLE_SHM_COUNTERS)
 
 
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <errno.h>
 #include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/mman.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <unistd.h>
 
 
@@ -52,7 +60,13 @@ typedef struct {
    uint32_t n_counters;
    uint32_t infos_offset;
    uint32_t values_offset;
-   uint8_t padding[44];
+   uint32_t n_histograms;
+   uint32_t histogram_infos_offset;
+   uint32_t histogram_values_offset;
+   uint32_t table_size;
+   uint32_t table_offset;
+   uint32_t table_values_offset;
+   uint8_t padding[20];
 } mongoc_counters_t;
 #pragma pack()
 
@@ -74,6 +88,74 @@ typedef struct {
 } mongoc_counter_t;
 
 
+#define MONGOC_HISTOGRAM_SUB_BUCKETS 8
+#define MONGOC_HISTOGRAM_N_BUCKETS 208
+
+
+typedef struct {
+   int64_t count;
+   int64_t sum;
+   int64_t buckets[MONGOC_HISTOGRAM_N_BUCKETS];
+   int64_t padding[6];
+} mongoc_histogram_slots_t;
+
+
+BSON_STATIC_ASSERT2 (sizeof_histogram_slots,
+                     sizeof (mongoc_histogram_slots_t) == 1728);
+
+
+#define MONGOC_COUNTERS_ENTRY_READY 1
+
+
+#pragma pack(1)
+typedef struct {
+   uint32_t state;
+   uint32_t padding;
+   char host[64];
+   char ns[128];
+   uint8_t padding2[56];
+} mongoc_counters_entry_t;
+#pragma pack()
+
+
+BSON_STATIC_ASSERT2 (sizeof_counters_entry,
+                     sizeof (mongoc_counters_entry_t) == 256);
+
+
+/* the slots of an entry's per-CPU values, see mongoc-counters-private.h */
+enum {
+   MONGOC_COUNTERS_SLOT_OPS,
+   MONGOC_COUNTERS_SLOT_ERRORS,
+   MONGOC_COUNTERS_SLOT_TIMEOUTS,
+   MONGOC_COUNTERS_SLOT_CONNECTIONS,
+   MONGOC_COUNTERS_SLOT_EGRESS_BYTES,
+   MONGOC_COUNTERS_SLOT_INGRESS_BYTES
+};
+
+
+/* an entry's counters, summed over the CPUs */
+typedef struct {
+   int64_t ops;
+   int64_t errors;
+   int64_t timeouts;
+   int64_t connections;
+   int64_t egress_bytes;
+   int64_t ingress_bytes;
+} mongoc_counters_totals_t;
+
+
+/* a row of the --top display */
+typedef struct {
+   const mongoc_counters_entry_t *entry;
+   double ops;
+   double errors;
+   double timeouts;
+   double connections;
+   double egress_bytes;
+   double ingress_bytes;
+} mongoc_counters_rate_t;
+
+
 static void
 mongoc_counters_destroy (mongoc_counters_t *counters)
 {
@@ -149,6 +231,28 @@ mongoc_counters_get_infos (mongoc_counters_t *counters, uint32_t *n_infos)
 }
 
 
+static mongoc_counter_info_t *
+mongoc_counters_get_histogram_infos (mongoc_counters_t *counters,
+                                     uint32_t *n_infos)
+{
+   mongoc_counter_info_t *info;
+   char *base = (char *) counters;
+
+   BSON_ASSERT (counters);
+   BSON_ASSERT (n_infos);
+
+   /* zero in segments from versions without histograms */
+   *n_infos = counters->n_histograms;
+   if (!*n_infos) {
+      return NULL;
+   }
+
+   info = (mongoc_counter_info_t *) (base + counters->histogram_infos_offset);
+
+   return info;
+}
+
+
 static int64_t
 mongoc_counters_get_value (mongoc_counters_t *counters,
                            mongoc_counter_info_t *info,
@@ -197,31 +301,589 @@ mongoc_counters_print_info (mongoc_counters_t *counters,
 }
 
 
+/* the largest value counted in @bucket, see mongoc-counters-private.h */
+static int64_t
+mongoc_histogram_bucket_max (uint32_t bucket)
+{
+   uint32_t msb;
+
+   if (bucket + 1 < MONGOC_HISTOGRAM_SUB_BUCKETS) {
+      return (int64_t) bucket;
+   }
+
+   bucket++;
+   msb = bucket / MONGOC_HISTOGRAM_SUB_BUCKETS + 2;
+   return ((int64_t) (MONGOC_HISTOGRAM_SUB_BUCKETS +
+                      bucket % MONGOC_HISTOGRAM_SUB_BUCKETS)
+           << (msb - 3)) -
+          1;
+}
+
+
+static int64_t
+mongoc_histogram_percentile (const int64_t *buckets, int64_t count, double q)
+{
+   int64_t rank;
+   int64_t seen = 0;
+   uint32_t i;
+
+   if (!count) {
+      return 0;
+   }
+
+   rank = (int64_t) (q * (double) count);
+   if (rank >= count) {
+      rank = count - 1;
+   }
+
+   for (i = 0; i < MONGOC_HISTOGRAM_N_BUCKETS - 1; i++) {
+      seen += buckets[i];
+      if (seen > rank) {
+         return mongoc_histogram_bucket_max (i);
+      }
+   }
+
+   /* the last bucket has no upper bound */
+   return mongoc_histogram_bucket_max (MONGOC_HISTOGRAM_N_BUCKETS - 2) + 1;
+}
+
+
+static void
+mongoc_counters_print_histogram (mongoc_counters_t *counters,
+                                 mongoc_counter_info_t *info,
+                                 FILE *file)
+{
+   mongoc_histogram_slots_t *cpus;
+   int64_t buckets[MONGOC_HISTOGRAM_N_BUCKETS] = {0};
+   int64_t count = 0;
+   unsigned i;
+   unsigned j;
+
+   BSON_ASSERT (info);
+   BSON_ASSERT (file);
+   BSON_ASSERT ((info->offset & 0x7) == 0);
+
+#ifdef __clang__
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wcast-align"
+#endif
+   cpus = (mongoc_histogram_slots_t *) (((char *) counters) + info->offset);
+#ifdef __clang__
+#pragma clang diagnostic pop
+#endif
+
+   /* sum the buckets rather than reading each CPU's count, so percentiles
+    * are consistent with the total while the process records values */
+   for (i = 0; i < counters->n_cpu; i++) {
+      for (j = 0; j < MONGOC_HISTOGRAM_N_BUCKETS; j++) {
+         buckets[j] += cpus[i].buckets[j];
+         count += cpus[i].buckets[j];
+      }
+   }
+
+   fprintf (file,
+            "%24s : %-24s : %-50s : n=%lld p50=%lld p99=%lld p999=%lld\n",
+            info->category,
+            info->name,
+            info->description,
+            (long long) count,
+            (long long) mongoc_histogram_percentile (buckets, count, 0.5),
+            (long long) mongoc_histogram_percentile (buckets, count, 0.99),
+            (long long) mongoc_histogram_percentile (buckets, count, 0.999));
+}
+
+
+static mongoc_counters_entry_t *
+mongoc_counters_get_entries (mongoc_counters_t *counters, uint32_t *n_entries)
+{
+   char *base = (char *) counters;
+
+   BSON_ASSERT (counters);
+   BSON_ASSERT (n_entries);
+
+   /* zero in segments from versions without the table, or without its
+    * per-CPU values */
+   *n_entries = counters->table_size;
+   if (!*n_entries || !counters->table_values_offset) {
+      *n_entries = 0;
+      return NULL;
+   }
+
+#ifdef __clang__
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wcast-align"
+#endif
+   return (mongoc_counters_entry_t *) (base + counters->table_offset);
+#ifdef __clang__
+#pragma clang diagnostic pop
+#endif
+}
+
+
+static void
+mongoc_counters_get_totals (mongoc_counters_t *counters,
+                            uint32_t i,
+                            mongoc_counters_totals_t *totals)
+{
+   mongoc_counter_slots_t *cpus;
+   const int64_t *slots;
+   unsigned cpu;
+
+   BSON_ASSERT (counters);
+   BSON_ASSERT (totals);
+
+#ifdef __clang__
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wcast-align"
+#endif
+   cpus = (mongoc_counter_slots_t *) (((char *) counters) +
+                                      counters->table_values_offset);
+#ifdef __clang__
+#pragma clang diagnostic pop
+#endif
+   cpus += (size_t) i * counters->n_cpu;
+
+   memset (totals, 0, sizeof *totals);
+   for (cpu = 0; cpu < counters->n_cpu; cpu++) {
+      slots = cpus[cpu].slots;
+      totals->ops += slots[MONGOC_COUNTERS_SLOT_OPS];
+      totals->errors += slots[MONGOC_COUNTERS_SLOT_ERRORS];
+      totals->timeouts += slots[MONGOC_COUNTERS_SLOT_TIMEOUTS];
+      totals->connections += slots[MONGOC_COUNTERS_SLOT_CONNECTIONS];
+      totals->egress_bytes += slots[MONGOC_COUNTERS_SLOT_EGRESS_BYTES];
+      totals->ingress_bytes += slots[MONGOC_COUNTERS_SLOT_INGRESS_BYTES];
+   }
+}
+
+
+static void
+mongoc_counters_print_entry (const mongoc_counters_entry_t *entry,
+                             const mongoc_counters_totals_t *totals,
+                             FILE *file)
+{
+   BSON_ASSERT (entry);
+   BSON_ASSERT (totals);
+   BSON_ASSERT (file);
+
+   fprintf (file,
+            "%24s : %-24s : %-50s : ops=%lld errors=%lld timeouts=%lld "
+            "connections=%lld egress_bytes=%lld ingress_bytes=%lld\n",
+            entry->ns[0] ? "Namespaces" : "Servers",
+            entry->host,
+            entry->ns,
+            (long long) totals->ops,
+            (long long) totals->errors,
+            (long long) totals->timeouts,
+            (long long) totals->connections,
+            (long long) totals->egress_bytes,
+            (long long) totals->ingress_bytes);
+}
+
+
+static int
+mongoc_counters_rate_cmp (const void *a, const void *b)
+{
+   const mongoc_counters_rate_t *rate_a = (const mongoc_counters_rate_t *) a;
+   const mongoc_counters_rate_t *rate_b = (const mongoc_counters_rate_t *) b;
+
+   if (rate_a->ops != rate_b->ops) {
+      return rate_a->ops < rate_b->ops ? 1 : -1;
+   }
+
+   if (rate_a->egress_bytes + rate_a->ingress_bytes !=
+       rate_b->egress_bytes + rate_b->ingress_bytes) {
+      return rate_a->egress_bytes + rate_a->ingress_bytes <
+                   rate_b->egress_bytes + rate_b->ingress_bytes
+                ? 1
+                : -1;
+   }
+
+   return strcmp (rate_a->entry->host, rate_b->entry->host);
+}
+
+
+/*
+ * like top(1): every @interval seconds, clear the terminal and print each
+ * server and namespace's rates over the last interval, busiest first.
+ * runs until interrupted.
+ */
+static int
+mongoc_counters_top (mongoc_counters_t *counters, double interval)
+{
+   mongoc_counters_entry_t *entries;
+   mongoc_counters_totals_t *totals;
+   mongoc_counters_totals_t *last;
+   mongoc_counters_rate_t *rates;
+   mongoc_counters_rate_t *rate;
+   int64_t last_time;
+   int64_t now;
+   double secs;
+   uint32_t n_entries;
+   uint32_t n_rates;
+   uint32_t i;
+
+   entries = mongoc_counters_get_entries (counters, &n_entries);
+   if (!entries) {
+      fprintf (stderr, "The process has no per-server counters.\n");
+      return EXIT_FAILURE;
+   }
+
+   totals = bson_malloc (n_entries * sizeof *totals);
+   last = bson_malloc (n_entries * sizeof *last);
+   rates = bson_malloc (n_entries * sizeof *rates);
+   for (i = 0; i < n_entries; i++) {
+      mongoc_counters_get_totals (counters, i, &last[i]);
+   }
+   last_time = bson_get_monotonic_time ();
+
+   for (;;) {
+      /* usleep may reject a second or more */
+      sleep ((unsigned) interval);
+      usleep ((useconds_t) ((interval - (unsigned) interval) * 1000 * 1000));
+      now = bson_get_monotonic_time ();
+      secs = (double) (now - last_time) / (1000 * 1000);
+      n_rates = 0;
+
+      for (i = 0; i < n_entries; i++) {
+         mongoc_counters_get_totals (counters, i, &totals[i]);
+         if (entries[i].state != MONGOC_COUNTERS_ENTRY_READY) {
+            continue;
+         }
+
+         rate = &rates[n_rates++];
+         rate->entry = &entries[i];
+#define RATE(_field) \
+   rate->_field = (double) (totals[i]._field - last[i]._field) / secs
+         RATE (ops);
+         RATE (errors);
+         RATE (timeouts);
+         RATE (connections);
+         RATE (egress_bytes);
+         RATE (ingress_bytes);
+#undef RATE
+      }
+
+      qsort (rates, n_rates, sizeof *rates, mongoc_counters_rate_cmp);
+
+      printf ("\033[H\033[2J");
+      printf ("%-32s %-32s %10s %8s %8s %8s %10s %10s\n",
+              "HOST",
+              "NAMESPACE",
+              "OPS/S",
+              "ERR/S",
+              "TMO/S",
+              "CONN/S",
+              "OUT KB/S",
+              "IN KB/S");
+
+      for (i = 0; i < n_rates; i++) {
+         rate = &rates[i];
+         printf ("%-32.32s %-32.32s %10.1f %8.1f %8.1f %8.1f %10.1f %10.1f\n",
+                 rate->entry->host,
+                 rate->entry->ns[0] ? rate->entry->ns : "(all)",
+                 rate->ops,
+                 rate->errors,
+                 rate->timeouts,
+                 rate->connections,
+                 rate->egress_bytes / 1024,
+                 rate->ingress_bytes / 1024);
+      }
+
+      fflush (stdout);
+      memcpy (last, totals, n_entries * sizeof *last);
+      last_time = now;
+   }
+
+   /* not reached */
+   bson_free (rates);
+   bson_free (last);
+   bson_free (totals);
+
+   return EXIT_SUCCESS;
+}
+
+
+/*
+ * the pids of the processes with a segment. Linux shows POSIX shared memory
+ * in /dev/shm, skip segments left by processes that exited without calling
+ * mongoc_cleanup().
+ */
+static size_t
+mongoc_counters_find_pids (int **pids)
+{
+   struct dirent *ent;
+   size_t n_pids = 0;
+   size_t max_pids = 16;
+   char *end;
+   DIR *dir;
+   long pid;
+
+   *pids = bson_malloc (max_pids * sizeof **pids);
+
+   if (!(dir = opendir ("/dev/shm"))) {
+      return 0;
+   }
+
+   while ((ent = readdir (dir))) {
+      if (strncmp (ent->d_name, "mongoc-", 7)) {
+         continue;
+      }
+
+      pid = strtol (ent->d_name + 7, &end, 10);
+      if (*end || pid <= 0 || pid == getpid ()) {
+         continue;
+      }
+
+      if (kill ((pid_t) pid, 0) && errno != EPERM) {
+         continue;
+      }
+
+      if (n_pids == max_pids) {
+         max_pids *= 2;
+         *pids = bson_realloc (*pids, max_pids * sizeof **pids);
+      }
+
+      (*pids)[n_pids++] = (int) pid;
+   }
+
+   closedir (dir);
+
+   return n_pids;
+}
+
+
+static void
+mongoc_counters_send_all (int fd, const char *buf, size_t len)
+{
+   ssize_t sent;
+
+   while (len) {
+      sent = send (fd, buf, len, 0);
+      if (sent <= 0) {
+         if (sent < 0 && errno == EINTR) {
+            continue;
+         }
+
+         return;
+      }
+
+      buf += sent;
+      len -= (size_t) sent;
+   }
+}
+
+
+/* answer one HTTP request on @fd with a snapshot of the processes' metrics */
+static void
+mongoc_counters_serve_request (int fd, const int *pids, size_t n_pids)
+{
+   char request[2048];
+   char header[256];
+   size_t len = 0;
+   ssize_t n;
+   int *found = NULL;
+   char *body;
+
+   /* a scraper sends a request line and headers, without a body */
+   request[0] = '\0';
+   while (len < sizeof request - 1 && !strstr (request, "\r\n\r\n")) {
+      n = recv (fd, request + len, sizeof request - 1 - len, 0);
+      if (n <= 0) {
+         break;
+      }
+
+      len += (size_t) n;
+      request[len] = '\0';
+   }
+
+   if (strncmp (request, "GET /metrics ", 13) &&
+       strncmp (request, "GET /metrics?", 13)) {
+      bson_snprintf (header,
+                     sizeof header,
+                     "HTTP/1.0 404 Not Found\r\n"
+                     "Content-Type: text/plain\r\n"
+                     "Content-Length: 10\r\n\r\n"
+                     "Not Found\n");
+      mongoc_counters_send_all (fd, header, strlen (header));
+      return;
+   }
+
+   if (!n_pids) {
+      n_pids = mongoc_counters_find_pids (&found);
+      pids = found;
+   }
+
+   body = mongoc_counters_openmetrics_for_pids (pids, n_pids);
+   bson_snprintf (header,
+                  sizeof header,
+                  "HTTP/1.0 200 OK\r\n"
+                  "Content-Type: application/openmetrics-text; "
+                  "version=1.0.0; charset=utf-8\r\n"
+                  "Content-Length: %zu\r\n\r\n",
+                  strlen (body));
+   mongoc_counters_send_all (fd, header, strlen (header));
+   mongoc_counters_send_all (fd, body, strlen (body));
+
+   bson_free (body);
+   bson_free (found);
+}
+
+
+/*
+ * serve snapshots of the processes' counters in the OpenMetrics format at
+ * http://127.0.0.1:PORT/metrics, or of every process using the driver if
+ * no pids are given. each request maps the processes' segments read-only,
+ * the processes themselves do nothing.
+ */
+static int
+mongoc_counters_serve (int port, const int *pids, size_t n_pids)
+{
+   struct sockaddr_in addr;
+   struct timeval timeout = {5, 0};
+   int optval = 1;
+   int listen_fd;
+   int fd;
+
+   /* a scraper that hangs up early must not end the daemon */
+   signal (SIGPIPE, SIG_IGN);
+
+   if (-1 == (listen_fd = socket (AF_INET, SOCK_STREAM, 0))) {
+      perror ("Failed to create socket");
+      return EXIT_FAILURE;
+   }
+
+   setsockopt (listen_fd, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof optval);
+
+   memset (&addr, 0, sizeof addr);
+   addr.sin_family = AF_INET;
+   addr.sin_port = htons ((uint16_t) port);
+   addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+
+   if (-1 == bind (listen_fd, (struct sockaddr *) &addr, sizeof addr) ||
+       -1 == listen (listen_fd, 16)) {
+      perror ("Failed to listen");
+      close (listen_fd);
+      return EXIT_FAILURE;
+   }
+
+   for (;;) {
+      if (-1 == (fd = accept (listen_fd, NULL, NULL))) {
+         if (errno == EINTR || errno == ECONNABORTED) {
+            continue;
+         }
+
+         perror ("Failed to accept");
+         break;
+      }
+
+      /* don't let a slow scraper block the others */
+      setsockopt (fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+      setsockopt (fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof timeout);
+      mongoc_counters_serve_request (fd, pids, n_pids);
+      close (fd);
+   }
+
+   close (listen_fd);
+
+   return EXIT_FAILURE;
+}
+
+
+static void
+usage (const char *prog)
+{
+   fprintf (stderr, "usage: %s PID\n", prog);
+   fprintf (stderr, "       %s --top PID [INTERVAL]\n", prog);
+   fprintf (stderr, "       %s --serve PORT [PID ...]\n", prog);
+}
+
+
 int
 main (int argc, char *argv[])
 {
    mongoc_counter_info_t *infos;
+   mongoc_counters_entry_t *entries;
+   mongoc_counters_totals_t totals;
    mongoc_counters_t *counters;
    uint32_t n_counters = 0;
+   uint32_t n_histograms = 0;
+   uint32_t n_entries = 0;
+   double interval = 1.0;
+   bool top = false;
    unsigned i;
+   int *pids;
+   int port;
+   int ret;
    int pid;
 
-   if (argc != 2) {
-      fprintf (stderr, "usage: %s PID\n", argv[0]);
+   if (argc >= 3 && !strcmp (argv[1], "--serve")) {
+      port = (int) strtol (argv[2], NULL, 10);
+      if (port <= 0 || port > 65535) {
+         usage (argv[0]);
+         return 1;
+      }
+
+      pids = bson_malloc0 ((size_t) argc * sizeof *pids);
+      for (i = 3; i < (unsigned) argc; i++) {
+         pids[i - 3] = (int) strtol (argv[i], NULL, 10);
+      }
+
+      ret = mongoc_counters_serve (port, pids, (size_t) argc - 3);
+      bson_free (pids);
+      return ret;
+   }
+
+   if (argc >= 3 && !strcmp (argv[1], "--top")) {
+      if (argc > 4) {
+         usage (argv[0]);
+         return 1;
+      }
+
+      top = true;
+      pid = strtol (argv[2], NULL, 10);
+      if (argc == 4) {
+         interval = strtod (argv[3], NULL);
+         if (interval <= 0) {
+            usage (argv[0]);
+            return 1;
+         }
+      }
+   } else if (argc == 2) {
+      pid = strtol (argv[1], NULL, 10);
+   } else {
+      usage (argv[0]);
       return 1;
    }
 
-   pid = strtol (argv[1], NULL, 10);
    if (!(counters = mongoc_counters_new_from_pid (pid))) {
       fprintf (stderr, "Failed to load shared memory for pid %u.\n", pid);
       return EXIT_FAILURE;
    }
 
+   if (top) {
+      ret = mongoc_counters_top (counters, interval);
+      mongoc_counters_destroy (counters);
+      return ret;
+   }
+
    infos = mongoc_counters_get_infos (counters, &n_counters);
    for (i = 0; i < n_counters; i++) {
       mongoc_counters_print_info (counters, &infos[i], stdout);
    }
 
+   infos = mongoc_counters_get_histogram_infos (counters, &n_histograms);
+   for (i = 0; i < n_histograms; i++) {
+      mongoc_counters_print_histogram (counters, &infos[i], stdout);
+   }
+
+   entries = mongoc_counters_get_entries (counters, &n_entries);
+   for (i = 0; i < n_entries; i++) {
+      if (entries[i].state == MONGOC_COUNTERS_ENTRY_READY) {
+         mongoc_counters_get_totals (counters, i, &totals);
+         mongoc_counters_print_entry (&entries[i], &totals, stdout);
+      }
+   }
+
    mongoc_counters_destroy (counters);
 
    return EXIT_SUCCESS;